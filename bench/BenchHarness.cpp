@@ -0,0 +1,320 @@
+#include "BenchHarness.hpp"
+#include "JsonWriter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef LODESTONE_BENCH_BUILD_TYPE
+#define LODESTONE_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace lodestone::bench
+{
+
+namespace
+{
+
+    /** Bump this when a field of the JSON report changes meaning, so an old report is not compared
+     * against a new one by mistake. */
+    constexpr uint32_t k_BenchReportVersion{ 1u };
+
+    constexpr std::string_view k_Usage = R"(usage: lodestone_bench [options]
+  --filter=<text>      run only the benchmarks whose name holds <text>
+  --samples=<n>        timed samples for each benchmark (default 15)
+  --min-time-ms=<n>    shortest time of one sample, in milliseconds (default 10)
+  --json=<file>        write every result to <file> as JSON
+  --label=<text>       copy <text> into the JSON report, such as a commit hash
+  --quick              3 samples of 1ms each, to check that every benchmark runs
+  --list               print the name of each benchmark and run nothing
+  --help               print this text)";
+
+    std::optional<uint32_t> ParsePositive(std::string_view text) noexcept
+    {
+        uint32_t value = 0u;
+        const std::from_chars_result parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (parsed.ec != std::errc{} || parsed.ptr != text.data() + text.size() || value == 0u)
+        {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /** The value after `prefix`, when `argument` starts with it. */
+    std::optional<std::string_view> ValueOf(std::string_view argument, std::string_view prefix) noexcept
+    {
+        if (!argument.starts_with(prefix))
+        {
+            return std::nullopt;
+        }
+
+        return argument.substr(prefix.size());
+    }
+
+    bool IsOptimizedBuild() noexcept
+    {
+#ifdef NDEBUG
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    double ItemsPerSecond(const BenchResult& result) noexcept
+    {
+        if (result.MedianNanoseconds <= 0.0)
+        {
+            return 0.0;
+        }
+
+        return static_cast<double>(result.ItemsPerIteration) * 1.0e9 / result.MedianNanoseconds;
+    }
+
+    /** The standard deviation as a share of the mean. Above a few percent, the machine was busy. */
+    double RelativeSpread(const BenchResult& result) noexcept
+    {
+        return result.MeanNanoseconds > 0.0 ? 100.0 * result.StdDevNanoseconds / result.MeanNanoseconds : 0.0;
+    }
+
+} // namespace
+
+namespace detail
+{
+    void EscapePointer(const void* pointer) noexcept
+    {
+        static const void* volatile sink = nullptr;
+        sink = pointer;
+    }
+} // namespace detail
+
+std::optional<BenchOptions> ParseBenchOptions(int argc, char** argv)
+{
+    BenchOptions options;
+    const std::span<char*> arguments{ argv, static_cast<size_t>(argc) };
+    for (size_t i = 1u; i < arguments.size(); ++i)
+    {
+        const std::string_view argument{ arguments[i] };
+        if (const std::optional<std::string_view> filter = ValueOf(argument, "--filter="))
+        {
+            options.Filter = *filter;
+        }
+        else if (const std::optional<std::string_view> samples = ValueOf(argument, "--samples="))
+        {
+            const std::optional<uint32_t> count = ParsePositive(*samples);
+            if (!count)
+            {
+                std::println(stderr, "[lodestone_bench] --samples needs a positive number, not '{}'",
+                             *samples);
+                return std::nullopt;
+            }
+            options.SampleCount = *count;
+        }
+        else if (const std::optional<std::string_view> minTime = ValueOf(argument, "--min-time-ms="))
+        {
+            const std::optional<uint32_t> milliseconds = ParsePositive(*minTime);
+            if (!milliseconds)
+            {
+                std::println(stderr, "[lodestone_bench] --min-time-ms needs a positive number, not '{}'",
+                             *minTime);
+                return std::nullopt;
+            }
+            options.MinSampleTime = std::chrono::milliseconds{ *milliseconds };
+        }
+        else if (const std::optional<std::string_view> json = ValueOf(argument, "--json="))
+        {
+            if (json->empty())
+            {
+                std::println(stderr, "[lodestone_bench] --json needs a file name");
+                return std::nullopt;
+            }
+            options.JsonPath = *json;
+        }
+        else if (const std::optional<std::string_view> label = ValueOf(argument, "--label="))
+        {
+            options.Label = *label;
+        }
+        else if (argument == "--quick")
+        {
+            options.SampleCount = 3u;
+            options.MinSampleTime = std::chrono::milliseconds{ 1 };
+        }
+        else if (argument == "--list")
+        {
+            options.ListOnly = true;
+        }
+        else
+        {
+            if (argument != "--help")
+            {
+                std::println(stderr, "[lodestone_bench] unknown argument '{}'", argument);
+            }
+            std::println(stderr, "{}", k_Usage);
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+BenchRunner::BenchRunner(BenchOptions _options)
+    : options{ std::move(_options) }
+{
+    if (!options.ListOnly && !IsOptimizedBuild())
+    {
+        std::println(stderr, "[lodestone_bench] warning: this is a debug build, so its numbers are not "
+                             "comparable to a release build's");
+    }
+}
+
+int BenchRunner::Finish() const
+{
+    if (options.ListOnly)
+    {
+        return listedCount > 0u ? 0 : 1;
+    }
+
+    if (results.empty())
+    {
+        std::println(stderr, "[lodestone_bench] no benchmark matched '{}'", options.Filter);
+        return 1;
+    }
+
+    if (!options.JsonPath.empty() && !WriteJsonReport())
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+bool BenchRunner::IsSelected(std::string_view name) const noexcept
+{
+    return options.Filter.empty() || name.find(options.Filter) != std::string_view::npos;
+}
+
+void BenchRunner::ListName(std::string_view name)
+{
+    std::println("{}", name);
+    ++listedCount;
+}
+
+void BenchRunner::Record(std::string_view name,
+                         uint64_t items_per_iteration,
+                         uint64_t iterations_per_sample,
+                         std::vector<double> samples)
+{
+    std::ranges::sort(samples);
+
+    BenchResult result;
+    result.Name = name;
+    result.ItemsPerIteration = items_per_iteration;
+    result.IterationsPerSample = iterations_per_sample;
+
+    const size_t count = samples.size();
+    result.MinNanoseconds = samples.front();
+    result.MaxNanoseconds = samples.back();
+    result.MedianNanoseconds =
+        count % 2u == 1u ? samples[count / 2u] : 0.5 * (samples[count / 2u - 1u] + samples[count / 2u]);
+    result.MeanNanoseconds =
+        std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(count);
+
+    // The sample deviation, with n - 1, because the samples estimate a machine and are not all of it.
+    if (count > 1u)
+    {
+        double squares = 0.0;
+        for (const double sample : samples)
+        {
+            squares += (sample - result.MeanNanoseconds) * (sample - result.MeanNanoseconds);
+        }
+        result.StdDevNanoseconds = std::sqrt(squares / static_cast<double>(count - 1u));
+    }
+
+    result.SampleNanoseconds = std::move(samples);
+
+    std::println("{:<48} {:>14.1f} ns  (min {:.1f}, +/- {:.1f}%)  {:>14.0f} items/s",
+                 result.Name,
+                 result.MedianNanoseconds,
+                 result.MinNanoseconds,
+                 RelativeSpread(result),
+                 ItemsPerSecond(result));
+    results.push_back(std::move(result));
+}
+
+bool BenchRunner::WriteJsonReport() const
+{
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.KeyUInt("version", k_BenchReportVersion);
+    writer.KeyString("label", options.Label);
+    writer.KeyString("build_type", LODESTONE_BENCH_BUILD_TYPE);
+    writer.KeyBool("optimized", IsOptimizedBuild());
+    writer.KeyUInt("samples", options.SampleCount);
+    writer.KeyDouble("min_sample_ms",
+                     std::chrono::duration<double, std::milli>{ options.MinSampleTime }.count());
+    writer.Key("benchmarks");
+    writer.BeginArray();
+    for (const BenchResult& result : results)
+    {
+        writer.BeginObject();
+        writer.KeyString("name", result.Name);
+        writer.KeyUInt("items_per_iteration", result.ItemsPerIteration);
+        writer.KeyUInt("iterations_per_sample", result.IterationsPerSample);
+        writer.KeyDouble("median_ns", result.MedianNanoseconds);
+        writer.KeyDouble("mean_ns", result.MeanNanoseconds);
+        writer.KeyDouble("stddev_ns", result.StdDevNanoseconds);
+        writer.KeyDouble("min_ns", result.MinNanoseconds);
+        writer.KeyDouble("max_ns", result.MaxNanoseconds);
+        writer.KeyDouble("items_per_second", ItemsPerSecond(result));
+        writer.Key("sample_ns");
+        writer.BeginArray();
+        for (const double sample : result.SampleNanoseconds)
+        {
+            writer.Double(sample);
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    const JsonResult<std::string> document = writer.Finish();
+    if (!document)
+    {
+        std::println(stderr, "[lodestone_bench] the JSON report did not balance");
+        return false;
+    }
+
+    std::error_code error;
+    if (options.JsonPath.has_parent_path())
+    {
+        std::filesystem::create_directories(options.JsonPath.parent_path(), error);
+    }
+
+    std::ofstream file{ options.JsonPath, std::ios::binary | std::ios::trunc };
+    file << document.value() << '\n';
+    if (!file)
+    {
+        std::println(stderr, "[lodestone_bench] could not write '{}'", options.JsonPath.string());
+        return false;
+    }
+
+    std::println("[lodestone_bench] wrote {} results to '{}'", results.size(), options.JsonPath.string());
+    return true;
+}
+
+} // namespace lodestone::bench
@@ -0,0 +1,144 @@
+#pragma once
+#ifndef LODESTONE_BENCH_HARNESS_HPP
+#define LODESTONE_BENCH_HARNESS_HPP
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/** Not Google Benchmark: a calibrated loop, a few samples, and the spread between them.
+ *
+ * Each benchmark first doubles its iteration count until one batch runs for at least the minimum
+ * sample time. Those batches also warm the caches. The runner then times a fixed number of batches of
+ * that size, and reports the median and the spread of the time per iteration. The median is the number
+ * to compare across commits, because one slow sample moves the mean but not the median. */
+namespace lodestone::bench
+{
+
+struct BenchOptions
+{
+    /** Runs only the benchmarks whose name holds this text. Empty runs every benchmark. */
+    std::string Filter;
+    uint32_t SampleCount{ 15u };
+    /** Each sample repeats the body until it runs at least this long, so a fast body still measures
+     * well above the resolution of the clock. */
+    std::chrono::nanoseconds MinSampleTime{ std::chrono::milliseconds{ 10 } };
+    /** Where the JSON report goes. Empty writes no report. */
+    std::filesystem::path JsonPath;
+    /** Copied into the JSON report as is, so a script can tag a run with its commit. */
+    std::string Label;
+    bool ListOnly{ false };
+};
+
+/** nullopt when the command line is wrong, or when it asked for help. Usage is printed in both cases. */
+std::optional<BenchOptions> ParseBenchOptions(int argc, char** argv);
+
+struct BenchResult
+{
+    std::string Name;
+    /** What one iteration processes, such as payloads interned or slots looked up. */
+    uint64_t ItemsPerIteration{ 1u };
+    uint64_t IterationsPerSample{ 0u };
+    /** Nanoseconds for one iteration, one entry for each sample, sorted. */
+    std::vector<double> SampleNanoseconds;
+    double MinNanoseconds{ 0.0 };
+    double MedianNanoseconds{ 0.0 };
+    double MeanNanoseconds{ 0.0 };
+    double StdDevNanoseconds{ 0.0 };
+    double MaxNanoseconds{ 0.0 };
+};
+
+namespace detail
+{
+    /** Defined in a separate translation unit, so the compiler cannot prove the pointer unused. */
+    void EscapePointer(const void* pointer) noexcept;
+} // namespace detail
+
+/** Keeps the compiler from deleting the work that produced `value`. */
+template<typename T>
+inline void KeepResult(const T& value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "m"(value) : "memory");
+#else
+    detail::EscapePointer(&value);
+#endif
+}
+
+class BenchRunner final
+{
+public:
+    explicit BenchRunner(BenchOptions _options);
+
+    /** Times `body`, which must do the same work on every call. `items_per_iteration` turns the time
+     * per call into a rate, and is 1 when a call is one item. */
+    template<typename Body>
+    void Run(std::string_view name, uint64_t items_per_iteration, Body&& body)
+    {
+        if (!IsSelected(name))
+        {
+            return;
+        }
+
+        if (options.ListOnly)
+        {
+            ListName(name);
+            return;
+        }
+
+        const auto timeBatch = [&body](uint64_t iterations)
+        {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t i = 0u; i < iterations; ++i)
+            {
+                body();
+            }
+            return Clock::now() - start;
+        };
+
+        uint64_t iterations = 1u;
+        while (iterations < k_MaxIterationsPerSample && timeBatch(iterations) < options.MinSampleTime)
+        {
+            iterations *= 2u;
+        }
+
+        std::vector<double> samples;
+        samples.reserve(options.SampleCount);
+        for (uint32_t i = 0u; i < options.SampleCount; ++i)
+        {
+            const std::chrono::duration<double, std::nano> elapsed = timeBatch(iterations);
+            samples.push_back(elapsed.count() / static_cast<double>(iterations));
+        }
+
+        Record(name, items_per_iteration, iterations, std::move(samples));
+    }
+
+    /** Writes the JSON report, when one was asked for. Returns what main() should hand back. */
+    [[nodiscard]] int Finish() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /** Stops calibration of a body so cheap that the compiler may have removed it. */
+    static constexpr uint64_t k_MaxIterationsPerSample{ uint64_t{ 1u } << 30u };
+
+    [[nodiscard]] bool IsSelected(std::string_view name) const noexcept;
+    void ListName(std::string_view name);
+    void Record(std::string_view name,
+                uint64_t items_per_iteration,
+                uint64_t iterations_per_sample,
+                std::vector<double> samples);
+    [[nodiscard]] bool WriteJsonReport() const;
+
+    BenchOptions options;
+    std::vector<BenchResult> results;
+    size_t listedCount{ 0u };
+};
+
+} // namespace lodestone::bench
+
+#endif // !LODESTONE_BENCH_HARNESS_HPP
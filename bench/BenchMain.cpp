@@ -0,0 +1,455 @@
+#include "BenchHarness.hpp"
+#include "NodeMapInterner.hpp"
+#include "SyntheticShaders.hpp"
+
+#include "CookerErrors.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderProviderRegistry.hpp"
+#include "emit/DedupeReport.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/ConcurrentContentInterner.hpp"
+#include "model/ContentHash.hpp"
+#include "model/ContentInterner.hpp"
+#include "model/CookedLibrary.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "permute/PermutationValue.hpp"
+#include "permute/SizeExpression.hpp"
+#include "target/WgslBindingScanner.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// The benchmarks cover the parts of a cook that run once per variant or once per slot, and the client
+// code that runs when a manifest loads. Every input is built in memory before the first timer starts,
+// so a run measures the code and never the disk. Names read "area/what", so --filter=manifest/ selects
+// one area.
+
+using namespace lodestone;
+using lodestone::bench::BenchRunner;
+using lodestone::bench::KeepResult;
+
+namespace
+{
+
+/** A cook of a large module interns a few hundred sources for each entry point. */
+constexpr uint32_t k_InternPayloadCount{ 256u };
+/** How many times each source repeats in the duplicate case. Entry points that read one axis of four
+ * see about this rate in practice. */
+constexpr uint32_t k_InternDuplicateFactor{ 8u };
+/** Threads that stage into the concurrent interner, as compile workers do during a cook. */
+constexpr uint32_t k_InternStagingThreads{ 4u };
+/** The collapse rates the README reports for OceanFft: 105 sources to 77, and 105 layouts to 21. */
+constexpr uint32_t k_TableArtifactCount{ 105u };
+constexpr uint32_t k_TableUniqueSources{ 77u };
+constexpr uint32_t k_TableUniqueLayouts{ 21u };
+/** The layout rate again at the scale of a 100k-variant module, where growth and allocation dominate. */
+constexpr uint32_t k_LargeTableScale{ 1000u };
+/** Sources are far larger than layouts, so their large case scales by less. */
+constexpr uint32_t k_LargeSourceScale{ 100u };
+/** Four axes of four values, then the dependent pair: 256 * 4 = 1024 variants. */
+constexpr uint32_t k_BenchAxisCount{ 4u };
+constexpr uint32_t k_BenchValuesPerAxis{ 4u };
+constexpr uint32_t k_BenchEntryPointCount{ 3u };
+/** Bindings in the scanned source. A large compute pass declares about this many. */
+constexpr uint32_t k_ScannedBindingCount{ 16u };
+
+/** The manifest bytes in storage that starts on an 8-byte boundary, the way a mapped file does.
+ * `ShaderManifestView::Open` refuses anything else. */
+struct AlignedManifest
+{
+    std::vector<uint64_t> Words;
+    size_t ByteCount{ 0u };
+
+    [[nodiscard]] std::span<const std::byte> Bytes() const noexcept
+    {
+        return std::as_bytes(std::span<const uint64_t>{ Words }).first(ByteCount);
+    }
+};
+
+AlignedManifest MakeAlignedManifest(const std::string& manifest)
+{
+    AlignedManifest aligned;
+    aligned.ByteCount = manifest.size();
+    aligned.Words.resize((manifest.size() + sizeof(uint64_t) - 1u) / sizeof(uint64_t));
+    std::memcpy(aligned.Words.data(), manifest.data(), manifest.size());
+    return aligned;
+}
+
+void RunInternerBenchmarks(BenchRunner& runner)
+{
+    std::vector<std::string> distinct;
+    std::vector<std::string> duplicated;
+    for (uint32_t i = 0u; i < k_InternPayloadCount; ++i)
+    {
+        distinct.push_back(bench::MakeSyntheticWgsl("BenchCS", 6u, i));
+        const uint32_t duplicateSeed = i % (k_InternPayloadCount / k_InternDuplicateFactor);
+        duplicated.push_back(bench::MakeSyntheticWgsl("BenchCS", 6u, duplicateSeed));
+    }
+
+    // The cook hands each payload over by value, so the copy is part of what an intern costs.
+    const auto internAll = [](const std::vector<std::string>& payloads)
+    {
+        ContentInterner<std::string> interner{ &HashSourceString, k_HashName };
+        for (uint32_t i = 0u; i < payloads.size(); ++i)
+        {
+            KeepResult(interner.Intern(payloads[i],
+                                       ProvenanceRecord{ .EntryPointIndex = 0u, .VariantIndex = i }));
+        }
+        KeepResult(interner.UniqueEntries().size());
+    };
+
+    // Workers stage and one thread commits in order, the way the source table fills during a cook. The
+    // threads start inside the timer, so a sample also pays for starting them, as the pool does.
+    const auto stageAndCommitAll = [](const std::vector<std::string>& payloads)
+    {
+        ConcurrentContentInterner<std::string> interner{ &HashSourceString, k_HashName };
+        std::vector<ConcurrentContentInterner<std::string>::Ticket> tickets(payloads.size());
+        {
+            std::vector<std::jthread> threads;
+            for (uint32_t t = 0u; t < k_InternStagingThreads; ++t)
+            {
+                threads.emplace_back(
+                    [&, t]
+                    {
+                        for (size_t i = t; i < payloads.size(); i += k_InternStagingThreads)
+                        {
+                            tickets[i] = interner.Stage(payloads[i]);
+                        }
+                    });
+            }
+        }
+
+        for (uint32_t i = 0u; i < tickets.size(); ++i)
+        {
+            KeepResult(interner.Commit(tickets[i],
+                                       ProvenanceRecord{ .EntryPointIndex = 0u, .VariantIndex = i }));
+        }
+        KeepResult(interner.UniqueCount());
+    };
+
+    runner.Run("interner/intern_wgsl_distinct", k_InternPayloadCount, [&] { internAll(distinct); });
+    runner.Run("interner/intern_wgsl_duplicates", k_InternPayloadCount, [&] { internAll(duplicated); });
+    runner.Run("interner/stage_wgsl_sharded_distinct",
+               k_InternPayloadCount,
+               [&] { stageAndCommitAll(distinct); });
+    runner.Run("interner/stage_wgsl_sharded_duplicates",
+               k_InternPayloadCount,
+               [&] { stageAndCommitAll(duplicated); });
+}
+
+/** Artifact `i` of `artifact_count` maps to one of `unique_count` payloads. The first `unique_count`
+ * are new, in order, and the rest repeat them in a scattered order, the way later variants repeat the
+ * text of earlier ones. */
+uint32_t PickPayload(uint32_t artifact, uint32_t unique_count) noexcept
+{
+    return artifact < unique_count ? artifact : (artifact * 7u + artifact / unique_count) % unique_count;
+}
+
+ResourceList MakeLayoutPayload(uint32_t layout)
+{
+    return ResourceList{ layout, layout + 1u, layout + 2u, layout * 3u, 4u, 5u };
+}
+
+/** Interns `payloads` through a fresh interner that `make_interner` builds. */
+template<typename MakeInterner, typename PayloadType>
+void InternThrough(const MakeInterner& make_interner, const std::vector<PayloadType>& payloads)
+{
+    auto interner = make_interner();
+    for (uint32_t i = 0u; i < payloads.size(); ++i)
+    {
+        KeepResult(interner.Intern(payloads[i],
+                                   ProvenanceRecord{ .EntryPointIndex = 0u, .VariantIndex = i }));
+    }
+    KeepResult(interner.UniqueCount());
+}
+
+/** Stages `payloads` through a fresh sharded interner that `make_interner` builds, then commits them in
+ * order. Both steps run on the calling thread, so the timer sees the shards and not thread starts. */
+template<typename MakeInterner, typename PayloadType>
+void StageAndCommitThrough(const MakeInterner& make_interner, const std::vector<PayloadType>& payloads)
+{
+    auto interner = make_interner();
+    std::vector<typename decltype(interner)::Ticket> tickets;
+    tickets.reserve(payloads.size());
+    for (const PayloadType& payload : payloads)
+    {
+        tickets.push_back(interner.Stage(payload));
+    }
+
+    for (uint32_t i = 0u; i < tickets.size(); ++i)
+    {
+        KeepResult(interner.Commit(tickets[i], ProvenanceRecord{ .EntryPointIndex = 0u, .VariantIndex = i }));
+    }
+    KeepResult(interner.UniqueCount());
+}
+
+/** The flat tables against the node maps they replaced, at the collapse rates a real module shows.
+ * Sources go through the sharded interner, as they do in a cook, and layouts through the serial one. */
+void RunInternerTableBenchmarks(BenchRunner& runner)
+{
+    std::vector<std::string> sources;
+    std::vector<std::string> largeSources;
+    std::vector<ResourceList> layouts;
+    std::vector<ResourceList> largeLayouts;
+    for (uint32_t i = 0u; i < k_TableArtifactCount; ++i)
+    {
+        sources.push_back(bench::MakeSyntheticWgsl("BenchCS", 6u, PickPayload(i, k_TableUniqueSources)));
+        layouts.push_back(MakeLayoutPayload(PickPayload(i, k_TableUniqueLayouts)));
+    }
+    for (uint32_t i = 0u; i < k_TableArtifactCount * k_LargeSourceScale; ++i)
+    {
+        const uint32_t source = PickPayload(i, k_TableUniqueSources * k_LargeSourceScale);
+        largeSources.push_back(bench::MakeSyntheticWgsl("BenchCS", 6u, source));
+    }
+    for (uint32_t i = 0u; i < k_TableArtifactCount * k_LargeTableScale; ++i)
+    {
+        largeLayouts.push_back(MakeLayoutPayload(PickPayload(i, k_TableUniqueLayouts * k_LargeTableScale)));
+    }
+
+    const auto flatSources = []
+    {
+        return ConcurrentContentInterner<std::string>{ &HashSourceString, k_HashName };
+    };
+    const auto nodeMapSources = []
+    {
+        return bench::NodeMapConcurrentInterner<std::string>{ &HashSourceString };
+    };
+    const auto flatLayouts = [] { return ContentInterner<ResourceList>{ &HashResourceList, k_HashName }; };
+    const auto nodeMapLayouts = [] { return bench::NodeMapInterner<ResourceList>{ &HashResourceList }; };
+
+    runner.Run("interner_table/sources_105_to_77/sharded_flat",
+               k_TableArtifactCount,
+               [&] { StageAndCommitThrough(flatSources, sources); });
+    runner.Run("interner_table/sources_105_to_77/sharded_node_map",
+               k_TableArtifactCount,
+               [&] { StageAndCommitThrough(nodeMapSources, sources); });
+    // One pass first and untimed. The large case grows the heap by tens of megabytes, and the first run
+    // of the pair would otherwise pay for all of it.
+    StageAndCommitThrough(nodeMapSources, largeSources);
+    runner.Run("interner_table/sources_10k_to_7k/sharded_flat",
+               largeSources.size(),
+               [&] { StageAndCommitThrough(flatSources, largeSources); });
+    runner.Run("interner_table/sources_10k_to_7k/sharded_node_map",
+               largeSources.size(),
+               [&] { StageAndCommitThrough(nodeMapSources, largeSources); });
+    runner.Run("interner_table/layouts_105_to_21/flat",
+               k_TableArtifactCount,
+               [&] { InternThrough(flatLayouts, layouts); });
+    runner.Run("interner_table/layouts_105_to_21/node_map",
+               k_TableArtifactCount,
+               [&] { InternThrough(nodeMapLayouts, layouts); });
+    runner.Run("interner_table/layouts_105k_to_21k/flat",
+               largeLayouts.size(),
+               [&] { InternThrough(flatLayouts, largeLayouts); });
+    runner.Run("interner_table/layouts_105k_to_21k/node_map",
+               largeLayouts.size(),
+               [&] { InternThrough(nodeMapLayouts, largeLayouts); });
+}
+
+void RunSizeExpressionBenchmarks(BenchRunner& runner)
+{
+    const std::array<SizeSymbol, 4u> symbols{ SizeSymbol{ .Name = "IFFT_SIZE", .Value = 256 },
+                                              SizeSymbol{ .Name = "TILE_COUNT", .Value = 8 },
+                                              SizeSymbol{ .Name = "CASCADE_COUNT", .Value = 3 },
+                                              SizeSymbol{ .Name = "LEVELS", .Value = 4 } };
+
+    // A failed parse returns early and logs, so check each expression once before the timing starts.
+    constexpr std::string_view k_Product = "IFFT_SIZE * 4";
+    constexpr std::string_view k_Nested =
+        "(IFFT_SIZE << 2) + (TILE_COUNT * 0x10) / (LEVELS + 1) - CASCADE_COUNT % 2";
+    if (!EvaluateSizeExpression(k_Product, symbols) || !EvaluateSizeExpression(k_Nested, symbols))
+    {
+        std::println(stderr, "[lodestone_bench] a size expression benchmark does not parse");
+        return;
+    }
+
+    runner.Run("size_expression/product",
+               1u,
+               [&] { KeepResult(EvaluateSizeExpression(k_Product, symbols)); });
+    runner.Run("size_expression/nested",
+               1u,
+               [&] { KeepResult(EvaluateSizeExpression(k_Nested, symbols)); });
+}
+
+void RunPermutationBenchmarks(BenchRunner& runner)
+{
+    const PermutationSpace space = bench::MakeSyntheticSpace(k_BenchAxisCount, k_BenchValuesPerAxis);
+    const CookResult<VariantSet> variants = space.EnumerateVariants();
+    if (!variants)
+    {
+        std::println(stderr, "[lodestone_bench] the synthetic space did not enumerate");
+        return;
+    }
+
+    const auto variantCount = static_cast<uint64_t>(variants->Variants.size());
+    runner.Run("permutation/enumerate_variants",
+               variantCount,
+               [&] { KeepResult(space.EnumerateVariants()); });
+    runner.Run("permutation/compute_variant_index",
+               variantCount,
+               [&]
+               {
+                   for (const VariantDescriptor& descriptor : variants->Variants)
+                   {
+                       KeepResult(space.ComputeVariantIndex(descriptor.Canonical));
+                   }
+               });
+}
+
+void RunManifestBenchmarks(BenchRunner& runner)
+{
+    const PermutationSpace space = bench::MakeSyntheticSpace(k_BenchAxisCount, k_BenchValuesPerAxis);
+    const CookedModule module = bench::MakeSyntheticModule(space, k_BenchEntryPointCount);
+    const AlignedManifest manifest = MakeAlignedManifest(EmitShaderManifest(module));
+
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(manifest.Bytes());
+    if (!opened)
+    {
+        std::println(stderr, "[lodestone_bench] the synthetic manifest did not open");
+        return;
+    }
+
+    const ShaderManifestView& view = opened.value();
+    const auto variantCount = static_cast<uint32_t>(view.Variants().size());
+    const auto entryPointCount = static_cast<uint16_t>(view.EntryPoints().size());
+
+    runner.Run("manifest/open", 1u, [&] { KeepResult(ShaderManifestView::Open(manifest.Bytes())); });
+    runner.Run("manifest/find_slot",
+               uint64_t{ variantCount } * entryPointCount,
+               [&]
+               {
+                   for (uint32_t variant = 0u; variant < variantCount; ++variant)
+                   {
+                       for (uint16_t entryPoint = 1u; entryPoint <= entryPointCount; ++entryPoint)
+                       {
+                           KeepResult(view.FindSlot(entryPoint, variant));
+                       }
+                   }
+               });
+
+    // One named query for each cooked variant, built outside the timed loop, so the loop measures
+    // canonicalization and the mixed-radix index alone.
+    std::vector<std::vector<ManifestAxisValue>> queries;
+    queries.reserve(module.Variants.size());
+    for (const LibraryVariant& variant : module.Variants)
+    {
+        std::vector<ManifestAxisValue>& query = queries.emplace_back();
+        for (size_t i = 0u; i < variant.Canonical.size(); ++i)
+        {
+            query.push_back(ManifestAxisValue::Named(variant.Canonical[i].Axis->Name,
+                                                     PermutationValueToInt64(variant.Canonical[i].Value)));
+        }
+    }
+
+    runner.Run("manifest/resolve_variant",
+               queries.size(),
+               [&]
+               {
+                   for (const std::vector<ManifestAxisValue>& query : queries)
+                   {
+                       KeepResult(view.ResolveVariant(query));
+                   }
+               });
+    std::vector<std::string_view> bindingNames;
+    for (const ManifestBinding& binding : view.Bindings())
+    {
+        bindingNames.push_back(view.String(binding.NameString));
+    }
+
+    runner.Run("manifest/find_binding_by_name",
+               bindingNames.size(),
+               [&]
+               {
+                   for (const std::string_view name : bindingNames)
+                   {
+                       KeepResult(view.FindBinding(name));
+                   }
+               });
+    runner.Run("manifest/source_provider_construct",
+               1u,
+               [&]
+               {
+                   const ManifestShaderSourceProvider provider{ view, 1u };
+                   KeepResult(provider.Generation());
+               });
+    runner.Run("manifest/source_provider_bindings_first",
+               uint64_t{ variantCount } * entryPointCount,
+               [&]
+               {
+                   const ManifestShaderSourceProvider provider{ view, 1u };
+                   for (uint32_t variant = 0u; variant < variantCount; ++variant)
+                   {
+                       for (uint16_t entryPoint = 1u; entryPoint <= entryPointCount; ++entryPoint)
+                       {
+                           KeepResult(provider.Bindings(entryPoint, variant));
+                       }
+                   }
+               });
+
+    // What a render thread pays to reach a source through a registry that a hot reload can swap. The
+    // bench owns the manifest bytes, so the provider is published with no backing.
+    ShaderProviderRegistry registry;
+    registry.Publish(std::make_unique<ManifestShaderSourceProvider>(view, 1u), nullptr);
+    ShaderProviderRegistry::Reader reader = registry.AttachReader();
+    runner.Run("manifest/registry_pin_source",
+               uint64_t{ variantCount } * entryPointCount,
+               [&]
+               {
+                   for (uint32_t variant = 0u; variant < variantCount; ++variant)
+                   {
+                       for (uint16_t entryPoint = 1u; entryPoint <= entryPointCount; ++entryPoint)
+                       {
+                           const ShaderProviderRegistry::PinnedProvider pinned = reader.Pin();
+                           KeepResult(pinned->Source(entryPoint, variant));
+                       }
+                   }
+               });
+}
+
+void RunScannerBenchmarks(BenchRunner& runner)
+{
+    const std::string wgsl = bench::MakeSyntheticWgsl("BenchCS", k_ScannedBindingCount, 1u);
+    runner.Run("wgsl/scan_bindings", 1u, [&] { KeepResult(ScanWgslBindings(wgsl)); });
+}
+
+void RunInfluenceBenchmarks(BenchRunner& runner)
+{
+    const PermutationSpace space = bench::MakeSyntheticSpace(k_BenchAxisCount, k_BenchValuesPerAxis);
+    const CookedModule module = bench::MakeSyntheticModule(space, k_BenchEntryPointCount);
+    runner.Run("influence/compute_axis_influence",
+               module.Variants.size(),
+               [&] { KeepResult(ComputeAxisInfluence(module)); });
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::optional<bench::BenchOptions> options = bench::ParseBenchOptions(argc, argv);
+    if (!options)
+    {
+        return 2;
+    }
+
+    BenchRunner runner{ *options };
+    RunInternerBenchmarks(runner);
+    RunInternerTableBenchmarks(runner);
+    RunSizeExpressionBenchmarks(runner);
+    RunPermutationBenchmarks(runner);
+    RunManifestBenchmarks(runner);
+    RunScannerBenchmarks(runner);
+    RunInfluenceBenchmarks(runner);
+    return runner.Finish();
+}
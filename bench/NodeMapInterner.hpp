@@ -0,0 +1,182 @@
+#pragma once
+#ifndef LODESTONE_BENCH_NODE_MAP_INTERNER_HPP
+#define LODESTONE_BENCH_NODE_MAP_INTERNER_HPP
+#include "model/ContentHash.hpp"
+#include "model/ContentInterner.hpp"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** The bucket map `ContentInterner` used before its flat table: one map node and one vector for each
+ * distinct hash. It stays here only as the baseline the flat table is measured against. It keeps the
+ * same provenance and the same counters, so the two differ in their table and in nothing else. */
+namespace lodestone::bench
+{
+
+template<typename PayloadType>
+class NodeMapInterner final
+{
+public:
+    using HashFunction = ContentHashValue (*)(const PayloadType&) noexcept;
+
+    explicit NodeMapInterner(HashFunction hash_function) noexcept
+        : hashFunction{ hash_function }
+    {
+        uniqueEntries.reserve(1024);
+        origins.reserve(1024);
+        buckets.reserve(256);
+    }
+
+    InternResult Intern(PayloadType payload, ProvenanceRecord origin)
+    {
+        ++statistics.ArtifactsSeen;
+
+        std::vector<uint32_t>& bucket = buckets[hashFunction(payload)];
+        for (uint32_t candidate : bucket)
+        {
+            ++statistics.ByteComparisons;
+            if (uniqueEntries[candidate] == payload)
+            {
+                origins[candidate].emplace_back(std::move(origin));
+                return InternResult{ candidate, false };
+            }
+            ++statistics.HashCollisions;
+        }
+
+        const auto index = static_cast<uint32_t>(uniqueEntries.size());
+        uniqueEntries.emplace_back(std::move(payload));
+        origins.emplace_back(std::vector<ProvenanceRecord>{ std::move(origin) });
+        statistics.UniqueEntries = index + 1u;
+        bucket.push_back(index);
+        return InternResult{ index, true };
+    }
+
+    [[nodiscard]] uint32_t UniqueCount() const noexcept
+    {
+        return static_cast<uint32_t>(uniqueEntries.size());
+    }
+
+private:
+    HashFunction hashFunction;
+    std::unordered_map<ContentHashValue, std::vector<uint32_t>> buckets;
+    std::vector<PayloadType> uniqueEntries;
+    std::vector<std::vector<ProvenanceRecord>> origins;
+    InternerStatistics statistics;
+};
+
+/** The shards `ConcurrentContentInterner` used before their flat tables: a map node and a vector of
+ * entry pointers for each distinct hash, and a deque of entries. Stage and commit follow the same rules,
+ * so the two differ in their shards and in nothing else. */
+template<typename PayloadType>
+class NodeMapConcurrentInterner final
+{
+private:
+    struct Entry;
+
+public:
+    using HashFunction = ContentHashValue (*)(const PayloadType&) noexcept;
+
+    static constexpr uint32_t k_ShardCount{ 16u };
+
+    struct Ticket
+    {
+        Entry* Staged{ nullptr };
+    };
+
+    explicit NodeMapConcurrentInterner(HashFunction hash_function) noexcept
+        : hashFunction{ hash_function },
+          shards{ std::make_unique<std::array<Shard, k_ShardCount>>() }
+    {
+        committed.reserve(1024);
+    }
+
+    [[nodiscard]] Ticket Stage(const PayloadType& payload)
+    {
+        const ContentHashValue hash = hashFunction(payload);
+        Shard& shard = (*shards)[hash % k_ShardCount];
+        const std::scoped_lock lock{ shard.Mutex };
+        Bucket& bucket = shard.Buckets[hash];
+        for (Entry* candidate : bucket.Entries)
+        {
+            if (candidate->Payload == payload)
+            {
+                return Ticket{ candidate };
+            }
+        }
+
+        Entry& added = shard.Entries.emplace_back(payload, &bucket);
+        bucket.Entries.push_back(&added);
+        return Ticket{ &added };
+    }
+
+    InternResult Commit(Ticket ticket, ProvenanceRecord origin)
+    {
+        ++statistics.ArtifactsSeen;
+
+        Entry& entry = *ticket.Staged;
+        const bool wasNew = entry.Index == k_Uncommitted;
+        if (wasNew)
+        {
+            entry.Index = static_cast<uint32_t>(committed.size());
+            entry.BucketRank = entry.Owner->CommittedCount++;
+            committed.push_back(&entry);
+            statistics.UniqueEntries = static_cast<uint32_t>(committed.size());
+        }
+
+        statistics.HashCollisions += entry.BucketRank;
+        statistics.ByteComparisons += entry.BucketRank + (wasNew ? 0u : 1u);
+        provenance.Record(entry.Index, origin);
+        return InternResult{ entry.Index, wasNew };
+    }
+
+    [[nodiscard]] uint32_t UniqueCount() const noexcept
+    {
+        return static_cast<uint32_t>(committed.size());
+    }
+
+private:
+    static constexpr uint32_t k_Uncommitted{ std::numeric_limits<uint32_t>::max() };
+
+    struct Bucket
+    {
+        std::vector<Entry*> Entries;
+        uint32_t CommittedCount{ 0u };
+    };
+
+    struct Entry
+    {
+        Entry(const PayloadType& payload, Bucket* owner)
+            : Payload{ payload },
+              Owner{ owner }
+        {
+        }
+
+        PayloadType Payload;
+        Bucket* Owner;
+        uint32_t Index{ k_Uncommitted };
+        uint32_t BucketRank{ 0u };
+    };
+
+    struct Shard
+    {
+        std::mutex Mutex;
+        std::unordered_map<ContentHashValue, Bucket> Buckets;
+        std::deque<Entry> Entries;
+    };
+
+    HashFunction hashFunction;
+    std::unique_ptr<std::array<Shard, k_ShardCount>> shards;
+    std::vector<Entry*> committed;
+    ProvenanceLog provenance;
+    InternerStatistics statistics;
+};
+
+} // namespace lodestone::bench
+
+#endif // !LODESTONE_BENCH_NODE_MAP_INTERNER_HPP
@@ -0,0 +1,231 @@
+#include "SyntheticShaders.hpp"
+#include "CookerErrors.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "model/ShaderDataSchema.hpp"
+#include "permute/PermutationAssignment.hpp"
+#include "permute/PermutationAxis.hpp"
+#include "permute/PermutationValue.hpp"
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lodestone::bench
+{
+
+namespace
+{
+
+    /** Every synthetic variant declares this many buffers, the uniform block included. */
+    constexpr uint32_t k_SyntheticBindingCount{ 6u };
+    /** Helper functions in each source. Eight of them bring the text to about 4KB. */
+    constexpr uint32_t k_SyntheticHelperCount{ 8u };
+
+    /** splitmix64. Spreads a small seed over all 64 bits, so neighbouring seeds differ everywhere. */
+    uint64_t MixSeed(uint64_t seed) noexcept
+    {
+        seed += 0x9E3779B97F4A7C15ull;
+        seed = (seed ^ (seed >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        seed = (seed ^ (seed >> 27u)) * 0x94D049BB133111EBull;
+        return seed ^ (seed >> 31u);
+    }
+
+    ReflectedBinding MakeBinding(uint32_t binding_index)
+    {
+        ReflectedBinding binding;
+        binding.Name = binding_index == 0u ? std::string{ "Params" } : std::format("Buffer{}", binding_index);
+        binding.Placement = BoundPlacement{ .Group = 0u, .Binding = binding_index };
+        binding.Kind = binding_index == 0u ? BindingKind::UniformBuffer : BindingKind::StorageBuffer;
+        binding.ElementStride = 16u;
+        binding.ArrayCount = 1u;
+        binding.Shape = ResourceShape::Buffer;
+        return binding;
+    }
+
+    /** Folds the values of the axes one entry point reads into its seed, so the entry point's text
+     * changes with those axes and with no other. */
+    uint64_t MakeEntryPointSeed(const CanonicalAssignment& canonical,
+                                uint32_t entry_point,
+                                uint32_t entry_point_count)
+    {
+        uint64_t seed = entry_point;
+        for (size_t axis = entry_point; axis < canonical.size(); axis += entry_point_count)
+        {
+            seed = MixSeed(seed ^ static_cast<uint64_t>(PermutationValueToInt64(canonical[axis].Value)));
+        }
+
+        return seed;
+    }
+
+    CompiledVariant MakeVariant(const VariantDescriptor& descriptor, uint32_t entry_point_count)
+    {
+        CompiledVariant variant;
+        variant.VariantIndex = static_cast<uint32_t>(descriptor.Index);
+        variant.VariantSuffix = MakeAssignmentSuffix(descriptor.Active);
+        variant.VariantDescription = DescribeAssignment(descriptor.Active);
+
+        // The first axis sizes every buffer, so the footprint lists dedupe as often as that axis repeats.
+        const auto sizeShift = static_cast<uint64_t>(PermutationValueToInt64(descriptor.Canonical[0].Value));
+        const uint64_t elementCount = uint64_t{ 64u } << sizeShift;
+        for (uint32_t i = 0u; i < k_SyntheticBindingCount; ++i)
+        {
+            variant.Bindings.push_back(MakeBinding(i));
+            variant.Footprints.emplace_back(BufferFootprint{ .ElementCount = elementCount });
+        }
+
+        for (uint32_t e = 0u; e < entry_point_count; ++e)
+        {
+            CompiledEntryPoint entryPoint;
+            entryPoint.Name = std::format("Bench{}CS", e);
+            const uint64_t seed = MakeEntryPointSeed(descriptor.Canonical, e, entry_point_count);
+            entryPoint.Code = MakeSyntheticWgsl(entryPoint.Name, k_SyntheticBindingCount, seed);
+            entryPoint.Reflection.Name = entryPoint.Name;
+            entryPoint.Reflection.Stage = ShaderStageKind::Compute;
+            entryPoint.Reflection.Workgroup = WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u };
+            for (uint32_t i = 0u; i < k_SyntheticBindingCount; ++i)
+            {
+                if (i == 0u || i % entry_point_count == e)
+                {
+                    entryPoint.Reflection.UsedBindingIndices.push_back(i);
+                }
+            }
+            variant.EntryPoints.push_back(std::move(entryPoint));
+        }
+
+        return variant;
+    }
+
+} // namespace
+
+std::string MakeSyntheticWgsl(std::string_view entry_point, uint32_t binding_count, uint64_t variant_seed)
+{
+    uint64_t state = MixSeed(variant_seed);
+    const auto nextConstant = [&state]
+    {
+        state = MixSeed(state);
+        return static_cast<double>(state % 100000u) / 1000.0;
+    };
+
+    std::string text;
+    text.reserve(4096u);
+    text += "struct Params_std140_0\n{\n    @align(16) count_0 : u32,\n    scale_0 : f32,\n"
+            "    offset_0 : vec2<f32>,\n    @align(16) tint_0 : vec4<f32>,\n};\n\n";
+    text += "@group(0) @binding(0) var<uniform> Params_0 : Params_std140_0;\n\n";
+    for (uint32_t i = 1u; i < binding_count; ++i)
+    {
+        const std::string_view access = i + 1u == binding_count ? "read_write" : "read";
+        text += std::format(
+            "@group(0) @binding({0}) var<storage, {1}> Buffer{0}_0 : array<vec4<f32>>;\n\n", i, access);
+    }
+
+    // Constants come from the seed, so two seeds give two sources of the same length and shape.
+    for (uint32_t helper = 0u; helper < k_SyntheticHelperCount; ++helper)
+    {
+        text += std::format("fn helper{0}_0(value_{0} : vec4<f32>, index_{0} : u32) -> vec4<f32>\n{{\n",
+                            helper);
+        text += std::format(
+            "    var result_{0} : vec4<f32> = value_{0} * vec4<f32>({1:.3f}, {2:.3f}, {3:.3f}, 1.0);\n",
+            helper,
+            nextConstant(),
+            nextConstant(),
+            nextConstant());
+        text += std::format("    if (index_{0} & {1}u) != 0u\n    {{\n", helper, (state % 7u) + 1u);
+        text += std::format("        result_{0} = result_{0} + Params_0.tint_0 * {1:.3f};\n    }}\n",
+                            helper,
+                            nextConstant());
+        text += std::format("    let bias_{0} : f32 = Params_0.scale_0 * {1:.3f} + Params_0.offset_0.x;\n",
+                            helper,
+                            nextConstant());
+        text += std::format(
+            "    return clamp(result_{0} + vec4<f32>(bias_{0}), vec4<f32>(0.0), vec4<f32>({1:.3f}));\n}}\n\n",
+            helper,
+            nextConstant());
+    }
+
+    text += "@compute\n@workgroup_size(64, 1, 1)\n";
+    text += std::format("fn {}(@builtin(global_invocation_id) dispatchThreadId_0 : vec3<u32>)\n{{\n",
+                        entry_point);
+    text += "    let index_0 : u32 = dispatchThreadId_0.x;\n";
+    text += "    if index_0 >= Params_0.count_0\n    {\n        return;\n    }\n";
+    text += "    var value_0 : vec4<f32> = vec4<f32>(0.0);\n";
+    for (uint32_t i = 1u; i + 1u < binding_count; ++i)
+    {
+        text += std::format("    value_0 = value_0 + helper{}_0(Buffer{}_0[index_0], index_0);\n",
+                            i % k_SyntheticHelperCount, i);
+    }
+    for (uint32_t helper = 0u; helper < k_SyntheticHelperCount; ++helper)
+    {
+        text += std::format("    value_0 = helper{}_0(value_0, index_0 + {}u);\n", helper, helper);
+    }
+    if (binding_count > 1u)
+    {
+        text += std::format("    Buffer{}_0[index_0] = value_0;\n", binding_count - 1u);
+    }
+    text += "    return;\n}\n";
+    return text;
+}
+
+PermutationSpace MakeSyntheticSpace(uint32_t axis_count, uint32_t values_per_axis)
+{
+    std::vector<PermutationValue> values;
+    for (uint32_t i = 0u; i < values_per_axis && i < PermutationAxis::k_MaxValues; ++i)
+    {
+        values.emplace_back(i);
+    }
+
+    std::vector<PermutationAxis> axes;
+    for (uint32_t i = 0u; i < axis_count; ++i)
+    {
+        axes.emplace_back(
+            std::format("BENCH_AXIS_{}", i), values, PermutationAxis::k_NoParent, PermutationValue{});
+    }
+
+    const auto detailIndex = static_cast<int32_t>(axes.size());
+    axes.emplace_back("BENCH_DETAIL",
+                      std::vector<PermutationValue>{ PermutationValue{ false }, PermutationValue{ true } },
+                      PermutationAxis::k_NoParent,
+                      PermutationValue{});
+    axes.emplace_back("BENCH_DETAIL_LEVEL",
+                      std::vector<PermutationValue>{
+                          PermutationValue{ 1u }, PermutationValue{ 2u }, PermutationValue{ 4u } },
+                      detailIndex,
+                      PermutationValue{ true });
+
+    return PermutationSpace{ "BenchSpace", axes };
+}
+
+CookedModule MakeSyntheticModule(const PermutationSpace& space, uint32_t entry_point_count)
+{
+    InternedModule module;
+    module.Name = "BenchModule";
+    module.Space = &space;
+    module.SpaceSize = static_cast<uint32_t>(space.ComputeVariantSpaceSize());
+    for (uint32_t e = 0u; e < entry_point_count; ++e)
+    {
+        module.EntryPoints.push_back(
+            LibraryEntryPoint{ .Name = std::format("Bench{}CS", e), .Stage = ShaderStageKind::Compute });
+    }
+
+    const CookResult<VariantSet> variants = space.EnumerateVariants();
+    if (!variants || entry_point_count == 0u)
+    {
+        return FreezeModuleTables(std::move(module));
+    }
+
+    for (const VariantDescriptor& descriptor : variants->Variants)
+    {
+        const CompiledVariant variant = MakeVariant(descriptor, entry_point_count);
+        if (!AppendVariantToModule(module, variant, descriptor.Canonical))
+        {
+            module.Variants.clear();
+            break;
+        }
+    }
+
+    return FreezeModuleTables(std::move(module));
+}
+
+} // namespace lodestone::bench
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef LODESTONE_BENCH_SYNTHETIC_SHADERS_HPP
+#define LODESTONE_BENCH_SYNTHETIC_SHADERS_HPP
+#include "model/CookedLibrary.hpp"
+#include "permute/PermutationSpace.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/** Inputs for the benchmarks, built in memory so no benchmark reads a file or needs Slang.
+ *
+ * The shapes follow what a real cook produces: WGSL text of a few kilobytes in the style Slang emits,
+ * spaces of a few axes with one dependent axis, and modules where each entry point reads only some of
+ * the axes. That last part matters, because the interner's duplicate rate depends on it. */
+namespace lodestone::bench
+{
+
+/** Compute WGSL of about 4KB. One uniform block, then storage buffers up to `binding_count`. The same
+ * seed always gives the same text, and a different seed gives different constants. */
+std::string MakeSyntheticWgsl(std::string_view entry_point, uint32_t binding_count, uint64_t variant_seed);
+
+/** `axis_count` uint axes of `values_per_axis` values each, then a bool axis, then an axis that is active
+ * only when the bool is true. */
+PermutationSpace MakeSyntheticSpace(uint32_t axis_count, uint32_t values_per_axis);
+
+/** Every variant of `space`, interned and frozen the way the cook does it. Entry point `e` reads the
+ * axes whose index is `e` modulo `entry_point_count`, so its source repeats across the other axes. An
+ * empty module means the space did not enumerate. */
+CookedModule MakeSyntheticModule(const PermutationSpace& space, uint32_t entry_point_count);
+
+} // namespace lodestone::bench
+
+#endif // !LODESTONE_BENCH_SYNTHETIC_SHADERS_HPP
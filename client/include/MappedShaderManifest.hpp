@@ -0,0 +1,87 @@
+#pragma once
+#ifndef LODESTONE_MAPPED_SHADER_MANIFEST_HPP
+#define LODESTONE_MAPPED_SHADER_MANIFEST_HPP
+#include "ShaderManifest.hpp"
+#include "ShaderPack.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+/**
+ * @brief A manifest file mapped read-only into memory, and the view over it.
+ *
+ * Opening one maps the file and checks the header and the section bounds, and nothing more. The system
+ * reads a page from disk the first time something touches it. A program that asks for a few variants
+ * reads the header, the index tables, and those variants' sources; the text of every other variant
+ * stays on disk.
+ *
+ * The mapping starts on a page boundary, so it always meets the 8-byte alignment that
+ * `ShaderManifestView::Open` requires. The check still runs, as it does for any span.
+ *
+ * The view, and every name and source it hands out, points into the mapping. They stay valid until
+ * this object is destroyed or assigned to, and moving it moves the mapping without changing its address.
+ * The file must not change while it is mapped.
+ *
+ * `MappedShaderPack` does the same for a shader pack: one mapping for every module of a library.
+ */
+namespace lodestone
+{
+
+class MappedShaderManifest final
+{
+public:
+    MappedShaderManifest() noexcept;
+    ~MappedShaderManifest();
+
+    MappedShaderManifest(const MappedShaderManifest&) = delete;
+    MappedShaderManifest& operator=(const MappedShaderManifest&) = delete;
+    MappedShaderManifest(MappedShaderManifest&& other) noexcept;
+    MappedShaderManifest& operator=(MappedShaderManifest&& other) noexcept;
+
+    static ManifestResult<MappedShaderManifest> Open(const std::filesystem::path& path) noexcept;
+    /** @brief Maps a manifest cooked with `--share-sources`, reading its text through the mapped library
+     * source file. `shared_sources` must outlive the result. */
+    static ManifestResult<MappedShaderManifest> Open(const std::filesystem::path& path,
+                                                     const MappedShaderManifest& shared_sources) noexcept;
+
+    [[nodiscard]] const ShaderManifestView& View() const noexcept;
+    /** @brief The whole mapped file. Empty for a default-constructed or moved-from object. */
+    [[nodiscard]] std::span<const std::byte> Bytes() const noexcept;
+
+private:
+    /** Maps the file, without opening a view over it. */
+    static ManifestResult<MappedShaderManifest> Map(const std::filesystem::path& path) noexcept;
+    void Unmap() noexcept;
+
+    std::span<const std::byte> mapping;
+    ShaderManifestView view;
+};
+
+class MappedShaderPack final
+{
+public:
+    MappedShaderPack() noexcept;
+    ~MappedShaderPack();
+
+    MappedShaderPack(const MappedShaderPack&) = delete;
+    MappedShaderPack& operator=(const MappedShaderPack&) = delete;
+    MappedShaderPack(MappedShaderPack&& other) noexcept;
+    MappedShaderPack& operator=(MappedShaderPack&& other) noexcept;
+
+    /** @brief Maps the pack and checks its header and table of contents. Opens no module: `Find` on the
+     * view does that, one module at a time. */
+    static ManifestResult<MappedShaderPack> Open(const std::filesystem::path& path) noexcept;
+
+    [[nodiscard]] const ShaderPackView& View() const noexcept;
+    [[nodiscard]] std::span<const std::byte> Bytes() const noexcept;
+
+private:
+    void Unmap() noexcept;
+
+    std::span<const std::byte> mapping;
+    ShaderPackView view;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_MAPPED_SHADER_MANIFEST_HPP
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef LODESTONE_PUBLISH_ONCE_TABLE_HPP
+#define LODESTONE_PUBLISH_ONCE_TABLE_HPP
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief A fixed number of slots, each set at most once and read without a lock.
+ *
+ * A reader that finds a slot empty builds the value itself and publishes it. Two threads can race to
+ * publish one slot: the first wins, the other's value is dropped, and both return the winner. A value
+ * never moves or changes once published, so a pointer to it stays valid until the table is destroyed.
+ *
+ * The slots live in pages that are allocated the first time one of their slots is published. A table
+ * nobody reads costs one pointer for each page of `k_PageSize` slots, so a provider over a large
+ * manifest opens without touching memory in proportion to its size.
+ */
+namespace lodestone
+{
+
+template<typename T>
+class PublishOnceTable final
+{
+public:
+    static constexpr size_t k_PageSize = 1024u;
+
+    explicit PublishOnceTable(size_t slot_count)
+        : pageCount{ (slot_count + k_PageSize - 1u) / k_PageSize },
+          pages{ std::make_unique<std::atomic<Page*>[]>(pageCount) }
+    {
+    }
+
+    ~PublishOnceTable()
+    {
+        for (size_t i = 0u; i < pageCount; ++i)
+        {
+            Page* page = pages[i].load(std::memory_order_acquire);
+            if (page == nullptr)
+            {
+                continue;
+            }
+
+            for (std::atomic<T*>& slot : *page)
+            {
+                delete slot.load(std::memory_order_acquire);
+            }
+
+            delete page;
+        }
+    }
+
+    PublishOnceTable(const PublishOnceTable&) = delete;
+    PublishOnceTable& operator=(const PublishOnceTable&) = delete;
+
+    /** @brief The published value, or nullptr when nothing is published there yet. */
+    [[nodiscard]] const T* Find(size_t index) const noexcept
+    {
+        const Page* page = pages[index / k_PageSize].load(std::memory_order_acquire);
+        return page != nullptr ? (*page)[index % k_PageSize].load(std::memory_order_acquire) : nullptr;
+    }
+
+    /** @brief Publishes `value` unless another thread got there first, and returns whichever won. */
+    const T* Publish(size_t index, std::unique_ptr<T> value) const
+    {
+        std::atomic<T*>& slot = (*PageFor(index))[index % k_PageSize];
+        T* expected = nullptr;
+        if (slot.compare_exchange_strong(
+                expected, value.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return value.release();
+        }
+
+        return expected;
+    }
+
+private:
+    using Page = std::array<std::atomic<T*>, k_PageSize>;
+
+    Page* PageFor(size_t index) const
+    {
+        std::atomic<Page*>& slot = pages[index / k_PageSize];
+        Page* page = slot.load(std::memory_order_acquire);
+        if (page != nullptr)
+        {
+            return page;
+        }
+
+        // Value-initialized, so every slot of a new page starts empty.
+        auto created = std::make_unique<Page>();
+        if (slot.compare_exchange_strong(
+                page, created.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return created.release();
+        }
+
+        return page;
+    }
+
+    size_t pageCount{ 0u };
+    /** Publishing writes through these from const members, which is what makes a lazy table const. */
+    std::unique_ptr<std::atomic<Page*>[]> pages;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_PUBLISH_ONCE_TABLE_HPP
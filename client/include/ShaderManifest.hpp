@@ -1,11 +1,15 @@
 #pragma once
 #ifndef LODESTONE_SHADER_MANIFEST_HPP
 #define LODESTONE_SHADER_MANIFEST_HPP
+#include "PublishOnceTable.hpp"
 #include "ShaderLibraryTypes.hpp"
+#include "SourceBlockCodec.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <memory>
 #include <span>
+#include <string>
 #include <string_view>
 #include <type_traits>
 #include <vector>
@@ -20,15 +24,54 @@
  * of spans over one byte span. It allocates nothing to open a file, and it relocates nothing.
  *
  * The byte span must outlive every view and every provider that reads it. Names and shader text point
- * into that span.
+ * into that span. `MappedShaderManifest` maps a file as that span, so only the pages a program reads
+ * ever come from disk.
+ *
+ * A library cook can move the shader text of every module into one library source file, so text that
+ * two modules share is stored once. That file is itself a manifest that holds only sources. A module
+ * manifest that uses it sets `k_ManifestSharedSources`, holds no source section, and opens through the
+ * `Open` overload that takes the library source view. Both spans must then outlive the view.
+ *
+ * A manifest can also hold its sources as chunks. Variants of one shader differ in a few functions
+ * and share the rest of their text, so the cooker can cut each source into chunks at content-defined
+ * boundaries and store each unique chunk once. Such a manifest sets `k_ManifestChunkedSources`: its
+ * source table then holds chunks, and each source is a run of chunk indices. `SourceChunks` reads a
+ * source in place as its list of chunks, and `AssembleSource` copies it into a caller's buffer.
+ *
+ * Finally, a manifest can store each entry of its source table compressed, as blocks that decode
+ * alone (see SourceBlockCodec.hpp). It sets `k_ManifestCompressedSources`, and no text is in place:
+ * `AssembleSource` decodes one source into a caller's buffer of `SourceSize` bytes, and touches no
+ * other source. A manifest without the flag keeps the zero-copy path. The blocks may be encoded against
+ * a dictionary the cooker trained from the sources, stored once in its own section; decoding a source
+ * then reads the dictionary and that source's blocks, still nothing else.
+ *
+ * Entry points, axes and bindings can be found by name in constant time. The cooker builds a minimal
+ * perfect hash over the names of each kind (hash and displace: a name's hash picks a bucket, and the
+ * bucket's displacement picks the name's slot), so a lookup is one hash, two table reads and one
+ * string compare, however many names the module has.
+ *
+ * The variant index maps a dense index to the variant that holds it. A space with deep dependent axes
+ * leaves most dense indices empty, so the cooker picks the smaller of two encodings for each module: a
+ * table of one variant number for each dense index, or a bitvector with a running count for each 64
+ * bits, which sets `k_ManifestSparseVariantIndex`. Either way `FindVariant` reads one record.
  */
 namespace lodestone
 {
 
 inline constexpr uint32_t k_ShaderManifestMagic = 0x48535856u;
-inline constexpr uint32_t k_ShaderManifestVersion = 1u;
+inline constexpr uint32_t k_ShaderManifestVersion = 8u;
 /** A slot in the variant index table that no variant occupies. */
 inline constexpr uint32_t k_ShaderManifestNoIndex = 0xFFFFFFFFu;
+/** The most axes `ShaderManifestView::ResolveVariant` canonicalizes. */
+inline constexpr uint32_t k_MaxQueryAxes = 64u;
+/** A header flag: slots index the source table of a library source file, not a section of this file. */
+inline constexpr uint32_t k_ManifestSharedSources = 0x1u;
+/** A header flag: the source table holds chunks, and the source chunk lists say which make each source. */
+inline constexpr uint32_t k_ManifestChunkedSources = 0x2u;
+/** A header flag: each source table entry is stored as compressed blocks, listed in the block table. */
+inline constexpr uint32_t k_ManifestCompressedSources = 0x4u;
+/** A header flag: the variant index is a rank bitvector, and the variant table is in dense index order. */
+inline constexpr uint32_t k_ManifestSparseVariantIndex = 0x8u;
 
 enum class ShaderManifestError : uint8_t
 {
@@ -43,6 +86,18 @@ enum class ShaderManifestError : uint8_t
     /** The byte span does not start on an 8-byte boundary. The reader maps records in place, so it
      * cannot accept a span that would make a 64-bit field unaligned. */
     Misaligned = 8,
+    /** The manifest keeps its sources in a library source file, and `Open` was not given one. */
+    SharedSourcesMissing = 9,
+    /** `MappedShaderManifest` could not open the file. */
+    FileOpenFailed = 10,
+    /** The file opened, but the system would not map it. */
+    FileMapFailed = 11,
+    /** A shader pack holds no module of the name asked for. */
+    ModuleNotFound = 12,
+    /** A variant query names an axis the manifest does not have. */
+    AxisNotFound = 13,
+    /** A variant query gives an axis a value the axis does not take. */
+    AxisValueNotFound = 14,
 };
 
 template<typename T>
@@ -96,6 +151,9 @@ struct ShaderManifestHeader
     uint32_t VariantCount{ 0u };
     uint32_t VariantIndexTableOffset{ 0u };
     uint32_t VariantIndexCount{ 0u };
+    /** Empty unless `k_ManifestSparseVariantIndex` is set, and then the dense table above is empty. */
+    uint32_t VariantRankTableOffset{ 0u };
+    uint32_t VariantRankCount{ 0u };
 
     uint32_t AxisTableOffset{ 0u };
     uint32_t AxisCount{ 0u };
@@ -110,6 +168,32 @@ struct ShaderManifestHeader
     uint32_t ColorTargetCount{ 0u };
     uint32_t UniformMemberTableOffset{ 0u };
     uint32_t UniformMemberCount{ 0u };
+
+    /** Empty unless `k_ManifestChunkedSources` is set. A chunk list is a run of the chunk index table,
+     * and each chunk index names an entry of the source table. */
+    uint32_t SourceChunkListTableOffset{ 0u };
+    uint32_t SourceChunkListCount{ 0u };
+    uint32_t ChunkIndexTableOffset{ 0u };
+    uint32_t ChunkIndexCount{ 0u };
+    /** Empty unless `k_ManifestCompressedSources` is set. */
+    uint32_t SourceBlockTableOffset{ 0u };
+    uint32_t SourceBlockCount{ 0u };
+    /** Bytes of text every block of the file was encoded against. Empty when the blocks need none. */
+    uint32_t SourceDictionaryOffset{ 0u };
+    uint32_t SourceDictionarySize{ 0u };
+
+    /** One `ManifestNameLookup` for each `ManifestNameKind`, or none in a library source file. Each is
+     * a run of the bucket table and a run of the name slot table. */
+    uint32_t NameLookupTableOffset{ 0u };
+    uint32_t NameLookupCount{ 0u };
+    uint32_t NameBucketTableOffset{ 0u };
+    uint32_t NameBucketCount{ 0u };
+    uint32_t NameSlotTableOffset{ 0u };
+    uint32_t NameSlotCount{ 0u };
+
+    /** Any of the `k_Manifest*Sources` flags, or zero. */
+    uint32_t Flags{ 0u };
+    uint32_t Reserved{ 0u };
 };
 
 struct ManifestStringRef
@@ -118,12 +202,23 @@ struct ManifestStringRef
     uint32_t Length{ 0u };
 };
 
+/** @brief One source table entry. `Length` is always the length of its text. `Offset` is where the text
+ * starts in the source blob, or, with `k_ManifestCompressedSources`, the index of the entry's first block. */
 struct ManifestSourceRef
 {
     uint32_t Offset{ 0u };
     uint32_t Length{ 0u };
 };
 
+/** @brief One compressed block in the source blob. An entry's blocks follow each other in the table, and
+ * each decodes to `k_SourceBlockSize` bytes except the entry's last, which decodes to what is left. A block
+ * whose `CompressedSize` equals the size it decodes to is stored as it is: it did not compress. */
+struct ManifestSourceBlock
+{
+    uint32_t Offset{ 0u };
+    uint32_t CompressedSize{ 0u };
+};
+
 /** @brief One resource binding. Field order puts the 8-byte members first, so the record needs no
  * padding on any target and its size stays the same on every compiler. */
 struct ManifestBinding
@@ -238,14 +333,104 @@ struct ManifestVariant
     uint32_t FootprintListIndex{ 0u };
 };
 
+/** @brief 64 dense indices of a sparse variant index: which of them hold a variant, and how many
+ * variants the indices before them hold. The variant at a live index is the variant table entry at
+ * `RankBefore` plus the live bits below it. */
+struct ManifestVariantRank
+{
+    uint64_t Live{ 0u };
+    uint32_t RankBefore{ 0u };
+    uint32_t Reserved{ 0u };
+};
+
+/** @brief 64-bit FNV-1a of a name. A variant query names an axis by it, and a shader pack keys its
+ * modules by it, so a lookup compares integers and not strings. */
+constexpr uint64_t HashManifestName(std::string_view name) noexcept
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const char character : name)
+    {
+        hash ^= static_cast<uint8_t>(character);
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+/** @brief The tables a name can be looked up in, and the index of each one's `ManifestNameLookup`. */
+enum class ManifestNameKind : uint32_t
+{
+    EntryPoint = 0,
+    Axis = 1,
+    Binding = 2,
+};
+
+inline constexpr uint32_t k_ManifestNameKindCount = 3u;
+
+/** @brief The perfect hash over the names of one kind. Each bucket holds a displacement, and each slot
+ * the index of one record in that kind's table. No bucket or slot means the kind has no names. */
+struct ManifestNameLookup
+{
+    uint32_t FirstBucket{ 0u };
+    uint32_t BucketCount{ 0u };
+    uint32_t FirstSlot{ 0u };
+    uint32_t SlotCount{ 0u };
+};
+
+/** @brief The bucket of a name hash. The cooker and the reader share these two functions. */
+constexpr uint32_t ManifestNameBucket(uint64_t name_hash, uint32_t bucket_count) noexcept
+{
+    return static_cast<uint32_t>((name_hash >> 32u) % bucket_count);
+}
+
+/** @brief The slot of a name hash under one displacement: a 64-bit finalizer over the hash mixed with
+ * the displacement, so each displacement tried scatters a bucket's names anew. */
+constexpr uint32_t ManifestNameSlot(uint64_t name_hash, uint32_t displacement, uint32_t slot_count) noexcept
+{
+    uint64_t mixed = name_hash ^ (static_cast<uint64_t>(displacement) * 0x9E3779B97F4A7C15ull);
+    mixed = (mixed ^ (mixed >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    mixed = (mixed ^ (mixed >> 27u)) * 0x94D049BB133111EBull;
+    mixed ^= mixed >> 31u;
+    return static_cast<uint32_t>(mixed % slot_count);
+}
+
+/** One permutation axis, with what canonicalization needs: the generated `Canonicalize` gives an axis
+ * its first value whenever its parent does not hold the value that turns it on. */
 struct ManifestAxis
 {
+    /** `HashManifestName` of the axis name. */
+    uint64_t NameHash{ 0u };
     uint32_t NameString{ 0u };
     uint32_t FirstValue{ 0u };
     uint32_t ValueCount{ 0u };
+    /** The axis this one depends on, or `k_ShaderManifestNoIndex` for an axis that is always on. */
+    uint32_t ParentAxis{ k_ShaderManifestNoIndex };
+    /** The index, among the parent's values, of the one that turns this axis on.
+     * `k_ShaderManifestNoIndex` when the parent cannot take it, and the axis is never on. */
+    uint32_t RequiredParentValue{ k_ShaderManifestNoIndex };
     uint32_t Reserved{ 0u };
 };
 
+/** @brief One axis of a partial variant assignment, and the value the caller wants for it. */
+struct ManifestAxisValue
+{
+    /** An index into `Axes()`, or the `HashManifestName` of the axis name when `ByName` is set. */
+    uint64_t Axis{ 0u };
+    /** The value as the manifest stores it: a bool as 0 or 1, an integer as itself. */
+    int64_t Value{ 0 };
+    bool ByName{ false };
+
+    static constexpr ManifestAxisValue Indexed(uint32_t axis_index, int64_t value) noexcept
+    {
+        return ManifestAxisValue{ .Axis = axis_index, .Value = value, .ByName = false };
+    }
+
+    static constexpr ManifestAxisValue Named(std::string_view axis_name, int64_t value) noexcept
+    {
+        return ManifestAxisValue{ .Axis = HashManifestName(axis_name), .Value = value, .ByName = true };
+    }
+};
+
 /** The reader reinterprets manifest bytes as records, so a record must be a bag of bytes.
  *
  * A record that held a pointer, a `std::string`, or a virtual table would make the reader read a
@@ -260,6 +445,7 @@ inline constexpr bool k_IsManifestRecord =
 static_assert(k_IsManifestRecord<ShaderManifestHeader>);
 static_assert(k_IsManifestRecord<ManifestStringRef>);
 static_assert(k_IsManifestRecord<ManifestSourceRef>);
+static_assert(k_IsManifestRecord<ManifestSourceBlock>);
 static_assert(k_IsManifestRecord<ManifestBinding>);
 static_assert(k_IsManifestRecord<ManifestRun>);
 static_assert(k_IsManifestRecord<ManifestFootprint>);
@@ -270,7 +456,65 @@ static_assert(k_IsManifestRecord<ManifestUniformMember>);
 static_assert(k_IsManifestRecord<ManifestColorTarget>);
 static_assert(k_IsManifestRecord<ManifestRaster>);
 static_assert(k_IsManifestRecord<ManifestVariant>);
+static_assert(k_IsManifestRecord<ManifestVariantRank>);
 static_assert(k_IsManifestRecord<ManifestAxis>);
+static_assert(k_IsManifestRecord<ManifestNameLookup>);
+
+/**
+ * @brief The text of one source, as the pieces the manifest stores it in. Each piece points into the
+ * manifest bytes, so reading a source this way copies nothing. A source the manifest stores whole is
+ * one piece.
+ */
+class ManifestSourceChunks final
+{
+public:
+    class Iterator final
+    {
+    public:
+        Iterator(const ManifestSourceChunks* source_chunks, uint32_t chunk_index) noexcept
+            : chunks{ source_chunks },
+              index{ chunk_index }
+        {
+        }
+
+        [[nodiscard]] std::string_view operator*() const noexcept
+        {
+            return (*chunks)[index];
+        }
+
+        Iterator& operator++() noexcept
+        {
+            ++index;
+            return *this;
+        }
+
+        [[nodiscard]] bool operator==(const Iterator& other) const noexcept = default;
+
+    private:
+        const ManifestSourceChunks* chunks;
+        uint32_t index;
+    };
+
+    ManifestSourceChunks() noexcept = default;
+    /** With `chunk_indices` empty, the pieces are `refs` themselves, in order. */
+    ManifestSourceChunks(std::span<const ManifestSourceRef> refs,
+                         std::span<const uint32_t> chunk_indices,
+                         std::string_view blob) noexcept;
+
+    [[nodiscard]] uint32_t Count() const noexcept;
+    /** Empty when `chunk` is past the end, or names bytes outside the blob. */
+    [[nodiscard]] std::string_view operator[](uint32_t chunk) const noexcept;
+    /** The length of the whole source. */
+    [[nodiscard]] size_t TotalSize() const noexcept;
+
+    [[nodiscard]] Iterator begin() const noexcept;
+    [[nodiscard]] Iterator end() const noexcept;
+
+private:
+    std::span<const ManifestSourceRef> refs;
+    std::span<const uint32_t> chunkIndices;
+    std::string_view blob;
+};
 
 /**
  * @brief Spans over one manifest byte span, checked once when it opens.
@@ -284,10 +528,37 @@ public:
     ShaderManifestView() noexcept;
 
     static ManifestResult<ShaderManifestView> Open(std::span<const std::byte> bytes) noexcept;
+    /** @brief Opens a manifest whose sources live in a library source file, and reads them through
+     * `shared_sources`. A manifest that holds its own sources ignores `shared_sources`. */
+    static ManifestResult<ShaderManifestView> Open(std::span<const std::byte> bytes,
+                                                   const ShaderManifestView& shared_sources) noexcept;
 
     [[nodiscard]] std::string_view ModuleName() const noexcept;
     [[nodiscard]] std::string_view String(uint32_t string_index) const noexcept;
+    /** @brief The text of one source, when the manifest stores it in one piece. Empty for a source
+     * of several chunks, and for every source of a manifest with compressed sources: read those through
+     * `AssembleSource`. */
     [[nodiscard]] std::string_view Source(uint32_t source_index) const noexcept;
+    [[nodiscard]] uint32_t SourceCount() const noexcept;
+    /** @brief True when `Source` reads a library source file rather than this manifest. */
+    [[nodiscard]] bool SharesLibrarySources() const noexcept;
+    /** @brief True when the manifest stores its sources as chunks. */
+    [[nodiscard]] bool HasChunkedSources() const noexcept;
+    /** @brief True when the variant index is a rank bitvector rather than a dense table. */
+    [[nodiscard]] bool HasSparseVariantIndex() const noexcept;
+    /** @brief True when the source text is compressed, so nothing can read it in place. */
+    [[nodiscard]] bool HasCompressedSources() const noexcept;
+    /** @brief The dictionary the compressed sources decode against. Empty when they need none. */
+    [[nodiscard]] std::string_view SourceDictionary() const noexcept;
+    /** @brief One source as the pieces the manifest holds, in order, whole or chunked. Empty when the
+     * sources are compressed. */
+    [[nodiscard]] ManifestSourceChunks SourceChunks(uint32_t source_index) const noexcept;
+    /** @brief The length of one source's text, however it is stored. */
+    [[nodiscard]] size_t SourceSize(uint32_t source_index) const noexcept;
+    /** @brief Copies or decodes one source into `buffer` and returns the part it filled. Empty when the
+     * source does not exist, its bytes are malformed, or `buffer` is smaller than `SourceSize`. */
+    [[nodiscard]] std::string_view AssembleSource(uint32_t source_index,
+                                                  std::span<char> buffer) const noexcept;
 
     [[nodiscard]] std::span<const ManifestBinding> Bindings() const noexcept;
     /** @brief The resources one variant declares. Indices into Bindings(). */
@@ -304,25 +575,73 @@ public:
     [[nodiscard]] std::span<const ManifestVertexInput> VertexInputs(uint32_t raster_index) const noexcept;
     [[nodiscard]] std::span<const ManifestColorTarget> ColorTargets(uint32_t raster_index) const noexcept;
     [[nodiscard]] bool WritesFragDepth(uint32_t raster_index) const noexcept;
+    [[nodiscard]] uint32_t RasterCount() const noexcept;
 
     [[nodiscard]] std::span<const ManifestUniformMember> UniformMembers(
         const ManifestBinding& binding) const noexcept;
 
+    /** @brief The `EntryPointId` value of the entry point of this name, or zero when there is none. */
+    [[nodiscard]] uint16_t FindEntryPoint(std::string_view name) const noexcept;
+    /** @brief The index into `Axes()` of the axis of this name, or `k_ShaderManifestNoIndex`. */
+    [[nodiscard]] uint32_t FindAxis(std::string_view name) const noexcept;
+    /** @brief The index into `Bindings()` of the first binding of this name, or `k_ShaderManifestNoIndex`.
+     * Variants that declare one resource differently hold a record each; this is the first in the table. */
+    [[nodiscard]] uint32_t FindBinding(std::string_view name) const noexcept;
+
     /** @brief The slot for one entry point of one variant, or nullptr when the pair does not exist.
      *
      * `entry_point` is the `EntryPointId` value, so it counts from one and zero is Invalid.
      * `variant_index` is the dense index, the same number the generated library uses. */
     [[nodiscard]] const ManifestSlot* FindSlot(uint16_t entry_point, uint32_t variant_index) const noexcept;
+    /** @brief The record of one variant by its dense index, or nullptr when the manifest has none.
+     * One table read with either variant index encoding. */
+    [[nodiscard]] const ManifestVariant* FindVariant(uint32_t variant_index) const noexcept;
+    /** @brief The dense index of a partial assignment, computed from the axis tables alone.
+     *
+     * An axis the assignment leaves out takes its first value, and so does an axis whose parent does
+     * not turn it on or is itself off, exactly as the generated `Canonicalize` does. The index is then the mixed radix
+     * over the axes, as the generated `VariantIndex` computes it. When an axis appears twice, the
+     * later value wins. Allocates nothing: the value of each axis lives on the stack, so a manifest
+     * of more than `k_MaxQueryAxes` axes answers `IndexOutOfBounds`. A 32-bit index cannot hold that
+     * many axes of two values or more anyway.
+     *
+     * The index can land on a hole, a combination no variant was cooked for: `FindVariant` then
+     * returns nullptr. */
+    [[nodiscard]] ManifestResult<uint32_t> ResolveVariant(
+        std::span<const ManifestAxisValue> assignment) const noexcept;
+    /** @brief `FindSlot` for the variant `ResolveVariant` picks, or nullptr when there is none. */
+    [[nodiscard]] const ManifestSlot* FindSlot(uint16_t entry_point,
+                                               std::span<const ManifestAxisValue> assignment) const noexcept;
     /** @brief One slot for each entry point of this variant, in entry point order. */
     [[nodiscard]] std::span<const ManifestSlot> Slots(const ManifestVariant& variant) const noexcept;
     /** @brief Every slot, in file order. */
     [[nodiscard]] std::span<const ManifestSlot> SlotTable() const noexcept;
 
 private:
+    /** Everything `Open` does except decide where the sources come from. */
+    static ManifestResult<ShaderManifestView> MapSections(std::span<const std::byte> bytes) noexcept;
+    /** The source table entries one source is made of: its chunk indices, or `whole_entry` set to the
+     * source itself. */
+    [[nodiscard]] std::span<const uint32_t> SourceEntries(uint32_t source_index,
+                                                          uint32_t& whole_entry) const noexcept;
+    /** The one record index the perfect hash of `kind` gives this name hash, or
+     * `k_ShaderManifestNoIndex` when the kind has no names. The caller still compares the name. */
+    [[nodiscard]] uint32_t LookupName(ManifestNameKind kind, uint64_t name_hash) const noexcept;
+    /** Writes one source table entry into `output`, which is exactly its length. */
+    [[nodiscard]] bool CopyEntry(uint32_t entry, std::span<char> output) const noexcept;
+
     std::span<const std::byte> bytes;
     const ShaderManifestHeader* header{ nullptr };
     std::span<const ManifestStringRef> strings;
     std::span<const ManifestSourceRef> sources;
+    /** Inside `bytes`, or inside the library source file. */
+    std::string_view sourceBlob;
+    std::span<const ManifestRun> sourceChunkLists;
+    std::span<const uint32_t> chunkIndices;
+    /** From the same file as `sourceBlob`, like the flag below. */
+    std::span<const ManifestSourceBlock> sourceBlocks;
+    std::string_view sourceDictionary;
+    bool compressedSources{ false };
     std::span<const ManifestBinding> bindings;
     std::span<const ManifestRun> resourceLists;
     std::span<const uint32_t> resourceIndices;
@@ -334,12 +653,16 @@ private:
     std::span<const ManifestSlot> slots;
     std::span<const ManifestVariant> variants;
     std::span<const uint32_t> variantIndices;
+    std::span<const ManifestVariantRank> variantRanks;
     std::span<const ManifestAxis> axes;
     std::span<const int64_t> axisValues;
     std::span<const ManifestRaster> rasterStates;
     std::span<const ManifestVertexInput> vertexInputs;
     std::span<const ManifestColorTarget> colorTargets;
     std::span<const ManifestUniformMember> uniformMembers;
+    std::span<const ManifestNameLookup> nameLookups;
+    std::span<const uint32_t> nameBuckets;
+    std::span<const uint32_t> nameSlots;
 };
 
 /**
@@ -347,10 +670,18 @@ private:
  *
  * This is the second implementation of ShaderSourceProvider, and the reason the interface exists. A
  * watch-and-serve cooker sends a new manifest, the caller builds a new provider, and Generation()
- * moves. Nothing in the rendergraph changes.
+ * moves. Nothing in the rendergraph changes. `ShaderProviderRegistry` swaps the two while render
+ * threads read, and frees the old one once they are done with it.
+ *
+ * Nothing is built up front: the constructor stores the view and sizes two empty tables. The first
+ * `Bindings` call for a slot converts that slot's binding records into BindingInfo, because BindingInfo
+ * holds string views while the file holds indices. The first `Source` call for a chunked or compressed
+ * source joins or decodes it, since `Source` returns one view. Each result is built once and kept, so
+ * a program pays only for the variants it asks for, however large the manifest. Both calls are
+ * `noexcept`, so a first call that runs out of memory terminates, as any allocation in the library does.
  *
- * The constructor converts the manifest binding records into BindingInfo once. That is the only
- * allocation, and it is needed because BindingInfo holds string views while the file holds indices.
+ * Every call is safe from any number of threads. Two threads that ask for the same slot at once may
+ * both build it, and both then return the one that was published first.
  */
 class ManifestShaderSourceProvider final : public ShaderSourceProvider
 {
@@ -369,21 +700,28 @@ public:
     [[nodiscard]] const ShaderManifestView& View() const noexcept;
 
 private:
-    ShaderManifestView view;
-    /** Built before bindingInfos and reserved to its final size, so the spans below stay valid. */
-    std::vector<UniformMemberInfo> memberInfos;
-    /** One entry for each slot, gathered from the resource list and the footprint list of the slot's
+    /** The bindings of one slot, gathered from the resource list and the footprint list of the slot's
      * variant. A layout is a subset of what the variant declares, so it is not a run of the resource
      * table and has to be materialized. */
-    std::vector<BindingInfo> bindingInfos;
-    /** Where each slot's bindings begin in bindingInfos, and how many there are. */
-    std::vector<uint32_t> slotFirstBinding;
-    std::vector<uint32_t> slotBindingCount;
+    struct SlotBindings
+    {
+        /** Reserved to its final size before the first binding points into it. */
+        std::vector<UniformMemberInfo> Members;
+        std::vector<BindingInfo> Bindings;
+    };
 
-    void GatherVariantBindings(const ManifestVariant& variant, const std::vector<uint32_t>& member_offsets);
+    ShaderManifestView view;
+    /** One entry for each slot of the slot table, published on its first `Bindings` call. */
+    PublishOnceTable<SlotBindings> slotBindings;
+    /** One entry for each source, published on its first `Source` call. Chunked or compressed manifests
+     * only: otherwise every source is in place, and the table has no pages. */
+    PublishOnceTable<std::string> assembledSources;
+
+    [[nodiscard]] std::unique_ptr<SlotBindings> GatherSlotBindings(const ManifestVariant& variant,
+                                                                   size_t slot_index) const;
+    [[nodiscard]] std::string_view AssembledSource(uint32_t source_index) const;
     [[nodiscard]] BindingInfo MakeBindingInfo(const ManifestBinding& record,
-                                              const ManifestFootprint* footprint,
-                                              uint32_t member_offset) const noexcept;
+                                              const ManifestFootprint* footprint) const noexcept;
     uint64_t generation{ 0u };
 };
 
@@ -0,0 +1,98 @@
+#pragma once
+#ifndef LODESTONE_SHADER_PACK_HPP
+#define LODESTONE_SHADER_PACK_HPP
+#include "ShaderManifest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief Every module manifest of one library cook in one file, behind a table of contents.
+ *
+ * A program that loads a library of many modules opens one pack instead of one file for each module.
+ * The manifests sit in the pack byte for byte as the cooker would have written them alone, each on an
+ * 8-byte boundary, so a view over one is the same view `ShaderManifestView::Open` gives over its own
+ * file. With `--share-sources`, the library source file is packed too, and every module that reads
+ * from it finds it without being told.
+ *
+ * The table of contents is an open-addressing hash table keyed by `HashShaderPackName` of each module
+ * name, with a power-of-two slot count. `Find` hashes the name, probes from its home slot, and opens
+ * the first manifest whose hash and name both match, so a lookup costs one hash and a probe or two.
+ *
+ * Opening a pack checks its header and that its table of contents lies inside the file, and nothing
+ * else. Each module is checked when `Find` opens it, so a program pays only for the modules it asks for.
+ * The returned views point into the pack's byte span, which must outlive them.
+ */
+namespace lodestone
+{
+
+inline constexpr uint32_t k_ShaderPackMagic = 0x4B505356u;
+inline constexpr uint32_t k_ShaderPackVersion = 1u;
+
+/** @brief The key of a module in the table of contents. The cooker and the reader share this
+ * function, so it lives here. */
+constexpr uint64_t HashShaderPackName(std::string_view name) noexcept
+{
+    return HashManifestName(name);
+}
+
+struct ShaderPackHeader
+{
+    uint32_t Magic{ 0u };
+    uint32_t Version{ 0u };
+    uint32_t FileSize{ 0u };
+    uint32_t ModuleCount{ 0u };
+
+    /** A power of two, at least twice `ModuleCount`, so a probe ends at an empty slot soon. */
+    uint32_t SlotTableOffset{ 0u };
+    uint32_t SlotCount{ 0u };
+    /** The packed library source file, or zero size when the modules hold their own sources. */
+    uint32_t SharedSourcesOffset{ 0u };
+    uint32_t SharedSourcesSize{ 0u };
+};
+
+/** @brief One slot of the table of contents. A slot with `Size` zero is empty: no manifest is empty. */
+struct ShaderPackSlot
+{
+    uint64_t NameHash{ 0u };
+    uint32_t Offset{ 0u };
+    uint32_t Size{ 0u };
+};
+
+static_assert(sizeof(ShaderPackHeader) == 32u);
+static_assert(sizeof(ShaderPackSlot) == 16u);
+static_assert(std::is_trivially_copyable_v<ShaderPackHeader>);
+static_assert(std::is_trivially_copyable_v<ShaderPackSlot>);
+
+class ShaderPackView final
+{
+public:
+    ShaderPackView() noexcept;
+
+    /** @brief Checks the header and the bounds of the table of contents, and opens the packed library
+     * source file when there is one. Opens no module. */
+    static ManifestResult<ShaderPackView> Open(std::span<const std::byte> bytes) noexcept;
+
+    [[nodiscard]] uint32_t ModuleCount() const noexcept;
+    /** @brief Opens one module's manifest, checking it as `ShaderManifestView::Open` does.
+     * `ModuleNotFound` when no module has the name. */
+    [[nodiscard]] ManifestResult<ShaderManifestView> Find(std::string_view module_name) const noexcept;
+    /** @brief Every slot of the table of contents, empty ones included, for a tool that lists a pack. */
+    [[nodiscard]] std::span<const ShaderPackSlot> Slots() const noexcept;
+    /** @brief Opens the manifest in one occupied slot. */
+    [[nodiscard]] ManifestResult<ShaderManifestView> OpenSlot(const ShaderPackSlot& slot) const noexcept;
+    /** @brief True when the modules read their text from a packed library source file. */
+    [[nodiscard]] bool HasSharedSources() const noexcept;
+
+private:
+    std::span<const std::byte> bytes;
+    const ShaderPackHeader* header{ nullptr };
+    std::span<const ShaderPackSlot> slots;
+    ShaderManifestView sharedSources;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SHADER_PACK_HPP
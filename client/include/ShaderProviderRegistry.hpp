@@ -0,0 +1,152 @@
+#pragma once
+#ifndef LODESTONE_SHADER_PROVIDER_REGISTRY_HPP
+#define LODESTONE_SHADER_PROVIDER_REGISTRY_HPP
+#include "MappedShaderManifest.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Holds the current shader source provider and swaps in a new one while render threads read.
+ *
+ * A hot reload publishes a new provider, usually over a new manifest. A render thread may be holding a
+ * source or a binding table from the old one at that moment, and those views point into the old bytes.
+ * So the old provider and its bytes are retired, not freed, and are freed only once no reader can
+ * still see them.
+ *
+ * The scheme is epoch based. Each render thread attaches a `Reader` once. `Reader::Pin` records the
+ * registry's epoch in the reader's slot, then loads the current provider. Every publish advances the
+ * epoch and tags the provider it replaced with the new epoch. A retired provider is freed once every
+ * pinned slot holds that epoch or a later one, because a reader that pinned at that epoch or later
+ * already loads the new provider.
+ *
+ * Pinning and unpinning are a few atomic loads and stores, with no lock, no allocation and no
+ * reference count on a shared line. Publishing and reclaiming take a mutex, which orders writers
+ * against each other and never against readers. A reader that stays pinned only delays reclamation:
+ * the retired providers wait, and `Reclaim` frees them once it unpins.
+ *
+ * Everything a pinned provider hands out, and the provider itself, stays valid until the pin is
+ * destroyed. Keep a pin for one frame, or for one pipeline build, and no longer.
+ */
+namespace lodestone
+{
+
+class ShaderProviderRegistry final
+{
+    struct Published;
+    struct ReaderRecord;
+
+public:
+    class Reader;
+
+    /** @brief One pin on the provider that was current when it was taken. Move-only. */
+    class PinnedProvider final
+    {
+    public:
+        PinnedProvider(PinnedProvider&& other) noexcept;
+        PinnedProvider& operator=(PinnedProvider&&) = delete;
+        PinnedProvider(const PinnedProvider&) = delete;
+        PinnedProvider& operator=(const PinnedProvider&) = delete;
+        ~PinnedProvider();
+
+        /** @brief The pinned provider, or nullptr when nothing was published yet. */
+        [[nodiscard]] const ShaderSourceProvider* Provider() const noexcept;
+        [[nodiscard]] const ShaderSourceProvider* operator->() const noexcept;
+        [[nodiscard]] explicit operator bool() const noexcept;
+
+    private:
+        friend class Reader;
+        PinnedProvider(Reader* _reader, const ShaderSourceProvider* _provider) noexcept;
+
+        Reader* reader{ nullptr };
+        const ShaderSourceProvider* provider{ nullptr };
+    };
+
+    /**
+     * @brief One render thread's slot in the registry.
+     *
+     * A reader belongs to one thread at a time. Pins from one reader nest: the slot keeps the epoch of
+     * the outermost pin until the last one is destroyed. Destroying a reader frees its slot for the
+     * next `AttachReader`.
+     */
+    class Reader final
+    {
+    public:
+        Reader(Reader&& other) noexcept;
+        Reader& operator=(Reader&&) = delete;
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader();
+
+        [[nodiscard]] PinnedProvider Pin() noexcept;
+
+    private:
+        friend class ShaderProviderRegistry;
+        friend class PinnedProvider;
+        Reader(const ShaderProviderRegistry* _registry, ReaderRecord* _record) noexcept;
+        void Unpin() noexcept;
+
+        const ShaderProviderRegistry* registry{ nullptr };
+        ReaderRecord* record{ nullptr };
+        uint32_t pinDepth{ 0u };
+    };
+
+    ShaderProviderRegistry() noexcept;
+    /** Frees the current provider and every retired one. Every reader must be destroyed first. */
+    ~ShaderProviderRegistry();
+
+    ShaderProviderRegistry(const ShaderProviderRegistry&) = delete;
+    ShaderProviderRegistry& operator=(const ShaderProviderRegistry&) = delete;
+
+    /** @brief Claims a free reader slot, or adds one. Lock-free, but meant for thread startup and not
+     * for every frame. */
+    [[nodiscard]] Reader AttachReader();
+
+    /**
+     * @brief Makes `provider` current and retires the one it replaces.
+     *
+     * `backing` owns whatever the provider reads from, such as the manifest bytes. It is released after
+     * the provider is destroyed, once no reader holds either. Returns the provider's generation.
+     */
+    uint64_t Publish(std::unique_ptr<ShaderSourceProvider> provider, std::shared_ptr<const void> backing);
+    /** @brief Serves `manifest` through a ManifestShaderSourceProvider one generation past the current
+     * one. The registry keeps the mapping until the provider is reclaimed. */
+    uint64_t Publish(MappedShaderManifest manifest);
+
+    /** @brief Frees every retired provider that no reader can still see. Returns how many are left.
+     * Publish calls this too, so a caller needs it only to free providers a long pin held back. */
+    size_t Reclaim();
+
+    /** @brief The generation of the current provider, or 0 before the first publish. A render thread
+     * can compare this each frame without pinning. */
+    [[nodiscard]] uint64_t Generation() const noexcept;
+
+private:
+    /** A provider that was replaced, and the epoch its replacement was published at. */
+    struct Retired
+    {
+        std::unique_ptr<Published> Entry;
+        uint64_t Epoch{ 0u };
+    };
+
+    uint64_t PublishLocked(std::unique_ptr<Published> published);
+    size_t ReclaimLocked();
+
+    std::atomic<Published*> current{ nullptr };
+    /** Starts at 1, because a reader slot of 0 means the reader holds no pin. */
+    std::atomic<uint64_t> epoch{ 1u };
+    std::atomic<uint64_t> generation{ 0u };
+    /** Readers push onto this list and never leave it; a detached reader's record is reused. */
+    std::atomic<ReaderRecord*> readers{ nullptr };
+
+    std::mutex writerMutex;
+    std::vector<Retired> retired;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SHADER_PROVIDER_REGISTRY_HPP
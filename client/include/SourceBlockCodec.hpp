@@ -0,0 +1,54 @@
+#pragma once
+#ifndef LODESTONE_SOURCE_BLOCK_CODEC_HPP
+#define LODESTONE_SOURCE_BLOCK_CODEC_HPP
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/**
+ * @brief The decoder for compressed manifest sources. The cooker holds the encoder; a program that
+ * loads manifests only ever decodes.
+ *
+ * A block is a byte-oriented LZ77 stream in the shape of an LZ4 block, which costs a few hundred bytes
+ * of code and no dependency. The stream is a list of sequences:
+ *
+ *   token              high nibble: literal count, low nibble: match length minus 4. A nibble of 15
+ *                      means more length follows, as bytes added together until one is not 255.
+ *   literal count      only when the high nibble is 15
+ *   literals           copied to the output as they are
+ *   offset             two bytes, little-endian: how far back from the output position the match starts
+ *   match length       only when the low nibble is 15
+ *
+ * The last sequence ends after its literals, with no offset. A match may overlap its own output, which
+ * is how a run repeats.
+ *
+ * A block can also be encoded against a dictionary: text the cooker trained from every source of the
+ * file, stored once. The decoder then reads a match that reaches back past the start of the output from
+ * the dictionary, as if the dictionary came just before it. Small sources that share their declarations
+ * then compress almost as well as one stream of all of them.
+ *
+ * Each block decodes alone, or with the dictionary alone, so the reader decompresses one source without
+ * touching its neighbours.
+ */
+namespace lodestone
+{
+
+/** No block decodes to more than this. A source longer than this takes several blocks. Every offset
+ * then fits the two bytes the format gives it. */
+inline constexpr uint32_t k_SourceBlockSize{ 65536u };
+
+/** The cooker trains a dictionary no longer than this, so an offset from anywhere in the first half of
+ * a block still reaches all of it. */
+inline constexpr uint32_t k_SourceDictionaryMaxSize{ 32768u };
+
+/** @brief Decodes one block into `output`, which must be exactly the size the block decodes to. Returns
+ * false when the block is malformed or decodes to another size. `dictionary` must be the one the block
+ * was encoded against, or empty when there was none. Never reads or writes outside the three spans,
+ * whatever the block holds. */
+bool DecodeSourceBlock(std::string_view block,
+                       std::span<char> output,
+                       std::string_view dictionary = {}) noexcept;
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SOURCE_BLOCK_CODEC_HPP
@@ -0,0 +1,281 @@
+#include "MappedShaderManifest.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lodestone
+{
+
+namespace
+{
+
+    std::span<const std::byte> AsMapping(const void* base, uint64_t size) noexcept
+    {
+        return std::span<const std::byte>{ static_cast<const std::byte*>(base), static_cast<size_t>(size) };
+    }
+
+    /** Maps the whole file read-only. The file and mapping handles close here: the mapped view keeps the
+     * file open on every platform, until it is unmapped. */
+    ManifestResult<std::span<const std::byte>> MapFile(const std::filesystem::path& path,
+                                                       size_t header_size) noexcept
+    {
+#ifdef _WIN32
+        const HANDLE file = CreateFileW(path.c_str(),
+                                        GENERIC_READ,
+                                        FILE_SHARE_READ,
+                                        nullptr,
+                                        OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return std::unexpected(ShaderManifestError::FileOpenFailed);
+        }
+
+        LARGE_INTEGER size{};
+        if (GetFileSizeEx(file, &size) == 0)
+        {
+            CloseHandle(file);
+            return std::unexpected(ShaderManifestError::FileOpenFailed);
+        }
+
+        // A mapping of nothing fails, so a file too short for a header never reaches the mapping call.
+        if (static_cast<uint64_t>(size.QuadPart) < header_size)
+        {
+            CloseHandle(file);
+            return std::unexpected(ShaderManifestError::TooSmall);
+        }
+
+        const HANDLE section = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+        CloseHandle(file);
+        if (section == nullptr)
+        {
+            return std::unexpected(ShaderManifestError::FileMapFailed);
+        }
+
+        const void* base = MapViewOfFile(section, FILE_MAP_READ, 0u, 0u, 0u);
+        CloseHandle(section);
+        if (base == nullptr)
+        {
+            return std::unexpected(ShaderManifestError::FileMapFailed);
+        }
+
+        return AsMapping(base, static_cast<uint64_t>(size.QuadPart));
+#else
+        const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+        {
+            return std::unexpected(ShaderManifestError::FileOpenFailed);
+        }
+
+        struct stat status{};
+        if (::fstat(file, &status) != 0)
+        {
+            ::close(file);
+            return std::unexpected(ShaderManifestError::FileOpenFailed);
+        }
+
+        // A mapping of nothing fails, so a file too short for a header never reaches the mapping call.
+        const auto size = static_cast<uint64_t>(status.st_size);
+        if (size < header_size)
+        {
+            ::close(file);
+            return std::unexpected(ShaderManifestError::TooSmall);
+        }
+
+        void* base = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+        if (base == MAP_FAILED)
+        {
+            return std::unexpected(ShaderManifestError::FileMapFailed);
+        }
+
+        return AsMapping(base, size);
+#endif
+    }
+
+    void UnmapFile(std::span<const std::byte> mapping) noexcept
+    {
+        if (mapping.empty())
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        UnmapViewOfFile(mapping.data());
+#else
+        ::munmap(const_cast<std::byte*>(mapping.data()), mapping.size());
+#endif
+    }
+
+} // namespace
+
+MappedShaderManifest::MappedShaderManifest() noexcept = default;
+
+MappedShaderManifest::~MappedShaderManifest()
+{
+    Unmap();
+}
+
+MappedShaderManifest::MappedShaderManifest(MappedShaderManifest&& other) noexcept
+    : mapping{ std::exchange(other.mapping, {}) }, view{ std::exchange(other.view, {}) }
+{
+}
+
+MappedShaderManifest& MappedShaderManifest::operator=(MappedShaderManifest&& other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+        mapping = std::exchange(other.mapping, {});
+        view = std::exchange(other.view, {});
+    }
+
+    return *this;
+}
+
+ManifestResult<MappedShaderManifest> MappedShaderManifest::Map(const std::filesystem::path& path) noexcept
+{
+    const ManifestResult<std::span<const std::byte>> mapped = MapFile(path, sizeof(ShaderManifestHeader));
+    if (!mapped)
+    {
+        return std::unexpected(mapped.error());
+    }
+
+    MappedShaderManifest manifest;
+    manifest.mapping = mapped.value();
+    return manifest;
+}
+
+ManifestResult<MappedShaderManifest> MappedShaderManifest::Open(const std::filesystem::path& path) noexcept
+{
+    ManifestResult<MappedShaderManifest> manifest = Map(path);
+    if (!manifest)
+    {
+        return manifest;
+    }
+
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(manifest.value().mapping);
+    if (!opened)
+    {
+        return std::unexpected(opened.error());
+    }
+
+    manifest.value().view = opened.value();
+    return manifest;
+}
+
+ManifestResult<MappedShaderManifest> MappedShaderManifest::Open(
+    const std::filesystem::path& path,
+    const MappedShaderManifest& shared_sources) noexcept
+{
+    ManifestResult<MappedShaderManifest> manifest = Map(path);
+    if (!manifest)
+    {
+        return manifest;
+    }
+
+    const ManifestResult<ShaderManifestView> opened =
+        ShaderManifestView::Open(manifest.value().mapping, shared_sources.view);
+    if (!opened)
+    {
+        return std::unexpected(opened.error());
+    }
+
+    manifest.value().view = opened.value();
+    return manifest;
+}
+
+const ShaderManifestView& MappedShaderManifest::View() const noexcept
+{
+    return view;
+}
+
+std::span<const std::byte> MappedShaderManifest::Bytes() const noexcept
+{
+    return mapping;
+}
+
+void MappedShaderManifest::Unmap() noexcept
+{
+    UnmapFile(mapping);
+    mapping = {};
+    view = {};
+}
+
+MappedShaderPack::MappedShaderPack() noexcept = default;
+
+MappedShaderPack::~MappedShaderPack()
+{
+    Unmap();
+}
+
+MappedShaderPack::MappedShaderPack(MappedShaderPack&& other) noexcept
+    : mapping{ std::exchange(other.mapping, {}) }, view{ std::exchange(other.view, {}) }
+{
+}
+
+MappedShaderPack& MappedShaderPack::operator=(MappedShaderPack&& other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+        mapping = std::exchange(other.mapping, {});
+        view = std::exchange(other.view, {});
+    }
+
+    return *this;
+}
+
+ManifestResult<MappedShaderPack> MappedShaderPack::Open(const std::filesystem::path& path) noexcept
+{
+    const ManifestResult<std::span<const std::byte>> mapped = MapFile(path, sizeof(ShaderPackHeader));
+    if (!mapped)
+    {
+        return std::unexpected(mapped.error());
+    }
+
+    MappedShaderPack pack;
+    pack.mapping = mapped.value();
+    const ManifestResult<ShaderPackView> opened = ShaderPackView::Open(pack.mapping);
+    if (!opened)
+    {
+        return std::unexpected(opened.error());
+    }
+
+    pack.view = opened.value();
+    return pack;
+}
+
+const ShaderPackView& MappedShaderPack::View() const noexcept
+{
+    return view;
+}
+
+std::span<const std::byte> MappedShaderPack::Bytes() const noexcept
+{
+    return mapping;
+}
+
+void MappedShaderPack::Unmap() noexcept
+{
+    UnmapFile(mapping);
+    mapping = {};
+    view = {};
+}
+
+} // namespace lodestone
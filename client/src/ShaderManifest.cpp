@@ -1,14 +1,21 @@
 #include "ShaderManifest.hpp"
 #include "ResourceFlags.hpp"
 #include "ShaderLibraryTypes.hpp"
+#include "SourceBlockCodec.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <expected>
 #include <magic_enum/magic_enum.hpp>
+#include <memory>
 #include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace lodestone
 {
@@ -53,6 +60,17 @@ namespace
                                             count };
     }
 
+    /** The bytes one source, chunk or block names, or empty when they fall outside the blob. */
+    std::string_view SliceBlob(std::string_view blob, uint32_t offset, uint32_t length) noexcept
+    {
+        if (length > blob.size() || offset > blob.size() - length)
+        {
+            return {};
+        }
+
+        return blob.substr(offset, length);
+    }
+
 } // namespace
 
 std::string_view ToString(ShaderManifestError error) noexcept
@@ -62,7 +80,7 @@ std::string_view ToString(ShaderManifestError error) noexcept
 
 ShaderManifestView::ShaderManifestView() noexcept = default;
 
-ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std::byte> bytes) noexcept
+ManifestResult<ShaderManifestView> ShaderManifestView::MapSections(std::span<const std::byte> bytes) noexcept
 {
     if (bytes.size() < sizeof(ShaderManifestHeader))
     {
@@ -99,6 +117,7 @@ ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std:
         BlobIsInBounds(parsed.StringBlobOffset, parsed.StringBlobSize, fileSize) &&
         TableIsInBounds(parsed.SourceTableOffset, parsed.SourceCount, sizeof(ManifestSourceRef), fileSize) &&
         BlobIsInBounds(parsed.SourceBlobOffset, parsed.SourceBlobSize, fileSize) &&
+        BlobIsInBounds(parsed.SourceDictionaryOffset, parsed.SourceDictionarySize, fileSize) &&
         TableIsInBounds(parsed.BindingTableOffset, parsed.BindingCount, sizeof(ManifestBinding), fileSize) &&
         TableIsInBounds(
             parsed.ResourceListTableOffset, parsed.ResourceListCount, sizeof(ManifestRun), fileSize) &&
@@ -118,6 +137,8 @@ ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std:
         TableIsInBounds(parsed.VariantTableOffset, parsed.VariantCount, sizeof(ManifestVariant), fileSize) &&
         TableIsInBounds(
             parsed.VariantIndexTableOffset, parsed.VariantIndexCount, sizeof(uint32_t), fileSize) &&
+        TableIsInBounds(
+            parsed.VariantRankTableOffset, parsed.VariantRankCount, sizeof(ManifestVariantRank), fileSize) &&
         TableIsInBounds(parsed.AxisTableOffset, parsed.AxisCount, sizeof(ManifestAxis), fileSize) &&
         TableIsInBounds(parsed.AxisValueTableOffset, parsed.AxisValueCount, sizeof(int64_t), fileSize) &&
         TableIsInBounds(parsed.RasterTableOffset, parsed.RasterCount, sizeof(ManifestRaster), fileSize) &&
@@ -128,7 +149,16 @@ ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std:
         TableIsInBounds(parsed.UniformMemberTableOffset,
                         parsed.UniformMemberCount,
                         sizeof(ManifestUniformMember),
-                        fileSize);
+                        fileSize) &&
+        TableIsInBounds(
+            parsed.SourceChunkListTableOffset, parsed.SourceChunkListCount, sizeof(ManifestRun), fileSize) &&
+        TableIsInBounds(parsed.ChunkIndexTableOffset, parsed.ChunkIndexCount, sizeof(uint32_t), fileSize) &&
+        TableIsInBounds(
+            parsed.SourceBlockTableOffset, parsed.SourceBlockCount, sizeof(ManifestSourceBlock), fileSize) &&
+        TableIsInBounds(
+            parsed.NameLookupTableOffset, parsed.NameLookupCount, sizeof(ManifestNameLookup), fileSize) &&
+        TableIsInBounds(parsed.NameBucketTableOffset, parsed.NameBucketCount, sizeof(uint32_t), fileSize) &&
+        TableIsInBounds(parsed.NameSlotTableOffset, parsed.NameSlotCount, sizeof(uint32_t), fileSize);
 
     if (!sectionsFit)
     {
@@ -140,6 +170,16 @@ ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std:
     view.header = reinterpret_cast<const ShaderManifestHeader*>(bytes.data());
     view.strings = MakeTable<ManifestStringRef>(bytes, parsed.StringTableOffset, parsed.StringCount);
     view.sources = MakeTable<ManifestSourceRef>(bytes, parsed.SourceTableOffset, parsed.SourceCount);
+    const char* base = reinterpret_cast<const char*>(bytes.data());
+    if (parsed.SourceBlobSize != 0u)
+    {
+        view.sourceBlob = std::string_view{ base + parsed.SourceBlobOffset, parsed.SourceBlobSize };
+    }
+    if (parsed.SourceDictionarySize != 0u)
+    {
+        view.sourceDictionary =
+            std::string_view{ base + parsed.SourceDictionaryOffset, parsed.SourceDictionarySize };
+    }
     view.bindings = MakeTable<ManifestBinding>(bytes, parsed.BindingTableOffset, parsed.BindingCount);
     view.resourceLists =
         MakeTable<ManifestRun>(bytes, parsed.ResourceListTableOffset, parsed.ResourceListCount);
@@ -158,6 +198,8 @@ ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std:
     view.variants = MakeTable<ManifestVariant>(bytes, parsed.VariantTableOffset, parsed.VariantCount);
     view.variantIndices =
         MakeTable<uint32_t>(bytes, parsed.VariantIndexTableOffset, parsed.VariantIndexCount);
+    view.variantRanks =
+        MakeTable<ManifestVariantRank>(bytes, parsed.VariantRankTableOffset, parsed.VariantRankCount);
     view.axes = MakeTable<ManifestAxis>(bytes, parsed.AxisTableOffset, parsed.AxisCount);
     view.axisValues = MakeTable<int64_t>(bytes, parsed.AxisValueTableOffset, parsed.AxisValueCount);
     view.rasterStates = MakeTable<ManifestRaster>(bytes, parsed.RasterTableOffset, parsed.RasterCount);
@@ -167,7 +209,64 @@ ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std:
         MakeTable<ManifestColorTarget>(bytes, parsed.ColorTargetTableOffset, parsed.ColorTargetCount);
     view.uniformMembers =
         MakeTable<ManifestUniformMember>(bytes, parsed.UniformMemberTableOffset, parsed.UniformMemberCount);
+    view.sourceChunkLists =
+        MakeTable<ManifestRun>(bytes, parsed.SourceChunkListTableOffset, parsed.SourceChunkListCount);
+    view.chunkIndices = MakeTable<uint32_t>(bytes, parsed.ChunkIndexTableOffset, parsed.ChunkIndexCount);
+    view.sourceBlocks =
+        MakeTable<ManifestSourceBlock>(bytes, parsed.SourceBlockTableOffset, parsed.SourceBlockCount);
+    view.compressedSources = (parsed.Flags & k_ManifestCompressedSources) != 0u;
+    view.nameLookups =
+        MakeTable<ManifestNameLookup>(bytes, parsed.NameLookupTableOffset, parsed.NameLookupCount);
+    view.nameBuckets = MakeTable<uint32_t>(bytes, parsed.NameBucketTableOffset, parsed.NameBucketCount);
+    view.nameSlots = MakeTable<uint32_t>(bytes, parsed.NameSlotTableOffset, parsed.NameSlotCount);
+
+    // A lookup is read on every find, so its runs are checked here once, and `LookupName` indexes them
+    // without a test. A kind with buckets and no slots would divide by zero.
+    for (const ManifestNameLookup& lookup : view.nameLookups)
+    {
+        const bool runsFit = lookup.FirstBucket <= view.nameBuckets.size() &&
+                             lookup.BucketCount <= view.nameBuckets.size() - lookup.FirstBucket &&
+                             lookup.FirstSlot <= view.nameSlots.size() &&
+                             lookup.SlotCount <= view.nameSlots.size() - lookup.FirstSlot;
+        if (!runsFit || ((lookup.BucketCount == 0u) != (lookup.SlotCount == 0u)))
+        {
+            return std::unexpected(ShaderManifestError::SectionOutOfBounds);
+        }
+    }
+
+    return view;
+}
+
+ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std::byte> bytes) noexcept
+{
+    ManifestResult<ShaderManifestView> view = MapSections(bytes);
+    if (view.has_value() && view.value().SharesLibrarySources())
+    {
+        return std::unexpected(ShaderManifestError::SharedSourcesMissing);
+    }
+
+    return view;
+}
+
+ManifestResult<ShaderManifestView> ShaderManifestView::Open(std::span<const std::byte> bytes,
+                                                            const ShaderManifestView& shared_sources) noexcept
+{
+    ManifestResult<ShaderManifestView> view = MapSections(bytes);
+    if (!view.has_value() || !view.value().SharesLibrarySources())
+    {
+        return view;
+    }
+
+    if (shared_sources.header == nullptr)
+    {
+        return std::unexpected(ShaderManifestError::SharedSourcesMissing);
+    }
 
+    view.value().sources = shared_sources.sources;
+    view.value().sourceBlob = shared_sources.sourceBlob;
+    view.value().sourceBlocks = shared_sources.sourceBlocks;
+    view.value().sourceDictionary = shared_sources.sourceDictionary;
+    view.value().compressedSources = shared_sources.compressedSources;
     return view;
 }
 
@@ -201,20 +300,217 @@ std::string_view ShaderManifestView::ModuleName() const noexcept
 
 std::string_view ShaderManifestView::Source(uint32_t source_index) const noexcept
 {
-    if (header == nullptr || source_index >= sources.size())
+    const ManifestSourceChunks chunks = SourceChunks(source_index);
+    return chunks.Count() == 1u ? chunks[0u] : std::string_view{};
+}
+
+uint32_t ShaderManifestView::SourceCount() const noexcept
+{
+    return static_cast<uint32_t>(HasChunkedSources() ? sourceChunkLists.size() : sources.size());
+}
+
+bool ShaderManifestView::SharesLibrarySources() const noexcept
+{
+    return header != nullptr && (header->Flags & k_ManifestSharedSources) != 0u;
+}
+
+bool ShaderManifestView::HasChunkedSources() const noexcept
+{
+    return header != nullptr && (header->Flags & k_ManifestChunkedSources) != 0u;
+}
+
+bool ShaderManifestView::HasSparseVariantIndex() const noexcept
+{
+    return header != nullptr && (header->Flags & k_ManifestSparseVariantIndex) != 0u;
+}
+
+bool ShaderManifestView::HasCompressedSources() const noexcept
+{
+    return compressedSources;
+}
+
+std::string_view ShaderManifestView::SourceDictionary() const noexcept
+{
+    return sourceDictionary;
+}
+
+ManifestSourceChunks ShaderManifestView::SourceChunks(uint32_t source_index) const noexcept
+{
+    if (header == nullptr || compressedSources || source_index >= SourceCount())
     {
         return {};
     }
 
-    const ManifestSourceRef& reference = sources[source_index];
-    if (reference.Length > header->SourceBlobSize ||
-        reference.Offset > header->SourceBlobSize - reference.Length)
+    if (!HasChunkedSources())
+    {
+        return ManifestSourceChunks{ sources.subspan(source_index, 1u), {}, sourceBlob };
+    }
+
+    uint32_t wholeEntry = 0u;
+    return ManifestSourceChunks{ sources, SourceEntries(source_index, wholeEntry), sourceBlob };
+}
+
+std::span<const uint32_t> ShaderManifestView::SourceEntries(uint32_t source_index,
+                                                            uint32_t& whole_entry) const noexcept
+{
+    if (header == nullptr || source_index >= SourceCount())
     {
         return {};
     }
 
-    const char* base = reinterpret_cast<const char*>(bytes.data() + header->SourceBlobOffset);
-    return std::string_view{ base + reference.Offset, reference.Length };
+    if (!HasChunkedSources())
+    {
+        whole_entry = source_index;
+        return std::span<const uint32_t>{ &whole_entry, 1u };
+    }
+
+    const ManifestRun& run = sourceChunkLists[source_index];
+    if (run.First > chunkIndices.size() || run.Count > chunkIndices.size() - run.First)
+    {
+        return {};
+    }
+
+    return chunkIndices.subspan(run.First, run.Count);
+}
+
+size_t ShaderManifestView::SourceSize(uint32_t source_index) const noexcept
+{
+    uint32_t wholeEntry = 0u;
+    size_t size = 0u;
+    for (const uint32_t entry : SourceEntries(source_index, wholeEntry))
+    {
+        size += entry < sources.size() ? sources[entry].Length : 0u;
+    }
+
+    return size;
+}
+
+bool ShaderManifestView::CopyEntry(uint32_t entry, std::span<char> output) const noexcept
+{
+    if (entry >= sources.size() || sources[entry].Length != output.size())
+    {
+        return false;
+    }
+
+    if (!compressedSources)
+    {
+        const std::string_view text = SliceBlob(sourceBlob, sources[entry].Offset, sources[entry].Length);
+        if (text.size() != output.size())
+        {
+            return false;
+        }
+
+        std::memcpy(output.data(), text.data(), text.size());
+        return true;
+    }
+
+    size_t written = 0u;
+    for (uint32_t blockIndex = sources[entry].Offset; written < output.size(); ++blockIndex)
+    {
+        if (blockIndex >= sourceBlocks.size())
+        {
+            return false;
+        }
+
+        const ManifestSourceBlock& block = sourceBlocks[blockIndex];
+        const size_t decodedSize = std::min<size_t>(output.size() - written, k_SourceBlockSize);
+        const std::string_view stored = SliceBlob(sourceBlob, block.Offset, block.CompressedSize);
+        if (stored.size() != block.CompressedSize)
+        {
+            return false;
+        }
+
+        const std::span<char> target = output.subspan(written, decodedSize);
+        if (stored.size() == decodedSize)
+        {
+            std::memcpy(target.data(), stored.data(), decodedSize);
+        }
+        else if (!DecodeSourceBlock(stored, target, sourceDictionary))
+        {
+            return false;
+        }
+
+        written += decodedSize;
+    }
+
+    return true;
+}
+
+std::string_view ShaderManifestView::AssembleSource(uint32_t source_index,
+                                                    std::span<char> buffer) const noexcept
+{
+    uint32_t wholeEntry = 0u;
+    const std::span<const uint32_t> entries = SourceEntries(source_index, wholeEntry);
+    const size_t size = SourceSize(source_index);
+    if (entries.empty() || size > buffer.size())
+    {
+        return {};
+    }
+
+    size_t written = 0u;
+    for (const uint32_t entry : entries)
+    {
+        const size_t length = sources[entry].Length;
+        if (!CopyEntry(entry, buffer.subspan(written, length)))
+        {
+            return {};
+        }
+
+        written += length;
+    }
+
+    return std::string_view{ buffer.data(), size };
+}
+
+ManifestSourceChunks::ManifestSourceChunks(std::span<const ManifestSourceRef> _refs,
+                                           std::span<const uint32_t> _chunk_indices,
+                                           std::string_view _blob) noexcept
+    : refs{ _refs },
+      chunkIndices{ _chunk_indices },
+      blob{ _blob }
+{
+}
+
+uint32_t ManifestSourceChunks::Count() const noexcept
+{
+    return static_cast<uint32_t>(chunkIndices.empty() ? refs.size() : chunkIndices.size());
+}
+
+std::string_view ManifestSourceChunks::operator[](uint32_t chunk) const noexcept
+{
+    if (chunk >= Count())
+    {
+        return {};
+    }
+
+    const uint32_t refIndex = chunkIndices.empty() ? chunk : chunkIndices[chunk];
+    if (refIndex >= refs.size())
+    {
+        return {};
+    }
+
+    return SliceBlob(blob, refs[refIndex].Offset, refs[refIndex].Length);
+}
+
+size_t ManifestSourceChunks::TotalSize() const noexcept
+{
+    size_t size = 0u;
+    for (const std::string_view chunk : *this)
+    {
+        size += chunk.size();
+    }
+
+    return size;
+}
+
+ManifestSourceChunks::Iterator ManifestSourceChunks::begin() const noexcept
+{
+    return Iterator{ this, 0u };
+}
+
+ManifestSourceChunks::Iterator ManifestSourceChunks::end() const noexcept
+{
+    return Iterator{ this, Count() };
 }
 
 std::span<const ManifestBinding> ShaderManifestView::Bindings() const noexcept
@@ -353,6 +649,11 @@ bool ShaderManifestView::WritesFragDepth(uint32_t raster_index) const noexcept
     return rasterStates[raster_index].WritesFragDepth != 0u;
 }
 
+uint32_t ShaderManifestView::RasterCount() const noexcept
+{
+    return static_cast<uint32_t>(rasterStates.size());
+}
+
 std::span<const ManifestUniformMember> ShaderManifestView::UniformMembers(
     const ManifestBinding& binding) const noexcept
 {
@@ -367,115 +668,264 @@ std::span<const ManifestUniformMember> ShaderManifestView::UniformMembers(
 
 const ManifestSlot* ShaderManifestView::FindSlot(uint16_t entry_point, uint32_t variant_index) const noexcept
 {
-    if (entry_point == 0u || variant_index >= variantIndices.size())
+    const ManifestVariant* variant = FindVariant(variant_index);
+    if (entry_point == 0u || variant == nullptr)
     {
         return nullptr;
     }
 
-    const uint32_t variantSlot = variantIndices[variant_index];
-    if (variantSlot == k_ShaderManifestNoIndex || variantSlot >= variants.size())
+    const uint32_t entryPointIndex = static_cast<uint32_t>(entry_point) - 1u;
+    if (entryPointIndex >= variant->SlotCount)
     {
         return nullptr;
     }
 
-    const uint32_t entryPointIndex = static_cast<uint32_t>(entry_point) - 1u;
-
-    const ManifestVariant& variant = variants[variantSlot];
-    if (entryPointIndex >= variant.SlotCount)
+    const uint32_t slotIndex = variant->FirstSlot + entryPointIndex;
+    if (slotIndex >= slots.size())
     {
         return nullptr;
     }
 
-    const uint32_t slotIndex = variant.FirstSlot + entryPointIndex;
-    if (slotIndex >= slots.size())
+    return &slots[slotIndex];
+}
+
+const ManifestVariant* ShaderManifestView::FindVariant(uint32_t variant_index) const noexcept
+{
+    uint32_t variantSlot = k_ShaderManifestNoIndex;
+    if (variant_index < variantIndices.size())
+    {
+        variantSlot = variantIndices[variant_index];
+    }
+    else if (variant_index / 64u < variantRanks.size())
+    {
+        // The live bits below this one count the variants between the word's first index and this one.
+        const ManifestVariantRank& rank = variantRanks[variant_index / 64u];
+        const uint64_t bit = uint64_t{ 1u } << (variant_index % 64u);
+        if ((rank.Live & bit) != 0u)
+        {
+            variantSlot = rank.RankBefore + static_cast<uint32_t>(std::popcount(rank.Live & (bit - 1u)));
+        }
+    }
+
+    if (variantSlot == k_ShaderManifestNoIndex || variantSlot >= variants.size())
     {
         return nullptr;
     }
 
-    return &slots[slotIndex];
+    return &variants[variantSlot];
 }
 
-ManifestShaderSourceProvider::ManifestShaderSourceProvider(ShaderManifestView _view,
-                                                           uint64_t _generation) noexcept
-    : view{ _view },
-      generation{ _generation }
+uint32_t ShaderManifestView::LookupName(ManifestNameKind kind, uint64_t name_hash) const noexcept
 {
-    const std::span<const ManifestBinding> records = view.Bindings();
-    bindingInfos.reserve(records.size());
+    const auto kindIndex = static_cast<uint32_t>(kind);
+    if (kindIndex >= nameLookups.size() || nameLookups[kindIndex].SlotCount == 0u)
+    {
+        return k_ShaderManifestNoIndex;
+    }
 
-    size_t totalMembers = 0u;
-    for (const ManifestBinding& record : records)
+    const ManifestNameLookup& lookup = nameLookups[kindIndex];
+    const uint32_t displacement =
+        nameBuckets[lookup.FirstBucket + ManifestNameBucket(name_hash, lookup.BucketCount)];
+    return nameSlots[lookup.FirstSlot + ManifestNameSlot(name_hash, displacement, lookup.SlotCount)];
+}
+
+uint16_t ShaderManifestView::FindEntryPoint(std::string_view name) const noexcept
+{
+    const uint32_t index = LookupName(ManifestNameKind::EntryPoint, HashManifestName(name));
+    if (index >= entryPoints.size() || String(entryPoints[index].NameString) != name)
     {
-        totalMembers += record.UniformMemberCount;
+        return 0u;
     }
 
-    memberInfos.reserve(totalMembers);
-    for (const ManifestBinding& record : records)
+    return static_cast<uint16_t>(index + 1u);
+}
+
+uint32_t ShaderManifestView::FindAxis(std::string_view name) const noexcept
+{
+    const uint32_t index = LookupName(ManifestNameKind::Axis, HashManifestName(name));
+    if (index >= axes.size() || String(axes[index].NameString) != name)
     {
-        for (const ManifestUniformMember& member : view.UniformMembers(record))
-        {
-            UniformMemberInfo info;
-            info.Name = view.String(member.NameString);
-            info.Offset = member.Offset;
-            info.Size = member.Size;
-            info.ArrayCount = member.ArrayCount;
-            memberInfos.push_back(info);
-        }
+        return k_ShaderManifestNoIndex;
     }
 
-    // Where each resource's members start, so a gathered binding can point at them.
-    std::vector<uint32_t> memberOffsets;
-    memberOffsets.reserve(records.size());
-    uint32_t memberCursor = 0u;
-    for (const ManifestBinding& record : records)
+    return index;
+}
+
+uint32_t ShaderManifestView::FindBinding(std::string_view name) const noexcept
+{
+    const uint32_t index = LookupName(ManifestNameKind::Binding, HashManifestName(name));
+    if (index >= bindings.size() || String(bindings[index].NameString) != name)
     {
-        memberOffsets.push_back(memberCursor);
-        memberCursor += record.UniformMemberCount;
+        return k_ShaderManifestNoIndex;
     }
 
-    const std::span<const ManifestSlot> allSlots = view.SlotTable();
-    slotFirstBinding.assign(allSlots.size(), 0u);
-    slotBindingCount.assign(allSlots.size(), 0u);
+    return index;
+}
 
-    for (const ManifestVariant& variant : view.Variants())
+ManifestResult<uint32_t> ShaderManifestView::ResolveVariant(
+    std::span<const ManifestAxisValue> assignment) const noexcept
+{
+    if (axes.size() > k_MaxQueryAxes)
+    {
+        return std::unexpected(ShaderManifestError::IndexOutOfBounds);
+    }
+
+    // The value index of each axis: first what the caller asked for, then, in axis order, what
+    // canonicalization leaves. An axis left out stays at zero, its first value.
+    std::array<uint32_t, k_MaxQueryAxes> valueIndices{};
+
+    // Every pair must name an axis, and a value that axis takes, whether or not canonicalization keeps
+    // it. A value the caller got wrong is an error even on an axis that is off.
+    for (const ManifestAxisValue& pair : assignment)
+    {
+        // A pair by name carries only the hash. There are at most `k_MaxQueryAxes` axes, and comparing
+        // their stored hashes in a row is cheaper than the perfect hash's mixing and two divisions.
+        size_t axisIndex = static_cast<size_t>(pair.Axis);
+        if (pair.ByName)
+        {
+            const auto named = std::ranges::find(axes, pair.Axis, &ManifestAxis::NameHash);
+            axisIndex = static_cast<size_t>(named - axes.begin());
+        }
+
+        if (axisIndex >= axes.size())
+        {
+            return std::unexpected(ShaderManifestError::AxisNotFound);
+        }
+
+        const std::span<const int64_t> values = AxisValues(static_cast<uint32_t>(axisIndex));
+        const auto value = std::ranges::find(values, pair.Value);
+        if (value == values.end())
+        {
+            return std::unexpected(ShaderManifestError::AxisValueNotFound);
+        }
+
+        valueIndices[axisIndex] = static_cast<uint32_t>(value - values.begin());
+    }
+
+    // The generated `Canonicalize` runs in axis order and overwrites as it goes, so an axis reads its
+    // parent after the parent was canonicalized when the parent comes first. This loop does the same.
+    // A parent that was switched off holds its first value, which can be the one that turns its child
+    // on, so each axis also records whether it is active, and an inactive parent turns its child off.
+    std::array<bool, k_MaxQueryAxes> isActive{};
+    uint32_t index = 0u;
+    for (uint32_t i = 0u; i < axes.size(); ++i)
     {
-        GatherVariantBindings(variant, memberOffsets);
+        const ManifestAxis& axis = axes[i];
+        const size_t valueCount = AxisValues(i).size();
+        const bool parentIsKnown =
+            axis.ParentAxis == k_ShaderManifestNoIndex || axis.ParentAxis < axes.size();
+        if (valueCount == 0u || !parentIsKnown)
+        {
+            return std::unexpected(ShaderManifestError::IndexOutOfBounds);
+        }
+
+        isActive[i] = axis.ParentAxis == k_ShaderManifestNoIndex ||
+                      (isActive[axis.ParentAxis] &&
+                       valueIndices[axis.ParentAxis] == axis.RequiredParentValue);
+        if (!isActive[i])
+        {
+            valueIndices[i] = 0u;
+        }
+
+        index = (index * static_cast<uint32_t>(valueCount)) + valueIndices[i];
     }
+
+    return index;
 }
 
-void ManifestShaderSourceProvider::GatherVariantBindings(const ManifestVariant& variant,
-                                                         const std::vector<uint32_t>& member_offsets)
+const ManifestSlot* ShaderManifestView::FindSlot(uint16_t entry_point,
+                                                 std::span<const ManifestAxisValue> assignment) const noexcept
+{
+    const ManifestResult<uint32_t> variantIndex = ResolveVariant(assignment);
+    return variantIndex.has_value() ? FindSlot(entry_point, variantIndex.value()) : nullptr;
+}
+
+ManifestShaderSourceProvider::ManifestShaderSourceProvider(ShaderManifestView _view,
+                                                           uint64_t _generation) noexcept
+    : view{ _view },
+      slotBindings{ _view.SlotTable().size() },
+      assembledSources{ (_view.HasChunkedSources() || _view.HasCompressedSources()) ? _view.SourceCount()
+                                                                                    : 0u },
+      generation{ _generation }
+{
+}
+
+std::unique_ptr<ManifestShaderSourceProvider::SlotBindings> ManifestShaderSourceProvider::GatherSlotBindings(
+    const ManifestVariant& variant,
+    size_t slot_index) const
 {
     const std::span<const ManifestBinding> records = view.Bindings();
-    const std::span<const ManifestSlot> allSlots = view.SlotTable();
     const std::span<const uint32_t> resources = view.ResourceList(variant.ResourceListIndex);
     const std::span<const ManifestFootprint> footprints = view.FootprintList(variant.FootprintListIndex);
+    const std::span<const uint32_t> visible =
+        view.VisibilityList(view.SlotTable()[slot_index].VisibilityIndex);
+
+    const auto isKnown = [&](uint32_t local)
+    {
+        return local < resources.size() && resources[local] < records.size();
+    };
+
+    auto gathered = std::make_unique<SlotBindings>();
+    size_t totalMembers = 0u;
+    for (const uint32_t local : visible)
+    {
+        totalMembers += isKnown(local) ? view.UniformMembers(records[resources[local]]).size() : 0u;
+    }
 
-    for (uint32_t i = 0u; i < variant.SlotCount && variant.FirstSlot + i < allSlots.size(); ++i)
+    gathered->Members.reserve(totalMembers);
+    gathered->Bindings.reserve(visible.size());
+    for (const uint32_t local : visible)
     {
-        const uint32_t slotIndex = variant.FirstSlot + i;
-        const std::span<const uint32_t> visible = view.VisibilityList(allSlots[slotIndex].VisibilityIndex);
+        if (!isKnown(local))
+        {
+            continue;
+        }
 
-        slotFirstBinding[slotIndex] = static_cast<uint32_t>(bindingInfos.size());
-        slotBindingCount[slotIndex] = static_cast<uint32_t>(visible.size());
+        const ManifestBinding& record = records[resources[local]];
+        BindingInfo info = MakeBindingInfo(record, local < footprints.size() ? &footprints[local] : nullptr);
+        const size_t firstMember = gathered->Members.size();
+        for (const ManifestUniformMember& member : view.UniformMembers(record))
+        {
+            UniformMemberInfo memberInfo;
+            memberInfo.Name = view.String(member.NameString);
+            memberInfo.Offset = member.Offset;
+            memberInfo.Size = member.Size;
+            memberInfo.ArrayCount = member.ArrayCount;
+            gathered->Members.push_back(memberInfo);
+        }
 
-        for (const uint32_t local : visible)
+        if (gathered->Members.size() != firstMember)
         {
-            if (local >= resources.size() || resources[local] >= records.size())
-            {
-                continue;
-            }
-
-            bindingInfos.push_back(MakeBindingInfo(records[resources[local]],
-                                                   local < footprints.size() ? &footprints[local] : nullptr,
-                                                   member_offsets[resources[local]]));
+            info.Members = std::span<const UniformMemberInfo>{ gathered->Members }.subspan(firstMember);
         }
+
+        gathered->Bindings.push_back(info);
     }
+
+    return gathered;
+}
+
+std::string_view ManifestShaderSourceProvider::AssembledSource(uint32_t source_index) const
+{
+    // A source is in place when `Source` returns its whole text, which an empty source trivially is.
+    const std::string_view inPlace = view.Source(source_index);
+    if (inPlace.size() == view.SourceSize(source_index))
+    {
+        return inPlace;
+    }
+
+    if (const std::string* published = assembledSources.Find(source_index); published != nullptr)
+    {
+        return *published;
+    }
+
+    auto assembled = std::make_unique<std::string>(view.SourceSize(source_index), '\0');
+    assembled->resize(view.AssembleSource(source_index, *assembled).size());
+    return *assembledSources.Publish(source_index, std::move(assembled));
 }
 
 BindingInfo ManifestShaderSourceProvider::MakeBindingInfo(const ManifestBinding& record,
-                                                          const ManifestFootprint* footprint,
-                                                          uint32_t member_offset) const noexcept
+                                                          const ManifestFootprint* footprint) const noexcept
 {
     BindingInfo info;
     info.Name = view.String(record.NameString);
@@ -500,12 +950,6 @@ BindingInfo ManifestShaderSourceProvider::MakeBindingInfo(const ManifestBinding&
         info.DerivedExtentZ = footprint->ExtentZ;
     }
 
-    if (record.UniformMemberCount != 0u)
-    {
-        info.Members = std::span<const UniformMemberInfo>{ memberInfos.data() + member_offset,
-                                                           record.UniformMemberCount };
-    }
-
     return info;
 }
 
@@ -520,6 +964,11 @@ std::string_view ManifestShaderSourceProvider::Source(uint16_t entry_point,
         return {};
     }
 
+    if ((view.HasChunkedSources() || view.HasCompressedSources()) && slot->SourceIndex < view.SourceCount())
+    {
+        return AssembledSource(slot->SourceIndex);
+    }
+
     return view.Source(slot->SourceIndex);
 }
 
@@ -533,13 +982,14 @@ std::span<const BindingInfo> ManifestShaderSourceProvider::Bindings(uint16_t ent
     }
 
     const size_t slotIndex = static_cast<size_t>(slot - view.SlotTable().data());
-    if (slotIndex >= slotBindingCount.size() || slotBindingCount[slotIndex] == 0u)
+    const SlotBindings* gathered = slotBindings.Find(slotIndex);
+    if (gathered == nullptr)
     {
-        return {};
+        gathered =
+            slotBindings.Publish(slotIndex, GatherSlotBindings(*view.FindVariant(variant_index), slotIndex));
     }
 
-    return std::span<const BindingInfo>{ bindingInfos.data() + slotFirstBinding[slotIndex],
-                                         slotBindingCount[slotIndex] };
+    return gathered->Bindings;
 }
 
 WorkgroupSize ManifestShaderSourceProvider::Workgroup(uint16_t entry_point,
@@ -0,0 +1,150 @@
+#include "ShaderPack.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    /** The bytes of one packed manifest, or empty when the range leaves the file or starts off an 8-byte
+     * boundary. An empty span then fails in `ShaderManifestView::Open` as TooSmall. */
+    std::span<const std::byte> SliceManifest(std::span<const std::byte> bytes,
+                                             uint32_t offset,
+                                             uint32_t size) noexcept
+    {
+        if ((offset % 8u) != 0u || size > bytes.size() || offset > bytes.size() - size)
+        {
+            return {};
+        }
+
+        return bytes.subspan(offset, size);
+    }
+
+} // namespace
+
+ShaderPackView::ShaderPackView() noexcept = default;
+
+ManifestResult<ShaderPackView> ShaderPackView::Open(std::span<const std::byte> bytes) noexcept
+{
+    if (bytes.size() < sizeof(ShaderPackHeader))
+    {
+        return std::unexpected(ShaderManifestError::TooSmall);
+    }
+
+    if ((reinterpret_cast<uintptr_t>(bytes.data()) % 8u) != 0u)
+    {
+        return std::unexpected(ShaderManifestError::Misaligned);
+    }
+
+    ShaderPackHeader parsed{};
+    std::memcpy(&parsed, bytes.data(), sizeof(ShaderPackHeader));
+
+    if (parsed.Magic != k_ShaderPackMagic)
+    {
+        return std::unexpected(ShaderManifestError::BadMagic);
+    }
+
+    if (parsed.Version != k_ShaderPackVersion)
+    {
+        return std::unexpected(ShaderManifestError::VersionMismatch);
+    }
+
+    if (parsed.FileSize != bytes.size())
+    {
+        return std::unexpected(ShaderManifestError::SizeMismatch);
+    }
+
+    // A probe masks the hash with the slot count, so the count must be a power of two. A pack of no
+    // modules has one empty slot, so every probe still ends.
+    const uint64_t slotBytes = static_cast<uint64_t>(parsed.SlotCount) * sizeof(ShaderPackSlot);
+    const bool slotsFit = std::has_single_bit(parsed.SlotCount) && parsed.ModuleCount < parsed.SlotCount &&
+                          (parsed.SlotTableOffset % 8u) == 0u && parsed.SlotTableOffset <= bytes.size() &&
+                          slotBytes <= bytes.size() - parsed.SlotTableOffset;
+    if (!slotsFit)
+    {
+        return std::unexpected(ShaderManifestError::SectionOutOfBounds);
+    }
+
+    ShaderPackView view;
+    view.bytes = bytes;
+    view.header = reinterpret_cast<const ShaderPackHeader*>(bytes.data());
+    view.slots = std::span<const ShaderPackSlot>{
+        reinterpret_cast<const ShaderPackSlot*>(bytes.data() + parsed.SlotTableOffset), parsed.SlotCount
+    };
+
+    if (parsed.SharedSourcesSize != 0u)
+    {
+        const ManifestResult<ShaderManifestView> sources = ShaderManifestView::Open(
+            SliceManifest(bytes, parsed.SharedSourcesOffset, parsed.SharedSourcesSize));
+        if (!sources)
+        {
+            return std::unexpected(sources.error());
+        }
+
+        view.sharedSources = sources.value();
+    }
+
+    return view;
+}
+
+uint32_t ShaderPackView::ModuleCount() const noexcept
+{
+    return header != nullptr ? header->ModuleCount : 0u;
+}
+
+ManifestResult<ShaderManifestView> ShaderPackView::Find(std::string_view module_name) const noexcept
+{
+    if (slots.empty())
+    {
+        return std::unexpected(ShaderManifestError::ModuleNotFound);
+    }
+
+    const uint64_t hash = HashShaderPackName(module_name);
+    const size_t mask = slots.size() - 1u;
+    for (size_t probe = 0u; probe < slots.size(); ++probe)
+    {
+        const ShaderPackSlot& slot = slots[(hash + probe) & mask];
+        if (slot.Size == 0u)
+        {
+            break;
+        }
+
+        if (slot.NameHash != hash)
+        {
+            continue;
+        }
+
+        // Two names can share a hash, so the manifest's own name decides.
+        ManifestResult<ShaderManifestView> opened = OpenSlot(slot);
+        if (!opened || opened.value().ModuleName() == module_name)
+        {
+            return opened;
+        }
+    }
+
+    return std::unexpected(ShaderManifestError::ModuleNotFound);
+}
+
+std::span<const ShaderPackSlot> ShaderPackView::Slots() const noexcept
+{
+    return slots;
+}
+
+ManifestResult<ShaderManifestView> ShaderPackView::OpenSlot(const ShaderPackSlot& slot) const noexcept
+{
+    return ShaderManifestView::Open(SliceManifest(bytes, slot.Offset, slot.Size), sharedSources);
+}
+
+bool ShaderPackView::HasSharedSources() const noexcept
+{
+    return header != nullptr && header->SharedSourcesSize != 0u;
+}
+
+} // namespace lodestone
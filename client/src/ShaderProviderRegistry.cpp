@@ -0,0 +1,221 @@
+#include "ShaderProviderRegistry.hpp"
+#include "MappedShaderManifest.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace lodestone
+{
+
+/** A provider and what it reads from. The provider is declared last so it is destroyed first, while
+ * the bytes its views point into still exist. */
+struct ShaderProviderRegistry::Published
+{
+    std::shared_ptr<const void> Backing;
+    std::unique_ptr<ShaderSourceProvider> Provider;
+};
+
+/** On a cache line of its own, so one render thread pinning never invalidates another's line. */
+struct alignas(64) ShaderProviderRegistry::ReaderRecord
+{
+    /** The epoch the reader pinned at, or 0 while it holds no pin. */
+    std::atomic<uint64_t> PinnedEpoch{ 0u };
+    std::atomic<bool> Attached{ false };
+    /** Set once, before the record is pushed onto the list. */
+    ReaderRecord* Next{ nullptr };
+};
+
+ShaderProviderRegistry::PinnedProvider::PinnedProvider(Reader* _reader,
+                                                       const ShaderSourceProvider* _provider) noexcept
+    : reader{ _reader }, provider{ _provider }
+{
+}
+
+ShaderProviderRegistry::PinnedProvider::PinnedProvider(PinnedProvider&& other) noexcept
+    : reader{ std::exchange(other.reader, nullptr) }, provider{ std::exchange(other.provider, nullptr) }
+{
+}
+
+ShaderProviderRegistry::PinnedProvider::~PinnedProvider()
+{
+    if (reader != nullptr)
+    {
+        reader->Unpin();
+    }
+}
+
+const ShaderSourceProvider* ShaderProviderRegistry::PinnedProvider::Provider() const noexcept
+{
+    return provider;
+}
+
+const ShaderSourceProvider* ShaderProviderRegistry::PinnedProvider::operator->() const noexcept
+{
+    return provider;
+}
+
+ShaderProviderRegistry::PinnedProvider::operator bool() const noexcept
+{
+    return provider != nullptr;
+}
+
+ShaderProviderRegistry::Reader::Reader(const ShaderProviderRegistry* _registry,
+                                       ReaderRecord* _record) noexcept
+    : registry{ _registry }, record{ _record }
+{
+}
+
+ShaderProviderRegistry::Reader::Reader(Reader&& other) noexcept
+    : registry{ std::exchange(other.registry, nullptr) },
+      record{ std::exchange(other.record, nullptr) },
+      pinDepth{ std::exchange(other.pinDepth, 0u) }
+{
+}
+
+ShaderProviderRegistry::Reader::~Reader()
+{
+    if (record == nullptr)
+    {
+        return;
+    }
+
+    record->PinnedEpoch.store(0u, std::memory_order_release);
+    record->Attached.store(false, std::memory_order_release);
+}
+
+ShaderProviderRegistry::PinnedProvider ShaderProviderRegistry::Reader::Pin() noexcept
+{
+    // The slot is written before the provider is read, and both are sequentially consistent. A writer
+    // that retires a provider after this load therefore sees the slot when it scans, and one that
+    // retired it before has already swapped in the provider this load returns.
+    if (pinDepth++ == 0u)
+    {
+        const uint64_t pinnedAt = registry->epoch.load(std::memory_order_seq_cst);
+        record->PinnedEpoch.store(pinnedAt, std::memory_order_seq_cst);
+    }
+
+    const Published* published = registry->current.load(std::memory_order_seq_cst);
+    return PinnedProvider{ this, published != nullptr ? published->Provider.get() : nullptr };
+}
+
+void ShaderProviderRegistry::Reader::Unpin() noexcept
+{
+    // Release, so every read through the pin happens before a writer that sees the slot clear frees
+    // what was read.
+    if (--pinDepth == 0u)
+    {
+        record->PinnedEpoch.store(0u, std::memory_order_release);
+    }
+}
+
+ShaderProviderRegistry::ShaderProviderRegistry() noexcept = default;
+
+ShaderProviderRegistry::~ShaderProviderRegistry()
+{
+    delete current.load(std::memory_order_acquire);
+    retired.clear();
+
+    ReaderRecord* record = readers.load(std::memory_order_acquire);
+    while (record != nullptr)
+    {
+        delete std::exchange(record, record->Next);
+    }
+}
+
+ShaderProviderRegistry::Reader ShaderProviderRegistry::AttachReader()
+{
+    ReaderRecord* head = readers.load(std::memory_order_acquire);
+    for (ReaderRecord* record = head; record != nullptr; record = record->Next)
+    {
+        bool attached = false;
+        if (record->Attached.compare_exchange_strong(attached, true, std::memory_order_acq_rel))
+        {
+            return Reader{ this, record };
+        }
+    }
+
+    auto created = std::make_unique<ReaderRecord>();
+    created->Attached.store(true, std::memory_order_relaxed);
+    do
+    {
+        created->Next = head;
+    } while (!readers.compare_exchange_weak(
+        head, created.get(), std::memory_order_release, std::memory_order_acquire));
+
+    return Reader{ this, created.release() };
+}
+
+uint64_t ShaderProviderRegistry::Publish(std::unique_ptr<ShaderSourceProvider> provider,
+                                         std::shared_ptr<const void> backing)
+{
+    auto published = std::make_unique<Published>(
+        Published{ .Backing = std::move(backing), .Provider = std::move(provider) });
+    const std::scoped_lock lock{ writerMutex };
+    return PublishLocked(std::move(published));
+}
+
+uint64_t ShaderProviderRegistry::Publish(MappedShaderManifest manifest)
+{
+    auto mapped = std::make_shared<const MappedShaderManifest>(std::move(manifest));
+    const std::scoped_lock lock{ writerMutex };
+    auto provider = std::make_unique<ManifestShaderSourceProvider>(
+        mapped->View(), generation.load(std::memory_order_relaxed) + 1u);
+    return PublishLocked(std::make_unique<Published>(
+        Published{ .Backing = std::move(mapped), .Provider = std::move(provider) }));
+}
+
+uint64_t ShaderProviderRegistry::PublishLocked(std::unique_ptr<Published> published)
+{
+    const uint64_t publishedGeneration = published->Provider->Generation();
+    Published* previous = current.exchange(published.release(), std::memory_order_seq_cst);
+    generation.store(publishedGeneration, std::memory_order_release);
+
+    // Any reader still able to see `previous` pinned before this increment, at a smaller epoch.
+    const uint64_t retiredAt = epoch.fetch_add(1u, std::memory_order_seq_cst) + 1u;
+    if (previous != nullptr)
+    {
+        retired.push_back(Retired{ .Entry = std::unique_ptr<Published>{ previous }, .Epoch = retiredAt });
+    }
+
+    ReclaimLocked();
+    return publishedGeneration;
+}
+
+size_t ShaderProviderRegistry::Reclaim()
+{
+    const std::scoped_lock lock{ writerMutex };
+    return ReclaimLocked();
+}
+
+size_t ShaderProviderRegistry::ReclaimLocked()
+{
+    uint64_t oldestPin = std::numeric_limits<uint64_t>::max();
+    for (ReaderRecord* record = readers.load(std::memory_order_acquire); record != nullptr;
+         record = record->Next)
+    {
+        const uint64_t pinned = record->PinnedEpoch.load(std::memory_order_seq_cst);
+        if (pinned != 0u)
+        {
+            oldestPin = std::min(oldestPin, pinned);
+        }
+    }
+
+    std::erase_if(retired, [oldestPin](const Retired& entry) { return entry.Epoch <= oldestPin; });
+    return retired.size();
+}
+
+uint64_t ShaderProviderRegistry::Generation() const noexcept
+{
+    return generation.load(std::memory_order_acquire);
+}
+
+} // namespace lodestone
@@ -0,0 +1,121 @@
+#include "SourceBlockCodec.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    constexpr uint32_t k_MinMatchLength{ 4u };
+    constexpr uint8_t k_NibbleContinues{ 15u };
+    constexpr uint8_t k_ByteContinues{ 255u };
+
+    /** Adds the length bytes that follow a nibble of 15. Fails when the block ends first, or the length
+     * already passes `limit`, so a run of 255s cannot spin up a huge count. */
+    bool ReadExtendedLength(std::string_view block, size_t& cursor, size_t& length, size_t limit) noexcept
+    {
+        while (cursor < block.size())
+        {
+            const auto next = static_cast<uint8_t>(block[cursor++]);
+            length += next;
+            if (length > limit)
+            {
+                return false;
+            }
+
+            if (next != k_ByteContinues)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+} // namespace
+
+bool DecodeSourceBlock(std::string_view block, std::span<char> output, std::string_view dictionary) noexcept
+{
+    size_t in = 0u;
+    size_t out = 0u;
+
+    while (in < block.size())
+    {
+        const auto token = static_cast<uint8_t>(block[in++]);
+
+        size_t literals = token >> 4u;
+        if (literals == k_NibbleContinues && !ReadExtendedLength(block, in, literals, output.size()))
+        {
+            return false;
+        }
+
+        if (literals > block.size() - in || literals > output.size() - out)
+        {
+            return false;
+        }
+
+        std::memcpy(output.data() + out, block.data() + in, literals);
+        in += literals;
+        out += literals;
+
+        if (in == block.size())
+        {
+            // The last sequence: literals and nothing after them.
+            return out == output.size();
+        }
+
+        if (block.size() - in < 2u)
+        {
+            return false;
+        }
+
+        const size_t offset = static_cast<size_t>(static_cast<uint8_t>(block[in])) |
+                              (static_cast<size_t>(static_cast<uint8_t>(block[in + 1u])) << 8u);
+        in += 2u;
+        if (offset == 0u || offset > out + dictionary.size())
+        {
+            return false;
+        }
+
+        size_t match = token & 0x0Fu;
+        if (match == k_NibbleContinues && !ReadExtendedLength(block, in, match, output.size()))
+        {
+            return false;
+        }
+
+        match += k_MinMatchLength;
+        if (match > output.size() - out)
+        {
+            return false;
+        }
+
+        // A match that starts before the output starts in the dictionary, and may run on into the output.
+        size_t copied = 0u;
+        if (offset > out)
+        {
+            const size_t behind = offset - out;
+            copied = std::min(match, behind);
+            std::memcpy(output.data() + out, dictionary.data() + (dictionary.size() - behind), copied);
+        }
+
+        // Byte by byte, because a match that starts less than its length back reads what it writes.
+        for (size_t i = copied; i < match; ++i)
+        {
+            output[out + i] = output[out + i - offset];
+        }
+
+        out += match;
+    }
+
+    // A block must end with a sequence of literals, even an empty one.
+    return false;
+}
+
+} // namespace lodestone
@@ -0,0 +1,145 @@
+#pragma once
+#ifndef LODESTONE_COOK_TRACE_HPP
+#define LODESTONE_COOK_TRACE_HPP
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** Measures where a cook spends its time.
+ *
+ * Each phase of the pipeline runs inside a `ScopedPhaseTimer`. The timer adds its time to a
+ * `CookPhaseTimes`, and the statistics of the cook sum those. When `--trace` asks for it, the timer
+ * also records one span into a `CookTrace`. The trace writes the Chrome trace-event format, which
+ * Perfetto and chrome://tracing both open. Each thread that records a span gets a track of its own, and
+ * a thread started after another exited never shares its track. */
+namespace lodestone
+{
+
+enum class CookPhase : uint8_t
+{
+    Invalid = 0,
+    /** Global session, session, and root module of one compiler. */
+    Setup,
+    /** A variant read back from the variant cache. */
+    CacheLoad,
+    Link,
+    Codegen,
+    Reflection,
+    Resolve,
+    /** The target's validator, reading the emitted text back against reflection. */
+    CrossCheck,
+    Intern,
+    RoundTrip,
+    Emit,
+};
+
+inline constexpr size_t k_CookPhaseCount{ 11u };
+
+std::string_view ToString(CookPhase phase) noexcept;
+
+/** Milliseconds spent in each phase. Phases that ran on more than one thread add up, so the sum can be
+ * larger than the time the cook took. */
+struct CookPhaseTimes
+{
+    std::array<double, k_CookPhaseCount> Milliseconds{};
+
+    [[nodiscard]] double Get(CookPhase phase) const noexcept;
+    void Add(CookPhase phase, double milliseconds) noexcept;
+    void Add(const CookPhaseTimes& other) noexcept;
+    /** What was added since `earlier`, which must be an older copy of this object. */
+    [[nodiscard]] CookPhaseTimes Since(const CookPhaseTimes& earlier) const noexcept;
+};
+
+/** One line, such as "link 12.0ms, codegen 40.5ms". A phase that took no time is left out. */
+std::string DescribePhaseTimes(const CookPhaseTimes& times);
+
+/** Collects spans from any thread, and writes them as one trace document.
+ *
+ * A disabled trace records nothing, so the cook can pass one everywhere and not ask first. */
+class CookTrace final
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CookTrace(bool _enabled = false);
+
+    [[nodiscard]] bool IsEnabled() const noexcept;
+
+    /** `name` shows on the span, and `detail` shows in its arguments. Both are copied. */
+    void Record(std::string_view name,
+                std::string_view detail,
+                Clock::time_point start,
+                Clock::time_point end);
+
+    /** The JSON object format: a `traceEvents` array, with one thread name event for each track. The
+     * thread that made the trace is named "cook", and every other thread "worker N". */
+    [[nodiscard]] std::string ToChromeTraceJson() const;
+    [[nodiscard]] size_t EventCount() const;
+
+private:
+    struct Event
+    {
+        std::string Name;
+        std::string Detail;
+        uint32_t Track{ 0u };
+        int64_t StartMicroseconds{ 0 };
+        int64_t DurationMicroseconds{ 0 };
+    };
+
+    uint32_t FindOrAddTrack(uint64_t thread_serial);
+
+    bool enabled{ false };
+    Clock::time_point origin;
+    mutable std::mutex mutex;
+    /** Track zero is the thread that made the trace, and track N after it is the Nth other thread
+     * that recorded a span. Each entry is a thread's serial, not its id, which the runtime reuses. */
+    std::vector<uint64_t> tracks;
+    std::vector<Event> events;
+};
+
+/** A span on the trace that no phase total counts, such as a whole module or a whole variant. */
+class ScopedTraceSpan final
+{
+public:
+    /** `name` and `detail` must outlive the span. */
+    ScopedTraceSpan(CookTrace* _trace, std::string_view _name, std::string_view _detail) noexcept;
+    ~ScopedTraceSpan();
+    ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+    ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+private:
+    CookTrace* trace{ nullptr };
+    std::string_view name;
+    std::string_view detail;
+    CookTrace::Clock::time_point start;
+};
+
+/** Adds the time of its scope to one phase, and records the same time as a span on the trace. */
+class ScopedPhaseTimer final
+{
+public:
+    /** `trace` may be null. `detail` must outlive the timer. */
+    ScopedPhaseTimer(CookPhaseTimes& _times,
+                     CookPhase _phase,
+                     CookTrace* _trace,
+                     std::string_view _detail) noexcept;
+    ~ScopedPhaseTimer();
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    CookPhaseTimes& times;
+    CookPhase phase{ CookPhase::Invalid };
+    CookTrace* trace{ nullptr };
+    std::string_view detail;
+    CookTrace::Clock::time_point start;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_COOK_TRACE_HPP
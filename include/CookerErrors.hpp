@@ -41,13 +41,16 @@ enum class CookError : uint16_t
     PermutationValueNotInAxis = 82,
     PermutationAxisNotDeclared = 83,
     PermutationVariantIndexCollision = 84,
+    PermutationVariantNotEnumerated = 85,
 
     LibraryRoundTripFailed = 90,
     CookNotDeterministic = 91,
     ModulePolicyViolated = 92,
+    StagedSourcesMismatch = 93,
 
     OutputPathInvalid = 100,
     OutputWriteFailed = 101,
+    CacheEntryInvalid = 102,
 
     // start system errors
     SystemError = 200,
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef LODESTONE_RAW_VARIANT_CACHE_HPP
+#define LODESTONE_RAW_VARIANT_CACHE_HPP
+#include "CookerErrors.hpp"
+#include "RawLibrary.hpp"
+#include "model/ContentHash.hpp"
+#include "permute/PermutationSpace.hpp"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/** Keeps stage 3 output on disk, so a cook of unchanged sources skips Slang.
+ *
+ * A `RawVariant` is a pure function of the module's sources, the compiler options, the Slang target,
+ * and the axis values the variant exports. The compiler hashes the first three into one value, and
+ * the cache mixes in the assignment to name one file for each variant. Each file is a cache record, so
+ * a damaged one reads as a miss. */
+namespace lodestone
+{
+
+/** Bump this whenever stage 3 starts to extract something different, or the file layout changes. An
+ * old file then names a different key and is never read again. */
+inline constexpr uint32_t k_RawVariantCacheVersion{ 1u };
+
+/** The file body, without the header. Exposed so a test can round trip a variant without Slang. */
+std::string SerializeRawVariant(const RawVariant& variant);
+CookResult<RawVariant> DeserializeRawVariant(std::string_view bytes);
+
+class RawVariantCache final
+{
+public:
+    /** An empty directory turns the cache off: every lookup misses and every store does nothing.
+     * `compile_input_hash` comes from `SlangCompiler::GetCompileInputHash`. */
+    RawVariantCache(const std::filesystem::path& directory, ContentHashValue compile_input_hash);
+
+    [[nodiscard]] bool IsEnabled() const noexcept;
+    /** True when a file exists for this descriptor. It says nothing about whether the file reads back,
+     * but it is enough to size a compiler pool before any variant loads. */
+    [[nodiscard]] bool Contains(const VariantDescriptor& descriptor) const;
+    /** The variant stored for this descriptor, with the index and the names the descriptor states. */
+    [[nodiscard]] std::optional<RawVariant> Load(const VariantDescriptor& descriptor) const;
+    void Store(const VariantDescriptor& descriptor, const RawVariant& variant) const;
+
+private:
+    [[nodiscard]] ContentHashValue MakeVariantKey(const VariantDescriptor& descriptor) const;
+    [[nodiscard]] std::filesystem::path MakeEntryPath(ContentHashValue key) const;
+
+    std::filesystem::path directory;
+    ContentHashValue compileInputHash{ 0u };
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_RAW_VARIANT_CACHE_HPP
@@ -1,10 +1,13 @@
 #pragma once
 #ifndef LODESTONE_SLANG_COMPILER_HPP
 #define LODESTONE_SLANG_COMPILER_HPP
+#include "CookTrace.hpp"
 #include "CookerErrors.hpp"
 #include "Diagnostics.hpp"
+#include "model/ContentHash.hpp"
 #include "permute/PermutationSpace.hpp"
 #include "RawLibrary.hpp"
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <span>
@@ -22,6 +25,17 @@ struct SlangCompilerCreateInfo
     std::filesystem::path ModuleCacheDirectory;
     uint32_t OptimizationLevel{ 0u };
     bool MultithreadEntryPointCodegen{ true };
+    /** Takes a span for each phase the compiler times. Null records nothing, and the times still add up
+     * in `GetPhaseTimes`. */
+    CookTrace* Trace{ nullptr };
+};
+
+/** How often a variant found the constant module of one (axis, value) pair already loaded in the
+ * session, and how often the session had to parse it. */
+struct ConstantModuleCacheStatistics
+{
+    uint32_t Hits{ 0u };
+    uint32_t Misses{ 0u };
 };
 
 class SlangCompiler final
@@ -36,8 +50,16 @@ public:
 
     /** The sink takes every compiler message, and it must outlive this object. It is a parameter
      * rather than a field of the create info because a sink cannot be absent: a compiler that has
-     * nowhere to report is a compiler that fails in silence. */
+     * nowhere to report is a compiler that fails in silence.
+     *
+     * Initializing a compiler again loads the module afresh in a new session, and keeps the global
+     * session. Creating a global session loads Slang's core module, which is the largest fixed cost of
+     * a small cook, so a process that cooks more than once reuses its compilers. */
     CookError Initialize(const SlangCompilerCreateInfo& create_info, DiagnosticSink& sink);
+    /** Points a compiler that stays loaded between cooks at the next cook's sink and trace. Both must
+     * outlive every later call. The phase times and the constant module counts start again from zero,
+     * so each cook reports only its own. */
+    void Rebind(DiagnosticSink& sink, CookTrace* trace) noexcept;
     /** Stage 3, once for each module. Returns the module facts stage 4 needs and only Slang can
      * supply, the defaults of the extern constants no axis drives among them. A size expression may
      * name one, so call this before the first `CompileVariantRaw`. */
@@ -52,6 +74,14 @@ public:
     std::span<const std::string> GetEntryPointNames() const noexcept;
     /** Every source file the module pulled in, transitively, in Slang's dependency order. */
     std::span<const std::string> GetModuleSourceTexts() const noexcept;
+    /** Where each of those texts came from, in the same order. */
+    std::span<const std::string> GetModuleSourcePaths() const noexcept;
+    /** Hashes the Slang build, the target, the options, and every source text. Two compilers that
+     * agree on it compile every variant to the same `RawVariant`. */
+    ContentHashValue GetCompileInputHash() const noexcept;
+    ConstantModuleCacheStatistics GetConstantModuleCacheStatistics() const noexcept;
+    /** Setup, link, codegen, and reflection, summed over every variant this compiler compiled. */
+    CookPhaseTimes GetPhaseTimes() const noexcept;
 
 private:
     struct Impl;
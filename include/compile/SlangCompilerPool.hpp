@@ -0,0 +1,104 @@
+#pragma once
+#ifndef LODESTONE_SLANG_COMPILER_POOL_HPP
+#define LODESTONE_SLANG_COMPILER_POOL_HPP
+#include "CookTrace.hpp"
+#include "CookerErrors.hpp"
+#include "Diagnostics.hpp"
+#include "RawLibrary.hpp"
+#include "SlangCompiler.hpp"
+#include "permute/PermutationSpace.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+/** Compiles the variants of one module on more than one thread, and streams the results back in order.
+ *
+ * Slang lets one thread at a time into a session, so each worker owns a `SlangCompiler` of its own,
+ * and with it a global session and a session. Every worker is built from the same create info, so
+ * every worker links the same module with the same options. A worker never touches the sink of the
+ * cook: it reports into a sink of its own, and the pool forwards those records after the workers
+ * join. */
+namespace lodestone
+{
+
+class SlangCompilerPool final
+{
+public:
+    SlangCompilerPool() noexcept;
+    ~SlangCompilerPool();
+    SlangCompilerPool(const SlangCompilerPool&) = delete;
+    SlangCompilerPool& operator=(const SlangCompilerPool&) = delete;
+    SlangCompilerPool(SlangCompilerPool&&) noexcept;
+    SlangCompilerPool& operator=(SlangCompilerPool&&) noexcept;
+
+    /** `primary` is the compiler the driver already initialized, and it becomes worker zero. The pool
+     * builds `worker_count - 1` more, in parallel, because each one pays for a global session. Both
+     * `primary` and `sink` must outlive the pool. */
+    CookError Initialize(const SlangCompilerCreateInfo& create_info,
+                         SlangCompiler& primary,
+                         uint32_t worker_count,
+                         DiagnosticSink& sink);
+    /** Gives `Initialize` compilers to build its workers from, ahead of new ones. A compiler that was
+     * initialized before keeps its global session, so a worker built from it skips the largest cost of
+     * starting. Extra compilers wait here until `ReleaseCompilers`. */
+    void AdoptCompilers(std::vector<SlangCompiler>&& compilers);
+    /** Gives `Initialize` compilers that hold this module loaded already, from an earlier cook of the
+     * same inputs. A worker built from one only rebinds, so it loads nothing. `Initialize` takes these
+     * before the ones from `AdoptCompilers`. */
+    void AdoptLoadedCompilers(std::vector<SlangCompiler>&& compilers);
+
+    /** Every compiler the pool held. `Loaded` hold the module: the workers that loaded or rebound it,
+     * and the loaded compilers no worker used. `Spares` are the rest. */
+    struct ReleasedCompilers
+    {
+        std::vector<SlangCompiler> Loaded;
+        std::vector<SlangCompiler> Spares;
+    };
+
+    /** Takes back every worker's compiler, and every adopted one no worker used. The pool has no
+     * workers afterwards. */
+    [[nodiscard]] ReleasedCompilers ReleaseCompilers();
+
+    /** What a worker does with one descriptor, on the worker's own compiler. The driver passes a
+     * function that tries the variant cache before it compiles. */
+    using VariantProducer = std::function<CookResult<RawVariant>(SlangCompiler&, const VariantDescriptor&)>;
+    /** Takes one result, on the calling thread. An error stops the stream. */
+    using VariantConsumer = std::function<CookResult<void>(size_t, CookResult<RawVariant>&&)>;
+
+    /** Produces a result for every descriptor on the workers, and hands each one to `consume` in
+     * descriptor order. The order never depends on which worker finished first.
+     *
+     * At most `window` results exist at once, counting the ones still compiling. A worker waits for
+     * the consumer before it takes a descriptor past the window, so memory stays bounded by the
+     * window and not by the variant count. The first error from `consume` stops the workers from
+     * taking more descriptors, and is returned. */
+    CookResult<void> StreamVariants(std::span<const VariantDescriptor> descriptors,
+                                    uint32_t window,
+                                    const VariantProducer& produce,
+                                    const VariantConsumer& consume);
+
+    uint32_t WorkerCount() const noexcept;
+    /** The sum over every worker. Each session keeps its own constant modules, so a pool of N parses
+     * each (axis, value) pair up to N times. */
+    ConstantModuleCacheStatistics GetConstantModuleCacheStatistics() const noexcept;
+    /** The sum over every worker. Workers run at once, so the sum can pass the time the module took. */
+    CookPhaseTimes GetPhaseTimes() const noexcept;
+
+private:
+    struct Worker;
+
+    void ForwardWorkerDiagnostics();
+
+    SlangCompiler* primaryCompiler{ nullptr };
+    DiagnosticSink* sink{ nullptr };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<SlangCompiler> adopted;
+    std::vector<SlangCompiler> adoptedLoaded;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SLANG_COMPILER_POOL_HPP
@@ -1,10 +1,14 @@
 #pragma once
 #ifndef LODESTONE_DRIVER_HPP
 #define LODESTONE_DRIVER_HPP
+#include "CookTrace.hpp"
 #include "CookerErrors.hpp"
 #include "CookerOptions.hpp"
+#include "compile/RawLibrary.hpp"
+#include "driver/WarmCompilerCache.hpp"
 #include "emit/OutputSink.hpp"
 #include <cstdint>
+#include <filesystem>
 
 /** The execution loop, separated from `main` so the cooker can also be driven in-process by a watcher
  * or by the engine itself. */
@@ -14,15 +18,43 @@ namespace lodestone
 struct CookStatistics
 {
     uint32_t ModulesCooked{ 0u };
+    /** Modules whose inputs did not change, taken from their stamps without a cook. */
+    uint32_t ModulesReused{ 0u };
     uint32_t VariantsCompiled{ 0u };
     uint32_t EntryPointsCompiled{ 0u };
     uint32_t ReflectionMismatches{ 0u };
+    /** Constant modules a variant found already loaded in its session, and ones a session parsed. */
+    uint32_t ConstantModuleCacheHits{ 0u };
+    uint32_t ConstantModuleCacheMisses{ 0u };
+    /** Variants read from the variant cache, and variants that Slang had to compile. */
+    uint32_t VariantCacheHits{ 0u };
+    uint32_t VariantCacheMisses{ 0u };
     size_t TotalWgslBytes{ 0u };
     size_t GeneratedSourceBytes{ 0u };
+    /** Time in each phase, summed over every module and every worker. */
+    CookPhaseTimes PhaseTimes;
     double ElapsedMilliseconds{ 0.0 };
 };
 
 CookResult<CookStatistics> RunCook(const CookerOptions& options, OutputSink& sink);
+/** The same cook, for a process that cooks more than once. Compilers come from `warm_compilers` and go
+ * back to it, so a module whose files did not change keeps its loaded session, and every other
+ * compiler keeps its global session. The output is byte for byte what a cold cook writes. */
+CookResult<CookStatistics> RunCook(const CookerOptions& options,
+                                   OutputSink& sink,
+                                   WarmCompilerCache& warm_compilers);
+
+/** @brief Compiles one variant of one module, for a live edit that needs one shader now.
+ *
+ * It stops at stage 3: the result is the target text and the raw reflection of each entry point,
+ * with nothing resolved or interned. A warm module answers with one link and one codegen, or with one
+ * file read when the variant cache holds it. `variant_index` is the dense index the generated
+ * `VariantIndex` returns; an index that names no enumerated variant fails with
+ * `PermutationVariantNotEnumerated`. */
+CookResult<RawVariant> CompileLiveVariant(const CookerOptions& options,
+                                          const std::filesystem::path& module_path,
+                                          uint32_t variant_index,
+                                          WarmCompilerCache& warm_compilers);
 
 } // namespace lodestone
 
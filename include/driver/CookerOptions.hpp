@@ -51,13 +51,47 @@ struct CookerOptions
     bool ValidateAgainstEmittedText{ true };
     bool ReportReflection{ false };
     bool MultithreadEntryPointCodegen{ true };
+    /** How many Slang sessions compile the variants of one module. Zero takes one for each hardware
+     * thread. `--compile-workers` sets it, and `--single-threaded` sets it to one. */
+    uint32_t CompileWorkerCount{ 0u };
+    /** How many modules cook at once. Each job cooks a whole module with compilers of its own, and the
+     * output is the same as a serial cook. `--jobs` sets it, and `--single-threaded` sets it to one. */
+    uint32_t ModuleJobCount{ 1u };
+    /** Reads and writes compiled variants under `ModuleCacheDirectory`, so an unchanged variant skips
+     * Slang. `--no-variant-cache` turns it off. */
+    bool VariantCacheEnabled{ true };
+    /** Takes a module whose inputs did not change from its stamp under `ModuleCacheDirectory`, instead
+     * of cooking it. `--no-incremental` turns it off. */
+    bool IncrementalEnabled{ true };
     /**Turns off content dedup. Output stays correct, and every artifact takes its own index */
     bool DedupeEnabled{ true };
+    /** Records which artifacts mapped onto each unique entry. Only the `interned` dump reads it, so a
+     * cook that writes no dump can skip it. `--no-provenance` turns it off. */
+    bool ProvenanceEnabled{ true };
+    /** Writes every module's sources once, in a library source file beside the manifests, and has the
+     * module manifests read from it. `--share-sources` turns it on. A manifest then no longer opens on
+     * its own, so a program that loads one module at a time can keep the default. */
+    bool ShareLibrarySources{ false };
+    /** Stores each manifest's sources as content-defined chunks, each unique chunk once.
+     * `--chunk-sources` turns it on. It cannot combine with `ShareLibrarySources`. */
+    bool ChunkedSources{ false };
+    /** Compresses the text of each manifest, and of the library source file when there is one. A
+     * loader then decodes a source instead of viewing it in place. `--compress-sources` turns it on. */
+    bool CompressSources{ false };
+    /** Compresses against a dictionary trained from each file's sources and stored in it, rather than
+     * each source on its own. `--source-dictionary` turns it on, and `CompressSources` with it. */
+    bool SourceDictionary{ false };
+    /** Writes every module manifest, and the library source file when there is one, into one pack
+     * behind a table of contents, instead of one file each. `--pack` turns it on. */
+    bool PackManifests{ false };
     /** Cooks twice into memory and compares. Catches an unordered container's iteration order when
      * it reaches the emitted output. */
     bool VerifyDeterministic{ false };
     /** One bit for each `StageDumpKind` the cook must write. `--dump-stage` sets them. */
     uint32_t DumpStageMask{ 0u };
+    /** Where to write a Chrome trace of the cook, with one track for each thread. Empty writes none.
+     * `--trace` sets it. */
+    std::filesystem::path TracePath;
 };
 
 bool IsStageDumpRequested(const CookerOptions& options, StageDumpKind kind) noexcept;
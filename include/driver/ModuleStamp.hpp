@@ -0,0 +1,67 @@
+#pragma once
+#ifndef LODESTONE_MODULE_STAMP_HPP
+#define LODESTONE_MODULE_STAMP_HPP
+#include "CookerOptions.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "model/ContentHash.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+/** Lets a cook skip a module whose inputs did not change since the last cook.
+ *
+ * A stamp holds the artifacts of one module's last cook, the path of every file that cook pulled in,
+ * and a fingerprint over all of it. The fingerprint covers the text of each of those files, the
+ * module's permutation space and policy, and every option that reaches the output. Checking a stamp
+ * reads those files again and hashes them, and that is all: no Slang session starts. An edit to a
+ * shared include changes the fingerprint of every module that imports it, and of no other module.
+ *
+ * What the fingerprint cannot see is the Slang build itself. A new Slang build needs a cook with
+ * `--no-incremental`, or a new `k_ModuleStampVersion`. */
+namespace lodestone
+{
+
+/** Bump this whenever the cook can produce different text from the same inputs. */
+inline constexpr uint32_t k_ModuleStampVersion{ 7u };
+
+/** `dependency_texts` runs parallel to `dependency_paths`. */
+ContentHashValue ComputeModuleFingerprint(const CookerOptions& options,
+                                          std::string_view header_name,
+                                          std::string_view module_name,
+                                          std::span<const std::string> dependency_paths,
+                                          std::span<const std::string> dependency_texts);
+
+class ModuleStampStore final
+{
+public:
+    /** An empty directory turns the store off. `header_name` is the name of the generated header,
+     * because the module's source includes it by that name. */
+    ModuleStampStore(const std::filesystem::path& cache_directory, std::string_view header_name);
+
+    [[nodiscard]] bool IsEnabled() const noexcept;
+
+    /** The artifacts of the last cook of this module, when every input still hashes the same. */
+    [[nodiscard]] std::optional<ModuleArtifacts> FindUnchanged(
+        const CookerOptions& options,
+        const std::filesystem::path& module_path) const;
+
+    void Store(const CookerOptions& options,
+               const std::filesystem::path& module_path,
+               std::span<const std::string> dependency_paths,
+               std::span<const std::string> dependency_texts,
+               const ModuleArtifacts& artifacts) const;
+
+private:
+    [[nodiscard]] ContentHashValue MakeStampKey(const std::filesystem::path& module_path) const;
+    [[nodiscard]] std::filesystem::path MakeStampPath(const std::filesystem::path& module_path) const;
+
+    std::filesystem::path directory;
+    std::string headerName;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_MODULE_STAMP_HPP
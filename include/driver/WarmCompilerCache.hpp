@@ -0,0 +1,105 @@
+#pragma once
+#ifndef LODESTONE_WARM_COMPILER_CACHE_HPP
+#define LODESTONE_WARM_COMPILER_CACHE_HPP
+#include "compile/SlangCompiler.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** Keeps Slang compilers alive between cooks, for a process that cooks more than once.
+ *
+ * A cook starts a global session for every compiler it builds, and loads each module's root. The
+ * global session loads Slang's core module, which dominates a small cook. A long-lived cooker hands
+ * its compilers back here when a module finishes, and the next cook takes them out again.
+ *
+ * Each module keeps the compiler that loaded it. The next cook of the module takes that compiler
+ * loaded, session and all, when every file the module read still has the text it had and the
+ * compiler options are the same. Otherwise the compiler loads the module again in a new session, and
+ * keeps its global session. The module's pool workers stay with it on the same terms, so a cook of an
+ * unchanged module loads nothing on any thread. A worker the module no longer needs, or one that must
+ * load, comes from a shared set of spare compilers, each of which keeps a global session.
+ *
+ * Every call locks, and none sits on a per-variant path. One module's compiler is out with one cook at
+ * a time. */
+namespace lodestone
+{
+
+struct WarmCompilerStatistics
+{
+    /** Modules whose compiler came back loaded, and modules that had to load. */
+    uint32_t ModulesWarm{ 0u };
+    uint32_t ModulesLoaded{ 0u };
+    /** Pool workers that came back with their module loaded, and workers that had to load it. */
+    uint32_t WorkersWarm{ 0u };
+    uint32_t WorkersLoaded{ 0u };
+    /** Compilers that came back with a global session, and ones that had to start one. */
+    uint32_t GlobalSessionsReused{ 0u };
+    uint32_t GlobalSessionsCreated{ 0u };
+};
+
+class WarmCompilerCache final
+{
+public:
+    WarmCompilerCache();
+    ~WarmCompilerCache();
+    WarmCompilerCache(const WarmCompilerCache&) = delete;
+    WarmCompilerCache& operator=(const WarmCompilerCache&) = delete;
+
+    /** A module's compiler. `IsLoaded` means it holds the module already and needs only `Rebind`;
+     * otherwise the caller must `Initialize` it. `Workers` are the pool workers that held the module
+     * after its last cook and read the same files as `Compiler`. Each needs only `Rebind` too, so they
+     * come only with a loaded `Compiler`. */
+    struct Checkout
+    {
+        SlangCompiler Compiler;
+        std::vector<SlangCompiler> Workers;
+        bool IsLoaded{ false };
+    };
+
+    [[nodiscard]] Checkout CheckOutModule(const SlangCompilerCreateInfo& create_info);
+    /** `is_loaded` says the module loaded and its checks passed. `workers` are the pool workers that
+     * loaded it as well, and they stay with it. A compiler that failed goes back as a spare with its
+     * workers, so the next cook loads the module again. */
+    void ReturnModule(const SlangCompilerCreateInfo& create_info,
+                      SlangCompiler&& compiler,
+                      bool is_loaded,
+                      std::vector<SlangCompiler>&& workers);
+
+    /** Up to `count` spare compilers for pool workers that must load their module. The pool builds new
+     * ones for the rest. */
+    [[nodiscard]] std::vector<SlangCompiler> CheckOutSpares(size_t count);
+    void ReturnSpares(std::vector<SlangCompiler>&& compilers);
+
+    /** Forgets every loaded module, so the next cook loads each one again. Global sessions stay. */
+    void Invalidate();
+
+    [[nodiscard]] WarmCompilerStatistics GetStatistics() const;
+
+private:
+    /** A loaded compiler, its pool workers, and the options they loaded the module with. */
+    struct WarmModule
+    {
+        SlangCompiler Compiler;
+        std::vector<SlangCompiler> Workers;
+        std::filesystem::path ModuleCacheDirectory;
+        uint32_t OptimizationLevel{ 0u };
+        bool MultithreadEntryPointCodegen{ true };
+    };
+
+    [[nodiscard]] static bool CanReuse(const WarmModule& warm, const SlangCompilerCreateInfo& create_info);
+    [[nodiscard]] static bool DependenciesUnchanged(const SlangCompiler& compiler);
+    [[nodiscard]] static bool ReadSameSources(const SlangCompiler& worker, const SlangCompiler& compiler);
+
+    mutable std::mutex mutex;
+    std::map<std::string, WarmModule> modules;
+    std::vector<SlangCompiler> spares;
+    WarmCompilerStatistics statistics;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_WARM_COMPILER_CACHE_HPP
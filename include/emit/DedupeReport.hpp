@@ -1,7 +1,10 @@
 #pragma once
 #ifndef LODESTONE_DEDUPE_REPORT_HPP
 #define LODESTONE_DEDUPE_REPORT_HPP
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
 #include "model/CookedLibrary.hpp"
+#include <span>
 #include <string>
 #include <vector>
 
@@ -56,7 +59,10 @@ bool AllVariantsShareOneLayout(const CookedModule& module);
  * A mismatch fails the cook and names the entry point and the axis. */
 CookResult<void> EnforceModulePolicy(const CookedModule& module, const ModuleInfluence& influence);
 
-std::string GenerateDedupeReport(const CookedLibrary& library);
+/** One module's block of the report. `GenerateDedupeReport` joins these under one preamble, and ends
+ * with what the library pass folded across modules. */
+std::string GenerateDedupeReportSection(const CookedModule& module);
+std::string GenerateDedupeReport(std::span<const ModuleArtifacts> modules, const LibraryStatistics& library);
 
 std::string_view ToString(AxisInfluence influence) noexcept;
 
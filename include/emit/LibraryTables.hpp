@@ -0,0 +1,65 @@
+#pragma once
+#ifndef LODESTONE_LIBRARY_TABLES_HPP
+#define LODESTONE_LIBRARY_TABLES_HPP
+#include "CookerErrors.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "model/CookedLibrary.hpp"
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The library-level interning pass. Each module interns its own tables, so text that two modules share,
+ * such as a fullscreen-quad vertex shader, sits once in each of them. This pass folds the tables of
+ * every module into library tables, where it sits once.
+ *
+ * The pass reads the module manifests, not `CookedModule`. A module taken from its stamp arrives as
+ * artifacts alone, and by the time the library emits, a cooked module has already given up its
+ * tables. The manifest holds every table this pass folds, and every module of the cook has one.
+ *
+ * Sources, resources and raster states are folded. Only the sources move into a shared table on
+ * disk: a source is kilobytes of text, while a binding or a raster record is a few dozen bytes that
+ * name strings in its own module's string table. The other two tables are folded for the report, so
+ * it shows what sharing them would save.
+ */
+namespace lodestone
+{
+
+struct LibraryStatistics
+{
+    uint32_t ModuleCount{ 0u };
+    /** An artifact here is one entry of one module's table. */
+    TableStatistics SourceTable;
+    TableStatistics ResourceTable;
+    TableStatistics RasterTable;
+    /** Source text the module tables hold between them, and what the library table holds. */
+    uint64_t ModuleSourceBytes{ 0u };
+    uint64_t LibrarySourceBytes{ 0u };
+    /** True when the cook wrote the library source file, and the module manifests read from it. */
+    bool SourcesShared{ false };
+};
+
+struct LibraryTables
+{
+    /** Each unique source once, in the order the modules first hold it. The views point into the
+     * module manifests, so they live as long as the artifacts the fold read, or into `JoinedSources`. */
+    std::vector<std::string_view> Sources;
+    /** The text of each unique source that a manifest stores as several chunks or compressed, joined or
+     * decoded. A deque, so a view into one stays valid as the fold adds the next. */
+    std::deque<std::string> JoinedSources;
+    /** One for each module, in module order: the library index of each entry of the module's source
+     * table. */
+    std::vector<std::vector<uint32_t>> SourceRemaps;
+    LibraryStatistics Statistics;
+};
+
+/** Folds the tables of every module into library tables. With `dedupe_enabled` false, every entry keeps
+ * its own index, as the module interners do under `--no-dedupe`. Fails when a manifest does not open. */
+CookResult<LibraryTables> FoldLibraryTables(std::span<const ModuleArtifacts> modules, bool dedupe_enabled);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_LIBRARY_TABLES_HPP
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef LODESTONE_MODULE_ARTIFACTS_HPP
+#define LODESTONE_MODULE_ARTIFACTS_HPP
+#include "CookerErrors.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** One module's share of every artifact a cook writes, as finished text.
+ *
+ * The header and the dedupe report cover the whole library, but each is a run of per-module sections
+ * with a little glue around them. The glue needs only the module names and the entry point names. So
+ * once a module is emitted, the library no longer needs its `CookedModule`, and a module whose inputs
+ * did not change can hand back the text of its last cook instead of cooking again. */
+namespace lodestone
+{
+
+struct ModuleArtifacts
+{
+    std::string Name;
+    /** In declaration order. The header numbers `EntryPointId` from these. */
+    std::vector<std::string> EntryPointNames;
+    /** The permutation struct and the index helpers of this module. */
+    std::string HeaderSection;
+    std::string SourceFileName;
+    std::string Source;
+    std::string ManifestFileName;
+    std::string Manifest;
+    std::string ReportSection;
+};
+
+std::string SerializeModuleArtifacts(const ModuleArtifacts& artifacts);
+CookResult<ModuleArtifacts> DeserializeModuleArtifacts(std::string_view bytes);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_MODULE_ARTIFACTS_HPP
@@ -1,7 +1,9 @@
 #pragma once
 #ifndef LODESTONE_SHADER_LIBRARY_EMITTER_HPP
 #define LODESTONE_SHADER_LIBRARY_EMITTER_HPP
+#include "emit/ModuleArtifacts.hpp"
 #include "model/CookedLibrary.hpp"
+#include <span>
 #include <string>
 
 /** Turns the frozen library into C++.
@@ -24,7 +26,10 @@ namespace lodestone
  * but it makes the generated file unreadable when you diff it to find a broken shader. */
 inline constexpr size_t k_MaxStringLiteralBytes = 8192u;
 
-std::string EmitShaderLibraryHeader(const CookedLibrary& library);
+/** The part of the header that belongs to one module. `EmitShaderLibraryHeader` joins these in module
+ * order, between the id enums and the accessor declarations. */
+std::string EmitShaderLibraryHeaderSection(const CookedModule& module);
+std::string EmitShaderLibraryHeader(std::span<const ModuleArtifacts> modules);
 std::string EmitShaderLibraryModuleSource(const CookedModule& module, std::string_view header_name);
 
 std::string MakeModuleSourceFileName(std::string_view header_stem, std::string_view module_name);
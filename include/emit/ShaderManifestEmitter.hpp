@@ -2,7 +2,10 @@
 #ifndef LODESTONE_MANIFEST_EMITTER_HPP
 #define LODESTONE_MANIFEST_EMITTER_HPP
 #include "model/CookedLibrary.hpp"
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 
 /**
  * Writes one CookedModule as the binary manifest that `include/shader/ShaderManifest.hpp` reads.
@@ -17,11 +20,45 @@
 namespace lodestone
 {
 
+/** How a manifest stores the text of its sources. */
+enum class ManifestSourceLayout : uint8_t
+{
+    /** Each unique source once, whole. `Source` reads any of them in place. */
+    Whole = 0,
+    /** Each source cut into content-defined chunks, and each unique chunk once, so variants that share
+     * most of their text share most of their bytes. `--chunk-sources` picks it. */
+    Chunked = 1,
+};
+
+/** Whether a manifest compresses the text it stores. */
+enum class ManifestSourceCompression : uint8_t
+{
+    /** The text sits in the file as it is, and a reader can view it in place. */
+    None = 0,
+    /** Each source table entry, whole source or chunk, is compressed alone in blocks of at most
+     * `k_SourceBlockSize`, so a reader decodes one source without the rest. `--compress-sources`. */
+    Blocks = 1,
+    /** Blocks as above, each encoded against one dictionary trained from the entries of the table and
+     * stored beside them. Small sources that share their declarations gain the most.
+     * `--source-dictionary`. */
+    Dictionary = 2,
+};
+
+struct ManifestSourceOptions
+{
+    ManifestSourceLayout Layout{ ManifestSourceLayout::Whole };
+    ManifestSourceCompression Compression{ ManifestSourceCompression::None };
+};
+
 /** The returned bytes must start on an 8-byte boundary before a reader opens them.
  * `ShaderManifestView::Open` rejects a span that does not, because it maps 64-bit fields in place. A
  * heap allocated `std::string` satisfies this today, but the type does not promise it. Copy the bytes
- * into an aligned buffer if you ever move them somewhere the alignment is not certain. */
-std::string EmitShaderManifest(const CookedModule& module);
+ * into an aligned buffer if you ever move them somewhere the alignment is not certain.
+ *
+ * With `ManifestSourceLayout::Chunked`, the chunks collapse only when the module's own source table
+ * did: a module cooked with `--no-dedupe` keeps every chunk of every source. Compression applies to
+ * whatever the source table holds, so chunks are compressed one by one. */
+std::string EmitShaderManifest(const CookedModule& module, const ManifestSourceOptions& source_options = {});
 
 std::string MakeManifestFileName(std::string_view module_name);
 
@@ -32,6 +69,30 @@ std::string MakeManifestFileName(std::string_view module_name);
  * failure this format could hide, so the check is not optional. */
 CookResult<void> VerifyManifestRoundTrip(const CookedModule& module, const std::string& manifest_bytes);
 
+/** The library source file of one cook, named after the header. */
+std::string MakeLibrarySourceFileName(std::string_view header_stem);
+
+/** A manifest that holds the name of the library and its source table, and nothing else. The module
+ * manifests that `ShareManifestSources` writes read their text from it, compressed or not. */
+std::string EmitLibrarySourceManifest(
+    std::string_view library_name,
+    std::span<const std::string_view> sources,
+    ManifestSourceCompression compression = ManifestSourceCompression::None);
+
+/** Rewrites one module manifest to read its sources from the library source file. The source sections
+ * go, compressed or not, `k_ManifestSharedSources` is set, and each slot's source index passes through
+ * `library_indices`, which holds the library index of each entry of the module's source table. Every
+ * other section is copied unchanged. A manifest with chunked sources is refused: the library source
+ * file holds whole sources. */
+CookResult<std::string> ShareManifestSources(const std::string& manifest_bytes,
+                                             std::span<const uint32_t> library_indices);
+
+/** Opens the rewritten manifest against the library source file, and compares every slot against the
+ * manifest it was rewritten from. Like `VerifyManifestRoundTrip`, it runs on every cook that shares. */
+CookResult<void> VerifySharedSourceRoundTrip(const std::string& module_manifest,
+                                             const std::string& shared_manifest,
+                                             const std::string& library_sources);
+
 } // namespace lodestone
 
 #endif // !LODESTONE_MANIFEST_EMITTER_HPP
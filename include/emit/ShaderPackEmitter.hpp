@@ -0,0 +1,43 @@
+#pragma once
+#ifndef LODESTONE_SHADER_PACK_EMITTER_HPP
+#define LODESTONE_SHADER_PACK_EMITTER_HPP
+#include "CookerErrors.hpp"
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * Writes the module manifests of one cook into the single pack file that `client/include/ShaderPack.hpp`
+ * reads.
+ *
+ * Each manifest goes in unchanged, so the pack holds nothing a module file would not. The table of
+ * contents is the only new structure, and it is built here and nowhere else.
+ */
+namespace lodestone
+{
+
+/** One module of a pack: the name a program looks it up by, and its finished manifest. */
+struct ShaderPackEntry
+{
+    std::string_view ModuleName;
+    std::string_view Manifest;
+};
+
+/** The pack of one cook, named after the header. */
+std::string MakeShaderPackFileName(std::string_view header_stem);
+
+/** Lays out the header, the table of contents, the library source file when `shared_sources` is not
+ * empty, and then every manifest, each on an 8-byte boundary. The table has a power-of-two slot count
+ * at least twice the module count, and two modules with one name are a bug of the caller.
+ *
+ * Like `EmitShaderManifest`, the bytes must sit on an 8-byte boundary before a reader opens them. */
+std::string EmitShaderPack(std::span<const ShaderPackEntry> modules, std::string_view shared_sources = {});
+
+/** Opens the pack and finds every module by name, and checks that each one reads back byte for byte
+ * as the manifest that went in. Runs on every cook that packs. */
+CookResult<void> VerifyShaderPackRoundTrip(std::span<const ShaderPackEntry> modules,
+                                           const std::string& pack_bytes);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SHADER_PACK_EMITTER_HPP
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef LODESTONE_SOURCE_BLOCK_ENCODER_HPP
+#define LODESTONE_SOURCE_BLOCK_ENCODER_HPP
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * The encoder half of `client/include/SourceBlockCodec.hpp`. It lives here rather than beside the
+ * decoder because only the cooker compresses.
+ *
+ * It is a greedy matcher over a hash of the next four bytes, which is fast and finds the repeats WGSL
+ * is full of: the same swizzles, the same casts, the same indexing into one buffer. It does not search
+ * for the longest match, so a tuned LZ4 or zstd would do somewhat better on the same text.
+ *
+ * The dictionary trainer keeps the lines that recur across sources: the struct declarations, bindings
+ * and helper functions every variant of a shader repeats. It is a much plainer cousin of zstd's COVER
+ * trainer, which scores substrings rather than lines.
+ */
+namespace lodestone
+{
+
+/** One block in the format `DecodeSourceBlock` reads. `input` must be at most `k_SourceBlockSize`
+ * bytes. The result can be a little longer than `input` when the text does not repeat; the caller then
+ * stores the bytes as they are. A block encoded against `dictionary` decodes only with it. */
+std::string EncodeSourceBlock(std::string_view input, std::string_view dictionary = {});
+
+/** At most `max_size` bytes of text that recurs across `samples`: each line that two or more samples
+ * hold, the lines that save the most first, laid out in the order the samples first hold them so that
+ * a run of shared lines stays one match. Empty when no line recurs. The same samples give the same
+ * dictionary. */
+std::string TrainSourceDictionary(std::span<const std::string_view> samples, size_t max_size);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SOURCE_BLOCK_ENCODER_HPP
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef LODESTONE_BINARY_STREAM_HPP
+#define LODESTONE_BINARY_STREAM_HPP
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/** The byte format of the files the cooker keeps for itself between cooks.
+ *
+ * Numbers go out in the byte order of the machine that wrote them, and an enum goes out as a
+ * `uint32_t`. That is fine for a cache that never leaves the machine, and wrong for anything that
+ * ships: the manifest has its own layout for that reason. A string is a `uint32_t` length and then its
+ * bytes. */
+namespace lodestone
+{
+
+class BinaryWriter
+{
+public:
+    template<typename T>
+    void Write(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if constexpr (std::is_enum_v<T>)
+        {
+            Write(static_cast<uint32_t>(std::to_underlying(value)));
+        }
+        else
+        {
+            bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+    }
+
+    void WriteString(std::string_view text)
+    {
+        Write(static_cast<uint32_t>(text.size()));
+        bytes.append(text);
+    }
+
+    [[nodiscard]] std::string Take() noexcept
+    {
+        return std::move(bytes);
+    }
+
+private:
+    std::string bytes;
+};
+
+/** Reads what `BinaryWriter` wrote. A read past the end sets `failed` and yields a zero, so a caller
+ * checks once at the end rather than after every field. */
+class BinaryReader
+{
+public:
+    explicit BinaryReader(std::string_view _bytes) noexcept
+        : bytes{ _bytes }
+    {
+    }
+
+    template<typename T>
+    T Read() noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if constexpr (std::is_enum_v<T>)
+        {
+            return static_cast<T>(Read<uint32_t>());
+        }
+        else
+        {
+            T value{};
+            if (!Take(sizeof(T)))
+            {
+                return value;
+            }
+
+            std::memcpy(&value, bytes.data() + offset - sizeof(T), sizeof(T));
+            return value;
+        }
+    }
+
+    std::string ReadString()
+    {
+        const uint32_t size = Read<uint32_t>();
+        if (!Take(size))
+        {
+            return {};
+        }
+
+        return std::string{ bytes.substr(offset - size, size) };
+    }
+
+    /** A count that cannot fit in the bytes left is corrupt, so it fails here rather than reaching a
+     * `reserve` of four billion elements. */
+    uint32_t ReadCount(size_t smallest_element_size) noexcept
+    {
+        const uint32_t count = Read<uint32_t>();
+        if (static_cast<uint64_t>(count) * smallest_element_size > bytes.size() - offset)
+        {
+            failed = true;
+            return 0u;
+        }
+
+        return count;
+    }
+
+    /** True when every read fit, and the reads consumed every byte. */
+    [[nodiscard]] bool Succeeded() const noexcept
+    {
+        return !failed && offset == bytes.size();
+    }
+
+private:
+    bool Take(size_t size) noexcept
+    {
+        if (failed || size > bytes.size() - offset)
+        {
+            failed = true;
+            return false;
+        }
+
+        offset += size;
+        return true;
+    }
+
+    std::string_view bytes;
+    size_t offset{ 0u };
+    bool failed{ false };
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_BINARY_STREAM_HPP
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef LODESTONE_CACHE_FILE_HPP
+#define LODESTONE_CACHE_FILE_HPP
+#include "model/ContentHash.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/** The files the cooker keeps for itself between cooks, under the cache directory.
+ *
+ * Every such file is a short header and a payload. The header names the kind of file, its layout
+ * version, and the key it was written for, and it carries a hash of the payload, which catches a file
+ * that a crash or a full disk cut short. A file that fails any check is a miss, never an error: a cache
+ * is only a shortcut around work the cook can still do.
+ *
+ * A file is written beside its final name and renamed over it, so a reader sees a whole file or no
+ * file. Two cooks that race on one name write the same bytes. */
+namespace lodestone
+{
+
+/** The header, then `payload`. */
+std::string SealCacheRecord(uint32_t magic, uint32_t version, ContentHashValue key, std::string_view payload);
+
+/** The payload of `record`, when its header agrees with every argument. The view points into
+ * `record`. */
+std::optional<std::string_view> OpenCacheRecord(std::string_view record,
+                                                uint32_t magic,
+                                                uint32_t version,
+                                                ContentHashValue key) noexcept;
+
+/** The whole file, or nothing. A missing file is the common case and is not worth a word. */
+std::optional<std::string> ReadCacheFile(const std::filesystem::path& path);
+
+/** Writes the file whole, or not at all. A failure leaves the old file, or none, and says nothing. */
+void WriteCacheFile(const std::filesystem::path& path, std::string_view bytes);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_CACHE_FILE_HPP
@@ -0,0 +1,275 @@
+#pragma once
+#ifndef LODESTONE_CONCURRENT_CONTENT_INTERNER_HPP
+#define LODESTONE_CONCURRENT_CONTENT_INTERNER_HPP
+#include "ContentHash.hpp"
+#include "ContentInterner.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * A `ContentInterner` that many threads can feed at once. It follows the same three rules: a hash only
+ * finds a bucket, every source is recorded, and `Disable()` gives every artifact its own index.
+ *
+ * Interning is split in two steps:
+ *
+ * 1. `Stage` hashes a payload and finds or adds its entry. Any thread can stage. The buckets are spread
+ *    over `k_ShardCount` shards by hash, and each shard has its own lock, so two threads only wait for
+ *    each other when their payloads land in the same shard. The hash and the byte comparison are the
+ *    expensive part, and they both happen here.
+ *
+ * 2. `Commit` gives the staged entry its index and records where it came from. One thread commits, in
+ *    variant order. An entry takes its index the first time it is committed, so the indices, the
+ *    provenance order and the counters are exactly what a serial `ContentInterner` gives for the same
+ *    order. Which thread staged first does not reach the output, and `--verify-deterministic` holds.
+ *
+ * An entry that is staged and never committed takes no index and never reaches the table.
+ *
+ * Each shard keeps its buckets in a `HashSlotTable`, as `ContentInterner` does, and chains the entries
+ * of one hash through their index in the shard. The entries sit in blocks that never move, so a ticket
+ * stays valid while the shard grows, and only the first entry of a block allocates.
+ */
+namespace lodestone
+{
+
+template<typename PayloadType>
+class ConcurrentContentInterner final
+{
+private:
+    struct Entry;
+
+public:
+    using HashFunction = ContentHashValue (*)(const PayloadType&) noexcept;
+
+    /** Sixteen shards keep a lock free for each compile worker on most machines. */
+    static constexpr uint32_t k_ShardCount{ 16u };
+
+    /**@brief A staged payload, waiting for its commit. It stays valid for the life of the interner. */
+    struct Ticket
+    {
+        Entry* Staged{ nullptr };
+    };
+
+    ConcurrentContentInterner(HashFunction hash_function, std::string_view hash_name) noexcept
+        : hashFunction{ hash_function },
+          hashName{ hash_name },
+          dedupeEnabled{ true },
+          shardSet{ std::make_unique<ShardSet>() }
+    {
+        committed.reserve(1024);
+    }
+
+    /** Call before the first `Stage`. */
+    void Disable() noexcept
+    {
+        dedupeEnabled = false;
+    }
+
+    [[nodiscard]] bool IsEnabled() const noexcept
+    {
+        return dedupeEnabled;
+    }
+
+    void DisableProvenance() noexcept
+    {
+        provenance.Disable();
+    }
+
+    [[nodiscard]] bool IsProvenanceRecorded() const noexcept
+    {
+        return provenance.IsEnabled();
+    }
+
+    /** Finds or adds the entry for `payload`. Safe to call from any number of threads, and alongside
+     * `Commit`. The payload is copied only when it is new. */
+    [[nodiscard]] Ticket Stage(const PayloadType& payload)
+    {
+        if (!dedupeEnabled)
+        {
+            // No hash, no bucket: the identity path spreads its entries over the shards in turn.
+            const uint32_t shardIndex =
+                shardSet->NextIdentityShard.fetch_add(1u, std::memory_order_relaxed) % k_ShardCount;
+            Shard& shard = shardSet->Shards[shardIndex];
+            const std::scoped_lock lock{ shard.Mutex };
+            return Ticket{ &shard.EntryAt(shard.Append(payload)) };
+        }
+
+        const ContentHashValue hash = hashFunction(payload);
+        Shard& shard = shardSet->Shards[hash % k_ShardCount];
+        const std::scoped_lock lock{ shard.Mutex };
+        HashSlotTable::Slot& slot = shard.Slots.Find(hash);
+        for (uint32_t candidate = slot.FirstIndex; candidate != k_EndOfChain;
+             candidate = shard.EntryAt(candidate).NextWithSameHash)
+        {
+            if (shard.EntryAt(candidate).Payload == payload)
+            {
+                return Ticket{ &shard.EntryAt(candidate) };
+            }
+        }
+
+        const uint32_t firstIndex = slot.FirstIndex;
+        const uint32_t addedIndex = shard.Append(payload);
+        Entry& added = shard.EntryAt(addedIndex);
+        added.ChainHead = firstIndex != k_EndOfChain ? &shard.EntryAt(firstIndex) : &added;
+        if (const uint32_t previous = shard.Slots.Append(slot, hash, addedIndex); previous != k_EndOfChain)
+        {
+            shard.EntryAt(previous).NextWithSameHash = addedIndex;
+        }
+
+        return Ticket{ &added };
+    }
+
+    /** Gives a staged entry its index, the first time it arrives here, and records `origin` against it.
+     * Call from one thread, in the order the indices must follow. */
+    InternResult Commit(Ticket ticket, ProvenanceRecord origin)
+    {
+        ++statistics.ArtifactsSeen;
+
+        Entry& entry = *ticket.Staged;
+        const bool wasNew = entry.Index == k_Uncommitted;
+        if (wasNew)
+        {
+            entry.Index = static_cast<uint32_t>(committed.size());
+            // Only this thread reads or writes the count, so the stagers never see it move.
+            entry.BucketRank = entry.ChainHead != nullptr ? entry.ChainHead->ChainCommittedCount++ : 0u;
+            committed.push_back(&entry);
+            statistics.UniqueEntries = static_cast<uint32_t>(committed.size());
+        }
+
+        if (dedupeEnabled)
+        {
+            // A serial interner walks the bucket in index order. It compares against every entry
+            // committed before this one, and each of those is a collision. A repeat compares once more,
+            // against itself. Counted here, the numbers do not depend on which thread staged first.
+            statistics.HashCollisions += entry.BucketRank;
+            statistics.ByteComparisons += entry.BucketRank + (wasNew ? 0u : 1u);
+        }
+
+        provenance.Record(entry.Index, origin);
+        return InternResult{ entry.Index, wasNew };
+    }
+
+    /** Stage and commit in one step, for a caller that has one thread anyway. */
+    InternResult Intern(const PayloadType& payload, ProvenanceRecord origin)
+    {
+        return Commit(Stage(payload), origin);
+    }
+
+    [[nodiscard]] uint32_t UniqueCount() const noexcept
+    {
+        return static_cast<uint32_t>(committed.size());
+    }
+
+    /** The committing thread only. `index` must be less than `UniqueCount()`. */
+    [[nodiscard]] const PayloadType& EntryAt(uint32_t index) const noexcept
+    {
+        return committed[index]->Payload;
+    }
+
+    /** Moves the committed entries out in index order. No thread may stage after this. */
+    [[nodiscard]] std::vector<PayloadType> ConsumeTable()
+    {
+        std::vector<PayloadType> table;
+        table.reserve(committed.size());
+        for (Entry* entry : committed)
+        {
+            table.emplace_back(std::move(entry->Payload));
+        }
+
+        return table;
+    }
+
+    /** The committing thread only. Empty when provenance is off. */
+    [[nodiscard]] std::span<const ProvenanceRecord> OriginsOf(uint32_t index) const
+    {
+        return provenance.OriginsOf(index);
+    }
+
+    [[nodiscard]] const InternerStatistics& Statistics() const noexcept
+    {
+        return statistics;
+    }
+
+    [[nodiscard]] std::string_view HashName() const noexcept
+    {
+        return hashName;
+    }
+
+private:
+    static constexpr uint32_t k_Uncommitted{ std::numeric_limits<uint32_t>::max() };
+    static constexpr uint32_t k_EndOfChain{ HashSlotTable::k_EndOfChain };
+    /** 64 slots for each shard hold 768 distinct hashes over all sixteen before the first growth. */
+    static constexpr size_t k_InitialSlotsPerShard{ 64u };
+    static constexpr uint32_t k_EntriesPerBlock{ 64u };
+
+    struct Entry
+    {
+        /** Never changes once staged, so a stager can compare it without waiting for a commit. */
+        PayloadType Payload{};
+        /** The first entry staged with this hash, which is itself for the first. Null on the identity
+         * path. An entry never moves, so the pointer holds while the shard grows. */
+        Entry* ChainHead{ nullptr };
+        /** The next entry of the shard with the same hash. Written by the stagers, under the shard lock. */
+        uint32_t NextWithSameHash{ k_EndOfChain };
+        /** The committing thread alone reads and writes these three. `ChainCommittedCount` counts the
+         * committed entries of a chain, on its head. */
+        uint32_t Index{ k_Uncommitted };
+        uint32_t BucketRank{ 0u };
+        uint32_t ChainCommittedCount{ 0u };
+    };
+
+    struct Shard
+    {
+        /** Under `Mutex`. A new entry starts a block only every `k_EntriesPerBlock` entries. */
+        [[nodiscard]] uint32_t Append(const PayloadType& payload)
+        {
+            if (EntryCount % k_EntriesPerBlock == 0u)
+            {
+                EntryBlocks.push_back(std::make_unique<Entry[]>(k_EntriesPerBlock));
+            }
+
+            EntryAt(EntryCount).Payload = payload;
+            return EntryCount++;
+        }
+
+        /** Under `Mutex`. The committing thread holds an `Entry*` instead, and never needs the lock. */
+        [[nodiscard]] Entry& EntryAt(uint32_t index) noexcept
+        {
+            return EntryBlocks[index / k_EntriesPerBlock][index % k_EntriesPerBlock];
+        }
+
+        std::mutex Mutex;
+        HashSlotTable Slots{ k_InitialSlotsPerShard };
+        /** Blocks never move, so a ticket stays valid while the shard grows. */
+        std::vector<std::unique_ptr<Entry[]>> EntryBlocks;
+        uint32_t EntryCount{ 0u };
+    };
+
+    /** On the heap, so the interner can move while its tickets stay valid. */
+    struct ShardSet
+    {
+        std::atomic<uint32_t> NextIdentityShard{ 0u };
+        std::array<Shard, k_ShardCount> Shards;
+    };
+
+    HashFunction hashFunction;
+    std::string_view hashName;
+    bool dedupeEnabled;
+    std::unique_ptr<ShardSet> shardSet;
+    std::vector<Entry*> committed;
+    ProvenanceLog provenance;
+    InternerStatistics statistics;
+};
+
+} // namespace lodestone
+
+#endif // !LODESTONE_CONCURRENT_CONTENT_INTERNER_HPP
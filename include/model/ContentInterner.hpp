@@ -2,10 +2,14 @@
 #ifndef LODESTONE_CONTENT_INTERNER_HPP
 #define LODESTONE_CONTENT_INTERNER_HPP
 #include "ContentHash.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 /**
@@ -29,18 +33,115 @@
  *
  * 3. You can stop deduplication. The `Disable()` function gives every item
  *    its own index. The build output must be correct and identical in both modes.
+ *
+ * The buckets live in one `HashSlotTable`, and the rest of each chain runs through
+ * `nextWithSameHash`, which sits beside the entries.
  */
 namespace lodestone
 {
 
-/** @brief One artifact that mapped onto a unique entry. */
+/** @brief One artifact that mapped onto a unique entry. It holds indices only: the entry point's name
+ * and the variant's description live once in the module, and `ResolveProvenanceNames` reads them there
+ * when a report asks. */
 struct ProvenanceRecord
 {
-    std::string EntryPointName;
-    std::string VariantDescription;
+    /** For an artifact the whole variant shares, such as its resource list. */
+    static constexpr uint32_t k_WholeVariant{ std::numeric_limits<uint32_t>::max() };
+
+    /** Into the module's entry points, or `k_WholeVariant`. */
+    uint32_t EntryPointIndex{ k_WholeVariant };
+    /** The variant's index in the permutation space, as in `LibraryVariant::Index`. */
     uint32_t VariantIndex{ 0u };
 };
 
+/**@brief Every provenance record of one interner, in one flat array in arrival order. An intern costs
+ * one append and no allocation of its own. `OriginsOf` groups the array by entry the first time it is
+ * asked after a change, and keeps arrival order within each entry.
+ *
+ * `OriginsOf` fills a cache, so two threads must not call it at once. */
+class ProvenanceLog final
+{
+public:
+    /** Records nothing from now on. A cook that never reads provenance saves the whole array. */
+    void Disable() noexcept
+    {
+        enabled = false;
+        logged.clear();
+        logged.shrink_to_fit();
+    }
+
+    [[nodiscard]] bool IsEnabled() const noexcept
+    {
+        return enabled;
+    }
+
+    void Record(uint32_t entry_index, ProvenanceRecord record)
+    {
+        if (enabled)
+        {
+            logged.push_back(LoggedOrigin{ .EntryIndex = entry_index, .Record = record });
+        }
+    }
+
+    [[nodiscard]] std::span<const ProvenanceRecord> OriginsOf(uint32_t entry_index) const
+    {
+        if (groupedCount != logged.size())
+        {
+            GroupByEntry();
+        }
+
+        if (static_cast<size_t>(entry_index) + 1u >= groupOffsets.size())
+        {
+            return {};
+        }
+
+        const uint32_t first = groupOffsets[entry_index];
+        const uint32_t count = groupOffsets[entry_index + 1u] - first;
+        return std::span<const ProvenanceRecord>{ grouped }.subspan(first, count);
+    }
+
+private:
+    struct LoggedOrigin
+    {
+        uint32_t EntryIndex{ 0u };
+        ProvenanceRecord Record;
+    };
+
+    /** A counting sort. Stable, so each entry keeps its records in arrival order. */
+    void GroupByEntry() const
+    {
+        size_t entryCount = 0u;
+        for (const LoggedOrigin& origin : logged)
+        {
+            entryCount = std::max<size_t>(entryCount, static_cast<size_t>(origin.EntryIndex) + 1u);
+        }
+
+        groupOffsets.assign(entryCount + 1u, 0u);
+        for (const LoggedOrigin& origin : logged)
+        {
+            ++groupOffsets[origin.EntryIndex + 1u];
+        }
+        for (size_t i = 1u; i < groupOffsets.size(); ++i)
+        {
+            groupOffsets[i] += groupOffsets[i - 1u];
+        }
+
+        std::vector<uint32_t> cursors{ groupOffsets.begin(), groupOffsets.end() - 1 };
+        grouped.resize(logged.size());
+        for (const LoggedOrigin& origin : logged)
+        {
+            grouped[cursors[origin.EntryIndex]++] = origin.Record;
+        }
+        groupedCount = logged.size();
+    }
+
+    bool enabled{ true };
+    std::vector<LoggedOrigin> logged;
+    mutable std::vector<uint32_t> groupOffsets;
+    mutable std::vector<ProvenanceRecord> grouped;
+    mutable size_t groupedCount{ 0u };
+};
+
 /** @brief The result - a lookup outcome - of interning */
 struct InternResult
 {
@@ -58,6 +159,93 @@ struct InternerStatistics
     /** Byte comparisons that a hash hit forced. A rising count means a worse hash, not a bug. */
     uint32_t ByteComparisons{ 0u };
 };
+/**@brief The flat open-addressing table an interner keeps its buckets in. A slot holds a hash and the
+ * first and last index with that hash, and the interner links the rest of each chain beside its
+ * entries. A new unique entry therefore costs no allocation of its own, and a lookup reads one slot
+ * rather than chasing a map node and then a vector. */
+class HashSlotTable final
+{
+public:
+    static constexpr uint32_t k_EndOfChain{ std::numeric_limits<uint32_t>::max() };
+
+    /** One distinct hash. An empty slot has `FirstIndex == k_EndOfChain`. */
+    struct Slot
+    {
+        ContentHashValue Hash{ 0u };
+        uint32_t FirstIndex{ k_EndOfChain };
+        uint32_t LastIndex{ k_EndOfChain };
+    };
+
+    /** `slot_count` must be a power of two. */
+    explicit HashSlotTable(size_t slot_count)
+        : slots(slot_count)
+    {
+    }
+
+    /** The slot that holds `hash`, or the empty slot where it belongs. Linear probing. */
+    [[nodiscard]] Slot& Find(ContentHashValue hash) noexcept
+    {
+        const size_t mask = slots.size() - 1u;
+        for (size_t i = HomeSlot(hash, slots.size());; i = (i + 1u) & mask)
+        {
+            Slot& slot = slots[i];
+            if (slot.FirstIndex == k_EndOfChain || slot.Hash == hash)
+            {
+                return slot;
+            }
+        }
+    }
+
+    /** Ends the chain of `slot`, which `Find(hash)` returned, with `index`. Returns the index that ended
+     * it before, for the caller to link to `index`, or `k_EndOfChain` when `index` starts the chain.
+     * The table can grow here, so `slot` is not valid afterwards. */
+    uint32_t Append(Slot& slot, ContentHashValue hash, uint32_t index)
+    {
+        const uint32_t previous = slot.LastIndex;
+        if (slot.FirstIndex == k_EndOfChain)
+        {
+            slot.Hash = hash;
+            slot.FirstIndex = index;
+            ++occupiedSlots;
+        }
+        slot.LastIndex = index;
+
+        // The table stays at most 3/4 full.
+        if (occupiedSlots * 4u > slots.size() * 3u)
+        {
+            Grow();
+        }
+
+        return previous;
+    }
+
+private:
+    /** Fibonacci hashing spreads the high bits over the table, so a weak hash in a test, or one that
+     * only varies in its top bits, still probes a short run. */
+    [[nodiscard]] static size_t HomeSlot(ContentHashValue hash, size_t slot_count) noexcept
+    {
+        const int shift = 64 - std::countr_zero(slot_count);
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    void Grow()
+    {
+        std::vector<Slot> previous(slots.size() * 2u);
+        previous.swap(slots);
+        for (const Slot& slot : previous)
+        {
+            if (slot.FirstIndex != k_EndOfChain)
+            {
+                Find(slot.Hash) = slot;
+            }
+        }
+    }
+
+    /** A power of two in size. */
+    std::vector<Slot> slots;
+    size_t occupiedSlots{ 0u };
+};
+
 /**@brief Note that this is templated on the payload type: that affects how equality and hashing can be
  * performed, and is another way we give ourselves flexibilty with output formats. This could be changed to be
  * SPIR-V, or GLSL, or DXIL, or any other format we want to support. The interner doesn't care, it just needs
@@ -71,11 +259,11 @@ public:
     ContentInterner(HashFunction hash_function, std::string_view hash_name) noexcept
         : hashFunction{ hash_function },
           hashName{ hash_name },
-          dedupeEnabled{ true }
+          dedupeEnabled{ true },
+          slots{ k_InitialSlotCount }
     {
         uniqueEntries.reserve(1024);
-        origins.reserve(1024);
-        buckets.reserve(256);
+        nextWithSameHash.reserve(1024);
     }
 
     /** Turns off collapsing. Every artifact then gets its own index, and the tables stay correct. */
@@ -89,6 +277,17 @@ public:
         return dedupeEnabled;
     }
 
+    /** Stops recording where artifacts came from. Indices and counters do not change. */
+    void DisableProvenance() noexcept
+    {
+        provenance.Disable();
+    }
+
+    [[nodiscard]] bool IsProvenanceRecorded() const noexcept
+    {
+        return provenance.IsEnabled();
+    }
+
     /** @brief take that payload and shove it somewhere else (intern. get it) */
     InternResult Intern(PayloadType payload, ProvenanceRecord origin)
     {
@@ -96,19 +295,20 @@ public:
 
         if (!dedupeEnabled)
         {
-            return Append(std::move(payload), std::move(origin));
+            return Append(std::move(payload), origin);
         }
 
         const ContentHashValue hash = hashFunction(payload);
-        // use [] here *because* we want to create the bucket
-        std::vector<uint32_t>& bucket = buckets[hash];
+        HashSlotTable::Slot& slot = slots.Find(hash);
 
-        for (uint32_t candidate : bucket)
+        // The chain runs in index order, so the comparisons happen in the order a bucket list gave.
+        for (uint32_t candidate = slot.FirstIndex; candidate != k_EndOfChain;
+             candidate = nextWithSameHash[candidate])
         {
             ++statistics.ByteComparisons;
             if (uniqueEntries[candidate] == payload)
             {
-                origins[candidate].emplace_back(std::move(origin));
+                provenance.Record(candidate, origin);
                 return InternResult{ candidate, false };
             }
 
@@ -116,8 +316,12 @@ public:
             ++statistics.HashCollisions;
         }
 
-        const InternResult appended = Append(std::move(payload), std::move(origin));
-        bucket.push_back(appended.Index);
+        const InternResult appended = Append(std::move(payload), origin);
+        if (const uint32_t previous = slots.Append(slot, hash, appended.Index); previous != k_EndOfChain)
+        {
+            nextWithSameHash[previous] = appended.Index;
+        }
+
         return appended;
     }
 
@@ -126,6 +330,11 @@ public:
         return uniqueEntries;
     }
 
+    [[nodiscard]] uint32_t UniqueCount() const noexcept
+    {
+        return static_cast<uint32_t>(uniqueEntries.size());
+    }
+
     /**@brief used during freezing step: a span is a non-owning view, which is great, but we can't move out
      * of it. and if we're holding a vector of source strings... it's worth moving it */
     [[nodiscard]] std::vector<PayloadType> ConsumeTable() noexcept
@@ -133,14 +342,10 @@ public:
         return std::move(uniqueEntries);
     }
 
-    [[nodiscard]] std::span<const ProvenanceRecord> OriginsOf(uint32_t index) const noexcept
+    /** Empty when provenance is off. */
+    [[nodiscard]] std::span<const ProvenanceRecord> OriginsOf(uint32_t index) const
     {
-        if (index >= origins.size())
-        {
-            return {};
-        }
-
-        return origins[index];
+        return provenance.OriginsOf(index);
     }
 
     [[nodiscard]] const InternerStatistics& Statistics() const noexcept
@@ -154,11 +359,16 @@ public:
     }
 
 private:
-    InternResult Append(PayloadType&& payload, ProvenanceRecord&& origin)
+    static constexpr uint32_t k_EndOfChain{ HashSlotTable::k_EndOfChain };
+    /** 512 slots hold 384 distinct hashes before the first growth, which covers most modules. */
+    static constexpr size_t k_InitialSlotCount{ 512u };
+
+    InternResult Append(PayloadType&& payload, ProvenanceRecord origin)
     {
         const uint32_t index = static_cast<uint32_t>(uniqueEntries.size());
         uniqueEntries.emplace_back(std::forward<PayloadType>(payload));
-        origins.emplace_back(std::vector<ProvenanceRecord>{ std::forward<ProvenanceRecord>(origin) });
+        provenance.Record(index, origin);
+        nextWithSameHash.push_back(k_EndOfChain);
         statistics.UniqueEntries = static_cast<uint32_t>(uniqueEntries.size());
         return InternResult{ index, true };
     }
@@ -166,9 +376,11 @@ private:
     HashFunction hashFunction;
     std::string_view hashName;
     bool dedupeEnabled;
-    std::unordered_map<ContentHashValue, std::vector<uint32_t>> buckets;
+    HashSlotTable slots;
+    /** The next entry with the same hash, or `k_EndOfChain`. One for each unique entry. */
+    std::vector<uint32_t> nextWithSameHash;
     std::vector<PayloadType> uniqueEntries;
-    std::vector<std::vector<ProvenanceRecord>> origins;
+    ProvenanceLog provenance;
     InternerStatistics statistics;
 };
 
@@ -1,13 +1,16 @@
 #pragma once
 #ifndef LODESTONE_COOKED_LIBRARY_HPP
 #define LODESTONE_COOKED_LIBRARY_HPP
+#include "ConcurrentContentInterner.hpp"
 #include "ContentHash.hpp"
 #include "ContentInterner.hpp"
 #include "CookerErrors.hpp"
+#include "compile/RawLibrary.hpp"
 #include "permute/PermutationSpace.hpp"
 #include "ShaderDataSchema.hpp"
 #include "ShaderLibraryTypes.hpp"
 #include <cstdint>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -79,9 +82,9 @@ struct TableStatistics
  *  stage to process as it sees fit. This object actually *does* the interning piece by piece, as
  *  compared to `CookedModule` which holds the completed results from this processing.
  *
- * @note As of now, there is no `InternedLibrary`: interning is a per-module operation for now.
- * In the future, we could intern libraries - but those would be most efficient running on interned
- * modules, anyways. */
+ * @note Interning here is per module. The library pass, `FoldLibraryTables` in emit/LibraryTables.hpp,
+ * folds the finished modules into library tables afterwards, so text two modules share is stored
+ * once. */
 struct InternedModule
 {
     std::string Name;
@@ -92,7 +95,10 @@ struct InternedModule
     // Every interner takes the name from `k_HashName`, because the name reaches the output and a new
     // hash needs a new name. A literal here is a second place to change, and the two spellings drifted
     // apart once already.
-    ContentInterner<std::string> SourceInterner{ &HashSourceString, k_HashName };
+    //
+    // Sources are the one table the compile workers feed. A source is kilobytes of text, so its hash
+    // and its byte comparison cost far more than the other tables, which hold a few integers each.
+    ConcurrentContentInterner<std::string> SourceInterner{ &HashSourceString, k_HashName };
     ContentInterner<ReflectedBinding> ResourceInterner{ &HashReflectedBinding, k_HashName };
     ContentInterner<ResourceList> ResourceListInterner{ &HashResourceList, k_HashName };
     ContentInterner<FootprintList> FootprintListInterner{ &HashFootprintList, k_HashName };
@@ -134,12 +140,44 @@ struct CookedLibrary
     std::vector<CookedModule> Modules;
 };
 
+/**@brief A source a compile worker already staged. */
+using StagedSource = ConcurrentContentInterner<std::string>::Ticket;
+
+/**@brief The sources one variant staged, one ticket for each entry point. The variant index travels with
+ * the tickets, so they cannot commit into another variant's record. */
+struct StagedVariantSources
+{
+    uint32_t VariantIndex{ 0u };
+    std::vector<StagedSource> Tickets;
+};
+
 void DisableDedupe(InternedModule& module) noexcept;
+/** Every interner stops recording provenance. The tables and the counters do not change. */
+void DisableProvenance(InternedModule& module) noexcept;
+
+/**@brief The names behind one provenance record. They view the module's own tables, so they live as
+ * long as the module does. Empty when the record points past them. */
+struct ProvenanceNames
+{
+    std::string_view EntryPointName;
+    std::string_view VariantDescription;
+};
 
-/** Adds one compiled variant to the module, interning each source, layout, and raster state. */
+ProvenanceNames ResolveProvenanceNames(const CookedModule& module, const ProvenanceRecord& record);
+ProvenanceNames ResolveProvenanceNames(const InternedModule& module, const ProvenanceRecord& record);
+
+/** Stages the text of each entry point into the module's source interner. Safe to call from a compile
+ * worker, alongside `AppendVariantToModule` on the thread that commits. */
+StagedVariantSources StageVariantSources(InternedModule& module, const RawVariant& variant);
+
+/** Adds one compiled variant to the module, interning each source, layout, and raster state. With
+ * `staged_sources`, the sources commit from those tickets, and are not hashed or compared again. Tickets
+ * staged for another variant, or for a different number of entry points, fail with
+ * `CookError::StagedSourcesMismatch` and change nothing. Without them, each source interns here. */
 CookResult<void> AppendVariantToModule(InternedModule& module,
                                        const CompiledVariant& variant,
-                                       const CanonicalAssignment& canonical);
+                                       const CanonicalAssignment& canonical,
+                                       const StagedVariantSources* staged_sources = nullptr);
 
 /**@brief "Freezes" the module by *consuming* `InternedModule`. CookedModule takes the results, gathering
  * all the data so far in one place. The intent was that CookedModule is a bundle of data, it doesn't hold
@@ -151,6 +189,11 @@ CookedModule FreezeModuleTables(InternedModule&& interned);
 std::string_view ResolveSource(const CookedModule& module,
                                const LibraryVariant& variant,
                                size_t entry_point_index) noexcept;
+/**@brief The same, through the tables of a module that is still interning. The tables only grow, so
+ * the answer for a variant already appended is the answer the frozen module will give. */
+std::string_view ResolveSource(const InternedModule& module,
+                               const LibraryVariant& variant,
+                               size_t entry_point_index) noexcept;
 
 /**@brief Retrieve the final shader layout built for one entry point of one variant
  * within a module.*/
@@ -162,6 +205,9 @@ ShaderLayout ResolveLayout(const CookedModule& module,
 ShaderLayoutView ResolveLayoutView(const CookedModule& module,
                                    const LibraryVariant& variant,
                                    size_t entry_point_index);
+ShaderLayoutView ResolveLayoutView(const InternedModule& module,
+                                   const LibraryVariant& variant,
+                                   size_t entry_point_index);
 
 } // namespace lodestone
 
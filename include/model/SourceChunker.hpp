@@ -0,0 +1,39 @@
+#pragma once
+#ifndef LODESTONE_SOURCE_CHUNKER_HPP
+#define LODESTONE_SOURCE_CHUNKER_HPP
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * Splits shader text into content-defined chunks, so two variants that differ in one function share
+ * every chunk but the few around it.
+ *
+ * Whole-source interning only collapses variants whose text is identical. Most variants are not: a
+ * define changes one loop, and the other few hundred lines come out of Slang the same. A chunk boundary
+ * depends only on the bytes just before it, never on where the source starts, so an edit moves the
+ * boundaries near it and no others. The chunks after it line up again, and intern onto the same entries.
+ *
+ * The boundary test is a gear hash: each byte shifts the hash left and adds a fixed random value for
+ * that byte, so the hash only remembers the last 64 bytes. A boundary falls where the top bits of the
+ * hash are zero, and then moves forward to the end of that line. WGSL has a statement or a brace on
+ * every line, so a chunk tends to hold whole declarations, and a chunk that starts a line is what the
+ * next variant starts a line with too.
+ */
+namespace lodestone
+{
+
+/** No chunk is shorter, except the last one of a source. */
+inline constexpr uint32_t k_SourceChunkMinSize{ 64u };
+/** The hash test fires once in this many bytes on average. A power of two. */
+inline constexpr uint32_t k_SourceChunkAverageSize{ 512u };
+/** No chunk is longer. A line longer than this is cut mid-line. */
+inline constexpr uint32_t k_SourceChunkMaxSize{ 4096u };
+
+/** The chunks of `source`, in order. They point into `source` and concatenate back to it. An empty
+ * source has no chunks. */
+std::vector<std::string_view> SplitSourceIntoChunks(std::string_view source);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SOURCE_CHUNKER_HPP
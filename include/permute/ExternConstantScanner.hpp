@@ -1,6 +1,7 @@
 #pragma once
 #ifndef LODESTONE_EXTERN_CONSTANT_SCANNER_HPP
 #define LODESTONE_EXTERN_CONSTANT_SCANNER_HPP
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -32,6 +33,23 @@ struct ExternConstantDeclaration
  * finds a declaration that `ScanExternConstants` does not. */
 [[nodiscard]] bool DeclaresExternConstantNamed(std::string_view source, std::string_view name);
 
+/** True when `source` could let the constant called `name` change a parameter layout.
+ *
+ * Layout follows types, so a constant reaches it through a type argument or an array extent. This
+ * returns true for every use of `name` inside `[]` or `<>`, including a list that spans lines. A
+ * constant or `#define` whose value uses `name` is an alias, and its uses count as uses of `name`, so
+ * `static const uint K = AXIS * 2; float w[K];` reaches the layout through `K`. Uses inside a string
+ * literal or a `//` comment do not count: `[vx_element_count("N")]` names `N` as text that stage 4
+ * evaluates, and the layout never sees it.
+ *
+ * The answer leans to true. A `<` that compares reads as a type argument, so a false answer is the one
+ * that has to be right. Nothing downstream checks it: variants that a false answer groups together share
+ * one extracted global layout. */
+[[nodiscard]] bool NameMayAffectLayout(std::string_view source, std::string_view name);
+/** The same answer over every file of a module, so an alias declared in one file and used in another
+ * still counts. */
+[[nodiscard]] bool NameMayAffectLayout(std::span<const std::string_view> sources, std::string_view name);
+
 /** Removes the spaces at each end of `text`. */
 [[nodiscard]] std::string_view TrimWhitespace(std::string_view text) noexcept;
 
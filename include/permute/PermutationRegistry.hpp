@@ -1,12 +1,16 @@
 #pragma once
 #ifndef LODESTONE_PERMUTATION_REGISTRY_HPP
 #define LODESTONE_PERMUTATION_REGISTRY_HPP
+#include <cstdint>
+#include <string>
 #include <string_view>
 
 /** Finds the permutation space and the policy of one module by name.
  *
  * The registry is compiled in, and phase E step E6 replaces it with a data file. Each lookup gives an
- * empty space or an empty policy for a module that has no entry, so a caller never gets null. */
+ * empty space or an empty policy for a module that has no entry, so a caller never gets null.
+ *
+ * A tool that writes its own modules can add a space at run time, with `RegisterPermutationSpace`. */
 namespace lodestone
 {
 
@@ -16,6 +20,12 @@ struct ModulePolicy;
 [[nodiscard]] const ModulePolicy* FindPolicyForModule(std::string_view module_name) noexcept;
 [[nodiscard]] const PermutationSpace* FindPermutationSpaceForModule(std::string_view module_name) noexcept;
 
+/** Adds a space for a module that the compiled-in table does not name. The policy of that module holds
+ * only `max_variants`, and zero means no budget. Returns false, and changes nothing, when a space of
+ * that name already exists. A registered space lives until the process ends, so the pointers the
+ * lookups return stay valid. */
+bool RegisterPermutationSpace(std::string module_name, PermutationSpace&& space, uint32_t max_variants);
+
 } // namespace lodestone
 
 #endif // !LODESTONE_PERMUTATION_REGISTRY_HPP
@@ -0,0 +1,249 @@
+#include "CookTrace.hpp"
+#include "JsonWriter.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    /** Indexed by `CookPhase`, so the trace and the log spell each phase the same way. */
+    constexpr std::array<std::string_view, k_CookPhaseCount> k_CookPhaseNames{
+        "invalid", "setup", "cache-load", "link", "codegen", "reflection", "resolve", "cross-check", "intern",
+        "round-trip", "emit"
+    };
+
+    /** The process id every event carries. A cook is one process, so any constant will do. */
+    constexpr uint64_t k_TraceProcessId{ 1u };
+
+    int64_t ToMicroseconds(CookTrace::Clock::duration duration) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+
+    double ToMilliseconds(CookTrace::Clock::duration duration) noexcept
+    {
+        return std::chrono::duration<double, std::milli>{ duration }.count();
+    }
+
+    /** A number no other thread of the process has had. A `std::thread::id` will not do: the runtime
+     * hands the id of a thread that exited to the next one it starts, and a cook with `--jobs` starts
+     * and joins a worker pool per module. */
+    uint64_t CurrentThreadSerial() noexcept
+    {
+        static std::atomic<uint64_t> nextSerial{ 0u };
+        thread_local const uint64_t serial = nextSerial.fetch_add(1u, std::memory_order_relaxed);
+        return serial;
+    }
+
+} // namespace
+
+std::string_view ToString(CookPhase phase) noexcept
+{
+    const auto index = static_cast<size_t>(phase);
+    return index < k_CookPhaseNames.size() ? k_CookPhaseNames[index] : k_CookPhaseNames[0];
+}
+
+double CookPhaseTimes::Get(CookPhase phase) const noexcept
+{
+    return Milliseconds[static_cast<size_t>(phase)];
+}
+
+void CookPhaseTimes::Add(CookPhase phase, double milliseconds) noexcept
+{
+    Milliseconds[static_cast<size_t>(phase)] += milliseconds;
+}
+
+void CookPhaseTimes::Add(const CookPhaseTimes& other) noexcept
+{
+    for (size_t i = 0u; i < Milliseconds.size(); ++i)
+    {
+        Milliseconds[i] += other.Milliseconds[i];
+    }
+}
+
+CookPhaseTimes CookPhaseTimes::Since(const CookPhaseTimes& earlier) const noexcept
+{
+    CookPhaseTimes difference;
+    for (size_t i = 0u; i < Milliseconds.size(); ++i)
+    {
+        difference.Milliseconds[i] = Milliseconds[i] - earlier.Milliseconds[i];
+    }
+
+    return difference;
+}
+
+std::string DescribePhaseTimes(const CookPhaseTimes& times)
+{
+    std::string description;
+    for (size_t i = 1u; i < times.Milliseconds.size(); ++i)
+    {
+        if (times.Milliseconds[i] <= 0.0)
+        {
+            continue;
+        }
+
+        if (!description.empty())
+        {
+            description += ", ";
+        }
+
+        description += std::format("{} {:.1f}ms", k_CookPhaseNames[i], times.Milliseconds[i]);
+    }
+
+    return description.empty() ? std::string{ "nothing timed" } : description;
+}
+
+CookTrace::CookTrace(bool _enabled)
+    : enabled{ _enabled },
+      origin{ Clock::now() },
+      tracks{ CurrentThreadSerial() }
+{
+}
+
+bool CookTrace::IsEnabled() const noexcept
+{
+    return enabled;
+}
+
+void CookTrace::Record(std::string_view name,
+                       std::string_view detail,
+                       Clock::time_point start,
+                       Clock::time_point end)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    const std::scoped_lock lock{ mutex };
+    events.push_back(Event{ .Name = std::string{ name },
+                            .Detail = std::string{ detail },
+                            .Track = FindOrAddTrack(CurrentThreadSerial()),
+                            .StartMicroseconds = ToMicroseconds(start - origin),
+                            .DurationMicroseconds = ToMicroseconds(end - start) });
+}
+
+std::string CookTrace::ToChromeTraceJson() const
+{
+    const std::scoped_lock lock{ mutex };
+
+    JsonWriter writer{ false };
+    writer.BeginObject();
+    writer.KeyString("displayTimeUnit", "ms");
+    writer.Key("traceEvents");
+    writer.BeginArray();
+
+    for (size_t track = 0u; track < tracks.size(); ++track)
+    {
+        writer.BeginObject();
+        writer.KeyString("name", "thread_name");
+        writer.KeyString("ph", "M");
+        writer.KeyUInt("pid", k_TraceProcessId);
+        writer.KeyUInt("tid", track);
+        writer.Key("args");
+        writer.BeginObject();
+        writer.KeyString("name", track == 0u ? std::string{ "cook" } : std::format("worker {}", track));
+        writer.EndObject();
+        writer.EndObject();
+    }
+
+    for (const Event& event : events)
+    {
+        writer.BeginObject();
+        writer.KeyString("name", event.Name);
+        writer.KeyString("cat", "cook");
+        writer.KeyString("ph", "X");
+        writer.KeyUInt("pid", k_TraceProcessId);
+        writer.KeyUInt("tid", event.Track);
+        writer.KeyInt("ts", event.StartMicroseconds);
+        writer.KeyInt("dur", event.DurationMicroseconds);
+        if (!event.Detail.empty())
+        {
+            writer.Key("args");
+            writer.BeginObject();
+            writer.KeyString("detail", event.Detail);
+            writer.EndObject();
+        }
+        writer.EndObject();
+    }
+
+    writer.EndArray();
+    writer.EndObject();
+
+    // Every container above closes, so this cannot fail.
+    JsonResult<std::string> document = writer.Finish();
+    return document ? std::move(document.value()) : std::string{};
+}
+
+size_t CookTrace::EventCount() const
+{
+    const std::scoped_lock lock{ mutex };
+    return events.size();
+}
+
+/** A cook starts at most a few hundred threads, so a linear search stays cheap. */
+uint32_t CookTrace::FindOrAddTrack(uint64_t thread_serial)
+{
+    for (size_t i = 0u; i < tracks.size(); ++i)
+    {
+        if (tracks[i] == thread_serial)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    tracks.push_back(thread_serial);
+    return static_cast<uint32_t>(tracks.size() - 1u);
+}
+
+ScopedTraceSpan::ScopedTraceSpan(CookTrace* _trace, std::string_view _name, std::string_view _detail) noexcept
+    : trace{ _trace },
+      name{ _name },
+      detail{ _detail },
+      start{ CookTrace::Clock::now() }
+{
+}
+
+ScopedTraceSpan::~ScopedTraceSpan()
+{
+    if (trace != nullptr)
+    {
+        trace->Record(name, detail, start, CookTrace::Clock::now());
+    }
+}
+
+ScopedPhaseTimer::ScopedPhaseTimer(CookPhaseTimes& _times,
+                                   CookPhase _phase,
+                                   CookTrace* _trace,
+                                   std::string_view _detail) noexcept
+    : times{ _times },
+      phase{ _phase },
+      trace{ _trace },
+      detail{ _detail },
+      start{ CookTrace::Clock::now() }
+{
+}
+
+ScopedPhaseTimer::~ScopedPhaseTimer()
+{
+    const CookTrace::Clock::time_point end = CookTrace::Clock::now();
+    times.Add(phase, ToMilliseconds(end - start));
+    if (trace != nullptr)
+    {
+        trace->Record(ToString(phase), detail, start, end);
+    }
+}
+
+} // namespace lodestone
@@ -0,0 +1,405 @@
+#include "compile/RawVariantCache.hpp"
+#include "CookerErrors.hpp"
+#include "compile/RawLibrary.hpp"
+#include "model/BinaryStream.hpp"
+#include "model/CacheFile.hpp"
+#include "model/ContentHash.hpp"
+#include "model/ShaderDataSchema.hpp"
+#include "permute/PermutationAssignment.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "permute/PermutationValue.hpp"
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    constexpr uint32_t k_RawVariantCacheMagic{ 0x5652534Cu }; // "LSRV"
+
+    void WritePlacement(BinaryWriter& writer, const RawPlacement& placement)
+    {
+        const BoundPlacement* bound = GetBoundPlacement(placement);
+        writer.Write(static_cast<uint8_t>(bound != nullptr ? 1u : 0u));
+        if (bound != nullptr)
+        {
+            writer.Write(bound->Group);
+            writer.Write(bound->Binding);
+        }
+    }
+
+    RawPlacement ReadPlacement(BinaryReader& reader)
+    {
+        if (reader.Read<uint8_t>() == 0u)
+        {
+            return std::monostate{};
+        }
+
+        BoundPlacement bound;
+        bound.Group = reader.Read<uint32_t>();
+        bound.Binding = reader.Read<uint32_t>();
+        return bound;
+    }
+
+    void WriteBinding(BinaryWriter& writer, const RawBinding& binding)
+    {
+        writer.WriteString(binding.Name);
+        writer.WriteString(binding.ScopeName);
+        WritePlacement(writer, binding.Placement);
+        writer.Write(binding.Kind);
+        writer.Write(binding.ElementStride);
+        writer.Write(binding.ByteSize);
+        writer.Write(binding.ArrayCount);
+        writer.Write(binding.Shape);
+        writer.Write(binding.SampleType);
+        writer.Write(binding.StorageFormat);
+        writer.Write(binding.StorageAccess);
+        writer.Write(binding.SamplerType);
+
+        writer.Write(static_cast<uint32_t>(binding.UniformMembers.size()));
+        for (const ReflectedUniformMember& member : binding.UniformMembers)
+        {
+            writer.WriteString(member.Name);
+            writer.Write(member.Offset);
+            writer.Write(member.Size);
+            writer.Write(member.ArrayCount);
+        }
+    }
+
+    RawBinding ReadBinding(BinaryReader& reader)
+    {
+        RawBinding binding;
+        binding.Name = reader.ReadString();
+        binding.ScopeName = reader.ReadString();
+        binding.Placement = ReadPlacement(reader);
+        binding.Kind = reader.Read<BindingKind>();
+        binding.ElementStride = reader.Read<uint32_t>();
+        binding.ByteSize = reader.Read<uint64_t>();
+        binding.ArrayCount = reader.Read<uint32_t>();
+        binding.Shape = reader.Read<ResourceShape>();
+        binding.SampleType = reader.Read<TextureSampleType>();
+        binding.StorageFormat = reader.Read<TextureFormat>();
+        binding.StorageAccess = reader.Read<StorageTextureAccess>();
+        binding.SamplerType = reader.Read<SamplerBindingType>();
+
+        const uint32_t memberCount = reader.ReadCount(sizeof(uint32_t) * 4u);
+        binding.UniformMembers.reserve(memberCount);
+        for (uint32_t i = 0u; i < memberCount; ++i)
+        {
+            ReflectedUniformMember& member = binding.UniformMembers.emplace_back();
+            member.Name = reader.ReadString();
+            member.Offset = reader.Read<uint32_t>();
+            member.Size = reader.Read<uint32_t>();
+            member.ArrayCount = reader.Read<uint32_t>();
+        }
+
+        return binding;
+    }
+
+    void WriteSizeAttribute(BinaryWriter& writer, const RawSizeAttribute& attribute)
+    {
+        writer.Write(attribute.BindingIndex);
+        writer.Write(attribute.Kind);
+        writer.Write(static_cast<uint32_t>(attribute.Arguments.size()));
+        for (const std::string& argument : attribute.Arguments)
+        {
+            writer.WriteString(argument);
+        }
+    }
+
+    RawSizeAttribute ReadSizeAttribute(BinaryReader& reader)
+    {
+        RawSizeAttribute attribute;
+        attribute.BindingIndex = reader.Read<uint32_t>();
+        attribute.Kind = reader.Read<RawSizeAttributeKind>();
+
+        const uint32_t argumentCount = reader.ReadCount(sizeof(uint32_t));
+        attribute.Arguments.reserve(argumentCount);
+        for (uint32_t i = 0u; i < argumentCount; ++i)
+        {
+            attribute.Arguments.emplace_back(reader.ReadString());
+        }
+
+        return attribute;
+    }
+
+    void WriteRasterState(BinaryWriter& writer, const ReflectedRasterState& raster)
+    {
+        writer.Write(static_cast<uint32_t>(raster.VertexInputs.size()));
+        for (const ReflectedVertexInput& input : raster.VertexInputs)
+        {
+            writer.Write(input.Data.SemanticIndex);
+            writer.Write(input.Data.Location);
+            writer.Write(input.Data.ScalarType);
+            writer.Write(input.Data.ComponentCount);
+            writer.WriteString(input.SemanticName);
+        }
+
+        writer.Write(static_cast<uint32_t>(raster.ColorTargets.size()));
+        for (const ReflectedColorTarget& target : raster.ColorTargets)
+        {
+            writer.Write(target.Location);
+            writer.Write(target.ScalarType);
+            writer.Write(target.ComponentCount);
+        }
+
+        writer.Write(static_cast<uint8_t>(raster.WritesFragDepth ? 1u : 0u));
+    }
+
+    ReflectedRasterState ReadRasterState(BinaryReader& reader)
+    {
+        ReflectedRasterState raster;
+
+        const uint32_t inputCount = reader.ReadCount(sizeof(uint32_t) * 5u);
+        raster.VertexInputs.reserve(inputCount);
+        for (uint32_t i = 0u; i < inputCount; ++i)
+        {
+            ReflectedVertexInput& input = raster.VertexInputs.emplace_back();
+            input.Data.SemanticIndex = reader.Read<uint32_t>();
+            input.Data.Location = reader.Read<uint32_t>();
+            input.Data.ScalarType = reader.Read<VertexScalarType>();
+            input.Data.ComponentCount = reader.Read<uint32_t>();
+            input.SemanticName = reader.ReadString();
+        }
+
+        const uint32_t targetCount = reader.ReadCount(sizeof(uint32_t) * 3u);
+        raster.ColorTargets.reserve(targetCount);
+        for (uint32_t i = 0u; i < targetCount; ++i)
+        {
+            ReflectedColorTarget& target = raster.ColorTargets.emplace_back();
+            target.Location = reader.Read<uint32_t>();
+            target.ScalarType = reader.Read<VertexScalarType>();
+            target.ComponentCount = reader.Read<uint32_t>();
+        }
+
+        raster.WritesFragDepth = reader.Read<uint8_t>() != 0u;
+        return raster;
+    }
+
+    /** The suffix of an entry point is the suffix of its variant, so the file stores it once. */
+    void WriteEntryPoint(BinaryWriter& writer, const RawEntryPoint& entry_point)
+    {
+        writer.WriteString(entry_point.Name);
+        writer.Write(entry_point.Stage);
+        writer.Write(entry_point.Workgroup.X);
+        writer.Write(entry_point.Workgroup.Y);
+        writer.Write(entry_point.Workgroup.Z);
+        writer.WriteString(entry_point.TargetText);
+
+        writer.Write(static_cast<uint32_t>(entry_point.UsedBindingIndices.size()));
+        for (const uint32_t index : entry_point.UsedBindingIndices)
+        {
+            writer.Write(index);
+        }
+
+        WriteRasterState(writer, entry_point.Raster);
+    }
+
+    RawEntryPoint ReadEntryPoint(BinaryReader& reader)
+    {
+        RawEntryPoint entryPoint;
+        entryPoint.Name = reader.ReadString();
+        entryPoint.Stage = reader.Read<ShaderStageKind>();
+        entryPoint.Workgroup.X = reader.Read<uint32_t>();
+        entryPoint.Workgroup.Y = reader.Read<uint32_t>();
+        entryPoint.Workgroup.Z = reader.Read<uint32_t>();
+        entryPoint.TargetText = reader.ReadString();
+
+        const uint32_t indexCount = reader.ReadCount(sizeof(uint32_t));
+        entryPoint.UsedBindingIndices.reserve(indexCount);
+        for (uint32_t i = 0u; i < indexCount; ++i)
+        {
+            entryPoint.UsedBindingIndices.push_back(reader.Read<uint32_t>());
+        }
+
+        entryPoint.Raster = ReadRasterState(reader);
+        return entryPoint;
+    }
+
+    void AppendAssignment(StreamingHash& hash, const PermutationAssignment& assignment)
+    {
+        hash.Append(static_cast<uint64_t>(assignment.size()));
+        for (const PermutationBinding& binding : assignment)
+        {
+            hash.Append(binding.Axis->Name);
+            hash.Append(static_cast<uint32_t>(std::to_underlying(binding.Value.GetType())));
+            hash.Append(PermutationValueToInt64(binding.Value));
+        }
+    }
+
+} // namespace
+
+std::string SerializeRawVariant(const RawVariant& variant)
+{
+    BinaryWriter writer;
+    writer.WriteString(variant.VariantSuffix);
+    writer.WriteString(variant.VariantDescription);
+    writer.Write(variant.VariantIndex);
+
+    writer.Write(static_cast<uint32_t>(variant.Bindings.size()));
+    for (const RawBinding& binding : variant.Bindings)
+    {
+        WriteBinding(writer, binding);
+    }
+
+    writer.Write(static_cast<uint32_t>(variant.SizeAttributes.size()));
+    for (const RawSizeAttribute& attribute : variant.SizeAttributes)
+    {
+        WriteSizeAttribute(writer, attribute);
+    }
+
+    writer.Write(static_cast<uint32_t>(variant.EntryPoints.size()));
+    for (const RawEntryPoint& entryPoint : variant.EntryPoints)
+    {
+        WriteEntryPoint(writer, entryPoint);
+    }
+
+    return writer.Take();
+}
+
+CookResult<RawVariant> DeserializeRawVariant(std::string_view bytes)
+{
+    BinaryReader reader{ bytes };
+
+    RawVariant variant;
+    variant.VariantSuffix = reader.ReadString();
+    variant.VariantDescription = reader.ReadString();
+    variant.VariantIndex = reader.Read<uint32_t>();
+
+    const uint32_t bindingCount = reader.ReadCount(sizeof(uint32_t) * 2u);
+    variant.Bindings.reserve(bindingCount);
+    for (uint32_t i = 0u; i < bindingCount; ++i)
+    {
+        variant.Bindings.emplace_back(ReadBinding(reader));
+    }
+
+    const uint32_t attributeCount = reader.ReadCount(sizeof(uint32_t) * 3u);
+    variant.SizeAttributes.reserve(attributeCount);
+    for (uint32_t i = 0u; i < attributeCount; ++i)
+    {
+        variant.SizeAttributes.emplace_back(ReadSizeAttribute(reader));
+    }
+
+    const uint32_t entryPointCount = reader.ReadCount(sizeof(uint32_t) * 2u);
+    variant.EntryPoints.reserve(entryPointCount);
+    for (uint32_t i = 0u; i < entryPointCount; ++i)
+    {
+        RawEntryPoint& entryPoint = variant.EntryPoints.emplace_back(ReadEntryPoint(reader));
+        entryPoint.VariantSuffix = variant.VariantSuffix;
+    }
+
+    if (!reader.Succeeded())
+    {
+        return std::unexpected(CookError::CacheEntryInvalid);
+    }
+
+    return variant;
+}
+
+RawVariantCache::RawVariantCache(const std::filesystem::path& _directory, ContentHashValue compile_input_hash)
+    : directory{ _directory.empty() ? std::filesystem::path{} : _directory / "variants" },
+      compileInputHash{ compile_input_hash }
+{
+}
+
+bool RawVariantCache::IsEnabled() const noexcept
+{
+    return !directory.empty();
+}
+
+bool RawVariantCache::Contains(const VariantDescriptor& descriptor) const
+{
+    if (!IsEnabled())
+    {
+        return false;
+    }
+
+    std::error_code filesystemError;
+    return std::filesystem::exists(MakeEntryPath(MakeVariantKey(descriptor)), filesystemError);
+}
+
+std::optional<RawVariant> RawVariantCache::Load(const VariantDescriptor& descriptor) const
+{
+    if (!IsEnabled())
+    {
+        return std::nullopt;
+    }
+
+    const ContentHashValue key = MakeVariantKey(descriptor);
+    const std::optional<std::string> file = ReadCacheFile(MakeEntryPath(key));
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    const std::optional<std::string_view> payload =
+        OpenCacheRecord(file.value(), k_RawVariantCacheMagic, k_RawVariantCacheVersion, key);
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+
+    CookResult<RawVariant> variant = DeserializeRawVariant(payload.value());
+    if (!variant)
+    {
+        return std::nullopt;
+    }
+
+    // The key leaves out the index and the names, because a space that gained an axis renumbers its
+    // variants without changing what any one of them compiles to.
+    variant.value().VariantSuffix = MakeAssignmentSuffix(descriptor.Canonical);
+    variant.value().VariantDescription = DescribeAssignment(descriptor.Canonical);
+    variant.value().VariantIndex = static_cast<uint32_t>(descriptor.Index);
+    for (RawEntryPoint& entryPoint : variant.value().EntryPoints)
+    {
+        entryPoint.VariantSuffix = variant.value().VariantSuffix;
+    }
+
+    return std::move(variant.value());
+}
+
+void RawVariantCache::Store(const VariantDescriptor& descriptor, const RawVariant& variant) const
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    const ContentHashValue key = MakeVariantKey(descriptor);
+    WriteCacheFile(MakeEntryPath(key),
+                   SealCacheRecord(k_RawVariantCacheMagic,
+                                   k_RawVariantCacheVersion,
+                                   key,
+                                   SerializeRawVariant(variant)));
+}
+
+/** Both assignments reach the key. `Active` is what Slang links, and `Canonical` names the variant. A
+ * space whose dependencies changed can keep one of them and change the other. */
+ContentHashValue RawVariantCache::MakeVariantKey(const VariantDescriptor& descriptor) const
+{
+    StreamingHash hash;
+    hash.Append(compileInputHash);
+    hash.Append(k_RawVariantCacheVersion);
+    AppendAssignment(hash, descriptor.Active);
+    AppendAssignment(hash, descriptor.Canonical);
+    return hash.Finalize();
+}
+
+std::filesystem::path RawVariantCache::MakeEntryPath(ContentHashValue key) const
+{
+    return directory / std::format("{:016x}.rawvariant", key);
+}
+
+} // namespace lodestone
@@ -1,9 +1,12 @@
 #include "compile/SlangCompiler.hpp"
+#include "CookTrace.hpp"
 #include "CookerErrors.hpp"
 #include "compile/Diagnostics.hpp"
 #include "compile/RawLibrary.hpp"
 #include "compile/SlangDiagnosticParser.hpp"
+#include "model/ContentHash.hpp"
 #include "model/ShaderDataSchema.hpp"
+#include "permute/ExternConstantScanner.hpp"
 #include "permute/PermutationAssignment.hpp"
 #include "permute/PermutationSpace.hpp"
 #include "permute/PermutationValue.hpp"
@@ -19,8 +22,10 @@
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <ios>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <optional>
 #include <print>
@@ -603,6 +608,11 @@ namespace
                         });
     }
 
+    /** What every session compiles to. Both reach the compile input hash, so a change here moves every
+     * cached variant to a new key. */
+    constexpr SlangCompileTarget k_SlangTarget{ SLANG_WGSL };
+    constexpr const char* k_SlangProfileName{ "spirv_1_4" };
+
     /** One compiler option as a row. A row of `Int` kind reads `IntValue`, and a row of `String`
      * kind reads `StringValue`. The unused field keeps the value Slang treats as absent, which is
      * what the entry held before this became a table. */
@@ -920,6 +930,19 @@ namespace
 
 } // namespace
 
+namespace
+{
+
+    /** The global scope of one linked program, as `ExtractRawBindings` leaves it: sorted, with each
+     * annotation keyed against the position of its binding. */
+    struct GlobalLayout
+    {
+        std::vector<RawBinding> Bindings;
+        std::vector<RawSizeAttribute> SizeAttributes;
+    };
+
+} // namespace
+
 struct SlangCompiler::Impl
 {
     Slang::ComPtr<slang::IGlobalSession> GlobalSession;
@@ -930,8 +953,26 @@ struct SlangCompiler::Impl
     std::vector<std::string> EntryPointNames;
     std::vector<slang::CompilerOptionEntry> CompilerOptions;
     std::vector<std::string> ModuleSourceTexts;
+    /** Runs parallel to `ModuleSourceTexts`. */
+    std::vector<std::string> ModuleSourcePaths;
     std::string ModuleName;
+    ContentHashValue CompileInputHash{ 0u };
     bool MultithreadEntryPointCodegen{ true };
+    /** Where each axis that can change the global layout sits in a canonical assignment. Built by the
+     * first variant, because every variant of a module comes from one space. */
+    std::vector<size_t> LayoutAxisPositions;
+    bool LayoutAxesKnown{ false };
+    /** One extracted global scope for each combination of the layout axes. A variant whose key is
+     * already here copies the bindings and skips the walk. A `std::map` so the key needs no hash, and
+     * so the address of an entry survives later inserts. */
+    std::map<std::vector<int64_t>, GlobalLayout> GlobalLayoutCache;
+    /** The one-line module that exports each (axis, value) pair, keyed on its module name. The session
+     * owns every module it loads, so a pointer stays valid for as long as the session lives. */
+    std::map<std::string, slang::IModule*, std::less<>> ConstantModules;
+    ConstantModuleCacheStatistics ConstantModuleStatistics;
+    CookPhaseTimes PhaseTimes;
+    /** May be null. The trace is shared with every other compiler of the cook, and it locks. */
+    CookTrace* Trace{ nullptr };
     /** Set once, by `Initialize`, and never null after that. A pointer rather than a reference only
      * because this object moves. */
     DiagnosticSink* Sink{ nullptr };
@@ -939,9 +980,11 @@ struct SlangCompiler::Impl
     CookError CreateSession(const SlangCompilerCreateInfo& create_info);
     CookError LoadRootModule();
     void ReadDependencySourceTexts();
+    void ComputeCompileInputHash();
     CookError CollectEntryPoints();
+    [[nodiscard]] CookResult<slang::IModule*> FindOrLoadConstantModule(const PermutationBinding& binding);
     [[nodiscard]] CookResult<Slang::ComPtr<slang::IComponentType>> LinkVariant(
-        const PermutationAssignment& assignment) const;
+        const PermutationAssignment& assignment);
     std::vector<std::string> GenerateEntryPointCode(slang::IComponentType* linked_program) const;
     CookResult<RawEntryPoint> ExtractRawEntryPoint(slang::IComponentType* linked_program,
                                                    slang::ProgramLayout* program_layout,
@@ -951,6 +994,10 @@ struct SlangCompiler::Impl
     CookError ExtractRawBindings(slang::ProgramLayout* program_layout,
                                  std::vector<RawBinding>& out_bindings,
                                  std::vector<RawSizeAttribute>& out_attributes) const;
+    std::vector<int64_t> MakeGlobalLayoutKey(const CanonicalAssignment& canonical);
+    [[nodiscard]] CookResult<const GlobalLayout*> FindOrExtractGlobalLayout(
+        slang::ProgramLayout* program_layout,
+        const CanonicalAssignment& canonical);
     CookError CollectBindingRangeDrafts(slang::TypeLayoutReflection* containing_layout,
                                         const BindingScope& scope,
                                         std::vector<RawBindingDraft>& out_drafts) const;
@@ -978,7 +1025,10 @@ struct SlangCompiler::Impl
 
 CookError SlangCompiler::Impl::CreateSession(const SlangCompilerCreateInfo& create_info)
 {
-    if (SLANG_FAILED(slang::createGlobalSession(GlobalSession.writeRef())) || GlobalSession == nullptr)
+    // A compiler initialized before keeps its global session, so only the first `Initialize` loads the
+    // core module.
+    if (GlobalSession == nullptr &&
+        (SLANG_FAILED(slang::createGlobalSession(GlobalSession.writeRef())) || GlobalSession == nullptr))
     {
         return CookError::GlobalSessionCreationFailed;
     }
@@ -999,8 +1049,8 @@ CookError SlangCompiler::Impl::CreateSession(const SlangCompilerCreateInfo& crea
     };
 
     slang::TargetDesc target{};
-    target.format = SLANG_WGSL;
-    target.profile = GlobalSession->findProfile("spirv_1_4");
+    target.format = k_SlangTarget;
+    target.profile = GlobalSession->findProfile(k_SlangProfileName);
 
     slang::SessionDesc sessionDesc{};
     sessionDesc.targets = &target;
@@ -1036,6 +1086,7 @@ CookError SlangCompiler::Impl::LoadRootModule()
     BaseComponents.push_back(RootModule);
 
     ReadDependencySourceTexts();
+    ComputeCompileInputHash();
     return CookError::Success;
 }
 
@@ -1046,6 +1097,8 @@ void SlangCompiler::Impl::ReadDependencySourceTexts()
     const SlangInt32 dependencyCount = RootModule->getDependencyFileCount();
     ModuleSourceTexts.clear();
     ModuleSourceTexts.reserve(static_cast<size_t>(dependencyCount));
+    ModuleSourcePaths.clear();
+    ModuleSourcePaths.reserve(static_cast<size_t>(dependencyCount));
 
     for (SlangInt32 i = 0; i < dependencyCount; ++i)
     {
@@ -1064,9 +1117,46 @@ void SlangCompiler::Impl::ReadDependencySourceTexts()
 
         ModuleSourceTexts.emplace_back(std::istreambuf_iterator<char>{ file },
                                        std::istreambuf_iterator<char>{});
+        ModuleSourcePaths.emplace_back(dependencyPath);
     }
 }
 
+/** Everything a variant's raw output depends on, other than its assignment. The Slang build tag is in
+ * here because a new compiler can emit different text from the same source. */
+void SlangCompiler::Impl::ComputeCompileInputHash()
+{
+    auto orEmpty = [](const char* text)
+    {
+        return std::string_view{ text != nullptr ? text : "" };
+    };
+
+    StreamingHash hash;
+    hash.Append(orEmpty(GlobalSession->getBuildTagString()));
+    hash.Append(static_cast<uint32_t>(k_SlangTarget));
+    hash.Append(std::string_view{ k_SlangProfileName });
+
+    hash.Append(static_cast<uint64_t>(CompilerOptions.size()));
+    for (const slang::CompilerOptionEntry& option : CompilerOptions)
+    {
+        hash.Append(static_cast<uint32_t>(option.name));
+        hash.Append(static_cast<uint32_t>(option.value.kind));
+        hash.Append(option.value.intValue0);
+        hash.Append(option.value.intValue1);
+        hash.Append(orEmpty(option.value.stringValue0));
+        hash.Append(orEmpty(option.value.stringValue1));
+    }
+
+    hash.Append(ModuleName);
+    hash.Append(static_cast<uint64_t>(ModuleSourceTexts.size()));
+    for (const std::string& text : ModuleSourceTexts)
+    {
+        hash.Append(static_cast<uint64_t>(text.size()));
+        hash.Append(text);
+    }
+
+    CompileInputHash = hash.Finalize();
+}
+
 CookError SlangCompiler::Impl::CollectEntryPoints()
 {
     const SlangInt entryPointCount = RootModule->getDefinedEntryPointCount();
@@ -1091,31 +1181,53 @@ CookError SlangCompiler::Impl::CollectEntryPoints()
     return CookError::Success;
 }
 
+/** The module that exports one axis value. Every variant that holds the same (axis, value) pair links
+ * the same one-line module, so a session parses it once and every later variant reuses it. A space of
+ * A axes and V variants then parses the sum of the value counts rather than A times V modules. */
+CookResult<slang::IModule*> SlangCompiler::Impl::FindOrLoadConstantModule(const PermutationBinding& binding)
+{
+    std::string variantModuleName = MakeVariantModuleName(binding.Axis->Name, binding.Value);
+    if (const auto found = ConstantModules.find(variantModuleName); found != ConstantModules.end())
+    {
+        ++ConstantModuleStatistics.Hits;
+        return found->second;
+    }
+
+    const std::string variantModulePath = MakeVariantModulePath(binding.Axis->Name, binding.Value);
+    const std::string variantSource = MakeExportedConstantSource(binding.Axis->Name, binding.Value);
+
+    Slang::ComPtr<slang::IBlob> diagnostics;
+    slang::IModule* variantModule = Session->loadModuleFromSourceString(variantModuleName.c_str(),
+                                                                        variantModulePath.c_str(),
+                                                                        variantSource.c_str(),
+                                                                        diagnostics.writeRef());
+    ReportDiagnostics(*Sink, "loadModuleFromSourceString", diagnostics.get());
+
+    if (variantModule == nullptr)
+    {
+        return std::unexpected(CookError::VariantModuleCreationFailed);
+    }
+
+    ++ConstantModuleStatistics.Misses;
+    ConstantModules.emplace(std::move(variantModuleName), variantModule);
+    return variantModule;
+}
+
 CookResult<Slang::ComPtr<slang::IComponentType>> SlangCompiler::Impl::LinkVariant(
-    const PermutationAssignment& assignment) const
+    const PermutationAssignment& assignment)
 {
     std::vector<slang::IComponentType*> components = BaseComponents;
     components.reserve(BaseComponents.size() + assignment.size());
 
     for (const PermutationBinding& binding : assignment)
     {
-        const std::string variantModuleName = MakeVariantModuleName(binding.Axis->Name, binding.Value);
-        const std::string variantModulePath = MakeVariantModulePath(binding.Axis->Name, binding.Value);
-        const std::string variantSource = MakeExportedConstantSource(binding.Axis->Name, binding.Value);
-
-        Slang::ComPtr<slang::IBlob> diagnostics;
-        slang::IModule* variantModule = Session->loadModuleFromSourceString(variantModuleName.c_str(),
-                                                                            variantModulePath.c_str(),
-                                                                            variantSource.c_str(),
-                                                                            diagnostics.writeRef());
-        ReportDiagnostics(*Sink, "loadModuleFromSourceString", diagnostics.get());
-
-        if (variantModule == nullptr)
+        const CookResult<slang::IModule*> variantModule = FindOrLoadConstantModule(binding);
+        if (!variantModule)
         {
-            return std::unexpected(CookError::VariantModuleCreationFailed);
+            return std::unexpected(variantModule.error());
         }
 
-        components.push_back(variantModule);
+        components.push_back(variantModule.value());
     }
 
     Slang::ComPtr<slang::IBlob> diagnostics;
@@ -1451,6 +1563,59 @@ CookError SlangCompiler::Impl::ExtractRawBindings(slang::ProgramLayout* program_
     return CookError::Success;
 }
 
+/** The canonical values of the axes that can change the global layout, in declaration order.
+ *
+ * A link-time constant reaches a layout only through a type argument or an array extent, directly or
+ * through a constant or macro that holds it, and `NameMayAffectLayout` finds every such use across the
+ * module's files. Two variants that agree on those axes link to one global scope. Nothing checks the
+ * reused bindings afterwards: the cross-check sees no sizes, and `--no-validate` skips it, so the scan
+ * must lean to true. */
+std::vector<int64_t> SlangCompiler::Impl::MakeGlobalLayoutKey(const CanonicalAssignment& canonical)
+{
+    if (!LayoutAxesKnown)
+    {
+        const std::vector<std::string_view> sourceViews{ ModuleSourceTexts.begin(), ModuleSourceTexts.end() };
+        for (size_t i = 0u; i < canonical.size(); ++i)
+        {
+            if (NameMayAffectLayout(sourceViews, canonical[i].Axis->Name))
+            {
+                LayoutAxisPositions.push_back(i);
+            }
+        }
+
+        LayoutAxesKnown = true;
+    }
+
+    std::vector<int64_t> key;
+    key.reserve(LayoutAxisPositions.size());
+    for (const size_t position : LayoutAxisPositions)
+    {
+        key.push_back(PermutationValueToInt64(canonical[position].Value));
+    }
+
+    return key;
+}
+
+CookResult<const GlobalLayout*> SlangCompiler::Impl::FindOrExtractGlobalLayout(
+    slang::ProgramLayout* program_layout,
+    const CanonicalAssignment& canonical)
+{
+    std::vector<int64_t> key = MakeGlobalLayoutKey(canonical);
+    if (const auto found = GlobalLayoutCache.find(key); found != GlobalLayoutCache.end())
+    {
+        return &found->second;
+    }
+
+    GlobalLayout layout;
+    const CookError bindingsError = ExtractRawBindings(program_layout, layout.Bindings, layout.SizeAttributes);
+    if (bindingsError != CookError::Success)
+    {
+        return std::unexpected(bindingsError);
+    }
+
+    return &GlobalLayoutCache.emplace(std::move(key), std::move(layout)).first->second;
+}
+
 /** Asks the metadata of one entry point which global bindings that entry point reads.
  *
  * `global_bindings` holds the global scope alone. Slang generates each entry point as its own
@@ -1581,8 +1746,20 @@ SlangCompiler& SlangCompiler::operator=(SlangCompiler&&) noexcept = default;
 
 CookError SlangCompiler::Initialize(const SlangCompilerCreateInfo& create_info, DiagnosticSink& sink)
 {
+    // Everything but the global session belongs to the module this compiler loaded last.
+    Slang::ComPtr<slang::IGlobalSession> globalSession;
+    if (impl != nullptr)
+    {
+        globalSession = std::move(impl->GlobalSession);
+    }
+
     impl = std::make_unique<Impl>();
+    impl->GlobalSession = std::move(globalSession);
     impl->Sink = &sink;
+    impl->Trace = create_info.Trace;
+
+    const std::string modulePath = create_info.ModulePath.string();
+    const ScopedPhaseTimer setupTimer{ impl->PhaseTimes, CookPhase::Setup, impl->Trace, modulePath };
 
     const CookError sessionResult = impl->CreateSession(create_info);
     if (sessionResult != CookError::Success)
@@ -1599,6 +1776,19 @@ CookError SlangCompiler::Initialize(const SlangCompilerCreateInfo& create_info,
     return impl->CollectEntryPoints();
 }
 
+void SlangCompiler::Rebind(DiagnosticSink& sink, CookTrace* trace) noexcept
+{
+    if (impl != nullptr)
+    {
+        impl->Sink = &sink;
+        impl->Trace = trace;
+        // The pool sums these into the statistics of the cook, so they start over with each one. The
+        // constant modules stay loaded; only the counts reset.
+        impl->PhaseTimes = CookPhaseTimes{};
+        impl->ConstantModuleStatistics = ConstantModuleCacheStatistics{};
+    }
+}
+
 CookResult<RawModule> SlangCompiler::PrepareRawModule(const PermutationSpace& space)
 {
     if (impl == nullptr)
@@ -1629,36 +1819,54 @@ CookResult<RawVariant> SlangCompiler::CompileVariantRaw(const VariantDescriptor&
         return std::unexpected(CookError::CompilerNotInitialized);
     }
 
-    CookResult<Slang::ComPtr<slang::IComponentType>> linkResult = impl->LinkVariant(descriptor.Active);
+    const std::string description = DescribeAssignment(descriptor.Canonical);
+
+    CookResult<Slang::ComPtr<slang::IComponentType>> linkResult{ std::unexpected(CookError::Invalid) };
+    {
+        const ScopedPhaseTimer linkTimer{ impl->PhaseTimes, CookPhase::Link, impl->Trace, description };
+        linkResult = impl->LinkVariant(descriptor.Active);
+    }
+
     if (!linkResult)
     {
         return std::unexpected(linkResult.error());
     }
 
     slang::IComponentType* linkedProgram = linkResult.value().get();
+    std::vector<std::string> generatedCode;
+    {
+        const ScopedPhaseTimer codegenTimer{ impl->PhaseTimes, CookPhase::Codegen, impl->Trace, description };
+        generatedCode = impl->GenerateEntryPointCode(linkedProgram);
+    }
+
+    // Everything from here on reads reflection, so one timer covers the rest of the variant.
+    const ScopedPhaseTimer reflectionTimer{
+        impl->PhaseTimes, CookPhase::Reflection, impl->Trace, description
+    };
     slang::ProgramLayout* programLayout = linkedProgram->getLayout();
     if (programLayout == nullptr)
     {
         return std::unexpected(CookError::ReflectionUnavailable);
     }
 
-    const std::vector<std::string> generatedCode = impl->GenerateEntryPointCode(linkedProgram);
-
     RawVariant variant;
     variant.VariantSuffix = MakeAssignmentSuffix(descriptor.Canonical);
-    variant.VariantDescription = DescribeAssignment(descriptor.Canonical);
+    variant.VariantDescription = description;
     variant.VariantIndex = static_cast<uint32_t>(descriptor.Index);
 
-    // The global scope is the same for every entry point of this variant. Extract it once, and let
-    // each entry point say which of those bindings it reads. An entry point then appends the
-    // parameters it declares itself.
-    const CookError bindingsError =
-        impl->ExtractRawBindings(programLayout, variant.Bindings, variant.SizeAttributes);
-    if (bindingsError != CookError::Success)
+    // The global scope is the same for every entry point of this variant, and for every variant that
+    // agrees on the layout axes. Extract it once for each such key, and let each entry point say which
+    // of those bindings it reads. An entry point then appends the parameters it declares itself.
+    const CookResult<const GlobalLayout*> globalLayout =
+        impl->FindOrExtractGlobalLayout(programLayout, descriptor.Canonical);
+    if (!globalLayout)
     {
-        return std::unexpected(bindingsError);
+        return std::unexpected(globalLayout.error());
     }
 
+    variant.Bindings = globalLayout.value()->Bindings;
+    variant.SizeAttributes = globalLayout.value()->SizeAttributes;
+
     variant.EntryPoints.reserve(impl->EntryPointNames.size());
 
     // The global sort is done. Each entry point appends after it, in declaration order, so a second
@@ -1729,4 +1937,44 @@ std::span<const std::string> SlangCompiler::GetModuleSourceTexts() const noexcep
     return impl->ModuleSourceTexts;
 }
 
+std::span<const std::string> SlangCompiler::GetModuleSourcePaths() const noexcept
+{
+    if (impl == nullptr)
+    {
+        return {};
+    }
+
+    return impl->ModuleSourcePaths;
+}
+
+ContentHashValue SlangCompiler::GetCompileInputHash() const noexcept
+{
+    if (impl == nullptr)
+    {
+        return 0u;
+    }
+
+    return impl->CompileInputHash;
+}
+
+ConstantModuleCacheStatistics SlangCompiler::GetConstantModuleCacheStatistics() const noexcept
+{
+    if (impl == nullptr)
+    {
+        return {};
+    }
+
+    return impl->ConstantModuleStatistics;
+}
+
+CookPhaseTimes SlangCompiler::GetPhaseTimes() const noexcept
+{
+    if (impl == nullptr)
+    {
+        return {};
+    }
+
+    return impl->PhaseTimes;
+}
+
 } // namespace lodestone
@@ -0,0 +1,282 @@
+#include "compile/SlangCompilerPool.hpp"
+#include "CookTrace.hpp"
+#include "CookerErrors.hpp"
+#include "compile/Diagnostics.hpp"
+#include "compile/RawLibrary.hpp"
+#include "compile/SlangCompiler.hpp"
+#include "permute/PermutationSpace.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lodestone
+{
+
+/** One extra compiler, and the sink it reports into while the other workers run. `Forwarded` counts
+ * the records the pool has already passed on, so a record reaches the cook sink once. `IsLoaded` means
+ * the compiler came to the pool holding the module. */
+struct SlangCompilerPool::Worker
+{
+    SlangCompiler Compiler;
+    RecordingDiagnosticSink Sink;
+    size_t Forwarded{ 0u };
+    CookError InitializeResult{ CookError::Invalid };
+    bool IsLoaded{ false };
+};
+
+SlangCompilerPool::SlangCompilerPool() noexcept = default;
+SlangCompilerPool::~SlangCompilerPool() = default;
+SlangCompilerPool::SlangCompilerPool(SlangCompilerPool&&) noexcept = default;
+SlangCompilerPool& SlangCompilerPool::operator=(SlangCompilerPool&&) noexcept = default;
+
+CookError SlangCompilerPool::Initialize(const SlangCompilerCreateInfo& create_info,
+                                        SlangCompiler& primary,
+                                        uint32_t worker_count,
+                                        DiagnosticSink& _sink)
+{
+    primaryCompiler = &primary;
+    sink = &_sink;
+
+    const size_t extraCount = worker_count > 1u ? static_cast<size_t>(worker_count - 1u) : 0u;
+    workers.clear();
+    workers.reserve(extraCount);
+    for (size_t i = 0u; i < extraCount; ++i)
+    {
+        std::unique_ptr<Worker>& worker = workers.emplace_back(std::make_unique<Worker>());
+        if (!adoptedLoaded.empty())
+        {
+            worker->Compiler = std::move(adoptedLoaded.back());
+            worker->IsLoaded = true;
+            adoptedLoaded.pop_back();
+        }
+        else if (!adopted.empty())
+        {
+            worker->Compiler = std::move(adopted.back());
+            adopted.pop_back();
+        }
+    }
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers.size());
+        for (const std::unique_ptr<Worker>& worker : workers)
+        {
+            threads.emplace_back(
+                [&create_info, &worker = *worker]
+                {
+                    if (worker.IsLoaded)
+                    {
+                        worker.Compiler.Rebind(worker.Sink, create_info.Trace);
+                        worker.InitializeResult = CookError::Success;
+                        return;
+                    }
+
+                    worker.InitializeResult = worker.Compiler.Initialize(create_info, worker.Sink);
+                });
+        }
+    }
+
+    ForwardWorkerDiagnostics();
+
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        if (worker->InitializeResult != CookError::Success)
+        {
+            return worker->InitializeResult;
+        }
+    }
+
+    return CookError::Success;
+}
+
+CookResult<void> SlangCompilerPool::StreamVariants(std::span<const VariantDescriptor> descriptors,
+                                                   uint32_t window,
+                                                   const VariantProducer& produce,
+                                                   const VariantConsumer& consume)
+{
+    if (primaryCompiler == nullptr)
+    {
+        return std::unexpected(CookError::CompilerNotInitialized);
+    }
+
+    // Slot `i % window` holds the result of descriptor `i` from the moment a worker finishes it until
+    // the consumer takes it. A worker takes descriptor `i` only once `i - window` has been consumed,
+    // so no slot ever holds two results.
+    const size_t slotCount = std::max<size_t>(window, 1u);
+    std::vector<std::optional<CookResult<RawVariant>>> slots(slotCount);
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    std::condition_variable slotFreed;
+    size_t nextDescriptor{ 0u };
+    size_t consumedCount{ 0u };
+    bool stopped{ false };
+
+    auto produceUntilDone = [&](SlangCompiler& compiler)
+    {
+        for (;;)
+        {
+            size_t i = 0u;
+            {
+                std::unique_lock lock{ mutex };
+                slotFreed.wait(lock,
+                               [&]
+                               {
+                                   return stopped || nextDescriptor >= descriptors.size() ||
+                                          nextDescriptor < consumedCount + slotCount;
+                               });
+                if (stopped || nextDescriptor >= descriptors.size())
+                {
+                    return;
+                }
+
+                i = nextDescriptor++;
+            }
+
+            CookResult<RawVariant> result = produce(compiler, descriptors[i]);
+            {
+                const std::lock_guard lock{ mutex };
+                slots[i % slotCount].emplace(std::move(result));
+            }
+            resultReady.notify_all();
+        }
+    };
+
+    CookResult<void> outcome{};
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers.size() + 1u);
+        threads.emplace_back(produceUntilDone, std::ref(*primaryCompiler));
+        for (const std::unique_ptr<Worker>& worker : workers)
+        {
+            threads.emplace_back(produceUntilDone, std::ref(worker->Compiler));
+        }
+
+        // The calling thread consumes, so whatever `consume` touches stays on one thread.
+        for (size_t i = 0u; i < descriptors.size(); ++i)
+        {
+            CookResult<RawVariant> result{ std::unexpected(CookError::Invalid) };
+            {
+                std::unique_lock lock{ mutex };
+                std::optional<CookResult<RawVariant>>& slot = slots[i % slotCount];
+                resultReady.wait(lock,
+                                 [&]
+                                 {
+                                     return slot.has_value();
+                                 });
+                result = std::move(slot.value());
+                slot.reset();
+                ++consumedCount;
+            }
+            slotFreed.notify_all();
+
+            outcome = consume(i, std::move(result));
+            if (!outcome)
+            {
+                break;
+            }
+        }
+
+        {
+            const std::lock_guard lock{ mutex };
+            stopped = true;
+        }
+        slotFreed.notify_all();
+    }
+
+    ForwardWorkerDiagnostics();
+    return outcome;
+}
+
+void SlangCompilerPool::AdoptCompilers(std::vector<SlangCompiler>&& compilers)
+{
+    std::ranges::move(compilers, std::back_inserter(adopted));
+    compilers.clear();
+}
+
+void SlangCompilerPool::AdoptLoadedCompilers(std::vector<SlangCompiler>&& compilers)
+{
+    std::ranges::move(compilers, std::back_inserter(adoptedLoaded));
+    compilers.clear();
+}
+
+SlangCompilerPool::ReleasedCompilers SlangCompilerPool::ReleaseCompilers()
+{
+    ReleasedCompilers released{ .Loaded = std::move(adoptedLoaded), .Spares = std::move(adopted) };
+    adoptedLoaded.clear();
+    adopted.clear();
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        const bool holdsModule = worker->InitializeResult == CookError::Success;
+        (holdsModule ? released.Loaded : released.Spares).push_back(std::move(worker->Compiler));
+    }
+
+    workers.clear();
+    return released;
+}
+
+uint32_t SlangCompilerPool::WorkerCount() const noexcept
+{
+    return static_cast<uint32_t>(workers.size()) + 1u;
+}
+
+ConstantModuleCacheStatistics SlangCompilerPool::GetConstantModuleCacheStatistics() const noexcept
+{
+    ConstantModuleCacheStatistics total;
+    if (primaryCompiler != nullptr)
+    {
+        total = primaryCompiler->GetConstantModuleCacheStatistics();
+    }
+
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        const ConstantModuleCacheStatistics counted = worker->Compiler.GetConstantModuleCacheStatistics();
+        total.Hits += counted.Hits;
+        total.Misses += counted.Misses;
+    }
+
+    return total;
+}
+
+CookPhaseTimes SlangCompilerPool::GetPhaseTimes() const noexcept
+{
+    CookPhaseTimes total;
+    if (primaryCompiler != nullptr)
+    {
+        total = primaryCompiler->GetPhaseTimes();
+    }
+
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        total.Add(worker->Compiler.GetPhaseTimes());
+    }
+
+    return total;
+}
+
+void SlangCompilerPool::ForwardWorkerDiagnostics()
+{
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        const std::vector<Diagnostic>& records = worker->Sink.Records();
+        for (size_t i = worker->Forwarded; i < records.size(); ++i)
+        {
+            sink->Report(records[i]);
+        }
+
+        worker->Forwarded = records.size();
+    }
+}
+
+} // namespace lodestone
@@ -1,13 +1,21 @@
 #include "driver/CookerDriver.hpp"
+#include "CookTrace.hpp"
 #include "CookerErrors.hpp"
 #include "compile/Diagnostics.hpp"
 #include "compile/RawLibrary.hpp"
+#include "compile/RawVariantCache.hpp"
 #include "compile/SlangCompiler.hpp"
+#include "compile/SlangCompilerPool.hpp"
 #include "driver/CookerOptions.hpp"
+#include "driver/ModuleStamp.hpp"
+#include "driver/WarmCompilerCache.hpp"
 #include "emit/DedupeReport.hpp"
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
 #include "emit/OutputSink.hpp"
 #include "emit/ShaderLibraryEmitter.hpp"
 #include "emit/ShaderManifestEmitter.hpp"
+#include "emit/ShaderPackEmitter.hpp"
 #include "emit/StageDump.hpp"
 #include "model/CookedLibrary.hpp"
 #include "model/ResolveStage.hpp"
@@ -18,14 +26,18 @@
 #include "target/TargetProfile.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <expected>
 #include <filesystem>
+#include <fstream>
 #include <functional>
+#include <ios>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <print>
 #include <ranges>
 #include <ratio>
@@ -33,6 +45,7 @@
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -192,53 +205,39 @@ namespace
         return mismatchCount;
     }
 
-    /** Replays every variant through the finished tables and compares the result against the text the
-     * compiler produced. This is the one check that makes a wrong shader impossible to ship: an index
-     * mistake, a table hole, or a bad collapse all show up here, and all of them fail the cook. */
-    const CompiledVariant* FindCompiledVariant(std::span<const CompiledVariant> compiled,
-                                               uint32_t variant_index) noexcept
-    {
-        // `compiled` is sorted in ascending order already: we can use lower_bound to find variant idx in
-        // log2(n)
-        auto candidateIter =
-            std::ranges::lower_bound(compiled, variant_index, std::less{}, &CompiledVariant::VariantIndex);
-        if (candidateIter != compiled.end() && candidateIter->VariantIndex == variant_index)
-        {
-            return std::to_address(candidateIter);
-        }
-        return nullptr;
-    }
-
-    /** Replays every layout through the finished tables and compares it against the bindings the
-     * compiler produced.
+    /** Replays one variant through the tables it was just interned into, and compares the result
+     * against what the compiler produced: the text of each entry point, and the bindings it reads.
+     * This is the one check that makes a wrong shader impossible to ship: an index mistake, a table
+     * hole, or a bad collapse all show up here, and all of them fail the cook.
      *
-     * The source table has a second opinion, and until this check the layout table had none.
-     * `CheckManifestLayout` compares the manifest against the table it was written from, so it can
-     * prove the serialization is faithful and cannot see a wrong collapse. */
-    CookResult<void> VerifyLayoutRoundTrip(const CookedModule& module,
-                                           std::span<const CompiledVariant> compiled)
+     * The tables only grow, so a variant resolves through the frozen module exactly as it does here.
+     * That lets the check run as each variant arrives, and the variant can go once it passes. */
+    CookResult<void> VerifyVariantRoundTrip(const InternedModule& module, const CompiledVariant& compiled)
     {
+        const LibraryVariant& variant = module.Variants.back();
         uint32_t mismatches = 0u;
 
-        for (const LibraryVariant& variant : module.Variants)
+        for (size_t i = 0u; i < compiled.EntryPoints.size(); ++i)
         {
-            const CompiledVariant* origin = FindCompiledVariant(compiled, variant.Index);
-            if (origin == nullptr)
+            if (ResolveSource(module, variant, i) != compiled.EntryPoints[i].Code)
             {
-                continue;
+                std::println(stderr,
+                             "[shader_cooker] ROUND TRIP FAILED for {} [{}]: the table returns "
+                             "different text than the compiler produced",
+                             compiled.EntryPoints[i].Name,
+                             variant.Description);
+                ++mismatches;
             }
 
-            for (size_t i = 0u; i < origin->EntryPoints.size(); ++i)
+            // The source table has a second opinion, and until this check the layout table had none.
+            // `CheckManifestLayout` compares the manifest against the table it was written from, so it
+            // can prove the serialization is faithful and cannot see a wrong collapse.
+            if (ResolveLayoutView(module, variant, i) != BuildEntryPointLayoutView(compiled, i))
             {
-                if (ResolveLayoutView(module, variant, i) == BuildEntryPointLayoutView(*origin, i))
-                {
-                    continue;
-                }
-
                 std::println(stderr,
                              "[shader_cooker] LAYOUT ROUND TRIP FAILED for {} [{}]: the tables return "
                              "different bindings than the compiler produced",
-                             origin->EntryPoints[i].Name,
+                             compiled.EntryPoints[i].Name,
                              variant.Description);
                 ++mismatches;
             }
@@ -252,127 +251,199 @@ namespace
         return {};
     }
 
-    CookResult<void> VerifyLibraryRoundTrip(const CookedModule& module,
-                                            std::span<const CompiledVariant> compiled)
+    ManifestSourceCompression SourceCompressionFor(const CookerOptions& options) noexcept
     {
-        if (module.Variants.size() != compiled.size())
+        if (!options.CompressSources)
         {
-            std::println(stderr,
-                         "[shader_cooker] module {} holds {} variants but the cook produced {}",
-                         module.Name,
-                         module.Variants.size(),
-                         compiled.size());
-            return std::unexpected(CookError::LibraryRoundTripFailed);
+            return ManifestSourceCompression::None;
         }
 
-        uint32_t mismatches = 0u;
-        for (const LibraryVariant& variant : module.Variants)
-        {
-            const CompiledVariant* origin = FindCompiledVariant(compiled, variant.Index);
-            if (origin == nullptr)
-            {
-                std::println(stderr,
-                             "[shader_cooker] variant index {} is in the library but not in the cook",
-                             variant.Index);
-                ++mismatches;
-                continue;
-            }
+        return options.SourceDictionary ? ManifestSourceCompression::Dictionary
+                                        : ManifestSourceCompression::Blocks;
+    }
 
-            for (size_t i = 0u; i < origin->EntryPoints.size(); ++i)
-            {
-                if (ResolveSource(module, variant, i) != origin->EntryPoints[i].Code)
-                {
-                    std::println(stderr,
-                                 "[shader_cooker] ROUND TRIP FAILED for {} [{}]: the table returns "
-                                 "different text than the compiler produced",
-                                 origin->EntryPoints[i].Name,
-                                 variant.Description);
-                    ++mismatches;
-                }
-            }
+    /** Emits every artifact of one module as text, while its `CookedModule` still exists. Nothing
+     * reaches the sink here: the library header needs every module first. */
+    CookResult<ModuleArtifacts> MakeModuleArtifacts(std::string_view header_stem,
+                                                    std::string_view header_name,
+                                                    const CookedModule& module,
+                                                    const ManifestSourceOptions& source_options)
+    {
+        ModuleArtifacts artifacts;
+        artifacts.Name = module.Name;
+        artifacts.EntryPointNames.reserve(module.EntryPoints.size());
+        for (const LibraryEntryPoint& entryPoint : module.EntryPoints)
+        {
+            artifacts.EntryPointNames.push_back(entryPoint.Name);
         }
 
-        if (mismatches != 0u)
+        artifacts.HeaderSection = EmitShaderLibraryHeaderSection(module);
+        artifacts.SourceFileName = MakeModuleSourceFileName(header_stem, module.Name);
+        artifacts.Source = EmitShaderLibraryModuleSource(module, header_name);
+
+        std::println(stderr,
+                     "[shader_cooker] emitted {} ({} unique sources, {} resources, {} resource "
+                     "lists, {} footprint lists, {} visibility lists, {} KiB)",
+                     artifacts.SourceFileName,
+                     module.Sources.size(),
+                     module.Resources.size(),
+                     module.ResourceLists.size(),
+                     module.FootprintLists.size(),
+                     module.VisibilityLists.size(),
+                     artifacts.Source.size() / 1024u);
+
+        artifacts.Manifest = EmitShaderManifest(module, source_options);
+        if (CookResult<void> manifestCheck = VerifyManifestRoundTrip(module, artifacts.Manifest);
+            !manifestCheck)
         {
-            return std::unexpected(CookError::LibraryRoundTripFailed);
+            return std::unexpected(manifestCheck.error());
         }
 
-        return {};
+        artifacts.ManifestFileName = MakeManifestFileName(module.Name);
+        artifacts.ReportSection = GenerateDedupeReportSection(module);
+        return artifacts;
     }
 
-    CookResult<void> EmitLibraryModules(std::string_view header_stem,
-                                        std::string_view header_name,
-                                        const std::vector<CookedModule>& modules,
-                                        OutputSink& sink,
-                                        CookStatistics& statistics)
+    /** Rewrites each module manifest to read its text from the library source file, and checks every
+     * rewrite against the manifest it came from before any of them can reach the sink. */
+    CookResult<std::vector<std::string>> ShareModuleSources(std::span<const ModuleArtifacts> modules,
+                                                            const LibraryTables& library,
+                                                            const std::string& library_sources)
     {
-        for (const CookedModule& module : modules)
-        {
-            const std::string sourceName = MakeModuleSourceFileName(header_stem, module.Name);
-            const std::string source = EmitShaderLibraryModuleSource(module, header_name);
+        std::vector<std::string> manifests;
+        manifests.reserve(modules.size());
 
-            if (CookResult<void> sourceResult = sink.WriteArtifact(sourceName, source); !sourceResult)
+        for (size_t i = 0u; i < modules.size(); ++i)
+        {
+            CookResult<std::string> shared =
+                ShareManifestSources(modules[i].Manifest, library.SourceRemaps[i]);
+            if (!shared)
             {
-                return sourceResult;
+                return std::unexpected(shared.error());
             }
 
-            statistics.GeneratedSourceBytes += source.size();
-            std::println(stderr,
-                         "[shader_cooker] wrote {} ({} unique sources, {} resources, {} resource "
-                         "lists, {} footprint lists, {} visibility lists, {} KiB)",
-                         sourceName,
-                         module.Sources.size(),
-                         module.Resources.size(),
-                         module.ResourceLists.size(),
-                         module.FootprintLists.size(),
-                         module.VisibilityLists.size(),
-                         source.size() / 1024u);
-
-            const std::string manifest = EmitShaderManifest(module);
-
-            if (CookResult<void> manifestCheck = VerifyManifestRoundTrip(module, manifest); !manifestCheck)
+            if (CookResult<void> check =
+                    VerifySharedSourceRoundTrip(modules[i].Manifest, shared.value(), library_sources);
+                !check)
             {
-                return manifestCheck;
+                return std::unexpected(check.error());
             }
 
-            if (CookResult<void> manifestResult =
-                    sink.WriteArtifact(MakeManifestFileName(module.Name), manifest);
-                !manifestResult)
-            {
-                return manifestResult;
-            }
+            manifests.push_back(std::move(shared.value()));
         }
 
-        return {};
+        return manifests;
     }
 
-    /** Writes the header and one source file for each module. The header name comes from the sink, so
-     * the generated source includes exactly the file the user asked for.
+    /** Writes the header, then one source file and one manifest for each module, then the report.
+     * The header name comes from the sink, so the generated source includes exactly the file the user
+     * asked for.
+     *
+     * The library pass runs here, over the finished module artifacts, so a module taken from its stamp
+     * takes part exactly as a cooked one does. With `--share-sources`, the library source file goes
+     * out before the manifests that read it. With `--pack`, both go into one pack instead, checked
+     * before it is written.
      * todo: For writing files, we can accumulate output we want to write into a buffer, and only validate
      * things once. Validate directory when opening the stream, validate write success of coalesced writes
      * (cleans up control flow)*/
-    CookResult<void> EmitLibraryArtifacts(const CookedLibrary& library,
+    CookResult<void> EmitLibraryArtifacts(const CookerOptions& options,
+                                          std::span<const ModuleArtifacts> modules,
                                           OutputSink& sink,
+                                          CookTrace& trace,
                                           CookStatistics& statistics)
     {
-        const std::string headerName{ sink.PrimaryName() };
-        const std::filesystem::path headerPath{ headerName };
-        const std::string headerStem = headerPath.stem().string();
+        const ScopedPhaseTimer emitTimer{
+            statistics.PhaseTimes, CookPhase::Emit, &trace, sink.PrimaryName()
+        };
+        CookResult<LibraryTables> library = FoldLibraryTables(modules, options.DedupeEnabled);
+        if (!library)
+        {
+            return std::unexpected(library.error());
+        }
+
+        std::println(stderr,
+                     "[shader_cooker] library: {} module sources -> {} library sources ({} KiB -> {} KiB)",
+                     library.value().Statistics.SourceTable.Interning.ArtifactsSeen,
+                     library.value().Sources.size(),
+                     library.value().Statistics.ModuleSourceBytes / 1024u,
+                     library.value().Statistics.LibrarySourceBytes / 1024u);
+
+        std::vector<std::string> sharedManifests;
+        std::string librarySources;
+        const std::string headerStem = std::filesystem::path{ sink.PrimaryName() }.stem().string();
+        if (options.ShareLibrarySources)
+        {
+            librarySources =
+                EmitLibrarySourceManifest(headerStem, library.value().Sources, SourceCompressionFor(options));
+            CookResult<std::vector<std::string>> shared =
+                ShareModuleSources(modules, library.value(), librarySources);
+            if (!shared)
+            {
+                return std::unexpected(shared.error());
+            }
+
+            if (!options.PackManifests)
+            {
+                if (CookResult<void> sourcesResult =
+                        sink.WriteArtifact(MakeLibrarySourceFileName(headerStem), librarySources);
+                    !sourcesResult)
+                {
+                    return sourcesResult;
+                }
+            }
 
-        const std::string header = EmitShaderLibraryHeader(library);
+            sharedManifests = std::move(shared.value());
+            library.value().Statistics.SourcesShared = true;
+        }
+
+        const std::string header = EmitShaderLibraryHeader(modules);
         if (auto headerResult = sink.Write(header); !headerResult)
         {
             return headerResult;
         }
 
-        if (auto emitLibraryResult =
-                EmitLibraryModules(headerStem, headerName, library.Modules, sink, statistics);
-            !emitLibraryResult)
+        std::vector<ShaderPackEntry> packEntries;
+        for (size_t i = 0u; i < modules.size(); ++i)
+        {
+            const ModuleArtifacts& module = modules[i];
+            if (CookResult<void> sourceResult = sink.WriteArtifact(module.SourceFileName, module.Source);
+                !sourceResult)
+            {
+                return sourceResult;
+            }
+
+            statistics.GeneratedSourceBytes += module.Source.size();
+
+            const std::string& manifest = sharedManifests.empty() ? module.Manifest : sharedManifests[i];
+            if (options.PackManifests)
+            {
+                packEntries.push_back(ShaderPackEntry{ .ModuleName = module.Name, .Manifest = manifest });
+                continue;
+            }
+
+            if (CookResult<void> manifestResult = sink.WriteArtifact(module.ManifestFileName, manifest);
+                !manifestResult)
+            {
+                return manifestResult;
+            }
+        }
+
+        if (options.PackManifests)
         {
-            return emitLibraryResult;
+            const std::string pack = EmitShaderPack(packEntries, librarySources);
+            if (CookResult<void> verifyResult = VerifyShaderPackRoundTrip(packEntries, pack); !verifyResult)
+            {
+                return verifyResult;
+            }
+
+            if (CookResult<void> packResult = sink.WriteArtifact(MakeShaderPackFileName(headerStem), pack);
+                !packResult)
+            {
+                return packResult;
+            }
         }
 
-        const std::string report = GenerateDedupeReport(library);
+        const std::string report = GenerateDedupeReport(modules, library.value().Statistics);
         if (auto reportResult = sink.WriteArtifact("ShaderLibrary.dedupe.txt", report); !reportResult)
         {
             return reportResult;
@@ -399,31 +470,114 @@ namespace
         return sink.WriteArtifact(MakeStageDumpFileName(module_name, kind), build_dump());
     }
 
-    /** Builds the compiler for one module, and checks everything that must hold before the first
-     * variant compiles. */
-    CookResult<void> PrepareModuleCompiler(const CookerOptions& options,
-                                           const std::filesystem::path& module_path,
-                                           DiagnosticSink& diagnostics,
-                                           SlangCompiler& compiler,
-                                           const PermutationSpace*& out_space)
+    /** One create info for every compiler of a module, so every worker of the pool compiles with the
+     * options the primary compiler was checked with. */
+    SlangCompilerCreateInfo MakeCompilerCreateInfo(const CookerOptions& options,
+                                                   const std::filesystem::path& module_path,
+                                                   CookTrace& trace)
     {
         SlangCompilerCreateInfo createInfo;
+        createInfo.Trace = &trace;
         createInfo.ModulePath = module_path;
         createInfo.ModuleCacheDirectory = options.ModuleCacheDirectory;
         createInfo.OptimizationLevel = options.OptimizationLevel;
         createInfo.MultithreadEntryPointCodegen = options.MultithreadEntryPointCodegen;
+        return createInfo;
+    }
 
-        if (auto initializeResult = compiler.Initialize(createInfo, diagnostics);
-            initializeResult != CookError::Success)
+    /** @brief The compiler one module cooks with, taken from a warm cache when there is one.
+     *
+     * It goes back to the cache when the module's cook ends, however it ends: loaded if the module
+     * loaded and passed its checks, as a spare otherwise. The module's pool workers go back with it.
+     * Without a cache it is an ordinary compiler that dies with the cook. */
+    class ModuleCompilerLease final
+    {
+    public:
+        ModuleCompilerLease(WarmCompilerCache* _cache, const SlangCompilerCreateInfo& create_info)
+            : cache{ _cache }, createInfo{ create_info }
+        {
+            if (cache != nullptr)
+            {
+                WarmCompilerCache::Checkout checkout = cache->CheckOutModule(createInfo);
+                compiler = std::move(checkout.Compiler);
+                workers = std::move(checkout.Workers);
+                isLoaded = checkout.IsLoaded;
+            }
+        }
+
+        ~ModuleCompilerLease()
+        {
+            if (cache != nullptr)
+            {
+                cache->ReturnModule(createInfo, std::move(compiler), isLoaded, std::move(workers));
+            }
+        }
+
+        ModuleCompilerLease(const ModuleCompilerLease&) = delete;
+        ModuleCompilerLease& operator=(const ModuleCompilerLease&) = delete;
+
+        [[nodiscard]] SlangCompiler& Compiler() noexcept
+        {
+            return compiler;
+        }
+
+        /** The pool workers that hold the module loaded. The pool takes them, and leaves here the ones
+         * that hold it when the cook ends. */
+        [[nodiscard]] std::vector<SlangCompiler>& Workers() noexcept
+        {
+            return workers;
+        }
+
+        [[nodiscard]] bool IsLoaded() const noexcept
+        {
+            return isLoaded;
+        }
+
+        /** Called once the module passed its checks, so the cache keeps it loaded. A lease that never
+         * gets here hands its compiler back as a spare. */
+        void MarkLoaded() noexcept
+        {
+            isLoaded = true;
+        }
+
+        void MarkUnloaded() noexcept
+        {
+            isLoaded = false;
+        }
+
+    private:
+        WarmCompilerCache* cache{ nullptr };
+        const SlangCompilerCreateInfo& createInfo;
+        SlangCompiler compiler;
+        std::vector<SlangCompiler> workers;
+        bool isLoaded{ false };
+    };
+
+    /** Builds the compiler for one module, and checks everything that must hold before the first
+     * variant compiles. A compiler a warm cache kept loaded only moves to this cook's sink and trace:
+     * nothing it read has changed, but the checks run again, because they are cheap and they print. */
+    CookResult<void> PrepareModuleCompiler(const SlangCompilerCreateInfo& create_info,
+                                           DiagnosticSink& diagnostics,
+                                           SlangCompiler& compiler,
+                                           bool is_loaded,
+                                           const PermutationSpace*& out_space)
+    {
+        if (is_loaded)
+        {
+            compiler.Rebind(diagnostics, create_info.Trace);
+        }
+        else if (auto initializeResult = compiler.Initialize(create_info, diagnostics);
+                 initializeResult != CookError::Success)
         {
             return std::unexpected(initializeResult);
         }
 
         const std::string_view moduleName = compiler.GetModuleName();
         std::println(stderr,
-                     "[shader_cooker] module {} declares {} entrypoints",
+                     "[shader_cooker] module {} declares {} entrypoints{}",
                      moduleName,
-                     compiler.GetEntryPointNames().size());
+                     compiler.GetEntryPointNames().size(),
+                     is_loaded ? ", and reuses its loaded Slang session" : "");
 
         out_space = FindPermutationSpaceForModule(moduleName);
 
@@ -484,94 +638,297 @@ namespace
         }
     }
 
-    /** @brief Runs Slang compiler on each variant (which contains multiple entry points, remember),
-     * and then takes that result and "resolves" it by evaluating our custom meta-language for sizes
-     * and resource descriptors etc. This is also when the index tables are built as well. */
-    CookResult<void> CompileModuleVariants(const CookerOptions& options,
-                                           const TargetProfile& target,
-                                           SlangCompiler& compiler,
-                                           const VariantSet& variant_set,
-                                           InternedModule& interned_module,
-                                           RawModule& raw_module,
-                                           std::vector<CompiledVariant>& out_module_variants,
-                                           CookStatistics& statistics)
+    /** How many modules cook at once. More jobs than modules would start threads with nothing to do. */
+    uint32_t ChooseModuleJobCount(const CookerOptions& options) noexcept
     {
-        const bool keepRawVariants = IsStageDumpRequested(options, StageDumpKind::Raw);
+        return static_cast<uint32_t>(
+            std::clamp<size_t>(options.ModulePaths.size(), 1u, std::max(options.ModuleJobCount, 1u)));
+    }
 
-        for (const VariantDescriptor& descriptor : variant_set.Variants)
+    /** A pool larger than the variant count would pay for global sessions that never compile. When
+     * modules cook at once, the default splits the hardware threads between them, so N jobs do not
+     * start N pools of one session per thread. */
+    uint32_t ChooseCompileWorkerCount(const CookerOptions& options, size_t variant_count) noexcept
+    {
+        const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        const uint32_t requested = options.CompileWorkerCount != 0u
+                                       ? options.CompileWorkerCount
+                                       : std::max(hardwareThreads / ChooseModuleJobCount(options), 1u);
+        return static_cast<uint32_t>(std::clamp<size_t>(variant_count, 1u, requested));
+    }
+
+    /** How many variants each compiler may run ahead of the resolve stage. Two keeps every worker busy
+     * while the consumer catches up, and bounds a module's raw output to two variants per session. */
+    constexpr uint32_t k_VariantWindowPerWorker{ 2u };
+
+    /** @brief Produces the stage 3 output of every variant, and hands each one to `consume` in
+     * descriptor order, on the calling thread.
+     *
+     * A variant the cache holds skips Slang. The rest compile on a pool, and the pool is sized by the
+     * variants the cache lacks, so a cook of unchanged sources pays for one session. A worker writes
+     * each variant it compiles to the cache at once. A variant that failed is not written, so a later
+     * cook tries it again.
+     *
+     * `warm_workers` are the workers a warm cache kept loaded for this module. The pool rebinds them
+     * ahead of loading any spare, and leaves in `warm_workers` every worker that holds the module at
+     * the end. */
+    CookResult<void> StreamModuleVariants(const CookerOptions& options,
+                                          const SlangCompilerCreateInfo& create_info,
+                                          SlangCompiler& compiler,
+                                          WarmCompilerCache* warm_compilers,
+                                          std::vector<SlangCompiler>& warm_workers,
+                                          const RawVariantCache& cache,
+                                          const VariantSet& variant_set,
+                                          InternedModule& interned_module,
+                                          std::span<StagedVariantSources> out_staged_sources,
+                                          DiagnosticSink& diagnostics,
+                                          CookTrace& trace,
+                                          CookStatistics& statistics,
+                                          const SlangCompilerPool::VariantConsumer& consume)
+    {
+        const std::string_view moduleName = compiler.GetModuleName();
+        const std::span<const VariantDescriptor> descriptors = variant_set.Variants;
+        auto isMissing = [&cache](const VariantDescriptor& descriptor)
+        {
+            return !cache.Contains(descriptor);
+        };
+        const auto expectedMisses = static_cast<size_t>(std::ranges::count_if(descriptors, isMissing));
+
+        SlangCompilerPool pool;
+        const uint32_t workerCount = ChooseCompileWorkerCount(options, expectedMisses);
+        auto releaseWorkers = [&]
         {
-            CookResult<RawVariant> rawResult = compiler.CompileVariantRaw(descriptor);
-            if (!rawResult)
+            if (warm_compilers != nullptr)
             {
-                std::println(stderr,
-                             "[shader_cooker] variant [{}] failed: {}",
-                             DescribeAssignment(descriptor.Canonical),
-                             ToString(rawResult.error()));
-                return std::unexpected(rawResult.error());
+                SlangCompilerPool::ReleasedCompilers released = pool.ReleaseCompilers();
+                warm_workers = std::move(released.Loaded);
+                warm_compilers->ReturnSpares(std::move(released.Spares));
             }
+        };
 
-            const ResolveContext context =
-                MakeResolveContext(descriptor.Canonical, raw_module.ExternDefaults);
-            CookResult<CompiledVariant> variantResult = ResolveVariant(rawResult.value(), context);
-            if (!variantResult)
+        if (warm_compilers != nullptr)
+        {
+            const size_t loadedWorkerCount = std::min<size_t>(warm_workers.size(), workerCount - 1u);
+            pool.AdoptLoadedCompilers(std::move(warm_workers));
+            pool.AdoptCompilers(warm_compilers->CheckOutSpares(workerCount - 1u - loadedWorkerCount));
+        }
+
+        const CookError poolResult = pool.Initialize(create_info, compiler, workerCount, diagnostics);
+        if (poolResult != CookError::Success)
+        {
+            releaseWorkers();
+            return std::unexpected(poolResult);
+        }
+
+        if (expectedMisses != 0u)
+        {
+            std::println(
+                stderr, "[shader_cooker] module {} compiles on {} Slang sessions", moduleName, workerCount);
+        }
+
+        // Workers count on their own threads. The join inside `StreamVariants` publishes every count.
+        // A cache load has no compiler to hold its time, so the workers sum it here.
+        std::atomic<uint32_t> hitCount{ 0u };
+        std::atomic<uint32_t> missCount{ 0u };
+        std::atomic<int64_t> cacheLoadNanoseconds{ 0 };
+        auto produce = [&](SlangCompiler& worker, const VariantDescriptor& descriptor)
+        {
+            // Described only for the trace, because a description costs a string for each variant.
+            const std::string detail =
+                trace.IsEnabled() ? DescribeAssignment(descriptor.Canonical) : std::string{};
+            const ScopedTraceSpan variantSpan{ &trace, "variant", detail };
+
+            const CookTrace::Clock::time_point loadStart = CookTrace::Clock::now();
+            std::optional<RawVariant> cached = cache.Load(descriptor);
+            const CookTrace::Clock::time_point loadEnd = CookTrace::Clock::now();
+            cacheLoadNanoseconds.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(loadEnd - loadStart).count(),
+                std::memory_order_relaxed);
+            if (cache.IsEnabled())
             {
-                std::println(stderr,
-                             "[shader_cooker] variant [{}] failed: {}",
-                             DescribeAssignment(descriptor.Canonical),
-                             ToString(variantResult.error()));
-                return std::unexpected(variantResult.error());
+                trace.Record(ToString(CookPhase::CacheLoad), detail, loadStart, loadEnd);
             }
 
-            if (keepRawVariants)
+            CookResult<RawVariant> produced{ std::unexpected(CookError::Invalid) };
+            if (cached)
             {
-                raw_module.Variants.push_back(std::move(rawResult.value()));
+                hitCount.fetch_add(1u, std::memory_order_relaxed);
+                produced = std::move(cached.value());
             }
-
-            CompiledVariant& variant = variantResult.value();
-            RecordVariantStatistics(variant, statistics);
-            ReportVariantIfRequested(options, variant);
-
-            if (options.ValidateAgainstEmittedText)
+            else
             {
-                statistics.ReflectionMismatches += ValidateResolvedLibrary(target, variant);
+                missCount.fetch_add(1u, std::memory_order_relaxed);
+                produced = worker.CompileVariantRaw(descriptor);
+                if (produced)
+                {
+                    cache.Store(descriptor, produced.value());
+                }
             }
 
-            if (options.ReportReflection)
+            // The source is hashed and compared here, on the worker, so the ordered consumer only has
+            // to commit it. The pool's hand-off publishes the tickets along with the result.
+            if (produced)
             {
-                ReportUnreferencedBindings(variant);
+                const auto position = static_cast<size_t>(&descriptor - descriptors.data());
+                out_staged_sources[position] = StageVariantSources(interned_module, produced.value());
             }
 
-            CaptureEntryPointsOnce(interned_module, variant);
+            return produced;
+        };
 
-            if (CookResult<void> appendResult =
-                    AppendVariantToModule(interned_module, variant, descriptor.Canonical);
-                !appendResult)
-            {
-                return appendResult;
-            }
+        const CookResult<void> streamed =
+            pool.StreamVariants(descriptors, workerCount * k_VariantWindowPerWorker, produce, consume);
 
-            out_module_variants.emplace_back(std::move(variant));
+        statistics.VariantCacheHits += hitCount.load(std::memory_order_relaxed);
+        statistics.VariantCacheMisses += missCount.load(std::memory_order_relaxed);
+        const std::chrono::nanoseconds cacheLoadTime{ cacheLoadNanoseconds.load(std::memory_order_relaxed) };
+        statistics.PhaseTimes.Add(CookPhase::CacheLoad,
+                                  std::chrono::duration<double, std::milli>{ cacheLoadTime }.count());
+        statistics.PhaseTimes.Add(pool.GetPhaseTimes());
+        if (cache.IsEnabled())
+        {
+            std::println(stderr,
+                         "[shader_cooker] module {} found {} of {} variants in the variant cache",
+                         moduleName,
+                         hitCount.load(std::memory_order_relaxed),
+                         descriptors.size());
         }
 
-        return {};
+        const ConstantModuleCacheStatistics constantModules = pool.GetConstantModuleCacheStatistics();
+        statistics.ConstantModuleCacheHits += constantModules.Hits;
+        statistics.ConstantModuleCacheMisses += constantModules.Misses;
+        std::println(stderr,
+                     "[shader_cooker] module {} parsed {} constant modules and reused {}",
+                     moduleName,
+                     constantModules.Misses,
+                     constantModules.Hits);
+
+        // Released last, because the pool sums its workers' counts only while it holds them.
+        releaseWorkers();
+        return streamed;
     }
 
-    /**@brief Take `InternedModule` and package it into `CookedModule`. */
-    CookResult<CookedModule> FinalizeModule(InternedModule&& interned_module,
-                                            std::span<const CompiledVariant> module_variants)
+    /** @brief Takes the Slang output of one variant (which contains multiple entry points, remember)
+     * and "resolves" it by evaluating our custom meta-language for sizes and resource descriptors
+     * etc. Then interns it into the module's tables and checks the round trip.
+     *
+     * This runs on one thread, in `VariantDescriptor::Index` order, so the interner numbers its
+     * entries exactly as a serial cook does and `--verify-deterministic` compares the same bytes.
+     * The workers already hashed and compared the sources, so here they only commit, in this order.
+     * Nothing of the variant outlives this call unless a dump asked for it, so a module's peak memory
+     * is its tables plus the variants in flight, not every variant at once. */
+    CookResult<void> ResolveAndInternVariant(const CookerOptions& options,
+                                             const TargetProfile& target,
+                                             const VariantDescriptor& descriptor,
+                                             CookResult<RawVariant>&& raw_result,
+                                             const StagedVariantSources& staged_sources,
+                                             InternedModule& interned_module,
+                                             RawModule& raw_module,
+                                             std::vector<CompiledVariant>& out_kept_variants,
+                                             CookTrace& trace,
+                                             CookStatistics& statistics)
     {
-        CookedModule cookedModule = FreezeModuleTables(std::move(interned_module));
+        if (!raw_result)
+        {
+            std::println(stderr,
+                         "[shader_cooker] variant [{}] failed: {}",
+                         DescribeAssignment(descriptor.Canonical),
+                         ToString(raw_result.error()));
+            return std::unexpected(raw_result.error());
+        }
 
-        if (CookResult<void> roundTripResult = VerifyLibraryRoundTrip(cookedModule, module_variants);
-            !roundTripResult)
+        CookResult<CompiledVariant> variantResult{ std::unexpected(CookError::Invalid) };
         {
-            return std::unexpected(roundTripResult.error());
+            const ScopedPhaseTimer resolveTimer{
+                statistics.PhaseTimes, CookPhase::Resolve, &trace, raw_result.value().VariantDescription
+            };
+            const ResolveContext context =
+                MakeResolveContext(descriptor.Canonical, raw_module.ExternDefaults);
+            variantResult = ResolveVariant(raw_result.value(), context);
         }
 
-        if (CookResult<void> layoutResult = VerifyLayoutRoundTrip(cookedModule, module_variants);
-            !layoutResult)
+        if (!variantResult)
         {
-            return std::unexpected(layoutResult.error());
+            std::println(stderr,
+                         "[shader_cooker] variant [{}] failed: {}",
+                         DescribeAssignment(descriptor.Canonical),
+                         ToString(variantResult.error()));
+            return std::unexpected(variantResult.error());
+        }
+
+        if (IsStageDumpRequested(options, StageDumpKind::Raw))
+        {
+            raw_module.Variants.push_back(std::move(raw_result.value()));
+        }
+
+        CompiledVariant& variant = variantResult.value();
+        RecordVariantStatistics(variant, statistics);
+        ReportVariantIfRequested(options, variant);
+
+        if (options.ValidateAgainstEmittedText)
+        {
+            const ScopedPhaseTimer crossCheckTimer{
+                statistics.PhaseTimes, CookPhase::CrossCheck, &trace, variant.VariantDescription
+            };
+            statistics.ReflectionMismatches += ValidateResolvedLibrary(target, variant);
+        }
+
+        if (options.ReportReflection)
+        {
+            ReportUnreferencedBindings(variant);
+        }
+
+        CaptureEntryPointsOnce(interned_module, variant);
+
+        CookResult<void> appendResult{};
+        {
+            const ScopedPhaseTimer internTimer{
+                statistics.PhaseTimes, CookPhase::Intern, &trace, variant.VariantDescription
+            };
+            appendResult =
+                AppendVariantToModule(interned_module, variant, descriptor.Canonical, &staged_sources);
+        }
+
+        if (!appendResult)
+        {
+            return appendResult;
+        }
+
+        CookResult<void> roundTrip{};
+        {
+            const ScopedPhaseTimer roundTripTimer{
+                statistics.PhaseTimes, CookPhase::RoundTrip, &trace, variant.VariantDescription
+            };
+            roundTrip = VerifyVariantRoundTrip(interned_module, variant);
+        }
+
+        if (!roundTrip)
+        {
+            return roundTrip;
+        }
+
+        if (IsStageDumpRequested(options, StageDumpKind::Resolved))
+        {
+            out_kept_variants.emplace_back(std::move(variant));
+        }
+
+        return {};
+    }
+
+    /**@brief Take `InternedModule` and package it into `CookedModule`. Every variant already passed its
+     * round trip on the way in, so what is left is to check that all of them arrived. */
+    CookResult<CookedModule> FinalizeModule(InternedModule&& interned_module, size_t variant_count)
+    {
+        CookedModule cookedModule = FreezeModuleTables(std::move(interned_module));
+
+        if (cookedModule.Variants.size() != variant_count)
+        {
+            std::println(stderr,
+                         "[shader_cooker] module {} holds {} variants but the cook produced {}",
+                         cookedModule.Name,
+                         cookedModule.Variants.size(),
+                         variant_count);
+            return std::unexpected(CookError::LibraryRoundTripFailed);
         }
 
         std::println(stderr,
@@ -589,11 +946,16 @@ namespace
         return cookedModule;
     }
 
+    /** Cooks one module into its artifacts. A clean cook also leaves a stamp, so the next cook can
+     * skip the module while its inputs stay the same. */
     CookResult<void> CookModule(const CookerOptions& options,
                                 const std::filesystem::path& module_path,
+                                const ModuleStampStore& stamps,
+                                WarmCompilerCache* warm_compilers,
                                 OutputSink& sink,
                                 DiagnosticSink& diagnostics,
-                                CookedLibrary& out_library,
+                                CookTrace& trace,
+                                std::vector<ModuleArtifacts>& out_modules,
                                 CookStatistics& statistics)
     {
         // `ParseCommandLine` already rejected a name no profile answers to, so this cannot be null.
@@ -603,16 +965,23 @@ namespace
             return std::unexpected(CookError::UnknownTargetProfile);
         }
 
-        SlangCompiler compiler;
+        const uint32_t mismatchesBefore = statistics.ReflectionMismatches;
+        const CookPhaseTimes phasesBefore = statistics.PhaseTimes;
+        const SlangCompilerCreateInfo createInfo = MakeCompilerCreateInfo(options, module_path, trace);
+        ModuleCompilerLease lease{ warm_compilers, createInfo };
+        SlangCompiler& compiler = lease.Compiler();
         const PermutationSpace* space = nullptr;
 
         if (CookResult<void> prepared =
-                PrepareModuleCompiler(options, module_path, diagnostics, compiler, space);
+                PrepareModuleCompiler(createInfo, diagnostics, compiler, lease.IsLoaded(), space);
             !prepared)
         {
+            lease.MarkUnloaded();
             return prepared;
         }
 
+        lease.MarkLoaded();
+
         // Said once for each module, because a cook that checked nothing must not look like a cook
         // that checked and agreed.
         std::println(stderr,
@@ -667,13 +1036,14 @@ namespace
         {
             DisableDedupe(internedModule);
         }
+        if (!options.ProvenanceEnabled)
+        {
+            DisableProvenance(internedModule);
+        }
         internedModule.Name = moduleName;
         internedModule.Space = space;
         internedModule.SpaceSize = variantSet.value().SpaceSize;
 
-        std::vector<CompiledVariant> moduleVariants;
-        moduleVariants.reserve(variantSet.value().Variants.size());
-
         CookResult<RawModule> rawModuleResult = compiler.PrepareRawModule(*space);
         if (!rawModuleResult)
         {
@@ -682,17 +1052,45 @@ namespace
 
         RawModule rawModule = std::move(rawModuleResult.value());
 
-        if (CookResult<void> compiled = CompileModuleVariants(options,
-                                                              *target,
-                                                              compiler,
-                                                              variantSet.value(),
-                                                              internedModule,
-                                                              rawModule,
-                                                              moduleVariants,
-                                                              statistics);
-            !compiled)
+        const RawVariantCache variantCache{ options.VariantCacheEnabled ? options.ModuleCacheDirectory
+                                                                        : std::filesystem::path{},
+                                            compiler.GetCompileInputHash() };
+        // Only the resolved dump needs the variants after they are interned.
+        std::vector<CompiledVariant> keptVariants;
+        // A worker writes the tickets of variant `i` before it hands the variant over, and the consumer
+        // drops them once the variant commits.
+        std::vector<StagedVariantSources> stagedSources(variantSet.value().Variants.size());
+        auto resolveAndIntern = [&](size_t position, CookResult<RawVariant>&& raw_result)
+        {
+            const StagedVariantSources staged = std::move(stagedSources[position]);
+            return ResolveAndInternVariant(options,
+                                           *target,
+                                           variantSet.value().Variants[position],
+                                           std::move(raw_result),
+                                           staged,
+                                           internedModule,
+                                           rawModule,
+                                           keptVariants,
+                                           trace,
+                                           statistics);
+        };
+
+        if (CookResult<void> streamed = StreamModuleVariants(options,
+                                                             createInfo,
+                                                             compiler,
+                                                             warm_compilers,
+                                                             lease.Workers(),
+                                                             variantCache,
+                                                             variantSet.value(),
+                                                             internedModule,
+                                                             stagedSources,
+                                                             diagnostics,
+                                                             trace,
+                                                             statistics,
+                                                             resolveAndIntern);
+            !streamed)
         {
-            return compiled;
+            return streamed;
         }
 
         if (CookResult<void> rawDump = WriteStageDumpIfRequested(options,
@@ -715,7 +1113,7 @@ namespace
                                           StageDumpKind::Resolved,
                                           [&]
                                           {
-                                              return DumpResolvedModule(moduleName, moduleVariants);
+                                              return DumpResolvedModule(moduleName, keptVariants);
                                           });
             !resolvedDump)
         {
@@ -738,7 +1136,8 @@ namespace
             return internedDump;
         }
 
-        CookResult<CookedModule> finalized = FinalizeModule(std::move(internedModule), moduleVariants);
+        CookResult<CookedModule> finalized =
+            FinalizeModule(std::move(internedModule), variantSet.value().Variants.size());
         if (!finalized)
         {
             return std::unexpected(finalized.error());
@@ -759,15 +1158,218 @@ namespace
             return cookedDump;
         }
 
-        out_library.Modules.push_back(std::move(cookedModule));
+        const std::string headerName{ sink.PrimaryName() };
+        const std::string headerStem = std::filesystem::path{ headerName }.stem().string();
+        CookResult<ModuleArtifacts> artifacts{ std::unexpected(CookError::Invalid) };
+        {
+            const ScopedPhaseTimer emitTimer{ statistics.PhaseTimes, CookPhase::Emit, &trace, moduleName };
+            const ManifestSourceOptions sourceOptions{
+                .Layout = options.ChunkedSources ? ManifestSourceLayout::Chunked
+                                                 : ManifestSourceLayout::Whole,
+                .Compression = SourceCompressionFor(options),
+            };
+            artifacts = MakeModuleArtifacts(headerStem, headerName, cookedModule, sourceOptions);
+        }
+
+        if (!artifacts)
+        {
+            return std::unexpected(artifacts.error());
+        }
+
+        // A module that disagreed with the target fails the cook further up. Its stamp would let the
+        // next cook skip the check that caught it.
+        if (statistics.ReflectionMismatches == mismatchesBefore)
+        {
+            stamps.Store(options,
+                         module_path,
+                         compiler.GetModuleSourcePaths(),
+                         compiler.GetModuleSourceTexts(),
+                         artifacts.value());
+        }
+
+        std::println(stderr,
+                     "[shader_cooker] module {} phases: {}",
+                     moduleName,
+                     DescribePhaseTimes(statistics.PhaseTimes.Since(phasesBefore)));
+
+        out_modules.push_back(std::move(artifacts.value()));
         ++statistics.ModulesCooked;
         return {};
     }
 
+    /** Takes the module from its stamp when nothing it reads has changed, and cooks it otherwise. A
+     * dump shows what the stages did, and the determinism check must watch both cooks do the work, so
+     * neither of them can take a module from its stamp. */
+    CookResult<void> CookOrReuseModule(const CookerOptions& options,
+                                       const std::filesystem::path& module_path,
+                                       const ModuleStampStore& stamps,
+                                       WarmCompilerCache* warm_compilers,
+                                       OutputSink& sink,
+                                       DiagnosticSink& diagnostics,
+                                       CookTrace& trace,
+                                       std::vector<ModuleArtifacts>& out_modules,
+                                       CookStatistics& statistics)
+    {
+        const std::string modulePath = module_path.string();
+        const ScopedTraceSpan moduleSpan{ &trace, "module", modulePath };
+
+        if (!options.VerifyDeterministic && options.DumpStageMask == 0u)
+        {
+            if (std::optional<ModuleArtifacts> unchanged = stamps.FindUnchanged(options, module_path))
+            {
+                std::println(stderr,
+                             "[shader_cooker] {} is unchanged, reusing its last cook",
+                             module_path.string());
+                out_modules.push_back(std::move(unchanged.value()));
+                ++statistics.ModulesReused;
+                return {};
+            }
+        }
+
+        std::println(stderr, "[shader_cooker] cooking {}", module_path.string());
+        return CookModule(
+            options, module_path, stamps, warm_compilers, sink, diagnostics, trace, out_modules, statistics);
+    }
+
+    /** Adds the counters of one module's cook to the totals of the whole cook. */
+    void AccumulateStatistics(CookStatistics& total, const CookStatistics& module) noexcept
+    {
+        total.ModulesCooked += module.ModulesCooked;
+        total.ModulesReused += module.ModulesReused;
+        total.VariantsCompiled += module.VariantsCompiled;
+        total.EntryPointsCompiled += module.EntryPointsCompiled;
+        total.ReflectionMismatches += module.ReflectionMismatches;
+        total.ConstantModuleCacheHits += module.ConstantModuleCacheHits;
+        total.ConstantModuleCacheMisses += module.ConstantModuleCacheMisses;
+        total.VariantCacheHits += module.VariantCacheHits;
+        total.VariantCacheMisses += module.VariantCacheMisses;
+        total.TotalWgslBytes += module.TotalWgslBytes;
+        total.GeneratedSourceBytes += module.GeneratedSourceBytes;
+        total.PhaseTimes.Add(module.PhaseTimes);
+    }
+
+    /** One module of a concurrent cook. The module writes into buffers of its own, and nothing reaches
+     * the cook until every job has finished. */
+    struct ModuleCookJob
+    {
+        explicit ModuleCookJob(std::string_view primary_name)
+            : Sink{ primary_name }
+        {
+        }
+
+        MemoryOutputSink Sink;
+        RecordingDiagnosticSink Diagnostics;
+        CookStatistics Statistics;
+        std::vector<ModuleArtifacts> Modules;
+        CookResult<void> Result{ std::unexpected(CookError::Invalid) };
+    };
+
+    /** Cooks the modules on `ChooseModuleJobCount` threads, each module with a compiler of its own.
+     *
+     * The jobs commit in `ModulePaths` order: diagnostics, then the artifacts the module wrote, then
+     * its counters. So the sink and the module list see exactly what a serial cook shows them. Modules
+     * are handed out in order and a job that starts always finishes, so every module before the first
+     * failure is complete, and the first failure is the one a serial cook would stop at. */
+    CookResult<void> CookModulesConcurrently(const CookerOptions& options,
+                                             const ModuleStampStore& stamps,
+                                             WarmCompilerCache* warm_compilers,
+                                             OutputSink& sink,
+                                             DiagnosticSink& diagnostics,
+                                             CookTrace& trace,
+                                             std::vector<ModuleArtifacts>& out_modules,
+                                             CookStatistics& statistics)
+    {
+        const std::span<const std::filesystem::path> modulePaths = options.ModulePaths;
+        std::vector<std::unique_ptr<ModuleCookJob>> jobs;
+        jobs.reserve(modulePaths.size());
+        for (size_t i = 0u; i < modulePaths.size(); ++i)
+        {
+            jobs.emplace_back(std::make_unique<ModuleCookJob>(sink.PrimaryName()));
+        }
+
+        // Each job has one writer, and the join below publishes every job to this thread. The two
+        // atomics only hand out work, so relaxed order is enough for both.
+        std::atomic<size_t> nextModule{ 0u };
+        std::atomic<bool> failed{ false };
+
+        auto cookUntilDone = [&]()
+        {
+            while (!failed.load(std::memory_order_relaxed))
+            {
+                const size_t i = nextModule.fetch_add(1u, std::memory_order_relaxed);
+                if (i >= modulePaths.size())
+                {
+                    return;
+                }
+
+                ModuleCookJob& job = *jobs[i];
+                job.Result = CookOrReuseModule(options,
+                                               modulePaths[i],
+                                               stamps,
+                                               warm_compilers,
+                                               job.Sink,
+                                               job.Diagnostics,
+                                               trace,
+                                               job.Modules,
+                                               job.Statistics);
+                if (!job.Result)
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        {
+            const uint32_t jobCount = ChooseModuleJobCount(options);
+            std::println(
+                stderr, "[shader_cooker] cooking {} modules on {} threads", modulePaths.size(), jobCount);
+
+            std::vector<std::jthread> threads;
+            threads.reserve(jobCount - 1u);
+            for (uint32_t i = 1u; i < jobCount; ++i)
+            {
+                threads.emplace_back(cookUntilDone);
+            }
+
+            // The calling thread cooks too, as the pool's worker zero does.
+            cookUntilDone();
+        }
+
+        for (const std::unique_ptr<ModuleCookJob>& job : jobs)
+        {
+            for (const Diagnostic& record : job->Diagnostics.Records())
+            {
+                diagnostics.Report(record);
+            }
+
+            if (!job->Result)
+            {
+                return job->Result;
+            }
+
+            for (const auto& [name, content] : job->Sink.GetArtifacts())
+            {
+                if (CookResult<void> artifactResult = sink.WriteArtifact(name, content); !artifactResult)
+                {
+                    return artifactResult;
+                }
+            }
+
+            AccumulateStatistics(statistics, job->Statistics);
+            std::ranges::move(job->Modules, std::back_inserter(out_modules));
+        }
+
+        return {};
+    }
+
 } // namespace
 
-CookResult<CookStatistics> RunCookOnce(const CookerOptions& options, OutputSink& sink)
+CookResult<CookStatistics> RunCookOnce(const CookerOptions& options,
+                                       OutputSink& sink,
+                                       CookTrace& trace,
+                                       WarmCompilerCache* warm_compilers)
 {
+    const ScopedTraceSpan cookSpan{ &trace, "cook", sink.PrimaryName() };
     const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
     const std::expected<std::filesystem::path, std::error_code> cacheDirectoryResult =
         EnsureModuleCacheDirectory(options.ModuleCacheDirectory);
@@ -778,19 +1380,35 @@ CookResult<CookStatistics> RunCookOnce(const CookerOptions& options, OutputSink&
     }
 
     CookStatistics statistics;
-    CookedLibrary library;
+    std::vector<ModuleArtifacts> modules;
+    modules.reserve(options.ModulePaths.size());
     // One sink for the whole cook, so a failure count spans every module rather than resetting at
     // each one.
     StderrDiagnosticSink diagnostics;
 
-    for (const std::filesystem::path& modulePath : options.ModulePaths)
+    const ModuleStampStore stamps{ options.IncrementalEnabled ? options.ModuleCacheDirectory
+                                                              : std::filesystem::path{},
+                                   sink.PrimaryName() };
+
+    if (ChooseModuleJobCount(options) > 1u)
+    {
+        const CookResult<void> cookResult = CookModulesConcurrently(
+            options, stamps, warm_compilers, sink, diagnostics, trace, modules, statistics);
+        if (!cookResult)
+        {
+            return std::unexpected(cookResult.error());
+        }
+    }
+    else
     {
-        std::println(stderr, "[shader_cooker] cooking {}", modulePath.string());
-        const CookResult<void> moduleResult =
-            CookModule(options, modulePath, sink, diagnostics, library, statistics);
-        if (!moduleResult)
+        for (const std::filesystem::path& modulePath : options.ModulePaths)
         {
-            return std::unexpected(moduleResult.error());
+            const CookResult<void> moduleResult = CookOrReuseModule(
+                options, modulePath, stamps, warm_compilers, sink, diagnostics, trace, modules, statistics);
+            if (!moduleResult)
+            {
+                return std::unexpected(moduleResult.error());
+            }
         }
     }
 
@@ -799,7 +1417,7 @@ CookResult<CookStatistics> RunCookOnce(const CookerOptions& options, OutputSink&
         return std::unexpected(CookError::ReflectionMismatch);
     }
 
-    const CookResult<void> emitResult = EmitLibraryArtifacts(library, sink, statistics);
+    const CookResult<void> emitResult = EmitLibraryArtifacts(options, modules, sink, trace, statistics);
     if (!emitResult)
     {
         return std::unexpected(emitResult.error());
@@ -819,7 +1437,10 @@ namespace
      * interner numbers entries in first-encounter order, so two cooks of one input must agree byte
      * for byte. A difference means an unordered container's iteration order reached the output, which
      * otherwise shows up months later as a rebuild that changes nothing. */
-    CookResult<CookStatistics> RunCookTwiceAndCompare(const CookerOptions& options, OutputSink& sink)
+    CookResult<CookStatistics> RunCookTwiceAndCompare(const CookerOptions& options,
+                                                      OutputSink& sink,
+                                                      CookTrace& trace,
+                                                      WarmCompilerCache* warm_compilers)
     {
         std::println(stderr, "[shader_cooker] determinism check: cooking twice into memory");
 
@@ -827,14 +1448,14 @@ namespace
         // artifact name from it, so a different name here would make the check compare a different
         // set of file names than the cook it stands in for.
         MemoryOutputSink first{ sink.PrimaryName() };
-        const CookResult<CookStatistics> firstResult = RunCookOnce(options, first);
+        const CookResult<CookStatistics> firstResult = RunCookOnce(options, first, trace, warm_compilers);
         if (!firstResult)
         {
             return firstResult;
         }
 
         MemoryOutputSink second{ sink.PrimaryName() };
-        const CookResult<CookStatistics> secondResult = RunCookOnce(options, second);
+        const CookResult<CookStatistics> secondResult = RunCookOnce(options, second, trace, warm_compilers);
         if (!secondResult)
         {
             return secondResult;
@@ -887,16 +1508,138 @@ namespace
         return secondResult;
     }
 
+    /** The trace is a diagnostic, like a stage dump, but it goes straight to its file and not through
+     * the sink. Its times differ on every cook, so the determinism check must never compare it. A
+     * trace that cannot be written does not fail a cook that worked. */
+    void WriteTraceIfRequested(const CookerOptions& options, const CookTrace& trace)
+    {
+        if (!trace.IsEnabled())
+        {
+            return;
+        }
+
+        std::error_code filesystemError;
+        if (options.TracePath.has_parent_path())
+        {
+            std::filesystem::create_directories(options.TracePath.parent_path(), filesystemError);
+        }
+
+        const std::string document = trace.ToChromeTraceJson();
+        std::ofstream file{ options.TracePath, std::ios::binary | std::ios::trunc };
+        file.write(document.data(), static_cast<std::streamsize>(document.size()));
+        if (!file)
+        {
+            std::println(
+                stderr, "[shader_cooker] could not write the trace to {}", options.TracePath.string());
+            return;
+        }
+
+        std::println(stderr,
+                     "[shader_cooker] wrote {} trace events to {}",
+                     trace.EventCount(),
+                     options.TracePath.string());
+    }
+
+} // namespace
+
+namespace
+{
+
+    CookResult<CookStatistics> RunTracedCook(const CookerOptions& options,
+                                             OutputSink& sink,
+                                             WarmCompilerCache* warm_compilers)
+    {
+        CookTrace trace{ !options.TracePath.empty() };
+        const CookResult<CookStatistics> result =
+            options.VerifyDeterministic ? RunCookTwiceAndCompare(options, sink, trace, warm_compilers)
+                                        : RunCookOnce(options, sink, trace, warm_compilers);
+
+        // Written for a failed cook too, because a cook that fails slowly is one the trace is for.
+        WriteTraceIfRequested(options, trace);
+        return result;
+    }
+
 } // namespace
 
 CookResult<CookStatistics> RunCook(const CookerOptions& options, OutputSink& sink)
 {
-    if (options.VerifyDeterministic)
+    return RunTracedCook(options, sink, nullptr);
+}
+
+CookResult<CookStatistics> RunCook(const CookerOptions& options,
+                                   OutputSink& sink,
+                                   WarmCompilerCache& warm_compilers)
+{
+    return RunTracedCook(options, sink, &warm_compilers);
+}
+
+CookResult<RawVariant> CompileLiveVariant(const CookerOptions& options,
+                                          const std::filesystem::path& module_path,
+                                          uint32_t variant_index,
+                                          WarmCompilerCache& warm_compilers)
+{
+    if (!EnsureModuleCacheDirectory(options.ModuleCacheDirectory))
+    {
+        return std::unexpected(CookError::FilesystemError);
+    }
+
+    CookTrace trace{ false };
+    StderrDiagnosticSink diagnostics;
+    const SlangCompilerCreateInfo createInfo = MakeCompilerCreateInfo(options, module_path, trace);
+    ModuleCompilerLease lease{ &warm_compilers, createInfo };
+    SlangCompiler& compiler = lease.Compiler();
+    const PermutationSpace* space = nullptr;
+
+    if (CookResult<void> prepared =
+            PrepareModuleCompiler(createInfo, diagnostics, compiler, lease.IsLoaded(), space);
+        !prepared)
+    {
+        lease.MarkUnloaded();
+        return std::unexpected(prepared.error());
+    }
+
+    lease.MarkLoaded();
+
+    const CookResult<VariantSet> variantSet = space->EnumerateVariants();
+    if (!variantSet)
+    {
+        return std::unexpected(variantSet.error());
+    }
+
+    const std::vector<VariantDescriptor>& descriptors = variantSet.value().Variants;
+    const auto descriptor = std::ranges::find_if(descriptors,
+                                                 [variant_index](const VariantDescriptor& candidate)
+                                                 {
+                                                     return static_cast<uint32_t>(candidate.Index) ==
+                                                            variant_index;
+                                                 });
+    if (descriptor == descriptors.end())
+    {
+        std::println(stderr,
+                     "[shader_cooker] module {} has no variant {}: it enumerates {} of an index space of {}",
+                     compiler.GetModuleName(),
+                     variant_index,
+                     descriptors.size(),
+                     variantSet.value().SpaceSize);
+        return std::unexpected(CookError::PermutationVariantNotEnumerated);
+    }
+
+    // The same cache a full cook reads and fills, so a variant the last cook compiled costs a file read.
+    const RawVariantCache variantCache{ options.VariantCacheEnabled ? options.ModuleCacheDirectory
+                                                                    : std::filesystem::path{},
+                                        compiler.GetCompileInputHash() };
+    if (std::optional<RawVariant> cached = variantCache.Load(*descriptor))
+    {
+        return std::move(cached.value());
+    }
+
+    CookResult<RawVariant> compiled = compiler.CompileVariantRaw(*descriptor);
+    if (compiled)
     {
-        return RunCookTwiceAndCompare(options, sink);
+        variantCache.Store(*descriptor, compiled.value());
     }
 
-    return RunCookOnce(options, sink);
+    return compiled;
 }
 
 } // namespace lodestone
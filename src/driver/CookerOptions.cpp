@@ -25,23 +25,50 @@ namespace
         "Usage: lodestone --output <header.hpp> [--O<level>] [--no-validate] [--quiet]\n"
         "                 [--cache-dir <path>] [--single-threaded] [--no-dedupe]\n"
         "                 [--target=<name>] [--verify-deterministic] [--dump-stage=<name>]\n"
-        "                 <module.slang>...\n"
+        "                 [--compile-workers=<n>] [--jobs=<n>] [--no-variant-cache] [--no-incremental]\n"
+        "                 [--trace=<file>] [--no-provenance] [--share-sources | --chunk-sources]\n"
+        "                 [--compress-sources] [--source-dictionary] [--pack] <module.slang>...\n"
         "  --output, -o    destination header path (required)\n"
         "  --O<level>      slang optimization level: 0-3, defaults to 0\n"
         "  --target=<name> output target profile, defaults to wgsl. Names: wgsl\n"
         "  --no-validate   skip cross-checking reflection against the emitted text\n"
         "  --quiet         suppress the per-variant reflection report\n"
-        "  --cache-dir     directory for precompiled slang modules\n"
-        "  --single-threaded disable multi-threaded entry point codegen\n"
+        "  --cache-dir     directory for precompiled slang modules and compiled variants\n"
+        "  --single-threaded cook every module and compile every variant on the calling thread\n"
+        "  --compile-workers=<n> Slang sessions that compile variants in parallel. Defaults to one for\n"
+        "                  each hardware thread, shared between the modules that cook at once\n"
+        "  --jobs=<n>      modules that cook at once, each on Slang sessions of its own. Defaults to 1\n"
         "  --no-dedupe     disable content deduplication\n"
+        "  --no-provenance do not record which artifacts collapsed onto each entry. Only the interned\n"
+        "                  stage dump reads it\n"
+        "  --share-sources write the sources of every module once, in <header>.sources.ldshaders, and\n"
+        "                  have each module manifest read its text from there\n"
+        "  --chunk-sources store each manifest's sources as content-defined chunks, and each unique\n"
+        "                  chunk once. Variants that differ in a few functions share the rest\n"
+        "  --compress-sources compress the text in each manifest and in the library source file. A\n"
+        "                  loader decodes a source when it first asks for it\n"
+        "  --source-dictionary compress against a dictionary trained from the sources of each file and\n"
+        "                  stored in it. Implies --compress-sources\n"
+        "  --pack          write every module manifest, and the library source file, into one\n"
+        "                  <header>.ldpack that a loader opens once and looks modules up in by name\n"
+        "  --no-variant-cache compile every variant, and neither read nor write the variant cache\n"
+        "  --no-incremental cook every module, even one whose inputs did not change since the last cook\n"
         "  --verify-deterministic cook twice and compare all artifacts\n"
         "  --dump-stage=<name> write one stage of the pipeline as JSON, beside the other artifacts.\n"
         "                  Repeat the flag for more than one stage. Names: space, variants, raw,\n"
-        "                  resolved, interned, cooked, all.\n";
+        "                  resolved, interned, cooked, all.\n"
+        "  --trace=<file>  write the time of each phase as a Chrome trace, one track for each thread. Open\n"
+        "                  the file in Perfetto or chrome://tracing\n";
 
     constexpr std::string_view k_OptimizationPrefix = "--O";
     constexpr std::string_view k_TargetPrefix = "--target=";
     constexpr std::string_view k_StageDumpPrefix = "--dump-stage=";
+    constexpr std::string_view k_CompileWorkersPrefix = "--compile-workers=";
+    constexpr std::string_view k_ModuleJobsPrefix = "--jobs=";
+    constexpr std::string_view k_TracePrefix = "--trace=";
+    /** Each worker holds a global session, and each global session holds the Slang core module. This
+     * bounds the memory a mistyped count can ask for. */
+    constexpr uint32_t k_MaxCompileWorkers = 256u;
     constexpr std::string_view k_AllStageDumpsName = "all";
 
     /** The one table that decides both what `--dump-stage` accepts and what a dump artifact is
@@ -100,6 +127,25 @@ namespace
 
         return level;
     }
+
+    CookResult<uint32_t> ParseWorkerCount(std::string_view count_text)
+    {
+        if (count_text.empty())
+        {
+            return std::unexpected(CookError::MalformedArgument);
+        }
+
+        uint32_t count = 0u;
+        const std::from_chars_result result =
+            std::from_chars(count_text.data(), count_text.data() + count_text.size(), count);
+        if (result.ec != std::errc{} || result.ptr != count_text.data() + count_text.size() || count == 0u ||
+            count > k_MaxCompileWorkers)
+        {
+            return std::unexpected(CookError::MalformedArgument);
+        }
+
+        return count;
+    }
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
@@ -123,6 +169,37 @@ namespace
         options.DedupeEnabled = false;
     }
 
+    void DisableProvenance(CookerOptions& options) noexcept
+    {
+        options.ProvenanceEnabled = false;
+    }
+
+    void EnableSharedSources(CookerOptions& options) noexcept
+    {
+        options.ShareLibrarySources = true;
+    }
+
+    void EnableChunkedSources(CookerOptions& options) noexcept
+    {
+        options.ChunkedSources = true;
+    }
+
+    void EnableCompressedSources(CookerOptions& options) noexcept
+    {
+        options.CompressSources = true;
+    }
+
+    void EnableSourceDictionary(CookerOptions& options) noexcept
+    {
+        options.CompressSources = true;
+        options.SourceDictionary = true;
+    }
+
+    void EnablePackedManifests(CookerOptions& options) noexcept
+    {
+        options.PackManifests = true;
+    }
+
     void EnableVerifyDeterminism(CookerOptions& options) noexcept
     {
         options.VerifyDeterministic = true;
@@ -141,14 +218,34 @@ namespace
     void DisableMultithreadedCompile(CookerOptions& options) noexcept
     {
         options.MultithreadEntryPointCodegen = false;
+        options.CompileWorkerCount = 1u;
+        options.ModuleJobCount = 1u;
+    }
+
+    void DisableVariantCache(CookerOptions& options) noexcept
+    {
+        options.VariantCacheEnabled = false;
+    }
+
+    void DisableIncrementalCook(CookerOptions& options) noexcept
+    {
+        options.IncrementalEnabled = false;
     }
 
-    constexpr std::array<SwitchFlag, 5u> k_SwitchFlags{
+    constexpr std::array<SwitchFlag, 13u> k_SwitchFlags{
         SwitchFlag{ .Name = "--no-dedupe", .Apply = &DisableDedupe },
+        SwitchFlag{ .Name = "--no-provenance", .Apply = &DisableProvenance },
+        SwitchFlag{ .Name = "--share-sources", .Apply = &EnableSharedSources },
+        SwitchFlag{ .Name = "--chunk-sources", .Apply = &EnableChunkedSources },
+        SwitchFlag{ .Name = "--compress-sources", .Apply = &EnableCompressedSources },
+        SwitchFlag{ .Name = "--source-dictionary", .Apply = &EnableSourceDictionary },
+        SwitchFlag{ .Name = "--pack", .Apply = &EnablePackedManifests },
         SwitchFlag{ .Name = "--verify-deterministic", .Apply = &EnableVerifyDeterminism },
         SwitchFlag{ .Name = "--no-validate", .Apply = &DisableValidateAgainstEmittedText },
         SwitchFlag{ .Name = "--quiet", .Apply = &DisableReflectionReports },
-        SwitchFlag{ .Name = "--single-threaded", .Apply = &DisableMultithreadedCompile }
+        SwitchFlag{ .Name = "--single-threaded", .Apply = &DisableMultithreadedCompile },
+        SwitchFlag{ .Name = "--no-variant-cache", .Apply = &DisableVariantCache },
+        SwitchFlag{ .Name = "--no-incremental", .Apply = &DisableIncrementalCook }
     };
 
     const SwitchFlag* FindSwitchFlag(std::string_view argument) noexcept
@@ -221,12 +318,48 @@ namespace
         return CookError::Success;
     }
 
-    const std::array<ValueFlag, 3u> k_ValueFlags{
+    CookError ApplyCompileWorkerCount(CookerOptions& options, std::string_view value)
+    {
+        const CookResult<uint32_t> count = ParseWorkerCount(value);
+        if (!count)
+        {
+            return count.error();
+        }
+        options.CompileWorkerCount = count.value();
+        return CookError::Success;
+    }
+
+    /** Each job holds at least one global session, so the worker bound holds here as well. */
+    CookError ApplyModuleJobCount(CookerOptions& options, std::string_view value)
+    {
+        const CookResult<uint32_t> count = ParseWorkerCount(value);
+        if (!count)
+        {
+            return count.error();
+        }
+        options.ModuleJobCount = count.value();
+        return CookError::Success;
+    }
+
+    CookError ApplyTracePath(CookerOptions& options, std::string_view value)
+    {
+        if (value.empty())
+        {
+            return CookError::MalformedArgument;
+        }
+        options.TracePath = std::filesystem::path{ value };
+        return CookError::Success;
+    }
+
+    const std::array<ValueFlag, 6u> k_ValueFlags{
         ValueFlag{ .Prefix = k_StageDumpPrefix, .Apply = &ApplyDumpStageArgument },
         // Rejected here rather than in the driver. A name that reaches CookerOptions is a name
         // FindTargetProfile accepts, so no later stage has to ask again.
         ValueFlag{ .Prefix = k_TargetPrefix, .Apply = &ApplyTargetOption },
-        ValueFlag{ .Prefix = k_OptimizationPrefix, .Apply = &ApplyDesiredOptimizationLevel }
+        ValueFlag{ .Prefix = k_OptimizationPrefix, .Apply = &ApplyDesiredOptimizationLevel },
+        ValueFlag{ .Prefix = k_CompileWorkersPrefix, .Apply = &ApplyCompileWorkerCount },
+        ValueFlag{ .Prefix = k_ModuleJobsPrefix, .Apply = &ApplyModuleJobCount },
+        ValueFlag{ .Prefix = k_TracePrefix, .Apply = &ApplyTracePath }
     };
 
     const ValueFlag* FindValueFlag(std::string_view argument) noexcept
@@ -371,6 +504,12 @@ CookResult<CookerOptions> ParseCommandLine(std::span<const std::string_view> arg
         return std::unexpected(CookError::NoModulesSpecified);
     }
 
+    // The library source file holds whole sources, so a manifest cannot both chunk and share its text.
+    if (options.ChunkedSources && options.ShareLibrarySources)
+    {
+        return std::unexpected(CookError::MalformedArgument);
+    }
+
     return options;
 }
 
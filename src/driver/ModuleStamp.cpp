@@ -0,0 +1,234 @@
+#include "driver/ModuleStamp.hpp"
+#include "CookerErrors.hpp"
+#include "driver/CookerOptions.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "model/BinaryStream.hpp"
+#include "model/CacheFile.hpp"
+#include "model/ContentHash.hpp"
+#include "permute/PermutationAxis.hpp"
+#include "permute/PermutationPolicy.hpp"
+#include "permute/PermutationRegistry.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "permute/PermutationValue.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    constexpr uint32_t k_ModuleStampMagic{ 0x534D534Cu }; // "LSMS"
+
+    void AppendValue(StreamingHash& hash, const PermutationValue& value)
+    {
+        hash.Append(static_cast<uint32_t>(std::to_underlying(value.GetType())));
+        hash.Append(PermutationValueToInt64(value));
+    }
+
+    /** The space and the policy are compiled into the cooker, so neither shows up in the source texts. */
+    void AppendModuleRegistration(StreamingHash& hash, std::string_view module_name)
+    {
+        const PermutationSpace* space = FindPermutationSpaceForModule(module_name);
+        hash.Append(space->Name());
+        hash.Append(static_cast<uint64_t>(space->AxisCount()));
+        for (const PermutationAxis& axis : space->Axes())
+        {
+            hash.Append(axis.Name);
+            hash.Append(axis.ParentIndex);
+            AppendValue(hash, axis.RequiredParentValue);
+            hash.Append(static_cast<uint64_t>(axis.NumValues()));
+            for (const PermutationValue& value : axis.GetValues())
+            {
+                AppendValue(hash, value);
+            }
+        }
+
+        const ModulePolicy* policy = FindPolicyForModule(module_name);
+        hash.Append(policy->MaxVariants);
+        hash.Append(static_cast<uint64_t>(policy->ExpectedInfluence.size()));
+        for (const ExpectedAxisInfluence& influence : policy->ExpectedInfluence)
+        {
+            hash.Append(influence.EntryPointName);
+            hash.Append(influence.AxisName);
+            hash.Append(static_cast<uint32_t>(influence.IsInert ? 1u : 0u));
+        }
+    }
+
+    std::string MakeModuleName(const std::filesystem::path& module_path)
+    {
+        return module_path.stem().string();
+    }
+
+} // namespace
+
+ContentHashValue ComputeModuleFingerprint(const CookerOptions& options,
+                                          std::string_view header_name,
+                                          std::string_view module_name,
+                                          std::span<const std::string> dependency_paths,
+                                          std::span<const std::string> dependency_texts)
+{
+    StreamingHash hash;
+    hash.Append(k_ModuleStampVersion);
+    hash.Append(module_name);
+    hash.Append(header_name);
+    hash.Append(options.OptimizationLevel);
+    hash.Append(std::string_view{ options.TargetName });
+    hash.Append(static_cast<uint32_t>(options.DedupeEnabled ? 1u : 0u));
+    hash.Append(static_cast<uint32_t>(options.ValidateAgainstEmittedText ? 1u : 0u));
+    hash.Append(static_cast<uint32_t>(options.ChunkedSources ? 1u : 0u));
+    hash.Append(static_cast<uint32_t>(options.CompressSources ? 1u : 0u));
+    hash.Append(static_cast<uint32_t>(options.SourceDictionary ? 1u : 0u));
+    AppendModuleRegistration(hash, module_name);
+
+    hash.Append(static_cast<uint64_t>(dependency_paths.size()));
+    for (size_t i = 0u; i < dependency_paths.size(); ++i)
+    {
+        hash.Append(std::string_view{ dependency_paths[i] });
+        hash.Append(std::string_view{ dependency_texts[i] });
+    }
+
+    return hash.Finalize();
+}
+
+ModuleStampStore::ModuleStampStore(const std::filesystem::path& cache_directory, std::string_view header_name)
+    : directory{ cache_directory.empty() ? std::filesystem::path{} : cache_directory / "modules" },
+      headerName{ header_name }
+{
+}
+
+bool ModuleStampStore::IsEnabled() const noexcept
+{
+    return !directory.empty();
+}
+
+std::optional<ModuleArtifacts> ModuleStampStore::FindUnchanged(const CookerOptions& options,
+                                                               const std::filesystem::path& module_path) const
+{
+    if (!IsEnabled())
+    {
+        return std::nullopt;
+    }
+
+    const ContentHashValue key = MakeStampKey(module_path);
+    const std::optional<std::string> file = ReadCacheFile(MakeStampPath(module_path));
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    const std::optional<std::string_view> payload =
+        OpenCacheRecord(file.value(), k_ModuleStampMagic, k_ModuleStampVersion, key);
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+
+    BinaryReader reader{ payload.value() };
+    const ContentHashValue storedFingerprint = reader.Read<ContentHashValue>();
+
+    const uint32_t dependencyCount = reader.ReadCount(sizeof(uint32_t));
+    std::vector<std::string> dependencyPaths;
+    dependencyPaths.reserve(dependencyCount);
+    for (uint32_t i = 0u; i < dependencyCount; ++i)
+    {
+        dependencyPaths.emplace_back(reader.ReadString());
+    }
+
+    const std::string artifactBytes = reader.ReadString();
+    if (!reader.Succeeded())
+    {
+        return std::nullopt;
+    }
+
+    // A dependency that is gone, or that cannot be read, means the module must cook again. The cook
+    // then reports the problem properly.
+    std::vector<std::string> dependencyTexts;
+    dependencyTexts.reserve(dependencyPaths.size());
+    for (const std::string& dependencyPath : dependencyPaths)
+    {
+        std::optional<std::string> text = ReadCacheFile(dependencyPath);
+        if (!text)
+        {
+            return std::nullopt;
+        }
+
+        dependencyTexts.emplace_back(std::move(text.value()));
+    }
+
+    const ContentHashValue fingerprint = ComputeModuleFingerprint(
+        options, headerName, MakeModuleName(module_path), dependencyPaths, dependencyTexts);
+    if (fingerprint != storedFingerprint)
+    {
+        return std::nullopt;
+    }
+
+    CookResult<ModuleArtifacts> artifacts = DeserializeModuleArtifacts(artifactBytes);
+    if (!artifacts)
+    {
+        return std::nullopt;
+    }
+
+    return std::move(artifacts.value());
+}
+
+void ModuleStampStore::Store(const CookerOptions& options,
+                             const std::filesystem::path& module_path,
+                             std::span<const std::string> dependency_paths,
+                             std::span<const std::string> dependency_texts,
+                             const ModuleArtifacts& artifacts) const
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    BinaryWriter writer;
+    writer.Write(ComputeModuleFingerprint(
+        options, headerName, MakeModuleName(module_path), dependency_paths, dependency_texts));
+    writer.Write(static_cast<uint32_t>(dependency_paths.size()));
+    for (const std::string& dependencyPath : dependency_paths)
+    {
+        writer.WriteString(dependencyPath);
+    }
+
+    writer.WriteString(SerializeModuleArtifacts(artifacts));
+
+    WriteCacheFile(MakeStampPath(module_path),
+                   SealCacheRecord(k_ModuleStampMagic,
+                                   k_ModuleStampVersion,
+                                   MakeStampKey(module_path),
+                                   writer.Take()));
+}
+
+/** The same module under two header names emits two different sources, so both reach the key. */
+ContentHashValue ModuleStampStore::MakeStampKey(const std::filesystem::path& module_path) const
+{
+    std::error_code filesystemError;
+    const std::filesystem::path canonicalPath =
+        std::filesystem::weakly_canonical(module_path, filesystemError);
+    const std::string keyPath = (filesystemError ? module_path : canonicalPath).generic_string();
+
+    StreamingHash hash;
+    hash.Append(std::string_view{ keyPath });
+    hash.Append(std::string_view{ headerName });
+    return hash.Finalize();
+}
+
+std::filesystem::path ModuleStampStore::MakeStampPath(const std::filesystem::path& module_path) const
+{
+    return directory /
+           std::format("{}-{:016x}.stamp", MakeModuleName(module_path), MakeStampKey(module_path));
+}
+
+} // namespace lodestone
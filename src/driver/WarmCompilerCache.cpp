@@ -0,0 +1,198 @@
+#include "driver/WarmCompilerCache.hpp"
+#include "compile/SlangCompiler.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    /** One key for a module however the command line spelled its path. */
+    std::string MakeModuleKey(const std::filesystem::path& module_path)
+    {
+        return std::filesystem::absolute(module_path).lexically_normal().string();
+    }
+
+    bool FileStillReads(const std::string& path, const std::string& expected_text)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file)
+        {
+            return false;
+        }
+
+        const std::string text{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+        return text == expected_text;
+    }
+
+} // namespace
+
+WarmCompilerCache::WarmCompilerCache() = default;
+WarmCompilerCache::~WarmCompilerCache() = default;
+
+bool WarmCompilerCache::CanReuse(const WarmModule& warm, const SlangCompilerCreateInfo& create_info)
+{
+    return warm.ModuleCacheDirectory == create_info.ModuleCacheDirectory &&
+           warm.OptimizationLevel == create_info.OptimizationLevel &&
+           warm.MultithreadEntryPointCodegen == create_info.MultithreadEntryPointCodegen &&
+           DependenciesUnchanged(warm.Compiler);
+}
+
+/** Reads every file the module pulled in and compares its text, as a module stamp does. A write time
+ * can stay the same across an edit, and can move without one. An import that an edit adds changes the
+ * text of a file already on the list, so the list itself never needs checking. */
+bool WarmCompilerCache::DependenciesUnchanged(const SlangCompiler& compiler)
+{
+    const std::span<const std::string> paths = compiler.GetModuleSourcePaths();
+    const std::span<const std::string> texts = compiler.GetModuleSourceTexts();
+    if (paths.empty() || paths.size() != texts.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0u; i < paths.size(); ++i)
+    {
+        if (!FileStillReads(paths[i], texts[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** A worker loaded the module on its own, so it compares its own list. The module's compiler has just
+ * read every file again, so comparing against its texts reads nothing. */
+bool WarmCompilerCache::ReadSameSources(const SlangCompiler& worker, const SlangCompiler& compiler)
+{
+    return std::ranges::equal(worker.GetModuleSourcePaths(), compiler.GetModuleSourcePaths()) &&
+           std::ranges::equal(worker.GetModuleSourceTexts(), compiler.GetModuleSourceTexts());
+}
+
+WarmCompilerCache::Checkout WarmCompilerCache::CheckOutModule(const SlangCompilerCreateInfo& create_info)
+{
+    const std::string key = MakeModuleKey(create_info.ModulePath);
+    std::optional<WarmModule> warm;
+    Checkout checkout;
+    {
+        const std::scoped_lock lock{ mutex };
+        if (const auto found = modules.find(key); found != modules.end())
+        {
+            warm.emplace(std::move(found->second));
+            modules.erase(found);
+        }
+        else if (!spares.empty())
+        {
+            checkout.Compiler = std::move(spares.back());
+            spares.pop_back();
+            ++statistics.GlobalSessionsReused;
+            ++statistics.ModulesLoaded;
+            return checkout;
+        }
+        else
+        {
+            ++statistics.GlobalSessionsCreated;
+            ++statistics.ModulesLoaded;
+            return checkout;
+        }
+    }
+
+    // The files are read outside the lock, so modules cooking at once do not wait on each other's disk.
+    checkout.IsLoaded = CanReuse(warm.value(), create_info);
+    checkout.Compiler = std::move(warm.value().Compiler);
+
+    std::vector<SlangCompiler> staleWorkers;
+    for (SlangCompiler& worker : warm.value().Workers)
+    {
+        const bool isWorkerLoaded = checkout.IsLoaded && ReadSameSources(worker, checkout.Compiler);
+        (isWorkerLoaded ? checkout.Workers : staleWorkers).push_back(std::move(worker));
+    }
+
+    const std::scoped_lock lock{ mutex };
+    ++(checkout.IsLoaded ? statistics.ModulesWarm : statistics.ModulesLoaded);
+    statistics.WorkersWarm += static_cast<uint32_t>(checkout.Workers.size());
+    statistics.GlobalSessionsReused += static_cast<uint32_t>(checkout.Workers.size()) + 1u;
+    std::ranges::move(staleWorkers, std::back_inserter(spares));
+    return checkout;
+}
+
+void WarmCompilerCache::ReturnModule(const SlangCompilerCreateInfo& create_info,
+                                     SlangCompiler&& compiler,
+                                     bool is_loaded,
+                                     std::vector<SlangCompiler>&& workers)
+{
+    const std::scoped_lock lock{ mutex };
+    if (!is_loaded)
+    {
+        spares.push_back(std::move(compiler));
+        std::ranges::move(workers, std::back_inserter(spares));
+        workers.clear();
+        return;
+    }
+
+    WarmModule warm{ .Compiler = std::move(compiler),
+                     .Workers = std::move(workers),
+                     .ModuleCacheDirectory = create_info.ModuleCacheDirectory,
+                     .OptimizationLevel = create_info.OptimizationLevel,
+                     .MultithreadEntryPointCodegen = create_info.MultithreadEntryPointCodegen };
+    modules.insert_or_assign(MakeModuleKey(create_info.ModulePath), std::move(warm));
+}
+
+std::vector<SlangCompiler> WarmCompilerCache::CheckOutSpares(size_t count)
+{
+    const std::scoped_lock lock{ mutex };
+    const size_t taken = std::min(count, spares.size());
+    std::vector<SlangCompiler> checkedOut;
+    checkedOut.reserve(taken);
+    for (size_t i = 0u; i < taken; ++i)
+    {
+        checkedOut.push_back(std::move(spares.back()));
+        spares.pop_back();
+    }
+
+    statistics.WorkersLoaded += static_cast<uint32_t>(count);
+    statistics.GlobalSessionsReused += static_cast<uint32_t>(taken);
+    statistics.GlobalSessionsCreated += static_cast<uint32_t>(count - taken);
+    return checkedOut;
+}
+
+void WarmCompilerCache::ReturnSpares(std::vector<SlangCompiler>&& compilers)
+{
+    const std::scoped_lock lock{ mutex };
+    std::ranges::move(compilers, std::back_inserter(spares));
+    compilers.clear();
+}
+
+void WarmCompilerCache::Invalidate()
+{
+    const std::scoped_lock lock{ mutex };
+    for (auto& [key, warm] : modules)
+    {
+        spares.push_back(std::move(warm.Compiler));
+        std::ranges::move(warm.Workers, std::back_inserter(spares));
+    }
+
+    modules.clear();
+}
+
+WarmCompilerStatistics WarmCompilerCache::GetStatistics() const
+{
+    const std::scoped_lock lock{ mutex };
+    return statistics;
+}
+
+} // namespace lodestone
@@ -1,4 +1,6 @@
 #include "emit/DedupeReport.hpp"
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
 #include "model/ContentHash.hpp"
 #include "model/ContentInterner.hpp"
 #include "model/CookedLibrary.hpp"
@@ -482,66 +484,122 @@ CookResult<void> EnforceModulePolicy(const CookedModule& module, const ModuleInf
     return {};
 }
 
-std::string GenerateDedupeReport(const CookedLibrary& library)
+std::string GenerateDedupeReportSection(const CookedModule& module)
 {
     std::string report;
-    report.reserve(1u << 13);
 
-    report += "Shader cooker dedup report\n";
-    report += "Generated by tools/shader_cooker. Do not edit by hand.\n\n";
-    report += "Note: The dedupe ratio indicates how many artifacts were seen for each unique entry. A higher "
-              "ratio means more effective deduplication.\n\n";
+    const InternerStatistics& sourceStatistics = module.SourceTable.Interning;
+
+    report += std::format("{}  {} variants x {} entrypoints = {} artifacts\n\n",
+                          module.Name,
+                          module.Variants.size(),
+                          module.EntryPoints.size(),
+                          sourceStatistics.ArtifactsSeen);
+
+    report += EmitProvenance(module);
+    report += "\n";
+
+    // One line for each table. Placement, footprint, and visibility collapse at different rates,
+    // and one number for all three would hide which one grows.
+    const std::array<std::pair<std::string_view, const TableStatistics*>, 5u> tables{
+        std::pair{ std::string_view{ "sources" }, &module.SourceTable },
+        std::pair{ std::string_view{ "resources" }, &module.ResourceTable },
+        std::pair{ std::string_view{ "resource lists" }, &module.ResourceListTable },
+        std::pair{ std::string_view{ "footprints" }, &module.FootprintListTable },
+        std::pair{ std::string_view{ "visibility" }, &module.VisibilityTable }
+    };
+
+    uint32_t collisions = 0u;
+    uint32_t comparisons = 0u;
 
-    for (const CookedModule& module : library.Modules)
+    for (const auto& [name, table] : tables)
     {
-        const InternerStatistics& sourceStatistics = module.SourceTable.Interning;
-
-        report += std::format("{}  {} variants x {} entrypoints = {} artifacts\n\n",
-                              module.Name,
-                              module.Variants.size(),
-                              module.EntryPoints.size(),
-                              sourceStatistics.ArtifactsSeen);
-
-        report += EmitProvenance(module);
-        report += "\n";
-
-        // One line for each table. Placement, footprint, and visibility collapse at different rates,
-        // and one number for all three would hide which one grows.
-        const std::array<std::pair<std::string_view, const TableStatistics*>, 5u> tables{
-            std::pair{ std::string_view{ "sources" }, &module.SourceTable },
-            std::pair{ std::string_view{ "resources" }, &module.ResourceTable },
-            std::pair{ std::string_view{ "resource lists" }, &module.ResourceListTable },
-            std::pair{ std::string_view{ "footprints" }, &module.FootprintListTable },
-            std::pair{ std::string_view{ "visibility" }, &module.VisibilityTable }
-        };
+        const float dedupeRatio = static_cast<float>(table->Interning.ArtifactsSeen) /
+                                  static_cast<float>(table->Interning.UniqueEntries);
+        report += std::format("  {}: Artifacts seen: {} -> Unique Entries: {} (Dedupe Ratio: {:.2f}:1)\n",
+                              name,
+                              table->Interning.ArtifactsSeen,
+                              table->Interning.UniqueEntries,
+                              dedupeRatio);
+        collisions += table->Interning.HashCollisions;
+        comparisons += table->Interning.ByteComparisons;
+    }
 
-        uint32_t collisions = 0u;
-        uint32_t comparisons = 0u;
+    report += std::format("  dedup enabled: {}\n", module.SourceTable.DedupeEnabled ? "yes" : "no");
+    report += std::format("  hash function: {}\n", module.SourceTable.HashName);
+    report += std::format("  hash collisions resolved by byte compare: {}\n", collisions);
+    report += std::format("  byte comparisons forced by a hash hit: {}\n", comparisons);
+    report += "  normalization passes active: (none)\n\n";
+
+    const ModuleInfluence influence = ComputeAxisInfluence(module);
+    report += EmitInfluenceTable(module, influence);
+    report += "\n";
+    return report;
+}
+
+namespace
+{
+
+    /** What the library pass folded. An artifact here is one entry of one module's table, so the ratio
+     * shows only what the modules share with each other. */
+    std::string EmitLibrarySection(const LibraryStatistics& library)
+    {
+        std::string section = std::format("library  {} modules\n\n", library.ModuleCount);
+
+        const std::array<std::pair<std::string_view, const TableStatistics*>, 3u> tables{
+            std::pair{ std::string_view{ "sources" }, &library.SourceTable },
+            std::pair{ std::string_view{ "resources" }, &library.ResourceTable },
+            std::pair{ std::string_view{ "raster states" }, &library.RasterTable }
+        };
 
         for (const auto& [name, table] : tables)
         {
-            const float dedupeRatio = static_cast<float>(table->Interning.ArtifactsSeen) /
-                                      static_cast<float>(table->Interning.UniqueEntries);
-            report += std::format("  {}: Artifacts seen: {} -> Unique Entries: {} (Dedupe Ratio: {:.2f}:1)\n",
-                                  name,
-                                  table->Interning.ArtifactsSeen,
-                                  table->Interning.UniqueEntries,
-                                  dedupeRatio);
-            collisions += table->Interning.HashCollisions;
-            comparisons += table->Interning.ByteComparisons;
+            const InternerStatistics& interning = table->Interning;
+            // A library of compute modules with no resources has nothing to fold.
+            const float dedupeRatio = interning.UniqueEntries == 0u
+                                          ? 1.0f
+                                          : static_cast<float>(interning.ArtifactsSeen) /
+                                                static_cast<float>(interning.UniqueEntries);
+            section += std::format("  {}: Module Entries: {} -> Library Entries: {} "
+                                   "(Dedupe Ratio: {:.2f}:1)\n",
+                                   name,
+                                   interning.ArtifactsSeen,
+                                   interning.UniqueEntries,
+                                   dedupeRatio);
         }
 
-        report += std::format("  dedup enabled: {}\n", module.SourceTable.DedupeEnabled ? "yes" : "no");
-        report += std::format("  hash function: {}\n", module.SourceTable.HashName);
-        report += std::format("  hash collisions resolved by byte compare: {}\n", collisions);
-        report += std::format("  byte comparisons forced by a hash hit: {}\n", comparisons);
-        report += "  normalization passes active: (none)\n\n";
+        const uint64_t savedBytes = library.ModuleSourceBytes - library.LibrarySourceBytes;
+        const double savedPercent = library.ModuleSourceBytes == 0u
+                                        ? 0.0
+                                        : 100.0 * static_cast<double>(savedBytes) /
+                                              static_cast<double>(library.ModuleSourceBytes);
+        section += std::format("  source bytes: {} in module tables -> {} in the library table "
+                               "({:.1f}% saved)\n",
+                               library.ModuleSourceBytes,
+                               library.LibrarySourceBytes,
+                               savedPercent);
+        section += std::format("  library source file: {}\n", library.SourcesShared ? "yes" : "no");
+        return section;
+    }
+
+} // namespace
+
+std::string GenerateDedupeReport(std::span<const ModuleArtifacts> modules, const LibraryStatistics& library)
+{
+    std::string report;
+    report.reserve(1u << 13);
+
+    report += "Shader cooker dedup report\n";
+    report += "Generated by tools/shader_cooker. Do not edit by hand.\n\n";
+    report += "Note: The dedupe ratio indicates how many artifacts were seen for each unique entry. A higher "
+              "ratio means more effective deduplication.\n\n";
 
-        const ModuleInfluence influence = ComputeAxisInfluence(module);
-        report += EmitInfluenceTable(module, influence);
-        report += "\n";
+    for (const ModuleArtifacts& module : modules)
+    {
+        report += module.ReportSection;
     }
 
+    report += EmitLibrarySection(library);
     return report;
 }
 // ttb: 764.5ms
@@ -0,0 +1,190 @@
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "model/ContentHash.hpp"
+#include "model/ContentInterner.hpp"
+#include "model/CookedLibrary.hpp"
+#include "CookerErrors.hpp"
+#include "ShaderManifest.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <expected>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    ContentHashValue HashSourceView(const std::string_view& source) noexcept
+    {
+        return HashBytes(std::as_bytes(std::span{ source.data(), source.size() }));
+    }
+
+    /** Appends a record's bytes to a key. Every field of a manifest record is an integer and the records
+     * have no padding, so equal bytes mean equal records. */
+    template<typename RecordType>
+    void AppendRecord(std::string& key, const RecordType& record)
+    {
+        key.append(reinterpret_cast<const char*>(&record), sizeof(RecordType));
+    }
+
+    /** A string index means nothing outside its own module. The key holds the text instead, with its
+     * length first, so two names cannot run together into a third. */
+    void AppendString(std::string& key, std::string_view text)
+    {
+        const auto length = static_cast<uint32_t>(text.size());
+        AppendRecord(key, length);
+        key.append(text);
+    }
+
+    /** One binding, as bytes that compare equal across modules exactly when the bindings are equal. */
+    std::string MakeBindingKey(const ShaderManifestView& view, const ManifestBinding& binding)
+    {
+        ManifestBinding record = binding;
+        record.NameString = 0u;
+        record.ScopeString = 0u;
+        record.FirstUniformMember = 0u;
+
+        std::string key;
+        AppendRecord(key, record);
+        AppendString(key, view.String(binding.NameString));
+        AppendString(key, view.String(binding.ScopeString));
+        for (ManifestUniformMember member : view.UniformMembers(binding))
+        {
+            AppendString(key, view.String(member.NameString));
+            member.NameString = 0u;
+            AppendRecord(key, member);
+        }
+
+        return key;
+    }
+
+    std::string MakeRasterKey(const ShaderManifestView& view, uint32_t raster_index)
+    {
+        std::string key;
+        AppendRecord(key, static_cast<uint32_t>(view.WritesFragDepth(raster_index) ? 1u : 0u));
+        AppendRecord(key, static_cast<uint32_t>(view.VertexInputs(raster_index).size()));
+        for (ManifestVertexInput input : view.VertexInputs(raster_index))
+        {
+            AppendString(key, view.String(input.SemanticNameString));
+            input.SemanticNameString = 0u;
+            AppendRecord(key, input);
+        }
+
+        for (const ManifestColorTarget& target : view.ColorTargets(raster_index))
+        {
+            AppendRecord(key, target);
+        }
+
+        return key;
+    }
+
+    /** A source of several chunks, or a compressed one, has no view of its whole text in the manifest,
+     * so the fold joins or decodes it into storage the tables keep. */
+    std::string_view ReadWholeSource(const ShaderManifestView& view,
+                                     uint32_t source_index,
+                                     std::deque<std::string>& joined)
+    {
+        const std::string_view inPlace = view.Source(source_index);
+        const size_t size = view.SourceSize(source_index);
+        if (inPlace.size() == size)
+        {
+            return inPlace;
+        }
+
+        std::string& text = joined.emplace_back(size, '\0');
+        return view.AssembleSource(source_index, text);
+    }
+
+    template<typename InternerType>
+    TableStatistics DescribeTable(const InternerType& interner)
+    {
+        return TableStatistics{ .HashName = interner.HashName(),
+                                .DedupeEnabled = interner.IsEnabled(),
+                                .Interning = interner.Statistics() };
+    }
+
+} // namespace
+
+CookResult<LibraryTables> FoldLibraryTables(std::span<const ModuleArtifacts> modules, bool dedupe_enabled)
+{
+    // A library entry has no variant of its own, so provenance has nothing to name.
+    ContentInterner<std::string_view> sourceInterner{ &HashSourceView, k_HashName };
+    ContentInterner<std::string> resourceInterner{ &HashSourceString, k_HashName };
+    ContentInterner<std::string> rasterInterner{ &HashSourceString, k_HashName };
+    sourceInterner.DisableProvenance();
+    resourceInterner.DisableProvenance();
+    rasterInterner.DisableProvenance();
+    if (!dedupe_enabled)
+    {
+        sourceInterner.Disable();
+        resourceInterner.Disable();
+        rasterInterner.Disable();
+    }
+
+    LibraryTables tables;
+    tables.SourceRemaps.reserve(modules.size());
+
+    for (const ModuleArtifacts& module : modules)
+    {
+        const std::span<const std::byte> raw{ reinterpret_cast<const std::byte*>(module.Manifest.data()),
+                                              module.Manifest.size() };
+        const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(raw);
+        if (!opened.has_value())
+        {
+            std::println(stderr,
+                         "[shader_cooker] module {} manifest does not open for the library pass: {}",
+                         module.Name,
+                         ToString(opened.error()));
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+
+        const ShaderManifestView& view = opened.value();
+        std::vector<uint32_t>& remap = tables.SourceRemaps.emplace_back();
+        remap.reserve(view.SourceCount());
+        for (uint32_t i = 0u; i < view.SourceCount(); ++i)
+        {
+            const size_t joinedBefore = tables.JoinedSources.size();
+            const std::string_view source = ReadWholeSource(view, i, tables.JoinedSources);
+            tables.Statistics.ModuleSourceBytes += source.size();
+            const InternResult interned = sourceInterner.Intern(source, ProvenanceRecord{});
+            if (interned.WasNew)
+            {
+                tables.Statistics.LibrarySourceBytes += source.size();
+            }
+            else if (tables.JoinedSources.size() != joinedBefore)
+            {
+                // The library already holds this text, so the copy just joined is not needed.
+                tables.JoinedSources.pop_back();
+            }
+            remap.push_back(interned.Index);
+        }
+
+        for (const ManifestBinding& binding : view.Bindings())
+        {
+            static_cast<void>(resourceInterner.Intern(MakeBindingKey(view, binding), ProvenanceRecord{}));
+        }
+
+        for (uint32_t i = 0u; i < view.RasterCount(); ++i)
+        {
+            static_cast<void>(rasterInterner.Intern(MakeRasterKey(view, i), ProvenanceRecord{}));
+        }
+    }
+
+    tables.Sources.assign(sourceInterner.UniqueEntries().begin(), sourceInterner.UniqueEntries().end());
+    tables.Statistics.ModuleCount = static_cast<uint32_t>(modules.size());
+    tables.Statistics.SourceTable = DescribeTable(sourceInterner);
+    tables.Statistics.ResourceTable = DescribeTable(resourceInterner);
+    tables.Statistics.RasterTable = DescribeTable(rasterInterner);
+    return tables;
+}
+
+} // namespace lodestone
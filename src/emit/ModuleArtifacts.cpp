@@ -0,0 +1,62 @@
+#include "emit/ModuleArtifacts.hpp"
+#include "CookerErrors.hpp"
+#include "model/BinaryStream.hpp"
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+
+namespace lodestone
+{
+
+std::string SerializeModuleArtifacts(const ModuleArtifacts& artifacts)
+{
+    BinaryWriter writer;
+    writer.WriteString(artifacts.Name);
+
+    writer.Write(static_cast<uint32_t>(artifacts.EntryPointNames.size()));
+    for (const std::string& name : artifacts.EntryPointNames)
+    {
+        writer.WriteString(name);
+    }
+
+    writer.WriteString(artifacts.HeaderSection);
+    writer.WriteString(artifacts.SourceFileName);
+    writer.WriteString(artifacts.Source);
+    writer.WriteString(artifacts.ManifestFileName);
+    writer.WriteString(artifacts.Manifest);
+    writer.WriteString(artifacts.ReportSection);
+    return writer.Take();
+}
+
+CookResult<ModuleArtifacts> DeserializeModuleArtifacts(std::string_view bytes)
+{
+    BinaryReader reader{ bytes };
+
+    ModuleArtifacts artifacts;
+    artifacts.Name = reader.ReadString();
+
+    const uint32_t entryPointCount = reader.ReadCount(sizeof(uint32_t));
+    artifacts.EntryPointNames.reserve(entryPointCount);
+    for (uint32_t i = 0u; i < entryPointCount; ++i)
+    {
+        artifacts.EntryPointNames.emplace_back(reader.ReadString());
+    }
+
+    artifacts.HeaderSection = reader.ReadString();
+    artifacts.SourceFileName = reader.ReadString();
+    artifacts.Source = reader.ReadString();
+    artifacts.ManifestFileName = reader.ReadString();
+    artifacts.Manifest = reader.ReadString();
+    artifacts.ReportSection = reader.ReadString();
+
+    if (!reader.Succeeded())
+    {
+        return std::unexpected(CookError::CacheEntryInvalid);
+    }
+
+    return artifacts;
+}
+
+} // namespace lodestone
@@ -1,4 +1,5 @@
 #include "emit/ShaderLibraryEmitter.hpp"
+#include "emit/ModuleArtifacts.hpp"
 #include "model/CookedLibrary.hpp"
 #include "permute/PermutationAxis.hpp"
 #include "permute/PermutationSpace.hpp"
@@ -6,10 +7,13 @@
 #include "ShaderLibraryTypes.hpp"
 #include "permute/PermutationValue.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <cctype>
 #include <cstddef>
 #include <cstdint>
 #include <format>
+#include <span>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -356,14 +360,27 @@ namespace
 
     /** Fills every disabled axis with its first value, so all values a caller could pass for a dead
      * axis resolve to one variant. That is true, and it means a caller never has to know which axes
-     * depend on which. */
+     * depend on which.
+     *
+     * An axis is active when its parent is active and holds the required value, as in
+     * EnumerateActiveCombinations. The parent's value alone is not enough in a chain: a parent that was
+     * reset to its default can hold the very value that enables its child. So an axis that is itself a
+     * parent, and has one, keeps an `is...Active` flag for the axes after it, in declaration order. */
     std::string EmitCanonicalize(const CookedModule& module)
     {
         const std::string typeName = std::format("{}Permutation", MakeTypeIdentifier(module.Name));
         std::string emitted =
             std::format("constexpr {} Canonicalize({} permutation) noexcept\n{{\n", typeName, typeName);
 
-        for (const PermutationAxis& axis : module.Space->Axes())
+        const std::span<const PermutationAxis> axes = module.Space->Axes();
+        const auto isParent = [&](const PermutationAxis& candidate)
+        {
+            return std::ranges::any_of(axes,
+                                       [&](const PermutationAxis& other)
+                                       { return module.Space->ParentOf(other) == &candidate; });
+        };
+
+        for (const PermutationAxis& axis : axes)
         {
             const PermutationAxis* parent = module.Space->ParentOf(axis);
             if (parent == nullptr)
@@ -371,11 +388,35 @@ namespace
                 continue;
             }
 
-            emitted += std::format("    if (permutation.{} != {})\n    {{\n        permutation.{} = {};\n"
-                                   "    }}\n",
-                                   MakeFieldIdentifier(parent->Name),
-                                   ValueToCppLiteral(axis.RequiredParentValue),
-                                   MakeFieldIdentifier(axis.Name),
+            // A root parent is always active, so only its value decides.
+            const std::string field = MakeFieldIdentifier(axis.Name);
+            const std::string parentField = MakeFieldIdentifier(parent->Name);
+            const std::string requiredValue = ValueToCppLiteral(axis.RequiredParentValue);
+            const bool parentIsRoot = module.Space->ParentOf(*parent) == nullptr;
+            const std::string parentIsActive =
+                parentIsRoot ? std::string{} : std::format("is{}Active && ", parentField);
+            const std::string parentIsInactive =
+                parentIsRoot ? std::string{} : std::format("!is{}Active || ", parentField);
+
+            std::string isInactive;
+            if (isParent(axis))
+            {
+                emitted += std::format("    const bool is{}Active = {}permutation.{} == {};\n",
+                                       field,
+                                       parentIsActive,
+                                       parentField,
+                                       requiredValue);
+                isInactive = std::format("!is{}Active", field);
+            }
+            else
+            {
+                isInactive =
+                    std::format("{}permutation.{} != {}", parentIsInactive, parentField, requiredValue);
+            }
+
+            emitted += std::format("    if ({})\n    {{\n        permutation.{} = {};\n    }}\n",
+                                   isInactive,
+                                   field,
                                    ValueToCppLiteral(axis.GetDefault()));
         }
 
@@ -436,7 +477,21 @@ std::string MakeModuleSourceFileName(std::string_view header_stem, std::string_v
     return std::format("{}_{}.cpp", header_stem, MakeTypeIdentifier(module_name));
 }
 
-std::string EmitShaderLibraryHeader(const CookedLibrary& library)
+std::string EmitShaderLibraryHeaderSection(const CookedModule& module)
+{
+    std::string section = EmitPermutationStruct(module);
+
+    for (const PermutationAxis& axis : module.Space->Axes())
+    {
+        section += EmitAxisIndexHelper(module, axis);
+    }
+
+    section += EmitCanonicalize(module);
+    section += EmitVariantIndex(module);
+    return section;
+}
+
+std::string EmitShaderLibraryHeader(std::span<const ModuleArtifacts> modules)
 {
     std::string header;
     header.reserve(1u << 14);
@@ -448,35 +503,27 @@ std::string EmitShaderLibraryHeader(const CookedLibrary& library)
     header += "namespace lodestone::shaders\n{\n\n";
 
     header += "enum class ModuleId : uint16_t\n{\n    Invalid = 0,\n";
-    for (size_t i = 0u; i < library.Modules.size(); ++i)
+    for (size_t i = 0u; i < modules.size(); ++i)
     {
-        header += std::format("    {} = {}u,\n", MakeTypeIdentifier(library.Modules[i].Name), i + 1u);
+        header += std::format("    {} = {}u,\n", MakeTypeIdentifier(modules[i].Name), i + 1u);
     }
     header += "};\n\n";
 
     header += "enum class EntryPointId : uint16_t\n{\n    Invalid = 0,\n";
     uint32_t entryPointOrdinal = 1u;
-    for (const CookedModule& module : library.Modules)
+    for (const ModuleArtifacts& module : modules)
     {
-        for (const LibraryEntryPoint& entryPoint : module.EntryPoints)
+        for (const std::string& entryPointName : module.EntryPointNames)
         {
-            header += std::format("    {} = {}u,\n", MakeTypeIdentifier(entryPoint.Name), entryPointOrdinal);
+            header += std::format("    {} = {}u,\n", MakeTypeIdentifier(entryPointName), entryPointOrdinal);
             ++entryPointOrdinal;
         }
     }
     header += "};\n\n";
 
-    for (const CookedModule& module : library.Modules)
+    for (const ModuleArtifacts& module : modules)
     {
-        header += EmitPermutationStruct(module);
-
-        for (const PermutationAxis& axis : module.Space->Axes())
-        {
-            header += EmitAxisIndexHelper(module, axis);
-        }
-
-        header += EmitCanonicalize(module);
-        header += EmitVariantIndex(module);
+        header += module.HeaderSection;
     }
 
     header += "/** Returns the WGSL for one entry point of one variant. An unknown pair returns an\n"
@@ -674,18 +721,87 @@ namespace
                            EmitRasterRecordFields(variant.RasterIndices[entry_point_index]));
     }
 
-    /** One table for each entry point, indexed by the dense variant index. A dependent axis leaves
-     * holes; those rows stay empty and every accessor reports them as unknown. */
-    std::string EmitVariantTables(const CookedModule& module, const LayoutProjection& projection)
+    /** The emitted `VariantRecord` on a 64-bit target: a string view, three pointers, three counts, a
+     * workgroup size and a flag, with their padding. */
+    constexpr size_t k_VariantRecordBytes = 80u;
+    /** The emitted `VariantRank`: 64 live bits and a count, with their padding. */
+    constexpr size_t k_VariantRankBytes = 16u;
+
+    /** True when the variant tables leave their holes out. Every hole costs a row in each entry point's
+     * table, and leaving them out costs one rank for each 64 dense indices, so the smaller wins. A rank
+     * counts rows in table order, so the variants must be sorted by index and unique, as enumeration
+     * leaves them. */
+    bool UsesSparseVariantTables(const CookedModule& module)
     {
-        const std::vector<const LibraryVariant*> slots = BuildVariantSlotTable(module);
+        const auto outOfOrder = std::ranges::adjacent_find(
+            module.Variants, std::ranges::greater_equal{}, &LibraryVariant::Index);
+        if (module.Variants.empty() || outOfOrder != module.Variants.end() ||
+            module.Variants.back().Index >= module.SpaceSize)
+        {
+            return false;
+        }
+
+        const size_t holeBytes =
+            (module.SpaceSize - module.Variants.size()) * module.EntryPoints.size() * k_VariantRecordBytes;
+        const size_t rankBytes = ((static_cast<size_t>(module.SpaceSize) + 63u) / 64u) * k_VariantRankBytes;
+        return holeBytes > rankBytes;
+    }
+
+    /** For each 64 dense indices, which hold a variant and how many variants the indices before them
+     * hold. `FindRow` adds the live bits below an index to find its row. */
+    std::string EmitVariantRanks(const CookedModule& module)
+    {
+        std::vector<uint64_t> live((static_cast<size_t>(module.SpaceSize) + 63u) / 64u, 0u);
+        for (const LibraryVariant& variant : module.Variants)
+        {
+            live[variant.Index / 64u] |= uint64_t{ 1u } << (variant.Index % 64u);
+        }
+
+        std::string emitted = "struct VariantRank\n{\n    uint64_t Live;\n    uint32_t RankBefore;\n};\n\n";
+        emitted += std::format("constexpr VariantRank k_VariantRanks[{}]\n{{\n", live.size());
+        uint32_t rankBefore = 0u;
+        for (const uint64_t word : live)
+        {
+            emitted += std::format("    VariantRank{{ 0x{:016X}ull, {}u }},\n", word, rankBefore);
+            rankBefore += static_cast<uint32_t>(std::popcount(word));
+        }
+        emitted += "};\n\n";
+
+        return emitted;
+    }
+
+    /** The row of every variant in the order the tables hold them: each at its dense index with an
+     * empty row for each hole, or only the variants, in index order. */
+    std::vector<const LibraryVariant*> BuildVariantRows(const CookedModule& module, bool sparse)
+    {
+        if (!sparse)
+        {
+            return BuildVariantSlotTable(module);
+        }
+
+        std::vector<const LibraryVariant*> rows;
+        rows.reserve(module.Variants.size());
+        for (const LibraryVariant& variant : module.Variants)
+        {
+            rows.push_back(&variant);
+        }
+
+        return rows;
+    }
+
+    /** One table for each entry point. A dependent axis leaves holes in the dense index range: a dense
+     * table keeps an empty row for each, and a sparse table leaves them out and goes through
+     * `k_VariantRanks`. Either way every accessor reports a hole as unknown. */
+    std::string EmitVariantTables(const CookedModule& module, const LayoutProjection& projection, bool sparse)
+    {
+        const std::vector<const LibraryVariant*> slots = BuildVariantRows(module, sparse);
         std::string emitted;
 
         for (size_t entryPointIndex = 0u; entryPointIndex < module.EntryPoints.size(); ++entryPointIndex)
         {
             emitted += std::format("constexpr VariantRecord k_{}_Variants[{}]\n{{\n",
                                    MakeTypeIdentifier(module.EntryPoints[entryPointIndex].Name),
-                                   module.SpaceSize);
+                                   slots.size());
 
             for (const LibraryVariant* variant : slots)
             {
@@ -713,8 +829,11 @@ std::string EmitShaderLibraryModuleSource(const CookedModule& module, std::strin
     std::string source;
     source.reserve(1u << 20);
 
+    const bool sparse = UsesSparseVariantTables(module);
+
     source += k_GeneratedBanner;
-    source += std::format("#include \"{}\"\n\n", header_name);
+    source += std::format("#include \"{}\"\n", header_name);
+    source += sparse ? "#include <bit>\n\n" : "\n";
     source += "namespace lodestone::shaders\n{\n\nnamespace\n{\n\n";
 
     const LayoutProjection projection = ProjectLayouts(module);
@@ -730,17 +849,37 @@ std::string EmitShaderLibraryModuleSource(const CookedModule& module, std::strin
               "    const lodestone::ColorTargetInfo* ColorTargets;\n    uint32_t ColorTargetCount;\n"
               "    bool WritesFragDepth;\n};\n\n";
 
-    source += EmitVariantTables(module, projection);
+    source += EmitVariantTables(module, projection, sparse);
 
     source += std::format("constexpr uint32_t k_VariantSpaceSize = {}u;\n\n", module.SpaceSize);
 
+    if (sparse)
+    {
+        source += EmitVariantRanks(module);
+        source += "uint32_t FindRow(uint32_t variant_index) noexcept\n"
+                  "{\n    const VariantRank& rank = k_VariantRanks[variant_index / 64u];\n"
+                  "    const uint64_t bit = uint64_t{ 1u } << (variant_index % 64u);\n"
+                  "    if ((rank.Live & bit) == 0u)\n    {\n        return k_VariantSpaceSize;\n    }\n\n"
+                  "    const uint64_t below = rank.Live & (bit - 1u);\n"
+                  "    return rank.RankBefore + static_cast<uint32_t>(std::popcount(below));\n}\n\n";
+    }
+
     source += "const VariantRecord* FindRecord(EntryPointId entry_point, uint32_t variant_index) noexcept\n"
-              "{\n    if (variant_index >= k_VariantSpaceSize)\n    {\n        return nullptr;\n    }\n\n"
-              "    switch (entry_point)\n    {\n";
+              "{\n    if (variant_index >= k_VariantSpaceSize)\n    {\n        return nullptr;\n    }\n\n";
+    if (sparse)
+    {
+        source += "    const uint32_t row = FindRow(variant_index);\n"
+                  "    if (row == k_VariantSpaceSize)\n    {\n        return nullptr;\n    }\n\n";
+    }
+    else
+    {
+        source += "    const uint32_t row = variant_index;\n";
+    }
+    source += "    switch (entry_point)\n    {\n";
     for (const LibraryEntryPoint& entryPoint : module.EntryPoints)
     {
         const std::string identifier = MakeTypeIdentifier(entryPoint.Name);
-        source += std::format("    case EntryPointId::{}:\n        return &k_{}_Variants[variant_index];\n",
+        source += std::format("    case EntryPointId::{}:\n        return &k_{}_Variants[row];\n",
                               identifier,
                               identifier);
     }
@@ -1,12 +1,19 @@
 #include "emit/ShaderManifestEmitter.hpp"
+#include "emit/SourceBlockEncoder.hpp"
+#include "model/ContentHash.hpp"
+#include "model/ContentInterner.hpp"
 #include "model/CookedLibrary.hpp"
 #include "CookerErrors.hpp"
 #include "permute/PermutationSpace.hpp"
 #include "model/ShaderDataSchema.hpp"
+#include "model/SourceChunker.hpp"
 #include "ShaderLibraryTypes.hpp"
 #include "ShaderManifest.hpp"
+#include "SourceBlockCodec.hpp"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -115,6 +122,20 @@ namespace
         return offset;
     }
 
+    /** The `Name` of each record, in order: entry points, axes or bindings. */
+    template<typename RecordRange>
+    std::vector<std::string_view> NamesOf(const RecordRange& records)
+    {
+        std::vector<std::string_view> names;
+        names.reserve(std::ranges::size(records));
+        for (const auto& record : records)
+        {
+            names.emplace_back(record.Name);
+        }
+
+        return names;
+    }
+
     ManifestBinding MakeBindingRecord(const ReflectedBinding& binding,
                                       StringTableBuilder& strings,
                                       std::vector<ManifestUniformMember>& member_records)
@@ -481,6 +502,104 @@ namespace
         return CheckManifestRaster(module, view, variant, entry_point_index);
     }
 
+    /** A query that names every axis of the variant by name must resolve to the variant's own index,
+     * so a program that looks variants up from the manifest alone agrees with the generated C++. */
+    CookResult<void> CheckManifestVariantQuery(const CookedModule& module,
+                                               const ShaderManifestView& view,
+                                               const LibraryVariant& variant)
+    {
+        // A module built without a space, as the tests build them, has no axis table to query.
+        if (module.Space == nullptr)
+        {
+            return {};
+        }
+
+        std::vector<ManifestAxisValue> assignment;
+        assignment.reserve(variant.Canonical.size());
+        for (size_t i = 0u; i < variant.Canonical.size(); ++i)
+        {
+            const PermutationBinding& binding = variant.Canonical[i];
+            assignment.push_back(
+                ManifestAxisValue::Named(binding.Axis->Name, PermutationValueToInt64(binding.Value)));
+        }
+
+        const ManifestResult<uint32_t> resolved = view.ResolveVariant(assignment);
+        if (!resolved.has_value() || resolved.value() != variant.Index)
+        {
+            std::println(stderr,
+                         "[shader_cooker] module {} variant {} does not resolve to its own index from the "
+                         "manifest axis tables",
+                         module.Name,
+                         variant.Index);
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+
+        return {};
+    }
+
+    /** The name of each record, where it came from, and the record `Find*` must return for it. */
+    CookResult<void> CheckManifestNameLookup(const CookedModule& module,
+                                             std::string_view kind,
+                                             std::span<const std::string_view> names,
+                                             auto find,
+                                             auto expected_of)
+    {
+        for (size_t i = 0u; i < names.size(); ++i)
+        {
+            if (find(names[i]) != expected_of(i))
+            {
+                std::println(stderr,
+                             "[shader_cooker] module {} {} {} is not found by name in the manifest",
+                             module.Name,
+                             kind,
+                             names[i]);
+                return std::unexpected(CookError::LibraryRoundTripFailed);
+            }
+        }
+
+        return {};
+    }
+
+    /** Every name the manifest hashes finds its own record, or the first record of the name when several
+     * bindings share it. A name the lookup builder gave up on fails here. */
+    CookResult<void> CheckManifestNameLookups(const CookedModule& module, const ShaderManifestView& view)
+    {
+        std::vector<std::string_view> names = NamesOf(module.EntryPoints);
+        CookResult<void> checked = CheckManifestNameLookup(
+            module,
+            "entry point",
+            names,
+            [&view](std::string_view name) { return view.FindEntryPoint(name); },
+            [](size_t i) { return static_cast<uint16_t>(i + 1u); });
+
+        if (checked && module.Space != nullptr)
+        {
+            names = NamesOf(module.Space->Axes());
+            checked = CheckManifestNameLookup(
+                module,
+                "axis",
+                names,
+                [&view](std::string_view name) { return view.FindAxis(name); },
+                [](size_t i) { return static_cast<uint32_t>(i); });
+        }
+
+        if (checked)
+        {
+            names = NamesOf(module.Resources);
+            checked = CheckManifestNameLookup(
+                module,
+                "binding",
+                names,
+                [&view](std::string_view name) { return view.FindBinding(name); },
+                [&names](size_t i)
+                {
+                    return static_cast<uint32_t>(std::ranges::find(names, names[i]) - names.begin());
+                });
+        }
+
+        return checked;
+    }
+
 } // namespace
 
 std::string MakeManifestFileName(std::string_view module_name)
@@ -678,20 +797,57 @@ namespace
     }
 
     /** Maps a dense variant index to a row of the variant table. A hole keeps k_ShaderManifestNoIndex. */
-    std::vector<uint32_t> BuildVariantIndexTable(const CookedModule& module)
+    /** One of the two variant index encodings; the other stays empty. */
+    struct VariantIndexTables
     {
-        std::vector<uint32_t> records(module.SpaceSize, k_ShaderManifestNoIndex);
+        std::vector<uint32_t> Dense;
+        std::vector<ManifestVariantRank> Ranks;
+    };
+
+    /** The dense table costs four bytes for each index of the space, live or not. The rank bitvector
+     * costs sixteen for each 64 indices, but counts variants in table order, so it needs the variants
+     * sorted by index and unique, as enumeration leaves them. The smaller wins, and a tie keeps the
+     * dense table, which needs no popcount. */
+    VariantIndexTables BuildVariantIndexTables(const CookedModule& module)
+    {
+        const size_t rankCount = (static_cast<size_t>(module.SpaceSize) + 63u) / 64u;
+        const auto outOfOrder = std::ranges::adjacent_find(
+            module.Variants, std::ranges::greater_equal{}, &LibraryVariant::Index);
+        const bool strictlyAscending = outOfOrder == module.Variants.end();
+        const bool inRange = module.Variants.empty() || module.Variants.back().Index < module.SpaceSize;
+        const bool ranksAreSmaller =
+            rankCount * sizeof(ManifestVariantRank) < module.SpaceSize * sizeof(uint32_t);
+
+        VariantIndexTables tables;
+        if (strictlyAscending && inRange && ranksAreSmaller)
+        {
+            tables.Ranks.resize(rankCount);
+            for (const LibraryVariant& variant : module.Variants)
+            {
+                tables.Ranks[variant.Index / 64u].Live |= uint64_t{ 1u } << (variant.Index % 64u);
+            }
+
+            uint32_t rankBefore = 0u;
+            for (ManifestVariantRank& rank : tables.Ranks)
+            {
+                rank.RankBefore = rankBefore;
+                rankBefore += static_cast<uint32_t>(std::popcount(rank.Live));
+            }
 
+            return tables;
+        }
+
+        tables.Dense.assign(module.SpaceSize, k_ShaderManifestNoIndex);
         for (size_t i = 0u; i < module.Variants.size(); ++i)
         {
             const uint32_t denseIndex = module.Variants[i].Index;
-            if (denseIndex < records.size())
+            if (denseIndex < tables.Dense.size())
             {
-                records[denseIndex] = static_cast<uint32_t>(i);
+                tables.Dense[denseIndex] = static_cast<uint32_t>(i);
             }
         }
 
-        return records;
+        return tables;
     }
 
     struct AxisTables
@@ -713,9 +869,24 @@ namespace
         for (const PermutationAxis& axis : module.Space->Axes())
         {
             ManifestAxis record;
+            record.NameHash = HashManifestName(axis.Name);
             record.NameString = strings.Add(axis.Name);
             record.FirstValue = static_cast<uint32_t>(tables.Values.size());
             record.ValueCount = static_cast<uint32_t>(axis.NumValues());
+
+            // The required value goes in as its position among the parent's values, which is what a
+            // query compares. A value the parent cannot take keeps the axis off, as it does in C++.
+            if (const PermutationAxis* parent = module.Space->ParentOf(axis); parent != nullptr)
+            {
+                const std::span<const PermutationValue> parentValues = parent->GetValues();
+                const auto required = std::ranges::find(parentValues, axis.RequiredParentValue);
+                record.ParentAxis = static_cast<uint32_t>(axis.ParentIndex);
+                record.RequiredParentValue =
+                    required != parentValues.end()
+                        ? static_cast<uint32_t>(required - parentValues.begin())
+                        : k_ShaderManifestNoIndex;
+            }
+
             tables.Axes.push_back(record);
             for (const PermutationValue& value : axis.GetValues())
             {
@@ -726,18 +897,140 @@ namespace
         return tables;
     }
 
+    /** The perfect hash of every name kind, in `ManifestNameKind` order, over shared tables. */
+    struct NameLookupTables
+    {
+        std::vector<ManifestNameLookup> Lookups;
+        std::vector<uint32_t> Buckets;
+        std::vector<uint32_t> Slots;
+    };
+
+    /** Names a bucket holds on average. Fewer means more buckets to store and faster builds. */
+    constexpr uint32_t k_NamesPerBucket = 4u;
+    /** Displacements tried for one bucket before the builder gives up on the kind. Only names whose
+     * 64-bit hashes collide get this far; the round trip then fails and says which. */
+    constexpr uint32_t k_MaxNameDisplacement = 1u << 20u;
+
+    /** Hash and displace. Buckets are placed largest first, while most slots are free, and each takes
+     * the first displacement that sends all its names to free and distinct slots. `names` holds one
+     * name for each record; a name several records share maps to the first of them. */
+    void AppendNameLookup(std::span<const std::string_view> names, NameLookupTables& tables)
+    {
+        ManifestNameLookup lookup{ .FirstBucket = static_cast<uint32_t>(tables.Buckets.size()),
+                                   .FirstSlot = static_cast<uint32_t>(tables.Slots.size()) };
+
+        std::vector<std::pair<uint64_t, uint32_t>> keys;
+        for (size_t i = 0u; i < names.size(); ++i)
+        {
+            if (std::ranges::find(names.first(i), names[i]) == names.begin() + static_cast<ptrdiff_t>(i))
+            {
+                keys.emplace_back(HashManifestName(names[i]), static_cast<uint32_t>(i));
+            }
+        }
+
+        if (keys.empty())
+        {
+            tables.Lookups.push_back(lookup);
+            return;
+        }
+
+        const auto slotCount = static_cast<uint32_t>(keys.size());
+        const uint32_t bucketCount = (slotCount + k_NamesPerBucket - 1u) / k_NamesPerBucket;
+        std::vector<std::vector<uint32_t>> buckets(bucketCount);
+        for (uint32_t key = 0u; key < slotCount; ++key)
+        {
+            buckets[ManifestNameBucket(keys[key].first, bucketCount)].push_back(key);
+        }
+
+        std::vector<uint32_t> order(bucketCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::stable_sort(order,
+                                 [&buckets](uint32_t lhs, uint32_t rhs)
+                                 {
+                                     return buckets[lhs].size() > buckets[rhs].size();
+                                 });
+
+        std::vector<uint32_t> displacements(bucketCount, 0u);
+        std::vector<uint32_t> slots(slotCount, k_ShaderManifestNoIndex);
+        std::vector<uint32_t> placed;
+        for (const uint32_t bucket : order)
+        {
+            if (buckets[bucket].empty())
+            {
+                break;
+            }
+
+            bool fits = false;
+            for (uint32_t displacement = 0u; !fits && displacement < k_MaxNameDisplacement; ++displacement)
+            {
+                placed.clear();
+                for (const uint32_t key : buckets[bucket])
+                {
+                    const uint32_t slot = ManifestNameSlot(keys[key].first, displacement, slotCount);
+                    const bool taken = slots[slot] != k_ShaderManifestNoIndex ||
+                                       std::ranges::find(placed, slot) != placed.end();
+                    if (taken)
+                    {
+                        break;
+                    }
+
+                    placed.push_back(slot);
+                }
+
+                fits = placed.size() == buckets[bucket].size();
+                displacements[bucket] = displacement;
+            }
+
+            if (!fits)
+            {
+                tables.Lookups.push_back(ManifestNameLookup{ .FirstBucket = lookup.FirstBucket,
+                                                             .FirstSlot = lookup.FirstSlot });
+                return;
+            }
+
+            for (size_t i = 0u; i < placed.size(); ++i)
+            {
+                slots[placed[i]] = keys[buckets[bucket][i]].second;
+            }
+        }
+
+        lookup.BucketCount = bucketCount;
+        lookup.SlotCount = slotCount;
+        tables.Lookups.push_back(lookup);
+        tables.Buckets.insert(tables.Buckets.end(), displacements.begin(), displacements.end());
+        tables.Slots.insert(tables.Slots.end(), slots.begin(), slots.end());
+    }
+
+    NameLookupTables BuildNameLookupTables(const CookedModule& module)
+    {
+        NameLookupTables tables;
+        AppendNameLookup(NamesOf(module.EntryPoints), tables);
+        const std::vector<std::string_view> axisNames =
+            module.Space != nullptr ? NamesOf(module.Space->Axes()) : std::vector<std::string_view>{};
+        AppendNameLookup(axisNames, tables);
+        AppendNameLookup(NamesOf(module.Resources), tables);
+
+        return tables;
+    }
+
     struct SourceTables
     {
         std::string Blob;
         std::vector<ManifestSourceRef> Refs;
+        /** Empty until `CompressSourceTables` runs. */
+        std::vector<ManifestSourceBlock> Blocks;
+        /** Empty unless the blocks were encoded against one. */
+        std::string Dictionary;
     };
 
-    SourceTables BuildSourceTables(const CookedModule& module)
+    /** Takes a module's source table or the library's, which hold strings and views. */
+    template<typename SourceRange>
+    SourceTables BuildSourceTables(const SourceRange& sources)
     {
         SourceTables tables;
-        tables.Refs.reserve(module.Sources.size());
+        tables.Refs.reserve(std::ranges::size(sources));
 
-        for (const std::string& source : module.Sources)
+        for (const std::string_view source : sources)
         {
             tables.Refs.push_back(ManifestSourceRef{ .Offset = static_cast<uint32_t>(tables.Blob.size()),
                                                      .Length = static_cast<uint32_t>(source.size()) });
@@ -747,9 +1040,137 @@ namespace
         return tables;
     }
 
+    ContentHashValue HashChunk(const std::string_view& chunk) noexcept
+    {
+        return HashBytes(std::as_bytes(std::span{ chunk.data(), chunk.size() }));
+    }
+
+    /** The chunk table, which takes the place of the source table, and the chunks of each source. */
+    struct ChunkedSourceTables
+    {
+        SourceTables Chunks;
+        std::vector<ManifestRun> ChunkLists;
+        std::vector<uint32_t> ChunkIndices;
+    };
+
+    /** Cuts every source of the module into chunks and interns them. The chunks of one source are
+     * interned in order, so the chunk table lists chunks in the order the sources first hold them. */
+    ChunkedSourceTables BuildChunkedSourceTables(const CookedModule& module)
+    {
+        ContentInterner<std::string_view> chunkInterner{ &HashChunk, k_HashName };
+        chunkInterner.DisableProvenance();
+        if (!module.SourceTable.DedupeEnabled)
+        {
+            chunkInterner.Disable();
+        }
+
+        ChunkedSourceTables tables;
+        tables.ChunkLists.reserve(module.Sources.size());
+        for (const std::string& source : module.Sources)
+        {
+            const std::vector<std::string_view> chunks = SplitSourceIntoChunks(source);
+            const auto first = static_cast<uint32_t>(tables.ChunkIndices.size());
+            const auto count = static_cast<uint32_t>(chunks.size());
+            tables.ChunkLists.push_back(ManifestRun{ .First = first, .Count = count });
+            for (const std::string_view chunk : chunks)
+            {
+                const InternResult interned = chunkInterner.Intern(chunk, ProvenanceRecord{});
+                if (interned.WasNew)
+                {
+                    tables.Chunks.Refs.push_back(
+                        ManifestSourceRef{ .Offset = static_cast<uint32_t>(tables.Chunks.Blob.size()),
+                                           .Length = static_cast<uint32_t>(chunk.size()) });
+                    tables.Chunks.Blob.append(chunk);
+                }
+
+                tables.ChunkIndices.push_back(interned.Index);
+            }
+        }
+
+        return tables;
+    }
+
+    /** Replaces the text of every entry with its compressed blocks. Each ref keeps its length and names
+     * its first block instead of its offset. A block that does not shrink is stored as it is. With
+     * `ManifestSourceCompression::Dictionary`, the entries train the dictionary first. */
+    void CompressSourceTables(SourceTables& tables, ManifestSourceCompression compression)
+    {
+        const std::string_view blob{ tables.Blob };
+        if (compression == ManifestSourceCompression::Dictionary)
+        {
+            std::vector<std::string_view> entries;
+            entries.reserve(tables.Refs.size());
+            for (const ManifestSourceRef& reference : tables.Refs)
+            {
+                entries.push_back(blob.substr(reference.Offset, reference.Length));
+            }
+
+            tables.Dictionary = TrainSourceDictionary(entries, k_SourceDictionaryMaxSize);
+        }
+
+        std::string compressed;
+        compressed.reserve(tables.Blob.size() / 2u);
+
+        for (ManifestSourceRef& reference : tables.Refs)
+        {
+            const std::string_view text = blob.substr(reference.Offset, reference.Length);
+            reference.Offset = static_cast<uint32_t>(tables.Blocks.size());
+            for (size_t start = 0u; start < text.size(); start += k_SourceBlockSize)
+            {
+                const std::string_view piece = text.substr(start, k_SourceBlockSize);
+                const std::string encoded = EncodeSourceBlock(piece, tables.Dictionary);
+                const std::string_view stored = encoded.size() < piece.size() ? encoded : piece;
+                tables.Blocks.push_back(
+                    ManifestSourceBlock{ .Offset = static_cast<uint32_t>(compressed.size()),
+                                         .CompressedSize = static_cast<uint32_t>(stored.size()) });
+                compressed.append(stored);
+            }
+        }
+
+        tables.Blob = std::move(compressed);
+    }
+
+    /** The string and source sections, which lead every manifest. The library source file holds these
+     * and nothing else. */
+    void AppendStringAndSourceSections(std::string& bytes,
+                                       ShaderManifestHeader& header,
+                                       const StringTableBuilder& strings,
+                                       const SourceTables& sources)
+    {
+        header.StringTableOffset = AppendTable(bytes, strings.References());
+        header.StringCount = static_cast<uint32_t>(strings.References().size());
+
+        AlignTo8(bytes);
+        header.StringBlobOffset = static_cast<uint32_t>(bytes.size());
+        header.StringBlobSize = static_cast<uint32_t>(strings.Blob().size());
+        bytes.append(strings.Blob());
+
+        header.SourceTableOffset = AppendTable(bytes, sources.Refs);
+        header.SourceCount = static_cast<uint32_t>(sources.Refs.size());
+        header.SourceBlockTableOffset = AppendTable(bytes, sources.Blocks);
+        header.SourceBlockCount = static_cast<uint32_t>(sources.Blocks.size());
+        if (!sources.Blocks.empty())
+        {
+            header.Flags |= k_ManifestCompressedSources;
+        }
+
+        if (!sources.Dictionary.empty())
+        {
+            AlignTo8(bytes);
+            header.SourceDictionaryOffset = static_cast<uint32_t>(bytes.size());
+            header.SourceDictionarySize = static_cast<uint32_t>(sources.Dictionary.size());
+            bytes.append(sources.Dictionary);
+        }
+
+        AlignTo8(bytes);
+        header.SourceBlobOffset = static_cast<uint32_t>(bytes.size());
+        header.SourceBlobSize = static_cast<uint32_t>(sources.Blob.size());
+        bytes.append(sources.Blob);
+    }
+
 } // namespace
 
-std::string EmitShaderManifest(const CookedModule& module)
+std::string EmitShaderManifest(const CookedModule& module, const ManifestSourceOptions& source_options)
 {
     StringTableBuilder strings;
     /** DO NOT REORDER THESE. The order of these calls currently decides the order of the strings
@@ -763,14 +1184,24 @@ std::string EmitShaderManifest(const CookedModule& module)
     const LayoutTables layouts = BuildLayoutTables(module, strings);
     const RasterTables rasters = BuildRasterTables(module, strings);
     const VariantTables variants = BuildVariantTables(module, strings);
-    const std::vector<uint32_t> variantIndexRecords = BuildVariantIndexTable(module);
+    const VariantIndexTables variantIndex = BuildVariantIndexTables(module);
     const AxisTables axes = BuildAxisTables(module, strings);
-    const SourceTables sources = BuildSourceTables(module);
+    const NameLookupTables nameLookups = BuildNameLookupTables(module);
+    const bool chunked = source_options.Layout == ManifestSourceLayout::Chunked;
+    ChunkedSourceTables chunkedSources = chunked ? BuildChunkedSourceTables(module) : ChunkedSourceTables{};
+    SourceTables wholeSources = chunked ? SourceTables{} : BuildSourceTables(module.Sources);
+    SourceTables& sources = chunked ? chunkedSources.Chunks : wholeSources;
+    if (source_options.Compression != ManifestSourceCompression::None)
+    {
+        CompressSourceTables(sources, source_options.Compression);
+    }
 
     ShaderManifestHeader header;
     header.Magic = k_ShaderManifestMagic;
     header.Version = k_ShaderManifestVersion;
     header.ModuleNameString = moduleNameString;
+    header.Flags = chunked ? k_ManifestChunkedSources : 0u;
+    header.Flags |= variantIndex.Ranks.empty() ? 0u : k_ManifestSparseVariantIndex;
 
     std::string bytes;
 
@@ -779,6 +1210,7 @@ std::string EmitShaderManifest(const CookedModule& module)
     // types)
     const size_t totalSize =
         sizeof(ShaderManifestHeader) + strings.Blob().size() + sources.Blob.size() +
+        sources.Dictionary.size() + (sources.Blocks.size() * sizeof(ManifestSourceBlock)) +
         (entryPointRecords.size() * sizeof(ManifestEntryPoint)) +
         (layouts.Bindings.size() * sizeof(ManifestBinding)) +
         (layouts.ResourceIndices.size() * sizeof(uint32_t)) +
@@ -791,28 +1223,19 @@ std::string EmitShaderManifest(const CookedModule& module)
         (rasters.ColorTargets.size() * sizeof(ManifestColorTarget)) +
         (rasters.Rasters.size() * sizeof(ManifestRaster)) + (variants.Slots.size() * sizeof(ManifestSlot)) +
         (variants.Variants.size() * sizeof(ManifestVariant)) +
-        (variantIndexRecords.size() * sizeof(decltype(variantIndexRecords)::value_type)) +
+        (variantIndex.Dense.size() * sizeof(uint32_t)) +
+        (variantIndex.Ranks.size() * sizeof(ManifestVariantRank)) +
         (axes.Axes.size() * sizeof(ManifestAxis)) +
-        (axes.Values.size() * sizeof(decltype(axes.Values)::value_type));
+        (axes.Values.size() * sizeof(decltype(axes.Values)::value_type)) +
+        (chunkedSources.ChunkLists.size() * sizeof(ManifestRun)) +
+        (chunkedSources.ChunkIndices.size() * sizeof(uint32_t)) +
+        (nameLookups.Lookups.size() * sizeof(ManifestNameLookup)) +
+        (nameLookups.Buckets.size() * sizeof(uint32_t)) + (nameLookups.Slots.size() * sizeof(uint32_t));
 
     bytes.reserve(totalSize);
     bytes.resize(sizeof(ShaderManifestHeader), '\0');
 
-    header.StringTableOffset = AppendTable(bytes, strings.References());
-    header.StringCount = static_cast<uint32_t>(strings.References().size());
-
-    AlignTo8(bytes);
-    header.StringBlobOffset = static_cast<uint32_t>(bytes.size());
-    header.StringBlobSize = static_cast<uint32_t>(strings.Blob().size());
-    bytes.append(strings.Blob());
-
-    header.SourceTableOffset = AppendTable(bytes, sources.Refs);
-    header.SourceCount = static_cast<uint32_t>(sources.Refs.size());
-
-    AlignTo8(bytes);
-    header.SourceBlobOffset = static_cast<uint32_t>(bytes.size());
-    header.SourceBlobSize = static_cast<uint32_t>(sources.Blob.size());
-    bytes.append(sources.Blob);
+    AppendStringAndSourceSections(bytes, header, strings, sources);
 
     // DO NOT REORDER THESE. Above, the ordering sets how the indices for the string table are assigned.
     // This ordering controls the actual order of the data the indices refer to. Changing either one
@@ -838,8 +1261,10 @@ std::string EmitShaderManifest(const CookedModule& module)
     header.SlotCount = static_cast<uint32_t>(variants.Slots.size());
     header.VariantTableOffset = AppendTable(bytes, variants.Variants);
     header.VariantCount = static_cast<uint32_t>(variants.Variants.size());
-    header.VariantIndexTableOffset = AppendTable(bytes, variantIndexRecords);
-    header.VariantIndexCount = static_cast<uint32_t>(variantIndexRecords.size());
+    header.VariantIndexTableOffset = AppendTable(bytes, variantIndex.Dense);
+    header.VariantIndexCount = static_cast<uint32_t>(variantIndex.Dense.size());
+    header.VariantRankTableOffset = AppendTable(bytes, variantIndex.Ranks);
+    header.VariantRankCount = static_cast<uint32_t>(variantIndex.Ranks.size());
     header.AxisTableOffset = AppendTable(bytes, axes.Axes);
     header.AxisCount = static_cast<uint32_t>(axes.Axes.size());
     header.AxisValueTableOffset = AppendTable(bytes, axes.Values);
@@ -852,6 +1277,16 @@ std::string EmitShaderManifest(const CookedModule& module)
     header.ColorTargetCount = static_cast<uint32_t>(rasters.ColorTargets.size());
     header.UniformMemberTableOffset = AppendTable(bytes, layouts.UniformMembers);
     header.UniformMemberCount = static_cast<uint32_t>(layouts.UniformMembers.size());
+    header.SourceChunkListTableOffset = AppendTable(bytes, chunkedSources.ChunkLists);
+    header.SourceChunkListCount = static_cast<uint32_t>(chunkedSources.ChunkLists.size());
+    header.ChunkIndexTableOffset = AppendTable(bytes, chunkedSources.ChunkIndices);
+    header.ChunkIndexCount = static_cast<uint32_t>(chunkedSources.ChunkIndices.size());
+    header.NameLookupTableOffset = AppendTable(bytes, nameLookups.Lookups);
+    header.NameLookupCount = static_cast<uint32_t>(nameLookups.Lookups.size());
+    header.NameBucketTableOffset = AppendTable(bytes, nameLookups.Buckets);
+    header.NameBucketCount = static_cast<uint32_t>(nameLookups.Buckets.size());
+    header.NameSlotTableOffset = AppendTable(bytes, nameLookups.Slots);
+    header.NameSlotCount = static_cast<uint32_t>(nameLookups.Slots.size());
 
     AlignTo8(bytes);
     header.FileSize = static_cast<uint32_t>(bytes.size());
@@ -876,6 +1311,11 @@ CookResult<void> VerifyManifestRoundTrip(const CookedModule& module, const std::
     const ManifestShaderSourceProvider provider{ view, 0u };
     uint32_t checked = 0u;
 
+    if (CookResult<void> names = CheckManifestNameLookups(module, view); !names)
+    {
+        return names;
+    }
+
     for (const LibraryVariant& variant : module.Variants)
     {
         for (size_t i = 0u; i < module.EntryPoints.size(); ++i)
@@ -887,6 +1327,11 @@ CookResult<void> VerifyManifestRoundTrip(const CookedModule& module, const std::
 
             ++checked;
         }
+
+        if (CookResult<void> query = CheckManifestVariantQuery(module, view, variant); !query)
+        {
+            return query;
+        }
     }
 
     std::println(stderr,
@@ -899,4 +1344,272 @@ CookResult<void> VerifyManifestRoundTrip(const CookedModule& module, const std::
     return {};
 }
 
+std::string MakeLibrarySourceFileName(std::string_view header_stem)
+{
+    return std::format("{}.sources.ldshaders", header_stem);
+}
+
+std::string EmitLibrarySourceManifest(std::string_view library_name,
+                                      std::span<const std::string_view> sources,
+                                      ManifestSourceCompression compression)
+{
+    StringTableBuilder strings;
+    ShaderManifestHeader header;
+    header.Magic = k_ShaderManifestMagic;
+    header.Version = k_ShaderManifestVersion;
+    header.ModuleNameString = strings.Add(library_name);
+
+    SourceTables sourceTables = BuildSourceTables(sources);
+    if (compression != ManifestSourceCompression::None)
+    {
+        CompressSourceTables(sourceTables, compression);
+    }
+
+    std::string bytes;
+    bytes.reserve(sizeof(ShaderManifestHeader) + strings.Blob().size() + sourceTables.Blob.size() +
+                  sourceTables.Dictionary.size() + (sourceTables.Refs.size() * sizeof(ManifestSourceRef)) +
+                  (sourceTables.Blocks.size() * sizeof(ManifestSourceBlock)));
+    bytes.resize(sizeof(ShaderManifestHeader), '\0');
+    AppendStringAndSourceSections(bytes, header, strings, sourceTables);
+
+    AlignTo8(bytes);
+    header.FileSize = static_cast<uint32_t>(bytes.size());
+    std::memcpy(bytes.data(), &header, sizeof(ShaderManifestHeader));
+    return bytes;
+}
+
+namespace
+{
+
+    std::span<const std::byte> AsManifestBytes(const std::string& manifest) noexcept
+    {
+        return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()),
+                                           manifest.size() };
+    }
+
+    using HeaderField = uint32_t ShaderManifestHeader::*;
+
+    /** Where a section starts, how many records it holds, and how large one record is. A blob counts
+     * bytes, so its record is one byte. */
+    struct ManifestSection
+    {
+        HeaderField Offset;
+        HeaderField Count;
+        uint32_t RecordSize;
+    };
+
+    using Header = ShaderManifestHeader;
+
+    /** Every section except those that hold sources. A new section must be added here, or a manifest
+     * that shares its sources loses it. The two chunk sections are left out as well: a manifest with
+     * chunked sources does not share. */
+    constexpr std::array<ManifestSection, 23u> k_SectionsKeptBySharing{
+        ManifestSection{ &Header::StringTableOffset, &Header::StringCount, sizeof(ManifestStringRef) },
+        ManifestSection{ &Header::StringBlobOffset, &Header::StringBlobSize, 1u },
+        ManifestSection{ &Header::BindingTableOffset, &Header::BindingCount, sizeof(ManifestBinding) },
+        ManifestSection{ &Header::ResourceListTableOffset, &Header::ResourceListCount, sizeof(ManifestRun) },
+        ManifestSection{ &Header::ResourceIndexTableOffset, &Header::ResourceIndexCount, sizeof(uint32_t) },
+        ManifestSection{ &Header::FootprintTableOffset, &Header::FootprintCount, sizeof(ManifestFootprint) },
+        ManifestSection{
+            &Header::FootprintListTableOffset, &Header::FootprintListCount, sizeof(ManifestRun) },
+        ManifestSection{
+            &Header::VisibilityListTableOffset, &Header::VisibilityListCount, sizeof(ManifestRun) },
+        ManifestSection{
+            &Header::VisibilityIndexTableOffset, &Header::VisibilityIndexCount, sizeof(uint32_t) },
+        ManifestSection{
+            &Header::EntryPointTableOffset, &Header::EntryPointCount, sizeof(ManifestEntryPoint) },
+        ManifestSection{ &Header::SlotTableOffset, &Header::SlotCount, sizeof(ManifestSlot) },
+        ManifestSection{ &Header::VariantTableOffset, &Header::VariantCount, sizeof(ManifestVariant) },
+        ManifestSection{ &Header::VariantIndexTableOffset, &Header::VariantIndexCount, sizeof(uint32_t) },
+        ManifestSection{
+            &Header::VariantRankTableOffset, &Header::VariantRankCount, sizeof(ManifestVariantRank) },
+        ManifestSection{ &Header::AxisTableOffset, &Header::AxisCount, sizeof(ManifestAxis) },
+        ManifestSection{ &Header::AxisValueTableOffset, &Header::AxisValueCount, sizeof(int64_t) },
+        ManifestSection{ &Header::RasterTableOffset, &Header::RasterCount, sizeof(ManifestRaster) },
+        ManifestSection{
+            &Header::VertexInputTableOffset, &Header::VertexInputCount, sizeof(ManifestVertexInput) },
+        ManifestSection{
+            &Header::ColorTargetTableOffset, &Header::ColorTargetCount, sizeof(ManifestColorTarget) },
+        ManifestSection{
+            &Header::UniformMemberTableOffset, &Header::UniformMemberCount, sizeof(ManifestUniformMember) },
+        ManifestSection{
+            &Header::NameLookupTableOffset, &Header::NameLookupCount, sizeof(ManifestNameLookup) },
+        ManifestSection{ &Header::NameBucketTableOffset, &Header::NameBucketCount, sizeof(uint32_t) },
+        ManifestSection{ &Header::NameSlotTableOffset, &Header::NameSlotCount, sizeof(uint32_t) }
+    };
+
+    /** The whole text of one source, however the manifest stores it. Empty when it does not read. */
+    std::string ReadSourceText(const ShaderManifestView& view, uint32_t source_index)
+    {
+        std::string text(view.SourceSize(source_index), '\0');
+        text.resize(view.AssembleSource(source_index, text).size());
+        return text;
+    }
+
+    CookResult<ShaderManifestView> OpenForSharing(const std::string& manifest_bytes, std::string_view purpose)
+    {
+        const ManifestResult<ShaderManifestView> opened =
+            ShaderManifestView::Open(AsManifestBytes(manifest_bytes));
+        if (!opened.has_value())
+        {
+            std::println(
+                stderr, "[shader_cooker] {} does not open: {}", purpose, ToString(opened.error()));
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+
+        return opened.value();
+    }
+
+} // namespace
+
+CookResult<std::string> ShareManifestSources(const std::string& manifest_bytes,
+                                             std::span<const uint32_t> library_indices)
+{
+    const CookResult<ShaderManifestView> opened = OpenForSharing(manifest_bytes, "a module manifest");
+    if (!opened)
+    {
+        return std::unexpected(opened.error());
+    }
+
+    if (opened.value().HasChunkedSources())
+    {
+        std::println(stderr,
+                     "[shader_cooker] module {} stores its sources as chunks, and the library source file "
+                     "holds whole sources",
+                     opened.value().ModuleName());
+        return std::unexpected(CookError::LibraryRoundTripFailed);
+    }
+
+    if (library_indices.size() != opened.value().SourceCount())
+    {
+        std::println(stderr,
+                     "[shader_cooker] module {} holds {} sources, but the library maps {}",
+                     opened.value().ModuleName(),
+                     opened.value().SourceCount(),
+                     library_indices.size());
+        return std::unexpected(CookError::LibraryRoundTripFailed);
+    }
+
+    ShaderManifestHeader header;
+    std::memcpy(&header, manifest_bytes.data(), sizeof(ShaderManifestHeader));
+
+    // Copied in the order the emitter wrote them, so the rewritten file reads like one it wrote.
+    std::array<ManifestSection, k_SectionsKeptBySharing.size()> sections = k_SectionsKeptBySharing;
+    std::ranges::stable_sort(sections,
+                             [&header](const ManifestSection& lhs, const ManifestSection& rhs)
+                             {
+                                 return header.*(lhs.Offset) < header.*(rhs.Offset);
+                             });
+
+    std::string bytes;
+    bytes.reserve(manifest_bytes.size() - header.SourceBlobSize);
+    bytes.resize(sizeof(ShaderManifestHeader), '\0');
+
+    for (const ManifestSection& section : sections)
+    {
+        AlignTo8(bytes);
+        const size_t size = static_cast<size_t>(header.*(section.Count)) * section.RecordSize;
+        if (size != 0u)
+        {
+            bytes.append(manifest_bytes, header.*(section.Offset), size);
+        }
+        header.*(section.Offset) = static_cast<uint32_t>(bytes.size() - size);
+    }
+
+    AlignTo8(bytes);
+    header.SourceTableOffset = 0u;
+    header.SourceCount = 0u;
+    header.SourceBlobOffset = 0u;
+    header.SourceBlobSize = 0u;
+    header.SourceBlockTableOffset = 0u;
+    header.SourceBlockCount = 0u;
+    header.SourceDictionaryOffset = 0u;
+    header.SourceDictionarySize = 0u;
+    header.Flags &= ~k_ManifestCompressedSources;
+    header.Flags |= k_ManifestSharedSources;
+    header.FileSize = static_cast<uint32_t>(bytes.size());
+    std::memcpy(bytes.data(), &header, sizeof(ShaderManifestHeader));
+
+    for (uint32_t i = 0u; i < header.SlotCount; ++i)
+    {
+        char* const record = bytes.data() + header.SlotTableOffset + (i * sizeof(ManifestSlot));
+        ManifestSlot slot;
+        std::memcpy(&slot, record, sizeof(ManifestSlot));
+        if (slot.SourceIndex >= library_indices.size())
+        {
+            std::println(stderr,
+                         "[shader_cooker] module {} slot {} names source {}, past its source table",
+                         opened.value().ModuleName(),
+                         i,
+                         slot.SourceIndex);
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+
+        slot.SourceIndex = library_indices[slot.SourceIndex];
+        std::memcpy(record, &slot, sizeof(ManifestSlot));
+    }
+
+    return bytes;
+}
+
+CookResult<void> VerifySharedSourceRoundTrip(const std::string& module_manifest,
+                                             const std::string& shared_manifest,
+                                             const std::string& library_sources)
+{
+    const CookResult<ShaderManifestView> original = OpenForSharing(module_manifest, "a module manifest");
+    const CookResult<ShaderManifestView> library = OpenForSharing(library_sources, "the library sources");
+    if (!original || !library)
+    {
+        return std::unexpected(CookError::LibraryRoundTripFailed);
+    }
+
+    const ManifestResult<ShaderManifestView> shared =
+        ShaderManifestView::Open(AsManifestBytes(shared_manifest), library.value());
+    if (!shared.has_value() || !shared.value().SharesLibrarySources())
+    {
+        std::println(stderr,
+                     "[shader_cooker] the shared manifest of module {} does not open against the library "
+                     "sources",
+                     original.value().ModuleName());
+        return std::unexpected(CookError::LibraryRoundTripFailed);
+    }
+
+    const std::span<const ManifestSlot> originalSlots = original.value().SlotTable();
+    const std::span<const ManifestSlot> sharedSlots = shared.value().SlotTable();
+    if (shared.value().ModuleName() != original.value().ModuleName() ||
+        sharedSlots.size() != originalSlots.size() ||
+        shared.value().Variants().size() != original.value().Variants().size() ||
+        shared.value().Bindings().size() != original.value().Bindings().size())
+    {
+        std::println(stderr,
+                     "[shader_cooker] the shared manifest of module {} does not match the manifest it "
+                     "came from",
+                     original.value().ModuleName());
+        return std::unexpected(CookError::LibraryRoundTripFailed);
+    }
+
+    for (size_t i = 0u; i < originalSlots.size(); ++i)
+    {
+        const ManifestSlot& before = originalSlots[i];
+        const ManifestSlot& after = sharedSlots[i];
+        const bool matches =
+            ReadSourceText(original.value(), before.SourceIndex) ==
+                ReadSourceText(shared.value(), after.SourceIndex) &&
+            before.VisibilityIndex == after.VisibilityIndex && before.WorkgroupX == after.WorkgroupX &&
+            before.WorkgroupY == after.WorkgroupY && before.WorkgroupZ == after.WorkgroupZ &&
+            before.RasterIndex == after.RasterIndex;
+        if (!matches)
+        {
+            std::println(stderr,
+                         "[shader_cooker] SHARED SOURCE ROUND TRIP FAILED for module {}: slot {} reads "
+                         "differently through the library sources",
+                         original.value().ModuleName(),
+                         i);
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+    }
+
+    return {};
+}
+
 } // namespace lodestone
@@ -0,0 +1,152 @@
+#include "emit/ShaderPackEmitter.hpp"
+#include "CookerErrors.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderPack.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    std::span<const std::byte> AsPackBytes(const std::string& pack) noexcept
+    {
+        return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(pack.data()), pack.size() };
+    }
+
+    /** Pads with zeros up to the next 8-byte boundary, and returns where the next record starts. */
+    uint32_t AlignPack(std::string& bytes)
+    {
+        bytes.resize((bytes.size() + 7u) & ~size_t{ 7u }, '\0');
+        return static_cast<uint32_t>(bytes.size());
+    }
+
+    uint32_t AppendManifest(std::string& bytes, std::string_view manifest)
+    {
+        const uint32_t offset = AlignPack(bytes);
+        bytes.append(manifest);
+        return offset;
+    }
+
+    /** The bytes a slot points at, or empty when it points outside the pack. */
+    std::string_view SlotBytes(const std::string& pack_bytes, const ShaderPackSlot& slot) noexcept
+    {
+        if (slot.Size > pack_bytes.size() || slot.Offset > pack_bytes.size() - slot.Size)
+        {
+            return {};
+        }
+
+        return std::string_view{ pack_bytes }.substr(slot.Offset, slot.Size);
+    }
+
+} // namespace
+
+std::string MakeShaderPackFileName(std::string_view header_stem)
+{
+    return std::format("{}.ldpack", header_stem);
+}
+
+std::string EmitShaderPack(std::span<const ShaderPackEntry> modules, std::string_view shared_sources)
+{
+    ShaderPackHeader header;
+    header.Magic = k_ShaderPackMagic;
+    header.Version = k_ShaderPackVersion;
+    header.ModuleCount = static_cast<uint32_t>(modules.size());
+    header.SlotCount = std::bit_ceil(std::max(header.ModuleCount * 2u, 1u));
+
+    std::string bytes(sizeof(ShaderPackHeader), '\0');
+    header.SlotTableOffset = AlignPack(bytes);
+    bytes.resize(bytes.size() + static_cast<size_t>(header.SlotCount) * sizeof(ShaderPackSlot), '\0');
+
+    if (!shared_sources.empty())
+    {
+        header.SharedSourcesOffset = AppendManifest(bytes, shared_sources);
+        header.SharedSourcesSize = static_cast<uint32_t>(shared_sources.size());
+    }
+
+    // Linear probing from the home slot. The table is at least half empty, so every insert finds a slot.
+    std::vector<ShaderPackSlot> slots(header.SlotCount);
+    const uint64_t mask = header.SlotCount - 1u;
+    for (const ShaderPackEntry& module : modules)
+    {
+        ShaderPackSlot slot;
+        slot.NameHash = HashShaderPackName(module.ModuleName);
+        slot.Offset = AppendManifest(bytes, module.Manifest);
+        slot.Size = static_cast<uint32_t>(module.Manifest.size());
+
+        uint64_t position = slot.NameHash & mask;
+        while (slots[position].Size != 0u)
+        {
+            position = (position + 1u) & mask;
+        }
+
+        slots[position] = slot;
+    }
+
+    header.FileSize = static_cast<uint32_t>(bytes.size());
+    std::memcpy(bytes.data(), &header, sizeof(ShaderPackHeader));
+    std::memcpy(bytes.data() + header.SlotTableOffset, slots.data(), slots.size() * sizeof(ShaderPackSlot));
+    return bytes;
+}
+
+CookResult<void> VerifyShaderPackRoundTrip(std::span<const ShaderPackEntry> modules,
+                                           const std::string& pack_bytes)
+{
+    const ManifestResult<ShaderPackView> pack = ShaderPackView::Open(AsPackBytes(pack_bytes));
+    if (!pack.has_value() || pack.value().ModuleCount() != modules.size())
+    {
+        std::println(stderr, "[shader_cooker] the shader pack does not open, or lost a module");
+        return std::unexpected(CookError::LibraryRoundTripFailed);
+    }
+
+    for (const ShaderPackEntry& module : modules)
+    {
+        const ManifestResult<ShaderManifestView> found = pack.value().Find(module.ModuleName);
+        if (!found.has_value() || found.value().ModuleName() != module.ModuleName)
+        {
+            std::println(
+                stderr, "[shader_cooker] module {} is not found in the shader pack", module.ModuleName);
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+
+        // The view does not hand back its bytes, so the slot that holds the module's hash and the same
+        // bytes stands for it. Find already proved that slot opens under this name.
+        const uint64_t hash = HashShaderPackName(module.ModuleName);
+        bool matched = false;
+        for (const ShaderPackSlot& slot : pack.value().Slots())
+        {
+            matched = matched || (slot.Size != 0u && slot.NameHash == hash &&
+                                  SlotBytes(pack_bytes, slot) == module.Manifest);
+        }
+
+        if (!matched)
+        {
+            std::println(stderr,
+                         "[shader_cooker] module {} does not read back from the shader pack as it went in",
+                         module.ModuleName);
+            return std::unexpected(CookError::LibraryRoundTripFailed);
+        }
+    }
+
+    std::println(stderr,
+                 "[shader_cooker] shader pack round trip verified: {} modules ({} KiB)",
+                 modules.size(),
+                 pack_bytes.size() / 1024u);
+    return {};
+}
+
+} // namespace lodestone
@@ -0,0 +1,234 @@
+#include "emit/SourceBlockEncoder.hpp"
+#include "SourceBlockCodec.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    constexpr uint32_t k_MinMatchLength{ 4u };
+    constexpr size_t k_NibbleContinues{ 15u };
+    constexpr size_t k_ByteContinues{ 255u };
+    constexpr uint32_t k_HashBits{ 14u };
+    constexpr uint32_t k_NoPosition{ std::numeric_limits<uint32_t>::max() };
+    /** The furthest back an offset of two bytes can reach. */
+    constexpr size_t k_MaxOffset{ 65535u };
+    static_assert(k_SourceBlockSize - 1u <= k_MaxOffset, "a match must reach the start of its block");
+    /** A shorter line is a brace or a blank, which the matcher finds anywhere. */
+    constexpr size_t k_MinDictionaryLine{ 8u };
+
+    uint32_t LoadFour(std::string_view input, size_t position) noexcept
+    {
+        uint32_t value = 0u;
+        std::memcpy(&value, input.data() + position, sizeof(value));
+        return value;
+    }
+
+    uint32_t HashFour(uint32_t value) noexcept
+    {
+        return (value * 2654435761u) >> (32u - k_HashBits);
+    }
+
+    /** The bytes that follow a nibble of 15: 255 for each full step, then the rest. */
+    void AppendExtendedLength(std::string& out, size_t length)
+    {
+        size_t remaining = length - k_NibbleContinues;
+        while (remaining >= k_ByteContinues)
+        {
+            out.push_back(static_cast<char>(k_ByteContinues));
+            remaining -= k_ByteContinues;
+        }
+
+        out.push_back(static_cast<char>(remaining));
+    }
+
+    /** One distinct line, and how many samples hold it. */
+    struct LineCount
+    {
+        std::string_view Text;
+        uint32_t Samples{ 0u };
+        uint32_t LastSample{ 0u };
+    };
+
+    /** What storing the line once in the dictionary saves: every sample after the first that holds it. */
+    size_t DictionarySaving(const LineCount& line) noexcept
+    {
+        return static_cast<size_t>(line.Samples - 1u) * line.Text.size();
+    }
+
+    /** One sequence. With `match_length` zero it is the last one, and ends after its literals. */
+    void AppendSequence(std::string& out, std::string_view literals, size_t offset, size_t match_length)
+    {
+        const size_t matchCode = match_length == 0u ? 0u : match_length - k_MinMatchLength;
+        const size_t literalNibble = std::min(literals.size(), k_NibbleContinues);
+        const size_t matchNibble = std::min(matchCode, k_NibbleContinues);
+        out.push_back(static_cast<char>((literalNibble << 4u) | matchNibble));
+
+        if (literalNibble == k_NibbleContinues)
+        {
+            AppendExtendedLength(out, literals.size());
+        }
+
+        out.append(literals);
+        if (match_length == 0u)
+        {
+            return;
+        }
+
+        out.push_back(static_cast<char>(offset & 0xFFu));
+        out.push_back(static_cast<char>(offset >> 8u));
+        if (matchNibble == k_NibbleContinues)
+        {
+            AppendExtendedLength(out, matchCode);
+        }
+    }
+
+} // namespace
+
+std::string EncodeSourceBlock(std::string_view input, std::string_view dictionary)
+{
+    // The dictionary sits just before the input, so a match into it is an ordinary offset back.
+    std::string window;
+    if (!dictionary.empty())
+    {
+        window.reserve(dictionary.size() + input.size());
+        window.append(dictionary);
+        window.append(input);
+    }
+    const std::string_view text = dictionary.empty() ? input : std::string_view{ window };
+
+    std::string out;
+    out.reserve((input.size() / 2u) + 16u);
+
+    std::vector<uint32_t> recent(size_t{ 1u } << k_HashBits, k_NoPosition);
+    for (size_t known = 0u; known + k_MinMatchLength <= dictionary.size(); ++known)
+    {
+        recent[HashFour(LoadFour(text, known))] = static_cast<uint32_t>(known);
+    }
+
+    size_t anchor = dictionary.size();
+    size_t position = dictionary.size();
+
+    while (position + k_MinMatchLength <= text.size())
+    {
+        const uint32_t next = LoadFour(text, position);
+        uint32_t& slot = recent[HashFour(next)];
+        const uint32_t candidate = slot;
+        slot = static_cast<uint32_t>(position);
+
+        if (candidate == k_NoPosition || position - candidate > k_MaxOffset ||
+            LoadFour(text, candidate) != next)
+        {
+            ++position;
+            continue;
+        }
+
+        size_t length = k_MinMatchLength;
+        while (position + length < text.size() && text[candidate + length] == text[position + length])
+        {
+            ++length;
+        }
+
+        AppendSequence(out, text.substr(anchor, position - anchor), position - candidate, length);
+
+        // Remember the positions the match covered, so the next repeat of this text finds them.
+        const size_t end = position + length;
+        for (size_t covered = position + 1u; covered + k_MinMatchLength <= text.size() && covered < end;
+             ++covered)
+        {
+            recent[HashFour(LoadFour(text, covered))] = static_cast<uint32_t>(covered);
+        }
+
+        position = end;
+        anchor = end;
+    }
+
+    AppendSequence(out, text.substr(anchor), 0u, 0u);
+    return out;
+}
+
+std::string TrainSourceDictionary(std::span<const std::string_view> samples, size_t max_size)
+{
+    // Lines in the order the samples first hold them, and where each sits in that order.
+    std::vector<LineCount> lines;
+    std::unordered_map<std::string_view, size_t> lineIndices;
+    for (uint32_t sample = 0u; sample < samples.size(); ++sample)
+    {
+        std::string_view rest = samples[sample];
+        while (!rest.empty())
+        {
+            const size_t newline = rest.find('\n');
+            const std::string_view text = rest.substr(0u, newline == std::string_view::npos ? rest.size()
+                                                                                             : newline + 1u);
+            rest.remove_prefix(text.size());
+            if (text.size() < k_MinDictionaryLine)
+            {
+                continue;
+            }
+
+            const auto [entry, inserted] = lineIndices.try_emplace(text, lines.size());
+            if (inserted)
+            {
+                lines.push_back(LineCount{ .Text = text });
+            }
+
+            // A line one sample repeats counts once: the matcher already finds the repeat in the sample.
+            LineCount& line = lines[entry->second];
+            if (line.Samples == 0u || line.LastSample != sample)
+            {
+                ++line.Samples;
+                line.LastSample = sample;
+            }
+        }
+    }
+
+    std::vector<size_t> recurring;
+    for (size_t i = 0u; i < lines.size(); ++i)
+    {
+        if (lines[i].Samples >= 2u)
+        {
+            recurring.push_back(i);
+        }
+    }
+
+    std::ranges::stable_sort(recurring,
+                             [&lines](size_t lhs, size_t rhs)
+                             {
+                                 return DictionarySaving(lines[lhs]) > DictionarySaving(lines[rhs]);
+                             });
+
+    std::vector<size_t> kept;
+    size_t keptSize = 0u;
+    for (const size_t i : recurring)
+    {
+        if (keptSize + lines[i].Text.size() <= max_size)
+        {
+            kept.push_back(i);
+            keptSize += lines[i].Text.size();
+        }
+    }
+
+    std::ranges::sort(kept);
+    std::string dictionary;
+    dictionary.reserve(keptSize);
+    for (const size_t i : kept)
+    {
+        dictionary.append(lines[i].Text);
+    }
+
+    return dictionary;
+}
+
+} // namespace lodestone
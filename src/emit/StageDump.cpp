@@ -670,15 +670,18 @@ namespace
      * This is the only thing the `interned` dump shows that `cooked` cannot. The interner records who
      * mapped where, `FreezeModuleTables` copies out the unique entries and leaves the provenance
      * behind, so after the freeze the answer is gone. A collapse that surprises you is findable here
-     * and nowhere else. */
-    template<typename PayloadType>
+     * and nowhere else.
+     *
+     * The records hold indices, and the names come from the module here, as the dump is written. */
+    template<typename InternerType>
     void WriteProvenance(JsonWriter& writer,
                          std::string_view key,
-                         const ContentInterner<PayloadType>& interner)
+                         const InternedModule& module,
+                         const InternerType& interner)
     {
         writer.Key(key);
         writer.BeginArray();
-        for (uint32_t index = 0u; index < interner.UniqueEntries().size(); ++index)
+        for (uint32_t index = 0u; index < interner.UniqueCount(); ++index)
         {
             writer.BeginObject();
             writer.KeyUInt("index", index);
@@ -686,9 +689,10 @@ namespace
             writer.BeginArray();
             for (const ProvenanceRecord& origin : interner.OriginsOf(index))
             {
+                const ProvenanceNames names = ResolveProvenanceNames(module, origin);
                 writer.BeginObject();
-                writer.KeyString("entryPoint", origin.EntryPointName);
-                writer.KeyString("variant", origin.VariantDescription);
+                writer.KeyString("entryPoint", names.EntryPointName);
+                writer.KeyString("variant", names.VariantDescription);
                 writer.KeyUInt("variantIndex", origin.VariantIndex);
                 writer.EndObject();
             }
@@ -748,12 +752,21 @@ std::string DumpInternedModule(const InternedModule& module)
 
     writer.Key("provenance");
     writer.BeginObject();
-    WriteProvenance(writer, "sources", module.SourceInterner);
-    WriteProvenance(writer, "resources", module.ResourceInterner);
-    WriteProvenance(writer, "resourceLists", module.ResourceListInterner);
-    WriteProvenance(writer, "footprintLists", module.FootprintListInterner);
-    WriteProvenance(writer, "visibility", module.VisibilityInterner);
-    WriteProvenance(writer, "rasterStates", module.RasterInterner);
+    // A cook under --no-provenance kept nothing to list. Saying so beats six tables of empty lists,
+    // which would read as six tables where nothing mapped.
+    if (!module.SourceInterner.IsProvenanceRecorded())
+    {
+        writer.KeyBool("recorded", false);
+    }
+    else
+    {
+        WriteProvenance(writer, "sources", module, module.SourceInterner);
+        WriteProvenance(writer, "resources", module, module.ResourceInterner);
+        WriteProvenance(writer, "resourceLists", module, module.ResourceListInterner);
+        WriteProvenance(writer, "footprintLists", module, module.FootprintListInterner);
+        WriteProvenance(writer, "visibility", module, module.VisibilityInterner);
+        WriteProvenance(writer, "rasterStates", module, module.RasterInterner);
+    }
     writer.EndObject();
 
     writer.EndObject();
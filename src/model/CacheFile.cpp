@@ -0,0 +1,141 @@
+#include "model/CacheFile.hpp"
+#include "model/ContentHash.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace lodestone
+{
+
+namespace
+{
+
+    /** The numbers are in the byte order of the machine that wrote them, which is fine for a cache
+     * that never leaves that machine. */
+    struct CacheRecordHeader
+    {
+        uint32_t Magic{ 0u };
+        uint32_t Version{ 0u };
+        ContentHashValue Key{ 0u };
+        uint64_t PayloadSize{ 0u };
+        ContentHashValue PayloadHash{ 0u };
+    };
+
+    ContentHashValue HashPayload(std::string_view payload) noexcept
+    {
+        return HashBytes(std::as_bytes(std::span{ payload }));
+    }
+
+    uint64_t CurrentProcessId() noexcept
+    {
+#ifdef _WIN32
+        return static_cast<uint64_t>(::_getpid());
+#else
+        return static_cast<uint64_t>(::getpid());
+#endif
+    }
+
+} // namespace
+
+std::string SealCacheRecord(uint32_t magic, uint32_t version, ContentHashValue key, std::string_view payload)
+{
+    const CacheRecordHeader header{ .Magic = magic,
+                                    .Version = version,
+                                    .Key = key,
+                                    .PayloadSize = payload.size(),
+                                    .PayloadHash = HashPayload(payload) };
+
+    std::string record;
+    record.reserve(sizeof(header) + payload.size());
+    record.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    record.append(payload);
+    return record;
+}
+
+std::optional<std::string_view> OpenCacheRecord(std::string_view record,
+                                                uint32_t magic,
+                                                uint32_t version,
+                                                ContentHashValue key) noexcept
+{
+    if (record.size() < sizeof(CacheRecordHeader))
+    {
+        return std::nullopt;
+    }
+
+    CacheRecordHeader header;
+    std::memcpy(&header, record.data(), sizeof(header));
+    const std::string_view payload = record.substr(sizeof(header));
+
+    if (header.Magic != magic || header.Version != version || header.Key != key ||
+        header.PayloadSize != payload.size() || header.PayloadHash != HashPayload(payload))
+    {
+        return std::nullopt;
+    }
+
+    return payload;
+}
+
+std::optional<std::string> ReadCacheFile(const std::filesystem::path& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    return std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+}
+
+void WriteCacheFile(const std::filesystem::path& path, std::string_view bytes)
+{
+    std::error_code filesystemError;
+    std::filesystem::create_directories(path.parent_path(), filesystemError);
+
+    // The process and thread in the name keep two cookers sharing a cache directory, and two workers of
+    // one cook, off each other's temporary file. Thread ids alone repeat across processes.
+    const std::filesystem::path temporaryPath =
+        path.string() + std::format(".{}.{}.tmp",
+                                    CurrentProcessId(),
+                                    std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+        if (!file)
+        {
+            return;
+        }
+
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(temporaryPath, filesystemError);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, filesystemError);
+    if (filesystemError)
+    {
+        std::filesystem::remove(temporaryPath, filesystemError);
+    }
+}
+
+} // namespace lodestone
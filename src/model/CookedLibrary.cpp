@@ -1,10 +1,13 @@
 #include "model/CookedLibrary.hpp"
+#include "compile/RawLibrary.hpp"
+#include "model/ConcurrentContentInterner.hpp"
 #include "model/ContentHash.hpp"
 #include "model/ContentInterner.hpp"
 #include "CookerErrors.hpp"
 #include "permute/PermutationSpace.hpp"
 #include "model/ShaderDataSchema.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <cstdio>
@@ -79,21 +82,94 @@ ContentHashValue HashFootprintList(const std::vector<ResourceFootprint>& footpri
     return compositeHasher.Finalize();
 }
 
+namespace
+{
+
+    /** The one list of a module's interners. A switch that reaches every table goes through here, so a
+     * new interner is added once and no switch can miss it. */
+    template<typename Visitor>
+    void ForEachInterner(InternedModule& module, Visitor&& visit)
+    {
+        visit(module.SourceInterner);
+        visit(module.ResourceInterner);
+        visit(module.ResourceListInterner);
+        visit(module.FootprintListInterner);
+        visit(module.VisibilityInterner);
+        visit(module.RasterInterner);
+    }
+
+    /** Variants arrive in ascending `Index` order, so a binary search finds one. */
+    std::string_view FindVariantDescription(std::span<const LibraryVariant> variants, uint32_t variant_index)
+    {
+        const auto found =
+            std::ranges::lower_bound(variants, variant_index, std::ranges::less{}, &LibraryVariant::Index);
+        if (found == variants.end() || found->Index != variant_index)
+        {
+            return {};
+        }
+
+        return found->Description;
+    }
+
+    ProvenanceNames ResolveNamesFromTables(std::span<const LibraryEntryPoint> entry_points,
+                                           std::span<const LibraryVariant> variants,
+                                           const ProvenanceRecord& record)
+    {
+        ProvenanceNames names;
+        if (record.EntryPointIndex < entry_points.size())
+        {
+            names.EntryPointName = entry_points[record.EntryPointIndex].Name;
+        }
+        names.VariantDescription = FindVariantDescription(variants, record.VariantIndex);
+        return names;
+    }
+
+} // namespace
+
 void DisableDedupe(InternedModule& module) noexcept
 {
-    // todo: This is brittle and vulnerable to being missed whenever we add or change interners.
-    // Can we do something smarter? (that's rhetorical. but think about it maybe)
-    module.SourceInterner.Disable();
-    module.ResourceInterner.Disable();
-    module.ResourceListInterner.Disable();
-    module.FootprintListInterner.Disable();
-    module.VisibilityInterner.Disable();
-    module.RasterInterner.Disable();
+    ForEachInterner(module,
+                    [](auto& interner)
+                    {
+                        interner.Disable();
+                    });
+}
+
+void DisableProvenance(InternedModule& module) noexcept
+{
+    ForEachInterner(module,
+                    [](auto& interner)
+                    {
+                        interner.DisableProvenance();
+                    });
+}
+
+ProvenanceNames ResolveProvenanceNames(const CookedModule& module, const ProvenanceRecord& record)
+{
+    return ResolveNamesFromTables(module.EntryPoints, module.Variants, record);
+}
+
+ProvenanceNames ResolveProvenanceNames(const InternedModule& module, const ProvenanceRecord& record)
+{
+    return ResolveNamesFromTables(module.EntryPoints, module.Variants, record);
+}
+
+StagedVariantSources StageVariantSources(InternedModule& module, const RawVariant& variant)
+{
+    StagedVariantSources staged{ .VariantIndex = variant.VariantIndex, .Tickets = {} };
+    staged.Tickets.reserve(variant.EntryPoints.size());
+    for (const RawEntryPoint& entryPoint : variant.EntryPoints)
+    {
+        staged.Tickets.push_back(module.SourceInterner.Stage(entryPoint.TargetText));
+    }
+
+    return staged;
 }
 
 CookResult<void> AppendVariantToModule(InternedModule& module,
                                        const CompiledVariant& variant,
-                                       const CanonicalAssignment& canonical)
+                                       const CanonicalAssignment& canonical,
+                                       const StagedVariantSources* staged_sources)
 {
     if (variant.EntryPoints.size() != module.EntryPoints.size())
     {
@@ -106,8 +182,19 @@ CookResult<void> AppendVariantToModule(InternedModule& module,
         return std::unexpected(CookError::ReflectionMismatch);
     }
 
-    const ProvenanceRecord variantOrigin{ .EntryPointName = {},
-                                          .VariantDescription = variant.VariantDescription,
+    if (staged_sources != nullptr && (staged_sources->VariantIndex != variant.VariantIndex ||
+                                      staged_sources->Tickets.size() != variant.EntryPoints.size()))
+    {
+        std::println(stderr,
+                     "[shader_cooker] variant [{}] (index {}) was handed {} sources staged for variant {}",
+                     variant.VariantDescription,
+                     variant.VariantIndex,
+                     staged_sources->Tickets.size(),
+                     staged_sources->VariantIndex);
+        return std::unexpected(CookError::StagedSourcesMismatch);
+    }
+
+    const ProvenanceRecord variantOrigin{ .EntryPointIndex = ProvenanceRecord::k_WholeVariant,
                                           .VariantIndex = variant.VariantIndex };
 
     // Resources are per-variant (since that's the granularity we will build resources and bind
@@ -137,11 +224,13 @@ CookResult<void> AppendVariantToModule(InternedModule& module,
     for (size_t entryPointIndex = 0u; entryPointIndex < variant.EntryPoints.size(); ++entryPointIndex)
     {
         const CompiledEntryPoint& entryPoint = variant.EntryPoints[entryPointIndex];
-        const ProvenanceRecord origin{ .EntryPointName = entryPoint.Name,
-                                       .VariantDescription = variant.VariantDescription,
+        const ProvenanceRecord origin{ .EntryPointIndex = static_cast<uint32_t>(entryPointIndex),
                                        .VariantIndex = variant.VariantIndex };
 
-        const InternResult source = module.SourceInterner.Intern(entryPoint.Code, origin);
+        const InternResult source =
+            staged_sources != nullptr
+                ? module.SourceInterner.Commit(staged_sources->Tickets[entryPointIndex], origin)
+                : module.SourceInterner.Intern(entryPoint.Code, origin);
         record.SourceIndices.push_back(source.Index);
 
         const InternResult visibility =
@@ -161,8 +250,8 @@ CookResult<void> AppendVariantToModule(InternedModule& module,
 namespace
 {
 
-    template<typename PayloadType>
-    TableStatistics DescribeTable(const ContentInterner<PayloadType>& interner)
+    template<typename InternerType>
+    TableStatistics DescribeTable(const InternerType& interner)
     {
         return TableStatistics{ .HashName = interner.HashName(),
                                 .DedupeEnabled = interner.IsEnabled(),
@@ -197,22 +286,104 @@ CookedModule FreezeModuleTables(InternedModule&& interned)
     return module;
 }
 
-std::string_view ResolveSource(const CookedModule& module,
-                               const LibraryVariant& variant,
-                               size_t entry_point_index) noexcept
+namespace
 {
-    if (entry_point_index >= variant.SourceIndices.size())
+
+    /** The tables a layout resolves through. A frozen module and a module still interning both hold
+     * them, so one walk serves both, and the check during the cook reads what the frozen tables
+     * will hold. */
+    struct LayoutTables
     {
-        return {};
+        std::span<const ReflectedBinding> Resources;
+        std::span<const ResourceList> ResourceLists;
+        std::span<const FootprintList> FootprintLists;
+        std::span<const VisibilityList> VisibilityLists;
+    };
+
+    /** `source_at` reads one entry of a table that holds `source_count` sources. The frozen module keeps
+     * a contiguous table, and the concurrent interner has none until the freeze, so each caller says how
+     * to read its own. */
+    template<typename SourceAt>
+    std::string_view ResolveSourceFromTable(size_t source_count,
+                                            const SourceAt& source_at,
+                                            const LibraryVariant& variant,
+                                            size_t entry_point_index) noexcept
+    {
+        if (entry_point_index >= variant.SourceIndices.size())
+        {
+            return {};
+        }
+
+        const uint32_t sourceIndex = variant.SourceIndices[entry_point_index];
+        if (sourceIndex >= source_count)
+        {
+            return {};
+        }
+
+        return source_at(sourceIndex);
     }
 
-    const uint32_t sourceIndex = variant.SourceIndices[entry_point_index];
-    if (sourceIndex >= module.Sources.size())
+    ShaderLayoutView ResolveLayoutViewFromTables(const LayoutTables& tables,
+                                                 const LibraryVariant& variant,
+                                                 size_t entry_point_index)
     {
-        return {};
+        if (entry_point_index >= variant.VisibilityIndices.size() ||
+            variant.ResourceListIndex >= tables.ResourceLists.size() ||
+            variant.FootprintListIndex >= tables.FootprintLists.size()) [[unlikely]]
+        {
+            return {};
+        }
+
+        const uint32_t visibilityIndex = variant.VisibilityIndices[entry_point_index];
+        if (visibilityIndex >= tables.VisibilityLists.size()) [[unlikely]]
+        {
+            return {};
+        }
+
+        const ResourceList& resources = tables.ResourceLists[variant.ResourceListIndex];
+        const FootprintList& footprints = tables.FootprintLists[variant.FootprintListIndex];
+
+        std::vector<ResolvedBindingView> layoutView;
+        layoutView.reserve(tables.VisibilityLists[visibilityIndex].size());
+        for (const uint32_t localRsrcIndex : tables.VisibilityLists[visibilityIndex])
+        {
+            if (localRsrcIndex >= resources.size() || resources[localRsrcIndex] >= tables.Resources.size())
+                [[unlikely]]
+            {
+                return {};
+            }
+
+            const ResourceFootprint* footprint =
+                localRsrcIndex < footprints.size() ? &footprints[localRsrcIndex] : nullptr;
+            layoutView.emplace_back(&tables.Resources[resources[localRsrcIndex]], footprint);
+        }
+
+        return layoutView;
     }
 
-    return module.Sources[sourceIndex];
+} // namespace
+
+std::string_view ResolveSource(const CookedModule& module,
+                               const LibraryVariant& variant,
+                               size_t entry_point_index) noexcept
+{
+    const auto sourceAt = [&](uint32_t index) -> std::string_view
+    {
+        return module.Sources[index];
+    };
+    return ResolveSourceFromTable(module.Sources.size(), sourceAt, variant, entry_point_index);
+}
+
+std::string_view ResolveSource(const InternedModule& module,
+                               const LibraryVariant& variant,
+                               size_t entry_point_index) noexcept
+{
+    // The concurrent interner keeps no contiguous table until the freeze, so this reads one entry.
+    const auto sourceAt = [&](uint32_t index) -> std::string_view
+    {
+        return module.SourceInterner.EntryAt(index);
+    };
+    return ResolveSourceFromTable(module.SourceInterner.UniqueCount(), sourceAt, variant, entry_point_index);
 }
 
 ShaderLayout ResolveLayout(const CookedModule& module,
@@ -261,38 +432,22 @@ ShaderLayoutView ResolveLayoutView(const CookedModule& module,
                                    const LibraryVariant& variant,
                                    size_t entry_point_index)
 {
-    if (entry_point_index >= variant.VisibilityIndices.size() ||
-        variant.ResourceListIndex >= module.ResourceLists.size() ||
-        variant.FootprintListIndex >= module.FootprintLists.size()) [[unlikely]]
-    {
-        return {};
-    }
-
-    const uint32_t visibilityIndex = variant.VisibilityIndices[entry_point_index];
-    if (visibilityIndex >= module.VisibilityLists.size()) [[unlikely]]
-    {
-        return {};
-    }
-
-    const ResourceList& resources = module.ResourceLists[variant.ResourceListIndex];
-    const FootprintList& footprints = module.FootprintLists[variant.FootprintListIndex];
-
-    std::vector<ResolvedBindingView> layoutView;
-    layoutView.reserve(module.VisibilityLists[visibilityIndex].size());
-    for (const uint32_t localRsrcIndex : module.VisibilityLists[visibilityIndex])
-    {
-        if (localRsrcIndex >= resources.size() || resources[localRsrcIndex] >= module.Resources.size())
-            [[unlikely]]
-        {
-            return {};
-        }
-
-        const ResourceFootprint* footprint =
-            localRsrcIndex < footprints.size() ? &footprints[localRsrcIndex] : nullptr;
-        layoutView.emplace_back(&module.Resources[resources[localRsrcIndex]], footprint);
-    }
+    const LayoutTables tables{ .Resources = module.Resources,
+                               .ResourceLists = module.ResourceLists,
+                               .FootprintLists = module.FootprintLists,
+                               .VisibilityLists = module.VisibilityLists };
+    return ResolveLayoutViewFromTables(tables, variant, entry_point_index);
+}
 
-    return layoutView;
+ShaderLayoutView ResolveLayoutView(const InternedModule& module,
+                                   const LibraryVariant& variant,
+                                   size_t entry_point_index)
+{
+    const LayoutTables tables{ .Resources = module.ResourceInterner.UniqueEntries(),
+                               .ResourceLists = module.ResourceListInterner.UniqueEntries(),
+                               .FootprintLists = module.FootprintListInterner.UniqueEntries(),
+                               .VisibilityLists = module.VisibilityInterner.UniqueEntries() };
+    return ResolveLayoutViewFromTables(tables, variant, entry_point_index);
 }
 
 } // namespace lodestone
@@ -0,0 +1,88 @@
+#include "model/SourceChunker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    /** One fixed random value for each byte. splitmix64 from a constant seed, so every build of the cooker
+     * finds the same boundaries in the same text. */
+    constexpr std::array<uint64_t, 256u> MakeGearTable() noexcept
+    {
+        std::array<uint64_t, 256u> table{};
+        uint64_t state = 0x6C6F646573746F6Eu;
+        for (uint64_t& entry : table)
+        {
+            state += 0x9E3779B97F4A7C15u;
+            uint64_t mixed = state;
+            mixed = (mixed ^ (mixed >> 30u)) * 0xBF58476D1CE4E5B9u;
+            mixed = (mixed ^ (mixed >> 27u)) * 0x94D049BB133111EBu;
+            entry = mixed ^ (mixed >> 31u);
+        }
+
+        return table;
+    }
+
+    constexpr std::array<uint64_t, 256u> k_GearTable = MakeGearTable();
+
+    static_assert(std::has_single_bit(k_SourceChunkAverageSize));
+    static_assert(k_SourceChunkMinSize < k_SourceChunkAverageSize &&
+                  k_SourceChunkAverageSize < k_SourceChunkMaxSize);
+
+    /** The top bits of the hash: they mix the most bytes, where the low bits only see the last few. */
+    constexpr uint64_t k_BoundaryMask = ~(~uint64_t{ 0u } >> std::countr_zero(k_SourceChunkAverageSize));
+
+    /** Where the chunk that starts at `start` ends. */
+    size_t FindChunkEnd(std::string_view source, size_t start) noexcept
+    {
+        const size_t limit = std::min(source.size(), start + k_SourceChunkMaxSize);
+        if (limit - start <= k_SourceChunkMinSize)
+        {
+            return limit;
+        }
+
+        uint64_t hash = 0u;
+        for (size_t i = start; i < limit; ++i)
+        {
+            hash = (hash << 1u) + k_GearTable[static_cast<uint8_t>(source[i])];
+            if (i - start < k_SourceChunkMinSize || (hash & k_BoundaryMask) != 0u)
+            {
+                continue;
+            }
+
+            // The cut moves to the end of the line, so the next chunk starts one.
+            const size_t newline = source.find('\n', i);
+            return newline == std::string_view::npos || newline >= limit ? limit : newline + 1u;
+        }
+
+        return limit;
+    }
+
+} // namespace
+
+std::vector<std::string_view> SplitSourceIntoChunks(std::string_view source)
+{
+    std::vector<std::string_view> chunks;
+    chunks.reserve((source.size() / k_SourceChunkAverageSize) + 1u);
+
+    size_t start = 0u;
+    while (start < source.size())
+    {
+        const size_t end = FindChunkEnd(source, start);
+        chunks.push_back(source.substr(start, end - start));
+        start = end;
+    }
+
+    return chunks;
+}
+
+} // namespace lodestone
@@ -1,7 +1,10 @@
 #include "permute/ExternConstantScanner.hpp"
 
+#include <algorithm>
 #include <cctype>
 #include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -60,6 +63,252 @@ namespace
         return IdentifierBefore(line, assignIndex == std::string_view::npos ? line.size() : assignIndex);
     }
 
+    /** True when `name` starts at `index` of `line` as a whole identifier. */
+    bool IdentifierAt(std::string_view line, size_t index, std::string_view name) noexcept
+    {
+        if (!line.substr(index).starts_with(name))
+        {
+            return false;
+        }
+
+        const size_t end = index + name.size();
+        const bool startsWord = index == 0u || !IsIdentifierCharacter(line[index - 1u]);
+        const bool endsWord = end == line.size() || !IsIdentifierCharacter(line[end]);
+        return startsWord && endsWord;
+    }
+
+    /** How one character moves the bracket depth. `<<`, `<=`, `>=`, `>>`, and `->` are operators and
+     * never open or close a type argument list. */
+    int32_t BracketStep(std::string_view line, size_t index) noexcept
+    {
+        const char current = line[index];
+        const char previous = index > 0u ? line[index - 1u] : '\0';
+        const char next = index + 1u < line.size() ? line[index + 1u] : '\0';
+
+        if (current == '[')
+        {
+            return 1;
+        }
+
+        if (current == ']')
+        {
+            return -1;
+        }
+
+        if (current == '<' && next != '<' && next != '=' && previous != '<')
+        {
+            return 1;
+        }
+
+        if (current == '>' && next != '>' && next != '=' && previous != '>' && previous != '-')
+        {
+            return -1;
+        }
+
+        return 0;
+    }
+
+    /** True when `line` uses `name` outside string literals and comments. With `inside_brackets`, the
+     * use must also sit inside `[]` or `<>`.
+     *
+     * `depth` carries the bracket depth from the line before and leaves it for the next one, because a
+     * type argument list can span lines. A `;`, `{`, or `}` cannot sit inside one, so each sets the
+     * depth back to zero, and a `<` that compared does not leak into the rest of the file. */
+    bool LineUsesName(std::string_view line,
+                      std::string_view name,
+                      bool inside_brackets,
+                      int32_t& depth) noexcept
+    {
+        bool inString = false;
+
+        for (size_t i = 0u; i < line.size(); ++i)
+        {
+            const char current = line[i];
+            if (current == '"' && (i == 0u || line[i - 1u] != '\\'))
+            {
+                inString = !inString;
+                continue;
+            }
+
+            if (inString)
+            {
+                continue;
+            }
+
+            if (line.substr(i).starts_with("//"))
+            {
+                return false;
+            }
+
+            if (current == ';' || current == '{' || current == '}')
+            {
+                depth = 0;
+                continue;
+            }
+
+            depth = std::max(depth + BracketStep(line, i), 0);
+
+            if (IdentifierAt(line, i, name) && (!inside_brackets || depth > 0))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /** The `=` that starts an initializer on `line`, or npos. `==`, `!=`, `<=`, and `>=` compare. */
+    size_t AssignmentIndex(std::string_view line) noexcept
+    {
+        for (size_t i = 0u; i < line.size(); ++i)
+        {
+            const char previous = i > 0u ? line[i - 1u] : '\0';
+            const char next = i + 1u < line.size() ? line[i + 1u] : '\0';
+            if (line[i] == '=' && next != '=' && previous != '=' && previous != '!' && previous != '<' &&
+                previous != '>')
+            {
+                return i;
+            }
+        }
+
+        return std::string_view::npos;
+    }
+
+    /** True when `line` holds `word` as a whole identifier anywhere. */
+    bool ContainsIdentifier(std::string_view line, std::string_view word) noexcept
+    {
+        for (size_t index = line.find(word); index != std::string_view::npos;
+             index = line.find(word, index + 1u))
+        {
+            if (IdentifierAt(line, index, word))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /** A name that `line` gives a value to: a constant with an initializer, or a macro. */
+    struct ValueDeclaration
+    {
+        std::string_view Name;
+        /** Where the value text starts on the line. */
+        size_t ValueStart{ 0u };
+        bool IsMacro{ false };
+    };
+
+    /** The constant or macro that `line` declares with a value. The name is empty when it declares
+     * none. A `const` line declares the identifier that ends at its `=`, and an `extern` one is no
+     * different; a `#define` declares the identifier after the directive. */
+    ValueDeclaration ValueDeclarationOnLine(std::string_view line) noexcept
+    {
+        constexpr std::string_view k_DefineDirective{ "#define" };
+        const std::string_view trimmed = TrimWhitespace(line);
+        if (trimmed.starts_with(k_DefineDirective))
+        {
+            size_t nameStart = line.find(k_DefineDirective) + k_DefineDirective.size();
+            while (nameStart < line.size() && !IsIdentifierCharacter(line[nameStart]))
+            {
+                ++nameStart;
+            }
+
+            size_t nameEnd = nameStart;
+            while (nameEnd < line.size() && IsIdentifierCharacter(line[nameEnd]))
+            {
+                ++nameEnd;
+            }
+
+            return ValueDeclaration{ .Name = line.substr(nameStart, nameEnd - nameStart),
+                                     .ValueStart = nameEnd,
+                                     .IsMacro = true };
+        }
+
+        const size_t assignIndex = AssignmentIndex(line);
+        if (assignIndex == std::string_view::npos ||
+            !ContainsIdentifier(line.substr(0u, assignIndex), "const"))
+        {
+            return {};
+        }
+
+        return ValueDeclaration{ .Name = IdentifierBefore(line, assignIndex),
+                                 .ValueStart = assignIndex + 1u };
+    }
+
+    void AddAlias(std::vector<std::string_view>& names, std::string_view alias)
+    {
+        if (!alias.empty() && std::ranges::find(names, alias) == names.end())
+        {
+            names.push_back(alias);
+        }
+    }
+
+    /** True when `source` uses `name` inside `[]` or `<>`. Each constant or macro whose value text
+     * uses `name` goes into `aliases`, because its own uses carry the value on.
+     *
+     * A constant's value runs to its `;`, and a macro's to the end of a line that does not end in `\`.
+     * Brackets inside a value do not count: they index or compare, and only the alias's uses place
+     * anything. */
+    bool ScanLayoutUses(std::string_view source,
+                        std::string_view name,
+                        std::vector<std::string_view>& aliases)
+    {
+        int32_t depth = 0;
+        ValueDeclaration open;
+        size_t lineStart = 0u;
+        while (lineStart < source.size())
+        {
+            const std::string_view line = NextLine(source, lineStart);
+
+            size_t valueStart = 0u;
+            if (open.Name.empty())
+            {
+                open = ValueDeclarationOnLine(line);
+                if (open.Name.empty())
+                {
+                    if (LineUsesName(line, name, true, depth))
+                    {
+                        return true;
+                    }
+
+                    continue;
+                }
+
+                // The type in front of the name can hold an extent or a type argument of its own.
+                valueStart = open.ValueStart;
+                if (LineUsesName(line.substr(0u, valueStart), name, true, depth))
+                {
+                    return true;
+                }
+            }
+
+            const size_t valueEnd =
+                open.IsMacro ? line.size() : std::min(line.find(';', valueStart), line.size());
+            int32_t valueDepth = 0;
+            if (open.Name != name &&
+                LineUsesName(line.substr(valueStart, valueEnd - valueStart), name, false, valueDepth))
+            {
+                AddAlias(aliases, open.Name);
+            }
+
+            const bool valueContinues =
+                open.IsMacro ? TrimWhitespace(line).ends_with('\\') : valueEnd == line.size();
+            if (valueContinues)
+            {
+                continue;
+            }
+
+            open = {};
+            depth = 0;
+            if (LineUsesName(line.substr(valueEnd), name, true, depth))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
 } // namespace
 
 std::vector<ExternConstantDeclaration> ScanExternConstants(std::string_view source)
@@ -116,6 +365,30 @@ bool DeclaresExternConstantNamed(std::string_view source, std::string_view name)
     return false;
 }
 
+bool NameMayAffectLayout(std::string_view source, std::string_view name)
+{
+    return NameMayAffectLayout(std::span<const std::string_view>{ &source, 1u }, name);
+}
+
+bool NameMayAffectLayout(std::span<const std::string_view> sources, std::string_view name)
+{
+    std::vector<std::string_view> names{ name };
+    for (size_t i = 0u; i < names.size(); ++i)
+    {
+        // Copied, because a scan can grow the list under it.
+        const std::string_view current = names[i];
+        for (const std::string_view source : sources)
+        {
+            if (ScanLayoutUses(source, current, names))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 std::string_view TrimWhitespace(std::string_view text) noexcept
 {
     while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())) != 0)
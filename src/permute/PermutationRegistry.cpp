@@ -5,7 +5,12 @@
 #include "permute/PermutationValue.hpp"
 
 #include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
 #include <string_view>
+#include <utility>
 
 // The compiled-in registry of every module that declares a permutation space.
 //
@@ -70,32 +75,102 @@ namespace
     const std::array<ModuleSpaceEntry, 1> k_ModuleSpaces{ ModuleSpaceEntry{
         .ModuleName = "OceanFft", .Space = &k_OceanFftSpace, .Policy = &k_OceanFftPolicy } };
 
+    /** A space added at run time. It owns its name, its space and its policy. */
+    struct RegisteredModule
+    {
+        std::string ModuleName;
+        PermutationSpace Space;
+        ModulePolicy Policy;
+    };
+
+    /** A deque, because it never moves an element it already holds. A lookup hands out pointers into
+     * these entries, and a later registration must not invalidate them. */
+    struct RuntimeRegistry
+    {
+        std::mutex Mutex;
+        std::deque<RegisteredModule> Modules;
+    };
+
+    RuntimeRegistry& GetRuntimeRegistry()
+    {
+        static RuntimeRegistry registry;
+        return registry;
+    }
+
+    const ModuleSpaceEntry* FindCompiledInEntry(std::string_view module_name) noexcept
+    {
+        for (const ModuleSpaceEntry& entry : k_ModuleSpaces)
+        {
+            if (entry.ModuleName == module_name)
+            {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /** The caller holds the registry's mutex. */
+    const RegisteredModule* FindRegisteredModule(const RuntimeRegistry& registry,
+                                                 std::string_view module_name) noexcept
+    {
+        for (const RegisteredModule& module : registry.Modules)
+        {
+            if (module.ModuleName == module_name)
+            {
+                return &module;
+            }
+        }
+
+        return nullptr;
+    }
+
 } // namespace
 
 const ModulePolicy* FindPolicyForModule(std::string_view module_name) noexcept
 {
-    for (const ModuleSpaceEntry& entry : k_ModuleSpaces)
+    if (const ModuleSpaceEntry* entry = FindCompiledInEntry(module_name))
     {
-        if (entry.ModuleName == module_name)
-        {
-            return entry.Policy;
-        }
+        return entry->Policy;
     }
 
-    return &k_EmptyPolicy;
+    RuntimeRegistry& registry = GetRuntimeRegistry();
+    const std::scoped_lock lock{ registry.Mutex };
+    const RegisteredModule* module = FindRegisteredModule(registry, module_name);
+    return module != nullptr ? &module->Policy : &k_EmptyPolicy;
 }
 
 const PermutationSpace* FindPermutationSpaceForModule(std::string_view module_name) noexcept
 {
-    for (const ModuleSpaceEntry& entry : k_ModuleSpaces)
+    if (const ModuleSpaceEntry* entry = FindCompiledInEntry(module_name))
     {
-        if (entry.ModuleName == module_name)
-        {
-            return entry.Space;
-        }
+        return entry->Space;
+    }
+
+    RuntimeRegistry& registry = GetRuntimeRegistry();
+    const std::scoped_lock lock{ registry.Mutex };
+    const RegisteredModule* module = FindRegisteredModule(registry, module_name);
+    return module != nullptr ? &module->Space : &k_EmptySpace;
+}
+
+bool RegisterPermutationSpace(std::string module_name, PermutationSpace&& space, uint32_t max_variants)
+{
+    if (FindCompiledInEntry(module_name) != nullptr)
+    {
+        return false;
+    }
+
+    RuntimeRegistry& registry = GetRuntimeRegistry();
+    const std::scoped_lock lock{ registry.Mutex };
+    if (FindRegisteredModule(registry, module_name) != nullptr)
+    {
+        return false;
     }
 
-    return &k_EmptySpace;
+    registry.Modules.push_back(RegisteredModule{ .ModuleName = std::move(module_name),
+                                                 .Space = std::move(space),
+                                                 .Policy = ModulePolicy{ .MaxVariants = max_variants } });
+    return true;
 }
 
 } // namespace lodestone
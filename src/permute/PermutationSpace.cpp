@@ -167,20 +167,21 @@ CookResult<std::vector<PermutationAssignment>> PermutationSpace::EnumerateActive
             const PermutationAxis* parentAxis = ParentOf(axis);
             if (parentAxis != nullptr)
             {
-                // Read the current list of active axes to see if the parent is active, and retrieve
-                // it if it is. If the parent is not active (present), there is an axis declaration
-                // order error.
-                const PermutationBinding* parentBinding = FindBindingForAxis(partial, parentAxis);
-                if (parentBinding == nullptr)
+                // A parent declared after its child has not been expanded yet, so nothing can say whether
+                // it is active. That is an axis declaration order error.
+                if (parentAxis >= &axis)
                 {
                     // todo-ship: This is a user error, and should be evaluated during initial load when we're
                     // already traversing permutations to check for undriven values, etc. Flatten this
                     // calltree to use less Results
                     return std::unexpected(CookError::PermutationParentAxisMissing);
                 }
-                // If the parent is active, but not set to the required value, close partial off
-                // for this current partial (where parent axis was evaluated to the wrong value)
-                if (parentBinding->Value != axis.RequiredParentValue)
+                // Read the current list of active axes to see if the parent is active. A parent that is
+                // absent was itself disabled by its own parent, and that disables this axis too: a chain
+                // is only as active as its first link. An absent parent, or a parent set to the wrong
+                // value, closes off this partial for the current axis.
+                const PermutationBinding* parentBinding = FindBindingForAxis(partial, parentAxis);
+                if (parentBinding == nullptr || parentBinding->Value != axis.RequiredParentValue)
                 {
                     expanded.push_back(partial);
                     continue;
@@ -0,0 +1,33 @@
+#include "ChainPermutationSpace.hpp"
+#include "emit/ShaderLibraryEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+
+#include <fstream>
+#include <ios>
+#include <print>
+#include <string>
+
+// Writes the generated header section of the chain space to the path it is given, wrapped the way
+// EmitShaderLibraryHeader wraps it. GeneratedCanonicalizeTest compiles against the result, so the
+// generated `Canonicalize` and `VariantIndex` are checked as C++, not as text.
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::println(stderr, "usage: ChainCanonicalizeEmitter <output header>");
+        return 1;
+    }
+
+    lodestone::CookedModule module;
+    module.Name = std::string{ lodestone::tests::k_ChainModuleName };
+    module.Space = &lodestone::tests::ChainPermutationSpace();
+
+    std::string header = "#pragma once\n#include <cstdint>\n\nnamespace lodestone::shaders\n{\n\n";
+    header += lodestone::EmitShaderLibraryHeaderSection(module);
+    header += "} // namespace lodestone::shaders\n";
+
+    std::ofstream file{ argv[1], std::ios::binary | std::ios::trunc };
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    return file ? 0 : 1;
+}
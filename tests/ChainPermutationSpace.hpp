@@ -0,0 +1,46 @@
+#pragma once
+#ifndef LODESTONE_TESTS_CHAIN_PERMUTATION_SPACE_HPP
+#define LODESTONE_TESTS_CHAIN_PERMUTATION_SPACE_HPP
+#include "permute/PermutationAxis.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "permute/PermutationValue.hpp"
+
+// The space that ChainCanonicalizeEmitter writes C++ for, and that GeneratedCanonicalizeTests checks
+// that C++ against. Both include it, so the two cannot drift apart.
+//
+// Each dependent axis is enabled by its parent's default value. When CHAIN_ENABLED is false,
+// CHAIN_MODE is reset to 0, the value that enables CHAIN_TAPS, and CHAIN_TAPS is reset to 4, the value
+// that enables CHAIN_WIDE. Only an axis that knows its parent was inactive disables itself, so this is
+// the space where a check of the parent's value alone goes wrong.
+namespace lodestone::tests
+{
+
+inline constexpr std::string_view k_ChainModuleName{ "Chain" };
+
+inline const PermutationSpace& ChainPermutationSpace()
+{
+    static const PermutationSpace space{
+        std::string{ k_ChainModuleName },
+        { PermutationAxis{ "CHAIN_ENABLED",
+                           { PermutationValue{ false }, PermutationValue{ true } },
+                           PermutationAxis::k_NoParent,
+                           PermutationValue{} },
+          PermutationAxis{ "CHAIN_MODE",
+                           { PermutationValue{ 0u }, PermutationValue{ 1u }, PermutationValue{ 2u } },
+                           0,
+                           PermutationValue{ true } },
+          PermutationAxis{ "CHAIN_TAPS",
+                           { PermutationValue{ 4u }, PermutationValue{ 8u } },
+                           1,
+                           PermutationValue{ 0u } },
+          PermutationAxis{ "CHAIN_WIDE",
+                           { PermutationValue{ false }, PermutationValue{ true } },
+                           2,
+                           PermutationValue{ 4u } } }
+    };
+    return space;
+}
+
+} // namespace lodestone::tests
+
+#endif // !LODESTONE_TESTS_CHAIN_PERMUTATION_SPACE_HPP
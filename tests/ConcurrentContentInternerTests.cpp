@@ -0,0 +1,239 @@
+#include "model/ConcurrentContentInterner.hpp"
+#include "model/ContentHash.hpp"
+#include "model/ContentInterner.hpp"
+#include "TestHarness.hpp"
+
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// The concurrent interner must give the output a serial interner gives. Many threads stage, one thread
+// commits in order, and every index, origin and counter is compared against a `ContentInterner` fed the
+// same sequence. The hash functions here are poor on purpose, so buckets hold several entries and the
+// byte comparison decides, exactly as in `ContentInternerTests`.
+
+using lodestone::ConcurrentContentInterner;
+using lodestone::ContentHashValue;
+using lodestone::ContentInterner;
+using lodestone::InternerStatistics;
+using lodestone::InternResult;
+using lodestone::ProvenanceRecord;
+
+namespace
+{
+
+using Interner = ConcurrentContentInterner<std::string>;
+
+ContentHashValue HashToOneBucket(const std::string& payload) noexcept
+{
+    static_cast<void>(payload);
+    return 0x1234u;
+}
+
+/** Three buckets, in three shards, each holding payloads that differ. */
+ContentHashValue HashByLength(const std::string& payload) noexcept
+{
+    return payload.size() % 3u;
+}
+
+ProvenanceRecord MakeOrigin(uint32_t artifact)
+{
+    return ProvenanceRecord{ .EntryPointIndex = artifact % 3u, .VariantIndex = artifact };
+}
+
+constexpr uint32_t k_ArtifactCount = 400u;
+constexpr uint32_t k_StagingThreads = 8u;
+constexpr uint32_t k_Rounds = 16u;
+
+/** Thirty distinct payloads, repeated in an order no thread schedule follows. */
+std::string MakePayload(uint32_t artifact)
+{
+    const uint32_t distinct = (artifact * 7u + artifact / 13u) % 30u;
+    return std::format("source {}{}", distinct, std::string(distinct % 5u, '+'));
+}
+
+/** Three thousand distinct payloads, so every shard fills several blocks of entries and grows its slot
+ * table more than once. */
+constexpr uint32_t k_ManyArtifactCount = 4000u;
+
+std::string MakeManyPayload(uint32_t artifact)
+{
+    return std::format("source {}", (artifact * 7u + artifact / 13u) % 3000u);
+}
+
+/** FNV-1a, so the payloads of `MakeManyPayload` spread over every shard. */
+ContentHashValue HashByText(const std::string& payload) noexcept
+{
+    ContentHashValue hash = 0xCBF29CE484222325ull;
+    for (const char character : payload)
+    {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+using PayloadMaker = std::string (*)(uint32_t);
+
+bool SameStatistics(const InternerStatistics& left, const InternerStatistics& right)
+{
+    return left.ArtifactsSeen == right.ArtifactsSeen && left.UniqueEntries == right.UniqueEntries &&
+           left.HashCollisions == right.HashCollisions && left.ByteComparisons == right.ByteComparisons;
+}
+
+bool SameOrigins(std::span<const ProvenanceRecord> left, std::span<const ProvenanceRecord> right)
+{
+    if (left.size() != right.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0u; i < left.size(); ++i)
+    {
+        if (left[i].VariantIndex != right[i].VariantIndex ||
+            left[i].EntryPointIndex != right[i].EntryPointIndex)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** Stages every artifact from several threads, each walking the sequence from a different point, and
+ * commits in sequence order. Returns false at the first difference from the serial interner. */
+bool MatchesSerialInterner(Interner::HashFunction hash_function,
+                           bool dedupe_enabled,
+                           PayloadMaker make_payload,
+                           uint32_t artifact_count)
+{
+    ContentInterner<std::string> serial{ hash_function, "test" };
+    Interner concurrent{ hash_function, "test" };
+    if (!dedupe_enabled)
+    {
+        serial.Disable();
+        concurrent.Disable();
+    }
+
+    std::vector<Interner::Ticket> tickets(artifact_count);
+    {
+        std::vector<std::jthread> threads;
+        for (uint32_t t = 0u; t < k_StagingThreads; ++t)
+        {
+            threads.emplace_back(
+                [&tickets, &concurrent, make_payload, artifact_count, t]
+                {
+                    for (uint32_t i = t; i < artifact_count; i += k_StagingThreads)
+                    {
+                        const uint32_t artifact = artifact_count - 1u - i;
+                        tickets[artifact] = concurrent.Stage(make_payload(artifact));
+                    }
+                });
+        }
+    }
+
+    for (uint32_t artifact = 0u; artifact < artifact_count; ++artifact)
+    {
+        const InternResult expected = serial.Intern(make_payload(artifact), MakeOrigin(artifact));
+        const InternResult actual = concurrent.Commit(tickets[artifact], MakeOrigin(artifact));
+        if (expected.Index != actual.Index || expected.WasNew != actual.WasNew)
+        {
+            return false;
+        }
+    }
+
+    if (!SameStatistics(serial.Statistics(), concurrent.Statistics()) ||
+        serial.UniqueCount() != concurrent.UniqueCount())
+    {
+        return false;
+    }
+
+    for (uint32_t index = 0u; index < serial.UniqueCount(); ++index)
+    {
+        if (serial.UniqueEntries()[index] != concurrent.EntryAt(index) ||
+            !SameOrigins(serial.OriginsOf(index), concurrent.OriginsOf(index)))
+        {
+            return false;
+        }
+    }
+
+    return serial.ConsumeTable() == concurrent.ConsumeTable();
+}
+
+bool MatchesEveryRound(Interner::HashFunction hash_function,
+                       bool dedupe_enabled,
+                       PayloadMaker make_payload = &MakePayload,
+                       uint32_t artifact_count = k_ArtifactCount)
+{
+    for (uint32_t round = 0u; round < k_Rounds; ++round)
+    {
+        if (!MatchesSerialInterner(hash_function, dedupe_enabled, make_payload, artifact_count))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    lodestone::tests::TestRunner runner{ "ConcurrentContentInternerTests" };
+
+    runner.BeginSection("staging on many threads gives the serial interner's output");
+    runner.Check(MatchesEveryRound(&HashToOneBucket, true),
+                 "with every payload in one bucket, indices, origins and counters match the serial interner");
+    runner.Check(MatchesEveryRound(&HashByLength, true),
+                 "with payloads spread over several shards, everything matches the serial interner");
+
+    runner.BeginSection("a shard that outgrows its first block and its first table loses nothing");
+    runner.Check(MatchesEveryRound(&HashByText, true, &MakeManyPayload, k_ManyArtifactCount),
+                 "with thousands of distinct hashes, everything matches the serial interner");
+    runner.Check(MatchesEveryRound(&HashByLength, true, &MakeManyPayload, k_ManyArtifactCount),
+                 "a chain that runs across many blocks keeps its order and its counters");
+    runner.Check(MatchesEveryRound(&HashByText, false, &MakeManyPayload, k_ManyArtifactCount),
+                 "the identity path fills blocks in every shard without losing an entry");
+
+    runner.BeginSection("the identity path stays correct");
+    runner.Check(MatchesEveryRound(&HashToOneBucket, false),
+                 "with dedupe off, every artifact takes its own index, in commit order");
+
+    Interner disabled{ &HashToOneBucket, "test" };
+    disabled.Disable();
+    const InternResult first = disabled.Intern("same", MakeOrigin(0u));
+    const InternResult second = disabled.Intern("same", MakeOrigin(1u));
+    runner.Check(!disabled.IsEnabled(), "Disable turns collapsing off");
+    runner.Check(first.Index == 0u && second.Index == 1u && second.WasNew,
+                 "with dedupe off, two equal payloads take two indices");
+    runner.Check(disabled.Statistics().ByteComparisons == 0u,
+                 "with dedupe off, no byte comparison runs at all");
+
+    runner.BeginSection("only a commit gives an index");
+    Interner interner{ &HashToOneBucket, "constant-for-test" };
+    const Interner::Ticket abandoned = interner.Stage("staged and dropped");
+    const Interner::Ticket kept = interner.Stage("staged and kept");
+    static_cast<void>(abandoned);
+    const InternResult committed = interner.Commit(kept, MakeOrigin(7u));
+    runner.Check(committed.Index == 0u && committed.WasNew,
+                 "the first commit takes index 0, whatever was staged before it");
+    runner.Check(interner.UniqueCount() == 1u && interner.Statistics().UniqueEntries == 1u,
+                 "a staged entry that never commits is not in the table");
+    runner.Check(interner.Statistics().HashCollisions == 0u,
+                 "an uncommitted entry in the bucket is not counted as a collision");
+
+    runner.BeginSection("a moved interner keeps its tickets");
+    const Interner::Ticket beforeMove = interner.Stage("staged before the move");
+    Interner moved{ std::move(interner) };
+    const InternResult afterMove = moved.Commit(beforeMove, MakeOrigin(8u));
+    runner.Check(afterMove.Index == 1u && moved.EntryAt(1u) == "staged before the move",
+                 "a ticket staged before a move commits into the moved interner");
+    runner.Check(moved.HashName() == "constant-for-test", "the interner reports the hash it used");
+
+    return runner.Report();
+}
@@ -6,6 +6,7 @@
 #include <format>
 #include <span>
 #include <string>
+#include <string_view>
 
 // Rule 1 of the cooker: a hash never decides that two artifacts are equal. It selects a bucket, and a
 // byte comparison decides. Every test here supplies a hash function that returns one constant, so
@@ -29,14 +30,27 @@ ContentHashValue HashToOneBucket(const std::string& payload) noexcept
     return 0x1234u;
 }
 
+/** FNV-1a of all but the last character. Payloads that differ only in their last digit share a hash,
+ * so every bucket holds a chain of up to ten, and there are enough buckets that the table must grow. */
+ContentHashValue HashAllButLastCharacter(const std::string& payload) noexcept
+{
+    ContentHashValue hash = 0xCBF29CE484222325ull;
+    for (const char c : std::string_view{ payload }.substr(0u, payload.size() - 1u))
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
 ProvenanceRecord MakeOrigin(uint32_t variant_index)
 {
-    return ProvenanceRecord{ .EntryPointName = "MainCS",
-                             .VariantDescription = std::format("variant {}", variant_index),
-                             .VariantIndex = variant_index };
+    return ProvenanceRecord{ .EntryPointIndex = 0u, .VariantIndex = variant_index };
 }
 
 constexpr uint32_t k_PayloadCount = 10u;
+/** Far past the first growth of the slot table. */
+constexpr uint32_t k_GrowthPayloadCount = 5000u;
 
 std::string MakePayload(uint32_t index)
 {
@@ -109,6 +123,38 @@ int main()
     runner.Check(disabled.Statistics().ByteComparisons == 0u,
                  "with dedupe off, no byte comparison runs at all");
 
+    runner.BeginSection("provenance can be skipped");
+    ContentInterner<std::string> unrecorded{ &HashToOneBucket, "constant-for-test" };
+    unrecorded.DisableProvenance();
+    const InternResult unrecordedFirst = unrecorded.Intern(MakePayload(0u), MakeOrigin(0u));
+    const InternResult unrecordedRepeat = unrecorded.Intern(MakePayload(0u), MakeOrigin(1u));
+    runner.Check(!unrecorded.IsProvenanceRecorded(), "DisableProvenance turns the records off");
+    runner.Check(unrecordedFirst.Index == 0u && unrecordedRepeat.Index == 0u && !unrecordedRepeat.WasNew,
+                 "without provenance, equal payloads still collapse");
+    runner.Check(unrecorded.OriginsOf(0u).empty(), "without provenance, an entry lists no origins");
+    runner.Check(unrecorded.Statistics().ArtifactsSeen == 2u, "without provenance, the counters still count");
+
+    runner.BeginSection("the table grows and keeps every chain");
+    ContentInterner<std::string> grown{ &HashAllButLastCharacter, "fnv-for-test" };
+    bool everyFirstInternIsNew = true;
+    for (uint32_t i = 0u; i < k_GrowthPayloadCount; ++i)
+    {
+        const InternResult result = grown.Intern(MakePayload(i), MakeOrigin(i));
+        everyFirstInternIsNew = everyFirstInternIsNew && result.WasNew && result.Index == i;
+    }
+
+    bool everyRepeatFindsItsEntry = true;
+    for (uint32_t i = 0u; i < k_GrowthPayloadCount; ++i)
+    {
+        const InternResult result = grown.Intern(MakePayload(i), MakeOrigin(i));
+        everyRepeatFindsItsEntry = everyRepeatFindsItsEntry && !result.WasNew && result.Index == i;
+    }
+
+    runner.Check(everyFirstInternIsNew, "thousands of distinct payloads take dense indices through growth");
+    runner.Check(everyRepeatFindsItsEntry, "after growth, each repeat finds the entry it matched");
+    runner.Check(grown.UniqueCount() == k_GrowthPayloadCount, "growth neither lost nor added an entry");
+    runner.Check(grown.Statistics().HashCollisions > 0u, "the payloads really did share buckets");
+
     runner.BeginSection("the hash name reaches the report");
     runner.Check(interner.HashName() == "constant-for-test", "the interner reports the hash it used");
 
@@ -1,15 +1,196 @@
 #include "driver/CookerDriver.hpp"
+#include "compile/SlangCompiler.hpp"
 #include "CookerErrors.hpp"
+#include "CookTrace.hpp"
 #include "driver/CookerOptions.hpp"
+#include "driver/WarmCompilerCache.hpp"
 #include "emit/OutputSink.hpp"
+#include "TestHarness.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <ios>
 #include <print>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+namespace
+{
+
+/** Runs the warm recook checks instead of one cook. It must be the first argument, and the rest is an
+ * ordinary cooker command line naming one module. */
+constexpr std::string_view k_WarmRecookSwitch = "--warm-recook";
+constexpr std::string_view k_AttributesFileName = "LodestoneAttributes.slang";
+
+/** Copies the module's directory into `scratch/module`, and the attributes module into `scratch`, where
+ * the compiler's shared search path finds it. The checks rewrite a dependency, and the asset tree must
+ * not change. Returns the path of the copied module, or an empty path when the copy failed. */
+std::filesystem::path CopyModuleToScratch(const std::filesystem::path& module_path,
+                                          const std::filesystem::path& scratch)
+{
+    std::error_code error;
+    std::filesystem::remove_all(scratch, error);
+    std::filesystem::create_directories(scratch / "module", error);
+
+    const std::filesystem::path sourceDirectory = std::filesystem::absolute(module_path).parent_path();
+    for (const std::filesystem::directory_entry& entry :
+         std::filesystem::directory_iterator{ sourceDirectory })
+    {
+        if (entry.is_regular_file())
+        {
+            std::filesystem::copy_file(entry.path(), scratch / "module" / entry.path().filename(), error);
+        }
+    }
+
+    for (std::filesystem::path directory = sourceDirectory;
+         !directory.empty() && directory != directory.root_path();
+         directory = directory.parent_path())
+    {
+        if (std::filesystem::exists(directory / k_AttributesFileName))
+        {
+            std::filesystem::copy_file(directory / k_AttributesFileName,
+                                       scratch / k_AttributesFileName,
+                                       std::filesystem::copy_options::overwrite_existing,
+                                       error);
+            break;
+        }
+    }
+
+    return error ? std::filesystem::path{} : scratch / "module" / module_path.filename();
+}
+
+bool SameOutput(const lodestone::MemoryOutputSink& left, const lodestone::MemoryOutputSink& right)
+{
+    return left.GetContent() == right.GetContent() && left.GetArtifacts() == right.GetArtifacts();
+}
+
+/** Cooks the module of `options` four times through one warm cache. The options should turn off the
+ * incremental cook and the variant cache, or the later cooks reuse output and never reach a compiler,
+ * and ask for two compile workers, so the pool has one worker beside the module's own compiler. */
+int RunWarmRecookChecks(lodestone::CookerOptions options)
+{
+    using namespace lodestone;
+
+    tests::TestRunner runner{ "WarmRecookTest" };
+    runner.Check(options.ModulePaths.size() == 1u, "the command line names one module");
+    if (options.ModulePaths.size() != 1u)
+    {
+        return runner.Report();
+    }
+
+    const std::filesystem::path modulePath =
+        CopyModuleToScratch(options.ModulePaths.front(), options.OutputPath.parent_path() / "warm_module");
+    runner.Check(!modulePath.empty(), "the module copies into a scratch directory");
+    if (modulePath.empty())
+    {
+        return runner.Report();
+    }
+
+    options.ModulePaths = { modulePath };
+    const std::string primaryName = options.OutputPath.filename().string();
+    WarmCompilerCache warmCompilers;
+
+    runner.BeginSection("a second cook of an unchanged module takes its loaded compiler");
+    MemoryOutputSink coldSink{ primaryName };
+    const CookResult<CookStatistics> cold = RunCook(options, coldSink, warmCompilers);
+    const WarmCompilerStatistics afterCold = warmCompilers.GetStatistics();
+    runner.Check(cold.has_value(), "the first cook succeeds");
+    runner.Check(afterCold.ModulesLoaded == 1u && afterCold.ModulesWarm == 0u &&
+                     afterCold.GlobalSessionsCreated >= 1u,
+                 "the first cook loads the module in a new global session");
+    runner.Check(afterCold.WorkersLoaded == 1u && afterCold.WorkersWarm == 0u,
+                 "the first cook loads the module on its pool worker as well");
+
+    MemoryOutputSink warmSink{ primaryName };
+    const CookResult<CookStatistics> warm = RunCook(options, warmSink, warmCompilers);
+    const WarmCompilerStatistics afterWarm = warmCompilers.GetStatistics();
+    runner.Check(warm.has_value(), "the second cook succeeds");
+    runner.Check(afterWarm.ModulesWarm == afterCold.ModulesWarm + 1u &&
+                     afterWarm.ModulesLoaded == afterCold.ModulesLoaded &&
+                     afterWarm.GlobalSessionsReused > afterCold.GlobalSessionsReused,
+                 "the second cook takes the module loaded, global session and all");
+    runner.Check(afterWarm.WorkersLoaded == afterCold.WorkersLoaded &&
+                     afterWarm.WorkersWarm == afterCold.WorkersWarm + 1u,
+                 "the second cook loads the module on no worker either");
+    runner.Check(SameOutput(coldSink, warmSink), "the warm cook writes the same bytes as the cold one");
+
+    // A warm compiler keeps its counters in the object it kept. Each cook must report its own.
+    if (cold && warm)
+    {
+        runner.Check(warm.value().PhaseTimes.Get(CookPhase::Setup) == 0.0,
+                     "the warm cook reports no setup, because it did none");
+        // Which worker takes which variant changes from cook to cook, so a warm worker can still miss
+        // a constant it never parsed. Only the number of lookups is fixed.
+        runner.Check(warm.value().ConstantModuleCacheHits + warm.value().ConstantModuleCacheMisses ==
+                         cold.value().ConstantModuleCacheHits + cold.value().ConstantModuleCacheMisses,
+                     "the warm cook counts its own constant module lookups");
+    }
+
+    runner.BeginSection("an edited dependency loads the module again");
+    SlangCompilerCreateInfo createInfo;
+    createInfo.ModulePath = modulePath;
+    createInfo.ModuleCacheDirectory = options.ModuleCacheDirectory;
+    createInfo.OptimizationLevel = options.OptimizationLevel;
+    createInfo.MultithreadEntryPointCodegen = options.MultithreadEntryPointCodegen;
+
+    WarmCompilerCache::Checkout unchanged = warmCompilers.CheckOutModule(createInfo);
+    runner.Check(unchanged.IsLoaded, "a module whose files still read the same checks out loaded");
+    runner.Check(unchanged.Workers.size() == 1u, "its pool worker checks out loaded with it");
+    warmCompilers.ReturnModule(
+        createInfo, std::move(unchanged.Compiler), unchanged.IsLoaded, std::move(unchanged.Workers));
+
+    {
+        std::ofstream dependency{ modulePath.parent_path().parent_path() / k_AttributesFileName,
+                                  std::ios::app };
+        dependency << "\n// Edited by WarmRecookTest.\n";
+    }
+
+    WarmCompilerCache::Checkout edited = warmCompilers.CheckOutModule(createInfo);
+    runner.Check(!edited.IsLoaded && edited.Workers.empty(),
+                 "after a dependency is rewritten, the module checks out unloaded, and without workers");
+    warmCompilers.ReturnModule(
+        createInfo, std::move(edited.Compiler), edited.IsLoaded, std::move(edited.Workers));
+
+    MemoryOutputSink reloadedSink{ primaryName };
+    const WarmCompilerStatistics beforeReload = warmCompilers.GetStatistics();
+    runner.Check(RunCook(options, reloadedSink, warmCompilers).has_value() &&
+                     warmCompilers.GetStatistics().ModulesLoaded == beforeReload.ModulesLoaded + 1u &&
+                     warmCompilers.GetStatistics().WorkersLoaded == beforeReload.WorkersLoaded + 1u,
+                 "the next cook loads the module again, on its worker too");
+    runner.Check(SameOutput(coldSink, reloadedSink), "a comment in a dependency changes no output");
+
+    runner.BeginSection("a forgotten module loads again, and one variant cooks warm");
+    warmCompilers.Invalidate();
+    MemoryOutputSink invalidatedSink{ primaryName };
+    const WarmCompilerStatistics beforeInvalidated = warmCompilers.GetStatistics();
+    runner.Check(RunCook(options, invalidatedSink, warmCompilers).has_value(),
+                 "the cook after Invalidate succeeds");
+    const WarmCompilerStatistics afterInvalidated = warmCompilers.GetStatistics();
+    runner.Check(afterInvalidated.ModulesLoaded == beforeInvalidated.ModulesLoaded + 1u &&
+                     afterInvalidated.ModulesWarm == beforeInvalidated.ModulesWarm &&
+                     afterInvalidated.WorkersLoaded == beforeInvalidated.WorkersLoaded + 1u &&
+                     afterInvalidated.GlobalSessionsCreated == beforeInvalidated.GlobalSessionsCreated,
+                 "Invalidate loads the module again, and keeps the global session");
+
+    const CookResult<RawVariant> live = CompileLiveVariant(options, modulePath, 0u, warmCompilers);
+    runner.Check(live.has_value() && !live.value().EntryPoints.empty() &&
+                     warmCompilers.GetStatistics().ModulesWarm == afterInvalidated.ModulesWarm + 1u,
+                 "one variant compiles on the loaded module");
+    const CookResult<RawVariant> missing = CompileLiveVariant(options, modulePath, ~0u, warmCompilers);
+    runner.Check(!missing.has_value() && missing.error() == CookError::PermutationVariantNotEnumerated,
+                 "an index no variant holds fails by name");
+
+    return runner.Report();
+}
+
+} // namespace
+
 int main(int argc, char** argv)
 {
     std::vector<std::string_view> arguments;
@@ -19,6 +200,12 @@ int main(int argc, char** argv)
         arguments.emplace_back(argv[i]);
     }
 
+    const bool warmRecook = !arguments.empty() && arguments.front() == k_WarmRecookSwitch;
+    if (warmRecook)
+    {
+        arguments.erase(arguments.begin());
+    }
+
     const lodestone::CookResult<lodestone::CookerOptions> options = lodestone::ParseCommandLine(arguments);
     if (!options)
     {
@@ -29,6 +216,11 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (warmRecook)
+    {
+        return RunWarmRecookChecks(options.value());
+    }
+
     lodestone::FileOutputSink sink{ options.value().OutputPath };
     const lodestone::CookResult<lodestone::CookStatistics> statistics =
         lodestone::RunCook(options.value(), sink);
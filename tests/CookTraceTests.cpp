@@ -0,0 +1,114 @@
+#include "CookTrace.hpp"
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// The phase totals feed the statistics of every cook, and the trace is what a slow cook gets opened
+// in. This file checks both without a compiler: that a timer adds to its own phase alone, that a
+// disabled trace stays empty, and that two threads land on two tracks of one document, even when the
+// second starts after the first has exited.
+
+using lodestone::CookPhase;
+using lodestone::CookPhaseTimes;
+using lodestone::CookTrace;
+using lodestone::ScopedPhaseTimer;
+using lodestone::ScopedTraceSpan;
+
+namespace
+{
+
+bool Contains(std::string_view text, std::string_view part)
+{
+    return text.find(part) != std::string_view::npos;
+}
+
+} // namespace
+
+int main()
+{
+    lodestone::tests::TestRunner runner{ "CookTraceTests" };
+
+    runner.BeginSection("phase times add up by phase");
+    CookPhaseTimes times;
+    times.Add(CookPhase::Link, 2.0);
+    times.Add(CookPhase::Link, 3.0);
+    times.Add(CookPhase::Emit, 1.0);
+    runner.Check(times.Get(CookPhase::Link) == 5.0, "two adds to one phase sum");
+    runner.Check(times.Get(CookPhase::Codegen) == 0.0, "a phase nothing added to stays at zero");
+
+    const CookPhaseTimes before = times;
+    times.Add(CookPhase::Emit, 4.0);
+    const CookPhaseTimes since = times.Since(before);
+    runner.Check(since.Get(CookPhase::Emit) == 4.0 && since.Get(CookPhase::Link) == 0.0,
+                 "the time since a copy holds only what was added after it");
+
+    CookPhaseTimes total;
+    total.Add(times);
+    total.Add(times);
+    runner.Check(total.Get(CookPhase::Link) == 10.0, "adding two totals sums each phase");
+
+    const std::string description = lodestone::DescribePhaseTimes(times);
+    runner.Check(Contains(description, "link 5.0ms") && Contains(description, "emit 5.0ms"),
+                 "the description names each phase that took time");
+    runner.Check(!Contains(description, "codegen"), "the description leaves out a phase that took none");
+
+    runner.BeginSection("a timer adds to its phase whether or not a trace is on");
+    CookPhaseTimes timed;
+    {
+        const ScopedPhaseTimer timer{ timed, CookPhase::Resolve, nullptr, "" };
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 2 });
+    }
+    runner.Check(timed.Get(CookPhase::Resolve) >= 1.0, "the timer measured its scope");
+    runner.Check(timed.Get(CookPhase::Intern) == 0.0, "the timer touched no other phase");
+
+    CookTrace disabled;
+    {
+        const ScopedPhaseTimer timer{ timed, CookPhase::Intern, &disabled, "variant" };
+        const ScopedTraceSpan span{ &disabled, "module", "Module.slang" };
+    }
+    runner.Check(disabled.EventCount() == 0u, "a disabled trace records nothing");
+    runner.Check(timed.Get(CookPhase::Intern) > 0.0, "a disabled trace still leaves the phase total");
+
+    runner.BeginSection("each thread gets a track of its own");
+    CookTrace trace{ true };
+    {
+        const ScopedTraceSpan span{ &trace, "cook", "ShaderLibrary.hpp" };
+        std::jthread worker{ [&trace]
+                             {
+                                 CookPhaseTimes workerTimes;
+                                 const ScopedPhaseTimer timer{
+                                     workerTimes, CookPhase::Link, &trace, "MODE=1"
+                                 };
+                             } };
+    }
+    runner.Check(trace.EventCount() == 2u, "the span and the timer each recorded one event");
+
+    const std::string document = trace.ToChromeTraceJson();
+    runner.Check(Contains(document, R"("traceEvents":)"), "the document holds a trace event array");
+    runner.Check(Contains(document, R"("name":"link")"), "the timer's span carries the phase name");
+    runner.Check(Contains(document, R"("detail":"MODE=1")"), "the span carries its detail");
+    runner.Check(Contains(document, R"("name":"cook")") && Contains(document, R"("name":"worker 1")"),
+                 "both threads have a named track");
+    runner.Check(Contains(document, R"("tid":1,"ts")"), "the worker records on track one");
+    runner.Check(Contains(document, R"("tid":0,"ts")"), "the thread that made the trace records on zero");
+
+    runner.BeginSection("a thread started after another exits gets a new track");
+    CookTrace pooled{ true };
+    for (uint32_t pool = 0u; pool < 3u; ++pool)
+    {
+        // One after another, the way a worker pool per module joins before the next one starts, so the
+        // runtime is free to hand each thread the id of the one before it.
+        std::jthread worker{ [&pooled] { const ScopedTraceSpan span{ &pooled, "worker", "" }; } };
+    }
+
+    const std::string pooledDocument = pooled.ToChromeTraceJson();
+    runner.Check(Contains(pooledDocument, R"("tid":1,"ts")") && Contains(pooledDocument, R"("tid":2,"ts")") &&
+                     Contains(pooledDocument, R"("tid":3,"ts")"),
+                 "three short-lived threads record on three tracks");
+
+    return runner.Report();
+}
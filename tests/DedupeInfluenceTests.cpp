@@ -1,6 +1,7 @@
 #include "CookerErrors.hpp"
 #include "TestHarness.hpp"
 
+#include "compile/RawLibrary.hpp"
 #include "model/CookedLibrary.hpp"
 #include "emit/DedupeReport.hpp"
 #include "permute/PermutationSpace.hpp"
@@ -348,6 +349,66 @@ void CheckEveryGroupIsMeasured(lodestone::tests::TestRunner& runner, const Permu
                  "the second axis decides whether the text changes, so it is Active as well");
 }
 
+/** What a compile worker stages for `variant`: the same texts, carried the way the compiler emits them. */
+RawVariant MakeRawVariant(const CompiledVariant& variant)
+{
+    RawVariant raw;
+    raw.VariantIndex = variant.VariantIndex;
+    raw.VariantDescription = variant.VariantDescription;
+    for (const CompiledEntryPoint& entryPoint : variant.EntryPoints)
+    {
+        RawEntryPoint rawEntryPoint;
+        rawEntryPoint.Name = entryPoint.Name;
+        rawEntryPoint.TargetText = entryPoint.Code;
+        raw.EntryPoints.push_back(std::move(rawEntryPoint));
+    }
+
+    return raw;
+}
+
+/** The tickets a worker staged belong to one variant. Handed to any other, they must fail the append
+ * and not commit that variant's sources into this one's record. */
+void CheckStagedSourcesStayWithTheirVariant(lodestone::tests::TestRunner& runner,
+                                            const PermutationSpace& space)
+{
+    runner.BeginSection("staged sources commit only into the variant that staged them");
+
+    InternedModule module;
+    module.Name = "StagedModule";
+    module.Space = &space;
+    module.SpaceSize = 4u;
+    module.EntryPoints.push_back(
+        LibraryEntryPoint{ .Name = std::string{ k_ActiveEntryPoint }, .Stage = ShaderStageKind::Compute });
+    module.EntryPoints.push_back(
+        LibraryEntryPoint{ .Name = std::string{ k_InertEntryPoint }, .Stage = ShaderStageKind::Compute });
+
+    const CompiledVariant first = MakeVariant(0u, false, false);
+    const CompiledVariant second = MakeVariant(1u, true, false);
+    const CanonicalAssignment firstCanonical =
+        MakeAssignment(space, space.Axes()[0], space.Axes()[1], false, false);
+
+    const StagedVariantSources firstStaged = StageVariantSources(module, MakeRawVariant(first));
+    const StagedVariantSources secondStaged = StageVariantSources(module, MakeRawVariant(second));
+    runner.Check(firstStaged.VariantIndex == 0u && firstStaged.Tickets.size() == 2u,
+                 "staging records the variant and one ticket for each entry point");
+
+    const CookResult<void> crossed = AppendVariantToModule(module, first, firstCanonical, &secondStaged);
+    runner.Check(!crossed && crossed.error() == CookError::StagedSourcesMismatch,
+                 "tickets with the same entry point count but another variant's index are refused");
+
+    StagedVariantSources truncated{ .VariantIndex = 0u, .Tickets = { firstStaged.Tickets.front() } };
+    const CookResult<void> shortened = AppendVariantToModule(module, first, firstCanonical, &truncated);
+    runner.Check(!shortened && shortened.error() == CookError::StagedSourcesMismatch,
+                 "a ticket list of the wrong length is refused, not interned a second time");
+    runner.Check(module.Variants.empty(), "a refused append adds no variant record");
+
+    const CookResult<void> appended = AppendVariantToModule(module, first, firstCanonical, &firstStaged);
+    runner.Check(appended.has_value(), "the variant's own tickets commit");
+    runner.Check(!module.Variants.empty() &&
+                     ResolveSource(module, module.Variants.back(), 0u) == first.EntryPoints[0].Code,
+                 "the committed record resolves to the text its own worker staged");
+}
+
 } // namespace
 
 int main()
@@ -364,6 +425,7 @@ int main()
     CheckSharedLayoutAgrees(runner, space);
     CheckSharedLayoutRejectsADifference(runner, space);
     CheckEveryGroupIsMeasured(runner, space);
+    CheckStagedSourcesStayWithTheirVariant(runner, space);
 
     return runner.Report();
 }
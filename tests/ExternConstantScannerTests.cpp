@@ -1,6 +1,7 @@
 #include "permute/ExternConstantScanner.hpp"
 #include "TestHarness.hpp"
 
+#include <array>
 #include <cstddef>
 #include <string_view>
 #include <vector>
@@ -15,6 +16,7 @@
 
 using lodestone::DeclaresExternConstantNamed;
 using lodestone::ExternConstantDeclaration;
+using lodestone::NameMayAffectLayout;
 using lodestone::ScanExternConstants;
 using lodestone::TrimWhitespace;
 
@@ -87,6 +89,88 @@ int main()
                                               "IFFT_SIZE"),
                  "a name used in the default of another constant does not declare it");
 
+    // A false answer lets variants share one extracted global layout, so a false answer must only
+    // come back for a constant that no type or extent can see.
+    runner.BeginSection("a name reaches layout only through a type or an extent");
+    constexpr std::string_view k_LayoutSource = R"(extern static const uint TILE_COUNT = 4;
+extern static const uint BLOCK = 8;
+extern static const uint DERIVED = BLOCK * 2;
+extern static const bool USE_WAVE_OPS = false;
+extern static const uint QUALITY = 1;
+[vx_element_count("TILE_SIZE")] RWStructuredBuffer<float4> Tiles;
+groupshared float Scratch[TILE_COUNT];
+groupshared float Blocks[DERIVED];
+ConstantBuffer<Params<QUALITY> > Settings;
+void Main() { if (USE_WAVE_OPS) { Scratch[0] = 1.0; } } // Scratch[USE_WAVE_OPS]
+)";
+    runner.Check(NameMayAffectLayout(k_LayoutSource, "TILE_COUNT"), "an array extent can change layout");
+    runner.Check(NameMayAffectLayout(k_LayoutSource, "QUALITY"), "a type argument can change layout");
+    runner.Check(NameMayAffectLayout(k_LayoutSource, "BLOCK"),
+                 "a name in the default of another constant reaches layout through that constant");
+    runner.Check(!NameMayAffectLayout(k_LayoutSource, "USE_WAVE_OPS"),
+                 "a branch, a comment, and the declaration itself do not reach layout");
+    runner.Check(!NameMayAffectLayout(k_LayoutSource, "TILE_SIZE"),
+                 "a name inside a string literal is text for stage 4, not a layout input");
+    runner.Check(!NameMayAffectLayout(k_LayoutSource, "TILE"), "a prefix of a name is not a use");
+
+    runner.BeginSection("a type argument list can span lines");
+    constexpr std::string_view k_MultiLineSource = R"(extern static const uint CASCADES = 4;
+extern static const uint LANES = 32;
+ConstantBuffer<
+    Spectrum<CASCADES>> Cascades;
+void Main()
+{
+    if (LANES < 16)
+    {
+        Lanes(
+            LANES);
+    }
+}
+)";
+    runner.Check(NameMayAffectLayout(k_MultiLineSource, "CASCADES"),
+                 "a name on the line after an unclosed `<` can change layout");
+    runner.Check(!NameMayAffectLayout(k_MultiLineSource, "LANES"),
+                 "a comparison left open does not carry past the end of its statement");
+
+    // An ordinary constant carries an axis as far as an extern one does. Missing one here gives
+    // every variant the first variant's bindings and sizes.
+    runner.BeginSection("a name reaches layout through the constants and macros that hold it");
+    constexpr std::string_view k_AliasSource = R"(extern static const uint AXIS = 1;
+extern static const uint CHAINED = 2;
+extern static const uint MACRO_AXIS = 3;
+extern static const uint SPLIT = 4;
+extern static const uint BRANCH = 5;
+static const uint K = AXIS * 2 + 1;
+struct S { float4 w[K]; };
+ConstantBuffer<S> s;
+static const uint FIRST = CHAINED + 1;
+static const uint SECOND = FIRST * 2;
+groupshared float Chain[SECOND];
+#define LANE_COUNT (MACRO_AXIS * \
+    4)
+groupshared float Lanes[LANE_COUNT];
+static const uint SPREAD =
+    SPLIT * 3;
+groupshared float Spread[SPREAD];
+static const bool IS_WIDE = BRANCH >= 4;
+void Main() { if (IS_WIDE) { Chain[0] = 1.0; } }
+)";
+    runner.Check(NameMayAffectLayout(k_AliasSource, "AXIS"), "an extent through a static const counts");
+    runner.Check(NameMayAffectLayout(k_AliasSource, "CHAINED"),
+                 "a chain of constants is followed to its end");
+    runner.Check(NameMayAffectLayout(k_AliasSource, "MACRO_AXIS"), "a macro body that spans lines counts");
+    runner.Check(NameMayAffectLayout(k_AliasSource, "SPLIT"), "an initializer on the next line counts");
+    runner.Check(!NameMayAffectLayout(k_AliasSource, "BRANCH"),
+                 "a constant that only a branch reads does not reach layout");
+
+    constexpr std::array<std::string_view, 2u> k_SplitSources{
+        "extern static const uint TAPS = 4;\nstatic const uint TAP_PAIRS = TAPS / 2;\n",
+        "groupshared float Pairs[TAP_PAIRS];\n"
+    };
+    runner.Check(NameMayAffectLayout(k_SplitSources, "TAPS"),
+                 "a constant declared in one file and used in another counts");
+    runner.Check(!NameMayAffectLayout(k_SplitSources[0], "TAPS"), "one file alone does not see the use");
+
     runner.BeginSection("nothing to read gives nothing back");
     runner.Check(ScanExternConstants("").empty(), "empty source has no declaration");
     runner.Check(!DeclaresExternConstantNamed("", "IFFT_SIZE"), "empty source declares no name");
@@ -0,0 +1,110 @@
+#include "ChainCanonicalizeSection.hpp"
+#include "ChainPermutationSpace.hpp"
+#include "CookerErrors.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "TestHarness.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// The generated `VariantIndex` is how a demo names a variant, and the cooker keyed every table with
+// the index it enumerated. A query the two canonicalize differently names a hole, and FindSlot returns
+// null for a valid request. The header this file includes is generated at build time from the chain
+// space, so the checks below run the generated C++ itself against EnumerateVariants.
+
+using lodestone::CookResult;
+using lodestone::VariantDescriptor;
+using lodestone::VariantSet;
+using lodestone::shaders::Canonicalize;
+using lodestone::shaders::ChainPermutation;
+using lodestone::shaders::VariantIndex;
+
+namespace
+{
+
+/** The struct the generated code would take for one enumerated variant. */
+ChainPermutation FromCanonical(const VariantDescriptor& variant)
+{
+    ChainPermutation permutation;
+    permutation.ChainEnabled = variant.Canonical[0].Value.AsBool();
+    permutation.ChainMode = variant.Canonical[1].Value.AsUInt();
+    permutation.ChainTaps = variant.Canonical[2].Value.AsUInt();
+    permutation.ChainWide = variant.Canonical[3].Value.AsBool();
+    return permutation;
+}
+
+bool SamePermutation(const ChainPermutation& left, const ChainPermutation& right)
+{
+    return left.ChainEnabled == right.ChainEnabled && left.ChainMode == right.ChainMode &&
+           left.ChainTaps == right.ChainTaps && left.ChainWide == right.ChainWide;
+}
+
+} // namespace
+
+int main()
+{
+    lodestone::tests::TestRunner runner{ "GeneratedCanonicalizeTests" };
+
+    const CookResult<VariantSet> variants = lodestone::tests::ChainPermutationSpace().EnumerateVariants();
+    runner.Check(variants.has_value(), "the chain space enumerates");
+    if (!variants)
+    {
+        return runner.Report();
+    }
+
+    std::vector<uint32_t> cookedIndices;
+    for (const VariantDescriptor& variant : variants.value().Variants)
+    {
+        cookedIndices.push_back(static_cast<uint32_t>(variant.Index));
+    }
+
+    runner.BeginSection("every enumerated variant keeps its index");
+    bool everyIndexMatches = true;
+    for (const VariantDescriptor& variant : variants.value().Variants)
+    {
+        const ChainPermutation permutation = FromCanonical(variant);
+        everyIndexMatches = everyIndexMatches &&
+                            VariantIndex(permutation) == static_cast<uint32_t>(variant.Index) &&
+                            SamePermutation(Canonicalize(permutation), permutation);
+    }
+    runner.Check(everyIndexMatches, "a canonical assignment is left alone and indexes to its variant");
+
+    runner.BeginSection("every query lands on a variant the cooker built");
+    bool everyQueryCooked = true;
+    for (const bool enabled : { false, true })
+    {
+        for (const uint32_t mode : { 0u, 1u, 2u })
+        {
+            for (const uint32_t taps : { 4u, 8u })
+            {
+                for (const bool wide : { false, true })
+                {
+                    const ChainPermutation query{
+                        .ChainEnabled = enabled, .ChainMode = mode, .ChainTaps = taps, .ChainWide = wide
+                    };
+                    const uint32_t index = VariantIndex(query);
+                    everyQueryCooked =
+                        everyQueryCooked && std::ranges::find(cookedIndices, index) != cookedIndices.end();
+                }
+            }
+        }
+    }
+    runner.Check(everyQueryCooked, "no assignment of the four fields names a hole");
+
+    runner.BeginSection("a parent reset to its enabling default does not enable its child");
+    const ChainPermutation disabledChain{ .ChainEnabled = false, .ChainTaps = 8u, .ChainWide = true };
+    runner.Check(SamePermutation(Canonicalize(disabledChain), ChainPermutation{}),
+                 "with the chain off, every link after it takes its default");
+    runner.Check(VariantIndex(disabledChain) == VariantIndex(ChainPermutation{}),
+                 "and the query resolves to the variant with the chain off");
+
+    const ChainPermutation offMode{
+        .ChainEnabled = true, .ChainMode = 1u, .ChainTaps = 8u, .ChainWide = true
+    };
+    const ChainPermutation offModeCanonical{ .ChainEnabled = true, .ChainMode = 1u };
+    runner.Check(SamePermutation(Canonicalize(offMode), offModeCanonical),
+                 "a link set to a value that disables its child resets every link after it");
+
+    return runner.Report();
+}
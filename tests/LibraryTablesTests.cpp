@@ -0,0 +1,185 @@
+#include "emit/DedupeReport.hpp"
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "model/ShaderDataSchema.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// The library pass folds the tables of every module into one, and a manifest cooked with
+// `--share-sources` reads its text from the library source file. Two small modules share one source
+// and one binding here, so every count below is small enough to check by hand.
+//
+// This test needs no Slang, no compiler, and no asset.
+
+using namespace lodestone;
+
+namespace
+{
+
+constexpr std::string_view k_SharedSource = "// a fullscreen quad both modules use";
+
+CookedModule MakeModule(std::string name, std::string own_source)
+{
+    CookedModule module;
+    module.Name = std::move(name);
+    module.SpaceSize = 2u;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+
+    module.Sources.emplace_back(k_SharedSource);
+    module.Sources.push_back(std::move(own_source));
+
+    ReflectedBinding binding;
+    binding.Name = "Input";
+    binding.Placement = BoundPlacement{ .Group = 0u, .Binding = 0u };
+    binding.Kind = BindingKind::StorageBuffer;
+    binding.ElementStride = 16u;
+    binding.Shape = ResourceShape::Buffer;
+    module.Resources.push_back(binding);
+    module.ResourceLists.push_back(ResourceList{ 0u });
+    module.FootprintLists.push_back(FootprintList{ BufferFootprint{ .ElementCount = 64u } });
+    module.VisibilityLists.push_back(VisibilityList{ 0u });
+    module.RasterStates.emplace_back();
+
+    for (uint32_t i = 0u; i < 2u; ++i)
+    {
+        LibraryVariant variant;
+        variant.Index = i;
+        variant.Suffix = i == 0u ? "_A" : "_B";
+        variant.Description = i == 0u ? "first" : "second";
+        variant.SourceIndices.push_back(i);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+ModuleArtifacts MakeArtifacts(const CookedModule& module)
+{
+    ModuleArtifacts artifacts;
+    artifacts.Name = module.Name;
+    artifacts.Manifest = EmitShaderManifest(module);
+    artifacts.ManifestFileName = MakeManifestFileName(module.Name);
+    return artifacts;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+bool SameIndices(std::span<const uint32_t> actual, std::initializer_list<uint32_t> expected)
+{
+    return std::ranges::equal(actual, expected);
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "LibraryTablesTests" };
+
+    const std::vector<ModuleArtifacts> modules{ MakeArtifacts(MakeModule("First", "// first only")),
+                                                MakeArtifacts(MakeModule("Second", "// second only")) };
+
+    runner.BeginSection("the library pass folds what the modules share");
+    const CookResult<LibraryTables> folded = FoldLibraryTables(modules, true);
+    runner.Check(folded.has_value(), "the pass reads every module manifest");
+    if (!folded)
+    {
+        return runner.Report();
+    }
+
+    const LibraryTables& library = folded.value();
+    const LibraryStatistics& statistics = library.Statistics;
+    runner.Check(library.Sources.size() == 3u && library.Sources[0] == k_SharedSource,
+                 "a source two modules hold sits once in the library table");
+    runner.Check(SameIndices(library.SourceRemaps[0], { 0u, 1u }) &&
+                     SameIndices(library.SourceRemaps[1], { 0u, 2u }),
+                 "each module's source table maps onto the library table in first-arrival order");
+    runner.Check(statistics.SourceTable.Interning.ArtifactsSeen == 4u &&
+                     statistics.SourceTable.Interning.UniqueEntries == 3u,
+                 "the source counters count module entries in and library entries out");
+    runner.Check(statistics.ResourceTable.Interning.UniqueEntries == 1u &&
+                     statistics.RasterTable.Interning.UniqueEntries == 1u,
+                 "an equal binding and an equal raster state in two modules fold to one");
+    runner.Check(statistics.ModuleSourceBytes - statistics.LibrarySourceBytes == k_SharedSource.size(),
+                 "the byte counters save exactly the shared source once");
+
+    const std::string report = GenerateDedupeReport(modules, statistics);
+    runner.Check(report.find("library  2 modules") != std::string::npos &&
+                     report.find("sources: Module Entries: 4 -> Library Entries: 3") != std::string::npos,
+                 "the dedupe report ends with the library section");
+
+    runner.BeginSection("the identity path folds nothing");
+    const CookResult<LibraryTables> unfolded = FoldLibraryTables(modules, false);
+    runner.Check(unfolded.has_value() && unfolded.value().Sources.size() == 4u &&
+                     SameIndices(unfolded.value().SourceRemaps[1], { 2u, 3u }),
+                 "with dedupe off, every module entry keeps its own library index");
+
+    runner.BeginSection("a manifest that shares its sources reads the same text");
+    const std::string librarySources = EmitLibrarySourceManifest("ShaderLibrary", library.Sources);
+    const CookResult<std::string> shared = ShareManifestSources(modules[1].Manifest, library.SourceRemaps[1]);
+    runner.Check(shared.has_value(), "the module manifest rewrites onto the library sources");
+    if (!shared)
+    {
+        return runner.Report();
+    }
+
+    runner.Check(shared.value().size() < modules[1].Manifest.size(),
+                 "the rewritten manifest no longer holds the source text");
+    runner.Check(VerifySharedSourceRoundTrip(modules[1].Manifest, shared.value(), librarySources).has_value(),
+                 "every slot reads the same text and the same fields through the library sources");
+
+    const ManifestResult<ShaderManifestView> alone = ShaderManifestView::Open(AsBytes(shared.value()));
+    runner.Check(!alone.has_value() && alone.error() == ShaderManifestError::SharedSourcesMissing,
+                 "a shared manifest opened without its library sources is SharedSourcesMissing");
+
+    const ManifestResult<ShaderManifestView> sources = ShaderManifestView::Open(AsBytes(librarySources));
+    runner.Check(sources.has_value() && sources.value().SourceCount() == 3u &&
+                     sources.value().ModuleName() == "ShaderLibrary",
+                 "the library source file is a manifest that holds the name and the sources");
+    if (sources.has_value())
+    {
+        const ManifestResult<ShaderManifestView> opened =
+            ShaderManifestView::Open(AsBytes(shared.value()), sources.value());
+        runner.Check(opened.has_value() && opened.value().SharesLibrarySources(),
+                     "a shared manifest opens against the library sources");
+        if (opened.has_value())
+        {
+            const ManifestShaderSourceProvider provider{ opened.value(), 0u };
+            runner.Check(provider.Source(1u, 0u) == k_SharedSource &&
+                             provider.Source(1u, 1u) == "// second only",
+                         "a provider over the shared manifest serves the shared text and the module's own");
+        }
+
+        const ManifestResult<ShaderManifestView> ownSources =
+            ShaderManifestView::Open(AsBytes(modules[0].Manifest), sources.value());
+        runner.Check(ownSources.has_value() && ownSources.value().Source(1u) == "// first only",
+                     "a manifest that holds its own sources ignores the library sources");
+    }
+
+    runner.BeginSection("a rewrite that cannot be right is refused");
+    const std::vector<uint32_t> shortRemap{ 0u };
+    runner.Check(!ShareManifestSources(modules[1].Manifest, shortRemap).has_value(),
+                 "a remap that does not cover the module's source table fails");
+    runner.Check(!VerifySharedSourceRoundTrip(modules[0].Manifest, shared.value(), librarySources),
+                 "the check fails a shared manifest compared against another module");
+
+    return runner.Report();
+}
@@ -0,0 +1,191 @@
+#include "CookerErrors.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "model/ShaderDataSchema.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "permute/PermutationValue.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Name lookups: the cooker writes a perfect hash over the entry point, axis and binding names of a
+// module, and the reader finds any of them with one hash, two table reads and one compare. Every name
+// must find its own record, and a name the module does not have must find nothing, even when it lands
+// on an occupied slot.
+//
+// This test needs no Slang, no compiler, and no asset.
+
+using namespace lodestone;
+
+namespace
+{
+
+constexpr uint32_t k_BindingCount = 300u;
+constexpr uint32_t k_EntryPointCount = 5u;
+
+const PermutationSpace k_LookupSpace{
+    "LookupSpace",
+    { PermutationAxis{ "LOOKUP_QUALITY",
+                       { PermutationValue{ 0u }, PermutationValue{ 1u } },
+                       PermutationAxis::k_NoParent,
+                       PermutationValue{} },
+      PermutationAxis{ "LOOKUP_SHADOWS",
+                       { PermutationValue{ false }, PermutationValue{ true } },
+                       PermutationAxis::k_NoParent,
+                       PermutationValue{} } } };
+
+std::string BindingName(uint32_t index)
+{
+    return std::format("Binding{}", index);
+}
+
+/** Enough bindings that most buckets hold several names, and the last binding repeats the first name,
+ * as two variants that declare one resource differently do. */
+CookedModule MakeModule(const VariantSet& variants)
+{
+    CookedModule module;
+    module.Name = "Lookup";
+    module.Space = &k_LookupSpace;
+    module.SpaceSize = static_cast<uint32_t>(variants.SpaceSize);
+    for (uint32_t i = 0u; i < k_EntryPointCount; ++i)
+    {
+        module.EntryPoints.push_back(
+            LibraryEntryPoint{ .Name = std::format("Main{}CS", i), .Stage = ShaderStageKind::Compute });
+    }
+
+    for (uint32_t i = 0u; i <= k_BindingCount; ++i)
+    {
+        ReflectedBinding binding;
+        binding.Name = BindingName(i % k_BindingCount);
+        binding.Placement = BoundPlacement{ .Group = 0u, .Binding = i };
+        binding.Kind = BindingKind::StorageBuffer;
+        binding.ElementStride = 4u * (1u + (i / k_BindingCount));
+        binding.Shape = ResourceShape::Buffer;
+        module.Resources.push_back(binding);
+    }
+
+    ResourceList everything(module.Resources.size());
+    std::iota(everything.begin(), everything.end(), 0u);
+    module.ResourceLists.push_back(everything);
+    module.FootprintLists.emplace_back(module.Resources.size());
+    module.VisibilityLists.push_back(everything);
+    module.RasterStates.emplace_back();
+    module.Sources.push_back("// lookup");
+
+    for (const VariantDescriptor& descriptor : variants.Variants)
+    {
+        LibraryVariant variant;
+        variant.Index = static_cast<uint32_t>(descriptor.Index);
+        variant.Suffix = MakeAssignmentSuffix(descriptor.Canonical);
+        variant.Description = DescribeAssignment(descriptor.Canonical);
+        variant.Canonical = descriptor.Canonical;
+        for (uint32_t i = 0u; i < k_EntryPointCount; ++i)
+        {
+            variant.SourceIndices.push_back(0u);
+            variant.VisibilityIndices.push_back(0u);
+            variant.RasterIndices.push_back(0u);
+            variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        }
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "ManifestNameLookupTests" };
+
+    const CookResult<VariantSet> variants = k_LookupSpace.EnumerateVariants();
+    runner.Check(variants.has_value(), "the space enumerates");
+    if (!variants)
+    {
+        return runner.Report();
+    }
+
+    const CookedModule module = MakeModule(variants.value());
+    const std::string manifest = EmitShaderManifest(module);
+    runner.Check(VerifyManifestRoundTrip(module, manifest).has_value(),
+                 "the cooker's round trip, which finds every name, passes");
+
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(AsBytes(manifest));
+    runner.Check(opened.has_value(), "the manifest opens");
+    if (!opened)
+    {
+        return runner.Report();
+    }
+
+    const ShaderManifestView& view = opened.value();
+    runner.BeginSection("every name finds its own record");
+    bool everyEntryPointFound = true;
+    for (uint32_t i = 0u; i < k_EntryPointCount; ++i)
+    {
+        everyEntryPointFound =
+            everyEntryPointFound && view.FindEntryPoint(module.EntryPoints[i].Name) == i + 1u;
+    }
+    runner.Check(everyEntryPointFound, "each entry point name finds its EntryPointId");
+    runner.Check(view.FindAxis("LOOKUP_QUALITY") == 0u && view.FindAxis("LOOKUP_SHADOWS") == 1u,
+                 "each axis name finds its axis index");
+
+    bool everyBindingFound = true;
+    for (uint32_t i = 0u; i < k_BindingCount; ++i)
+    {
+        everyBindingFound = everyBindingFound && view.FindBinding(BindingName(i)) == i;
+    }
+    runner.Check(everyBindingFound, "each of 300 binding names finds its binding");
+    runner.Check(view.FindBinding(BindingName(0u)) == 0u &&
+                     view.Bindings()[k_BindingCount].ElementStride == 8u,
+                 "a name two bindings share finds the first");
+
+    runner.BeginSection("a name the module does not have finds nothing");
+    bool noStrangerFound = true;
+    for (uint32_t i = k_BindingCount; i < 4u * k_BindingCount; ++i)
+    {
+        noStrangerFound = noStrangerFound && view.FindBinding(BindingName(i)) == k_ShaderManifestNoIndex;
+    }
+    runner.Check(noStrangerFound, "900 unknown binding names each land on a slot and fail the compare");
+    runner.Check(view.FindEntryPoint("MainPS") == 0u && view.FindEntryPoint({}) == 0u,
+                 "an unknown entry point is zero, the Invalid id");
+    runner.Check(view.FindAxis("LOOKUP_MISSING") == k_ShaderManifestNoIndex,
+                 "an unknown axis is k_ShaderManifestNoIndex");
+    runner.Check(view.FindBinding("MainCS0") == k_ShaderManifestNoIndex,
+                 "a name of another kind is not found among the bindings");
+
+    runner.BeginSection("a variant query by name goes through the same hash");
+    const std::array<ManifestAxisValue, 1u> shadows{ ManifestAxisValue::Named("LOOKUP_SHADOWS", 1) };
+    const std::array<ManifestAxisValue, 1u> missing{ ManifestAxisValue::Named("LOOKUP_MISSING", 1) };
+    runner.Check(view.ResolveVariant(shadows).value_or(~0u) == 1u, "a named axis resolves");
+    runner.Check(!view.ResolveVariant(missing).has_value() &&
+                     view.ResolveVariant(missing).error() == ShaderManifestError::AxisNotFound,
+                 "an unknown axis name is still AxisNotFound");
+
+    runner.BeginSection("a manifest that names nothing finds nothing");
+    CookedModule empty;
+    empty.Name = "Empty";
+    const std::string emptyManifest = EmitShaderManifest(empty);
+    const ManifestResult<ShaderManifestView> emptyView = ShaderManifestView::Open(AsBytes(emptyManifest));
+    runner.Check(emptyView.has_value() && emptyView.value().FindEntryPoint("MainCS") == 0u &&
+                     emptyView.value().FindAxis("LOOKUP_QUALITY") == k_ShaderManifestNoIndex &&
+                     emptyView.value().FindBinding("Binding0") == k_ShaderManifestNoIndex,
+                 "an empty module opens, and every find misses");
+
+    return runner.Report();
+}
@@ -0,0 +1,232 @@
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "model/ShaderDataSchema.hpp"
+#include "PublishOnceTable.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// The manifest source provider: it builds a slot's bindings and a compressed source the first time
+// they are asked for, hands back the same bytes every time after, and hands back the same bytes to
+// every thread that asks at once.
+//
+// This test needs no Slang, no compiler, and no asset.
+
+using namespace lodestone;
+
+namespace
+{
+
+constexpr uint32_t k_VariantCount = 64u;
+constexpr uint32_t k_ThreadCount = 8u;
+
+/** Long and repetitive enough that the block codec shrinks it, so a compressed manifest has no text
+ * in place. */
+std::string MakeSource(std::string_view name)
+{
+    std::string source = "struct Params { scale: f32, bias: f32 }\n";
+    for (uint32_t i = 0u; i < 32u; ++i)
+    {
+        source += std::format("fn Helper{}() -> f32 {{ return params.scale * {}.0 + params.bias; }}\n", i, i);
+    }
+
+    return source + std::format("fn MainCS() {{ let {} = 0u; }}\n", name);
+}
+
+/** One entry point. Each variant sees a uniform block of two members and a storage buffer, and even
+ * and odd variants read different sources. */
+CookedModule MakeModule()
+{
+    CookedModule module;
+    module.Name = "Provider";
+    module.SpaceSize = k_VariantCount;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.Sources.push_back(MakeSource("even"));
+    module.Sources.push_back(MakeSource("odd"));
+
+    ReflectedBinding params;
+    params.Name = "Params";
+    params.Placement = BoundPlacement{ .Group = 0u, .Binding = 0u };
+    params.Kind = BindingKind::UniformBuffer;
+    params.ByteSize = 8u;
+    params.Shape = ResourceShape::Buffer;
+    params.UniformMembers.push_back(ReflectedUniformMember{ .Name = "scale", .Offset = 0u, .Size = 4u });
+    params.UniformMembers.push_back(ReflectedUniformMember{ .Name = "bias", .Offset = 4u, .Size = 4u });
+
+    ReflectedBinding output;
+    output.Name = "Output";
+    output.Placement = BoundPlacement{ .Group = 0u, .Binding = 1u };
+    output.Kind = BindingKind::StorageBuffer;
+    output.ElementStride = 16u;
+    output.Shape = ResourceShape::Buffer;
+
+    module.Resources.push_back(params);
+    module.Resources.push_back(output);
+    module.ResourceLists.push_back(ResourceList{ 0u, 1u });
+    module.FootprintLists.push_back(
+        FootprintList{ std::monostate{}, BufferFootprint{ .ElementCount = 256u } });
+    module.VisibilityLists.push_back(VisibilityList{ 0u, 1u });
+    module.RasterStates.emplace_back();
+
+    for (uint32_t i = 0u; i < k_VariantCount; ++i)
+    {
+        LibraryVariant variant;
+        variant.Index = i;
+        variant.Suffix = "_" + std::to_string(i);
+        variant.Description = "variant " + std::to_string(i);
+        variant.SourceIndices.push_back(i % 2u);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+/** What every thread saw: the address of each variant's bindings and source. */
+struct SeenAddresses
+{
+    std::array<const BindingInfo*, k_VariantCount> Bindings{};
+    std::array<const char*, k_VariantCount> Sources{};
+};
+
+/** Every thread asks for every variant at once, from the last to the first so the threads collide. */
+std::vector<SeenAddresses> AskFromEveryThread(const ManifestShaderSourceProvider& provider)
+{
+    std::vector<SeenAddresses> seen(k_ThreadCount);
+    {
+        std::vector<std::jthread> threads;
+        for (uint32_t t = 0u; t < k_ThreadCount; ++t)
+        {
+            threads.emplace_back(
+                [&provider, &seen, t]
+                {
+                    for (uint32_t i = k_VariantCount; i-- > 0u;)
+                    {
+                        seen[t].Bindings[i] = provider.Bindings(1u, i).data();
+                        seen[t].Sources[i] = provider.Source(1u, i).data();
+                    }
+                });
+        }
+    }
+
+    return seen;
+}
+
+bool AllThreadsAgree(const std::vector<SeenAddresses>& seen)
+{
+    for (const SeenAddresses& addresses : seen)
+    {
+        if (addresses.Bindings != seen.front().Bindings || addresses.Sources != seen.front().Sources)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "ManifestProviderTests" };
+
+    const CookedModule module = MakeModule();
+    const std::string manifest = EmitShaderManifest(module);
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(AsBytes(manifest));
+    runner.Check(opened.has_value(), "the manifest opens");
+    if (!opened)
+    {
+        return runner.Report();
+    }
+
+    runner.BeginSection("bindings are built on first request and kept");
+    {
+        const ManifestShaderSourceProvider provider{ opened.value(), 7u };
+        runner.Check(provider.Generation() == 7u, "the provider keeps its generation");
+
+        const std::span<const BindingInfo> bindings = provider.Bindings(1u, 3u);
+        runner.Check(bindings.size() == 2u, "a slot gathers every binding its entry point sees");
+        if (bindings.size() == 2u)
+        {
+            runner.Check(bindings[0].Name == "Params" && bindings[0].Members.size() == 2u &&
+                             bindings[0].Members[1].Name == "bias" && bindings[0].Members[1].Offset == 4u,
+                         "a uniform block carries its members");
+            runner.Check(bindings[1].Name == "Output" && bindings[1].Members.empty() &&
+                             bindings[1].DerivedElementCount == 256u,
+                         "a storage buffer carries its footprint");
+        }
+
+        runner.Check(provider.Bindings(1u, 3u).data() == bindings.data(),
+                     "a second request returns the same bindings, not a copy");
+        runner.Check(provider.Bindings(2u, 3u).empty() && provider.Bindings(1u, k_VariantCount).empty(),
+                     "an unknown entry point or variant has no bindings");
+        runner.Check(provider.Source(1u, 4u) == module.Sources[0] &&
+                         provider.Source(1u, 5u) == module.Sources[1],
+                     "a source in place reads straight from the manifest");
+    }
+
+    runner.BeginSection("every thread gets the same bindings");
+    {
+        const ManifestShaderSourceProvider provider{ opened.value(), 0u };
+        const std::vector<SeenAddresses> seen = AskFromEveryThread(provider);
+        runner.Check(AllThreadsAgree(seen), "threads that race for a slot all return the one published");
+        runner.Check(seen.front().Bindings[0] != seen.front().Bindings[1],
+                     "each slot has bindings of its own");
+    }
+
+    runner.BeginSection("a compressed source is decoded on first request and kept");
+    {
+        const std::string compressed =
+            EmitShaderManifest(module, { .Compression = ManifestSourceCompression::Blocks });
+        const ManifestResult<ShaderManifestView> compressedView =
+            ShaderManifestView::Open(AsBytes(compressed));
+        runner.Check(compressedView.has_value() && compressedView.value().HasCompressedSources() &&
+                         compressedView.value().Source(0u).empty(),
+                     "the compressed manifest opens, with no text in place");
+        if (compressedView.has_value())
+        {
+            const ManifestShaderSourceProvider provider{ compressedView.value(), 0u };
+            const std::vector<SeenAddresses> seen = AskFromEveryThread(provider);
+            runner.Check(AllThreadsAgree(seen),
+                         "threads that race for a source all return the one published");
+            runner.Check(provider.Source(1u, 0u) == module.Sources[0] &&
+                             provider.Source(1u, 1u) == module.Sources[1],
+                         "a decoded source reads as the text that went in");
+            runner.Check(seen.front().Sources[0] == seen.front().Sources[2],
+                         "two variants of one source share one decoded copy");
+        }
+    }
+
+    runner.BeginSection("a publish-once table keeps the first value");
+    {
+        const PublishOnceTable<int> table{ 3000u };
+        runner.Check(table.Find(2999u) == nullptr, "a slot starts empty");
+        const int* first = table.Publish(2999u, std::make_unique<int>(1));
+        const int* second = table.Publish(2999u, std::make_unique<int>(2));
+        runner.Check(first == second && *table.Find(2999u) == 1, "a second publish returns the first value");
+        runner.Check(table.Find(0u) == nullptr, "a slot on another page stays empty");
+    }
+
+    return runner.Report();
+}
@@ -0,0 +1,185 @@
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "MappedShaderManifest.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Mapped manifests: a manifest the cooker wrote maps from disk and reads the same as one read into
+// memory, the mapping outlives a move, and a file that cannot be a manifest fails by name.
+//
+// This test needs no Slang, no compiler, and no asset. It writes its files to the temp directory.
+
+using namespace lodestone;
+
+namespace
+{
+
+std::filesystem::path MakeTestDirectory()
+{
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "lodestone_mapped_manifest_test";
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+    std::filesystem::create_directories(directory, ignored);
+    return directory;
+}
+
+bool WriteFile(const std::filesystem::path& path, std::string_view bytes)
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+/** Two variants, one source each. */
+CookedModule MakeModule()
+{
+    CookedModule module;
+    module.Name = "Mapped";
+    module.SpaceSize = 2u;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.Sources.emplace_back("fn MainCS() { let first = 1u; }\n");
+    module.Sources.emplace_back("fn MainCS() { let second = 2u; }\n");
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+
+    for (uint32_t i = 0u; i < 2u; ++i)
+    {
+        LibraryVariant variant;
+        variant.Index = i;
+        variant.Suffix = i == 0u ? "_A" : "_B";
+        variant.Description = i == 0u ? "first" : "second";
+        variant.SourceIndices.push_back(i);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+ShaderManifestError ErrorFrom(const ManifestResult<MappedShaderManifest>& mapped)
+{
+    return mapped.has_value() ? ShaderManifestError::Success : mapped.error();
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "MappedManifestTests" };
+
+    const std::filesystem::path directory = MakeTestDirectory();
+    const CookedModule module = MakeModule();
+    const std::string manifest = EmitShaderManifest(module);
+    const std::filesystem::path manifestPath = directory / MakeManifestFileName(module.Name);
+    runner.Check(WriteFile(manifestPath, manifest), "the manifest writes to the temp directory");
+
+    runner.BeginSection("a manifest maps from disk and reads the same as one in memory");
+    ManifestResult<MappedShaderManifest> mapped = MappedShaderManifest::Open(manifestPath);
+    runner.Check(mapped.has_value(), "the manifest maps and opens");
+    if (!mapped)
+    {
+        return runner.Report();
+    }
+
+    const std::span<const std::byte> bytes = mapped.value().Bytes();
+    const std::string_view text{ reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+    runner.Check(text == manifest, "the mapping is the file, byte for byte");
+    runner.Check((reinterpret_cast<uintptr_t>(bytes.data()) % 8u) == 0u,
+                 "the mapping starts on an 8-byte boundary");
+    const ShaderManifestView& view = mapped.value().View();
+    runner.Check(view.ModuleName() == "Mapped" && view.Source(1u) == module.Sources[1],
+                 "the view reads names and sources in place");
+
+    runner.BeginSection("the mapping moves with its owner");
+    MappedShaderManifest moved = std::move(mapped.value());
+    runner.Check(mapped.value().Bytes().empty() && mapped.value().View().SourceCount() == 0u,
+                 "a moved-from manifest holds nothing");
+    runner.Check(moved.Bytes().data() == bytes.data() && moved.View().Source(0u) == module.Sources[0],
+                 "the moved-to manifest keeps the same mapping and the same view");
+
+    const ManifestShaderSourceProvider provider{ moved.View(), 0u };
+    runner.Check(provider.Source(1u, 1u) == module.Sources[1], "a provider serves text from the mapping");
+
+    MappedShaderManifest assigned;
+    assigned = std::move(moved);
+    runner.Check(assigned.View().Source(1u) == module.Sources[1] && moved.Bytes().empty(),
+                 "move assignment hands the mapping over");
+
+    runner.BeginSection("a file that cannot be a manifest fails by name");
+    runner.Check(ErrorFrom(MappedShaderManifest::Open(directory / "missing.ldshader")) ==
+                     ShaderManifestError::FileOpenFailed,
+                 "a missing file is FileOpenFailed");
+
+    const std::filesystem::path emptyPath = directory / "empty.ldshader";
+    runner.Check(WriteFile(emptyPath, {}) &&
+                     ErrorFrom(MappedShaderManifest::Open(emptyPath)) == ShaderManifestError::TooSmall,
+                 "an empty file is TooSmall, before anything maps");
+
+    const std::filesystem::path truncatedPath = directory / "truncated.ldshader";
+    runner.Check(WriteFile(truncatedPath, std::string_view{ manifest }.substr(0u, manifest.size() - 8u)) &&
+                     ErrorFrom(MappedShaderManifest::Open(truncatedPath)) ==
+                         ShaderManifestError::SizeMismatch,
+                 "a truncated file maps, and the view rejects it as SizeMismatch");
+
+    runner.BeginSection("a shared manifest maps beside its library source file");
+    ModuleArtifacts artifacts;
+    artifacts.Name = module.Name;
+    artifacts.Manifest = manifest;
+    artifacts.ManifestFileName = MakeManifestFileName(module.Name);
+    const std::vector<ModuleArtifacts> modules{ artifacts };
+    const CookResult<LibraryTables> library = FoldLibraryTables(modules, true);
+    if (!library)
+    {
+        runner.Check(false, "the library tables fold");
+        return runner.Report();
+    }
+
+    const std::string librarySources = EmitLibrarySourceManifest("ShaderLibrary", library.value().Sources);
+    const CookResult<std::string> shared = ShareManifestSources(manifest, library.value().SourceRemaps[0]);
+    const std::filesystem::path sourcesPath = directory / MakeLibrarySourceFileName("ShaderLibrary");
+    const std::filesystem::path sharedPath = directory / "Shared.ldshader";
+    runner.Check(shared.has_value() && WriteFile(sourcesPath, librarySources) &&
+                     WriteFile(sharedPath, shared.value()),
+                 "the library source file and the shared manifest write");
+
+    runner.Check(ErrorFrom(MappedShaderManifest::Open(sharedPath)) ==
+                     ShaderManifestError::SharedSourcesMissing,
+                 "a shared manifest mapped alone is SharedSourcesMissing");
+
+    const ManifestResult<MappedShaderManifest> sources = MappedShaderManifest::Open(sourcesPath);
+    if (sources.has_value())
+    {
+        const ManifestResult<MappedShaderManifest> sharedManifest =
+            MappedShaderManifest::Open(sharedPath, sources.value());
+        runner.Check(sharedManifest.has_value() && sharedManifest.value().View().SharesLibrarySources() &&
+                         sharedManifest.value().View().Source(0u) == module.Sources[0],
+                     "a shared manifest reads its text from the mapped library source file");
+    }
+    else
+    {
+        runner.Check(false, "the library source file maps");
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+    return runner.Report();
+}
@@ -0,0 +1,137 @@
+#include "driver/CookerOptions.hpp"
+#include "driver/ModuleStamp.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "TestHarness.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// A stamp lets a cook skip a module entirely, so a wrong hit ships the text of an older cook. This
+// file checks, without a compiler, that a stamp hits only while every input it covers is unchanged:
+// each dependency's text, the options that reach the output, and the name of the header.
+
+using lodestone::CookerOptions;
+using lodestone::CookResult;
+using lodestone::ModuleArtifacts;
+using lodestone::ModuleStampStore;
+
+namespace
+{
+
+ModuleArtifacts MakeSampleArtifacts()
+{
+    ModuleArtifacts artifacts;
+    artifacts.Name = "StampTestModule";
+    artifacts.EntryPointNames = { "MainCS", "MainVS" };
+    artifacts.HeaderSection = "struct StampTestModulePermutation {};\n";
+    artifacts.SourceFileName = "ShaderLibrary_StampTestModule.cpp";
+    artifacts.Source = "// generated\n";
+    artifacts.ManifestFileName = "StampTestModule.lsmanifest";
+    artifacts.Manifest = std::string{ "LSMF\0\0\0\1", 8u };
+    artifacts.ReportSection = "module StampTestModule\n";
+    return artifacts;
+}
+
+void WriteTextFile(const std::filesystem::path& path, std::string_view text)
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+std::filesystem::path MakeScratchDirectory()
+{
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "lodestone_module_stamp_test";
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+    std::filesystem::create_directories(directory, ignored);
+    return directory;
+}
+
+} // namespace
+
+int main()
+{
+    lodestone::tests::TestRunner runner{ "ModuleStampTests" };
+
+    runner.BeginSection("module artifacts survive a round trip through bytes");
+    const ModuleArtifacts sample = MakeSampleArtifacts();
+    const std::string bytes = lodestone::SerializeModuleArtifacts(sample);
+    const CookResult<ModuleArtifacts> readBack = lodestone::DeserializeModuleArtifacts(bytes);
+    runner.Check(readBack.has_value(), "the serialized bytes read back");
+    if (readBack)
+    {
+        runner.Check(lodestone::SerializeModuleArtifacts(readBack.value()) == bytes,
+                     "writing the read-back artifacts again yields the same bytes");
+        runner.Check(readBack->EntryPointNames == sample.EntryPointNames,
+                     "the entry point names keep their order");
+        runner.Check(readBack->Manifest == sample.Manifest, "a manifest with zero bytes in it stays whole");
+    }
+
+    bool everyPrefixRejected = true;
+    for (size_t length = 0u; length < bytes.size(); ++length)
+    {
+        if (lodestone::DeserializeModuleArtifacts(std::string_view{ bytes }.substr(0u, length)))
+        {
+            everyPrefixRejected = false;
+        }
+    }
+    runner.Check(everyPrefixRejected, "no strict prefix of the bytes reads as artifacts");
+
+    const std::filesystem::path directory = MakeScratchDirectory();
+    const std::filesystem::path modulePath = directory / "StampTestModule.slang";
+    const std::filesystem::path includePath = directory / "Shared.slang";
+    WriteTextFile(modulePath, "import Shared;\n");
+    WriteTextFile(includePath, "static const uint k_Size = 64;\n");
+
+    const std::vector<std::string> dependencyPaths{ modulePath.string(), includePath.string() };
+    const std::vector<std::string> dependencyTexts{ "import Shared;\n", "static const uint k_Size = 64;\n" };
+
+    CookerOptions options;
+    options.ModuleCacheDirectory = directory / "cache";
+
+    runner.BeginSection("a stamp hits while its inputs stay the same");
+    const ModuleStampStore stamps{ options.ModuleCacheDirectory, "ShaderLibrary.hpp" };
+    runner.Check(!stamps.FindUnchanged(options, modulePath).has_value(), "a module with no stamp misses");
+
+    stamps.Store(options, modulePath, dependencyPaths, dependencyTexts, sample);
+    const std::optional<ModuleArtifacts> hit = stamps.FindUnchanged(options, modulePath);
+    runner.Check(hit.has_value() && hit->Source == sample.Source, "a stamped module hits with its artifacts");
+    runner.Check(!ModuleStampStore({}, "ShaderLibrary.hpp").FindUnchanged(options, modulePath).has_value(),
+                 "a disabled store misses");
+
+    runner.BeginSection("a stamp misses once any input changes");
+    runner.Check(!ModuleStampStore(options.ModuleCacheDirectory, "Other.hpp")
+                      .FindUnchanged(options, modulePath)
+                      .has_value(),
+                 "another header name misses");
+
+    CookerOptions optimized = options;
+    optimized.OptimizationLevel = 2u;
+    runner.Check(!stamps.FindUnchanged(optimized, modulePath).has_value(),
+                 "another optimization level misses");
+
+    CookerOptions undeduped = options;
+    undeduped.DedupeEnabled = false;
+    runner.Check(!stamps.FindUnchanged(undeduped, modulePath).has_value(), "turning dedupe off misses");
+
+    WriteTextFile(includePath, "static const uint k_Size = 128;\n");
+    runner.Check(!stamps.FindUnchanged(options, modulePath).has_value(), "an edited import misses");
+
+    WriteTextFile(includePath, "static const uint k_Size = 64;\n");
+    runner.Check(stamps.FindUnchanged(options, modulePath).has_value(), "undoing the edit hits again");
+
+    std::error_code ignored;
+    std::filesystem::remove(includePath, ignored);
+    runner.Check(!stamps.FindUnchanged(options, modulePath).has_value(), "a deleted import misses");
+
+    std::filesystem::remove_all(directory, ignored);
+    return runner.Report();
+}
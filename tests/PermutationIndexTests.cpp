@@ -184,6 +184,49 @@ int main()
 
     runner.Check(matchesRealVariant, "the partial assignment names a variant the cook produced");
 
+    runner.BeginSection("a chain of dependent axes is only as active as its first link");
+    // C depends on B, and B on A. When A disables B, C must be disabled too, rather than fail the cook
+    // because its parent is absent.
+    const PermutationSpace chainSpace{
+        "Chain",
+        { PermutationAxis{ "CHAIN_A",
+                           { PermutationValue{ false }, PermutationValue{ true } },
+                           PermutationAxis::k_NoParent,
+                           PermutationValue{} },
+          PermutationAxis{ "CHAIN_B",
+                           { PermutationValue{ false }, PermutationValue{ true } },
+                           0,
+                           PermutationValue{ true } },
+          PermutationAxis{ "CHAIN_C",
+                           { PermutationValue{ 1u }, PermutationValue{ 2u } },
+                           1,
+                           PermutationValue{ true } } }
+    };
+    const CookResult<VariantSet> chainVariants = chainSpace.EnumerateVariants();
+    runner.Check(chainVariants.has_value(), "a two-level chain enumerates");
+    if (chainVariants)
+    {
+        // A=false; A=true,B=false; A=true,B=true,C=1; A=true,B=true,C=2.
+        runner.Check(chainVariants.value().Variants.size() == 4u,
+                     "each link adds only the values it enables");
+        runner.Check(chainVariants.value().Variants.front().Active.size() == 1u,
+                     "a disabled link leaves every axis after it out of Active");
+    }
+
+    const PermutationSpace backwardSpace{
+        "Backward",
+        { PermutationAxis{ "LATE_CHILD",
+                           { PermutationValue{ false }, PermutationValue{ true } },
+                           1,
+                           PermutationValue{ true } },
+          PermutationAxis{ "LATE_PARENT",
+                           { PermutationValue{ false }, PermutationValue{ true } },
+                           PermutationAxis::k_NoParent,
+                           PermutationValue{} } }
+    };
+    runner.Check(!backwardSpace.EnumerateVariants().has_value(),
+                 "a parent declared after its child still fails");
+
     runner.BeginSection("a module with no registered space still cooks");
     const PermutationSpace emptySpace{ "", {} };
     const CookResult<VariantSet> emptyVariants = emptySpace.EnumerateVariants();
@@ -0,0 +1,210 @@
+#include "compile/RawLibrary.hpp"
+#include "compile/RawVariantCache.hpp"
+#include "model/ShaderDataSchema.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "TestHarness.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <system_error>
+
+// The variant cache lets a cook skip Slang, so a wrong hit ships a shader that the sources no longer
+// describe. This file proves the three things that keep a hit honest, without a compiler: the bytes
+// carry every field, a damaged file reads as a miss, and a key that differs in any input misses.
+
+using lodestone::BoundPlacement;
+using lodestone::CookResult;
+using lodestone::PermutationAxis;
+using lodestone::PermutationSpace;
+using lodestone::PermutationValue;
+using lodestone::RawBinding;
+using lodestone::RawEntryPoint;
+using lodestone::RawSizeAttribute;
+using lodestone::RawSizeAttributeKind;
+using lodestone::RawVariant;
+using lodestone::RawVariantCache;
+using lodestone::VariantSet;
+
+namespace
+{
+
+const PermutationSpace k_TestSpace{
+    "CacheTestSpace",
+    { PermutationAxis{ "TEST_SIZE",
+                       { PermutationValue{ 128u }, PermutationValue{ 256u } },
+                       PermutationAxis::k_NoParent,
+                       PermutationValue{} },
+      PermutationAxis{ "TEST_USE_WAVE_OPS",
+                       { PermutationValue{ false }, PermutationValue{ true } },
+                       PermutationAxis::k_NoParent,
+                       PermutationValue{} } } };
+
+/** One of every record, and a binding with no placement, because that is the case a careless writer
+ * flattens into group 0 binding 0. */
+RawVariant MakeSampleVariant()
+{
+    RawVariant variant;
+    variant.VariantSuffix = "_TEST_SIZE_128";
+    variant.VariantDescription = "TEST_SIZE=128";
+    variant.VariantIndex = 0u;
+
+    RawBinding& spectrum = variant.Bindings.emplace_back();
+    spectrum.Name = "spectrum";
+    spectrum.ScopeName = "";
+    spectrum.Placement = BoundPlacement{ .Group = 0u, .Binding = 3u };
+    spectrum.Kind = lodestone::BindingKind::StorageBuffer;
+    spectrum.ElementStride = 8u;
+    spectrum.ByteSize = 0x1'0000'0000u;
+
+    RawBinding& parameters = variant.Bindings.emplace_back();
+    parameters.Name = "parameters";
+    parameters.ScopeName = "Block";
+    parameters.Kind = lodestone::BindingKind::UniformBuffer;
+    parameters.UniformMembers.push_back({ .Name = "time", .Offset = 0u, .Size = 4u, .ArrayCount = 1u });
+    parameters.UniformMembers.push_back({ .Name = "scale", .Offset = 16u, .Size = 16u, .ArrayCount = 2u });
+
+    variant.SizeAttributes.push_back(RawSizeAttribute{
+        .BindingIndex = 0u, .Kind = RawSizeAttributeKind::ElementCount, .Arguments = { "TEST_SIZE * 2" } });
+
+    RawEntryPoint& entryPoint = variant.EntryPoints.emplace_back();
+    entryPoint.Name = "MainCS";
+    entryPoint.VariantSuffix = variant.VariantSuffix;
+    entryPoint.Stage = lodestone::ShaderStageKind::Compute;
+    entryPoint.Workgroup = { .X = 64u, .Y = 1u, .Z = 1u };
+    entryPoint.TargetText = "@compute @workgroup_size(64) fn MainCS() {}\n";
+    entryPoint.UsedBindingIndices = { 0u, 1u };
+    entryPoint.Raster.WritesFragDepth = true;
+
+    return variant;
+}
+
+std::filesystem::path MakeScratchDirectory()
+{
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "lodestone_raw_variant_cache_test";
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+    return directory;
+}
+
+/** The one file the cache wrote. The test stores exactly one variant, so there is nothing to pick. */
+std::optional<std::filesystem::path> FindOnlyEntry(const std::filesystem::path& directory)
+{
+    std::error_code ignored;
+    for (const std::filesystem::directory_entry& entry :
+         std::filesystem::directory_iterator{ directory / "variants", ignored })
+    {
+        return entry.path();
+    }
+
+    return std::nullopt;
+}
+
+} // namespace
+
+int main()
+{
+    lodestone::tests::TestRunner runner{ "RawVariantCacheTests" };
+
+    const CookResult<VariantSet> variantSet = k_TestSpace.EnumerateVariants();
+    runner.Check(variantSet.has_value() && variantSet.value().Variants.size() == 4u,
+                 "the test space expands to four variants");
+    if (!variantSet || variantSet.value().Variants.size() != 4u)
+    {
+        return runner.Report();
+    }
+
+    const lodestone::VariantDescriptor& first = variantSet.value().Variants[0];
+    const lodestone::VariantDescriptor& second = variantSet.value().Variants[1];
+
+    runner.BeginSection("a variant survives a round trip through bytes");
+    const RawVariant sample = MakeSampleVariant();
+    const std::string bytes = lodestone::SerializeRawVariant(sample);
+    const CookResult<RawVariant> readBack = lodestone::DeserializeRawVariant(bytes);
+    runner.Check(readBack.has_value(), "the serialized bytes read back");
+    if (readBack)
+    {
+        runner.Check(lodestone::SerializeRawVariant(readBack.value()) == bytes,
+                     "writing the read-back variant again yields the same bytes");
+        runner.Check(readBack->Bindings.size() == 2u &&
+                         readBack->Bindings[0].ByteSize == sample.Bindings[0].ByteSize,
+                     "a 64-bit byte size keeps its high half");
+        runner.Check(readBack->Bindings.size() == 2u &&
+                         lodestone::GetBoundPlacement(readBack->Bindings[1].Placement) == nullptr,
+                     "a binding with no placement still has none");
+        runner.Check(readBack->Bindings.size() == 2u && readBack->Bindings[1].UniformMembers ==
+                                                            sample.Bindings[1].UniformMembers,
+                     "uniform members keep their names, offsets, and counts");
+        runner.Check(readBack->EntryPoints.size() == 1u &&
+                         readBack->EntryPoints[0].VariantSuffix == sample.VariantSuffix &&
+                         readBack->EntryPoints[0].TargetText == sample.EntryPoints[0].TargetText &&
+                         readBack->EntryPoints[0].Raster == sample.EntryPoints[0].Raster,
+                     "the entry point keeps its text, its raster state, and the variant suffix");
+    }
+
+    runner.BeginSection("a cut or padded payload is rejected");
+    bool everyPrefixRejected = true;
+    for (size_t length = 0u; length < bytes.size(); ++length)
+    {
+        if (lodestone::DeserializeRawVariant(std::string_view{ bytes }.substr(0u, length)))
+        {
+            everyPrefixRejected = false;
+        }
+    }
+    runner.Check(everyPrefixRejected, "no strict prefix of the bytes reads as a variant");
+    runner.Check(!lodestone::DeserializeRawVariant(bytes + '\0'), "a trailing byte is rejected");
+
+    runner.BeginSection("the cache hands back what it stored, and only for the same key");
+    const std::filesystem::path directory = MakeScratchDirectory();
+    const RawVariantCache cache{ directory, 0xC0FFEEu };
+    runner.Check(!cache.Load(first).has_value(), "an empty cache misses");
+    runner.Check(!cache.Contains(first), "an empty cache contains nothing");
+
+    cache.Store(first, sample);
+    runner.Check(cache.Contains(first) && !cache.Contains(second), "the cache contains only what it stored");
+    const std::optional<RawVariant> hit = cache.Load(first);
+    runner.Check(hit.has_value(), "a stored variant hits");
+    if (hit)
+    {
+        runner.Check(hit->VariantIndex == static_cast<uint32_t>(first.Index),
+                     "a hit takes its index from the descriptor");
+        runner.Check(hit->EntryPoints.size() == 1u &&
+                         hit->EntryPoints[0].TargetText == sample.EntryPoints[0].TargetText,
+                     "a hit carries the stored target text");
+    }
+
+    runner.Check(!cache.Load(second).has_value(), "another assignment misses");
+    runner.Check(!RawVariantCache(directory, 0xC0FFEFu).Load(first).has_value(),
+                 "another compile input hash misses");
+    runner.Check(!RawVariantCache({}, 0xC0FFEEu).Load(first).has_value(), "a disabled cache misses");
+
+    runner.BeginSection("a damaged file reads as a miss");
+    const std::optional<std::filesystem::path> entryPath = FindOnlyEntry(directory);
+    runner.Check(entryPath.has_value(), "the cache wrote one file");
+    if (entryPath)
+    {
+        std::string content;
+        {
+            std::ifstream file{ entryPath.value(), std::ios::binary };
+            content.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+        }
+
+        content.back() = static_cast<char>(content.back() ^ 0x5A);
+        {
+            std::ofstream file{ entryPath.value(), std::ios::binary | std::ios::trunc };
+            file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
+
+        runner.Check(!cache.Load(first).has_value(), "a flipped payload byte misses");
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+    return runner.Report();
+}
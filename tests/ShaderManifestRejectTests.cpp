@@ -159,5 +159,15 @@ int main()
     runner.Check(ErrorFrom(badSection) == ShaderManifestError::SectionOutOfBounds,
                  "a section that reaches past the file is SectionOutOfBounds");
 
+    // The lookup runs are indexed without a test on every find, so Open checks each one.
+    lodestone::ShaderManifestHeader header{};
+    std::memcpy(&header, valid.data(), sizeof(header));
+    std::vector<std::byte> badLookup = valid;
+    WriteUint32(badLookup,
+                header.NameLookupTableOffset + offsetof(lodestone::ManifestNameLookup, BucketCount),
+                header.NameBucketCount + 1u);
+    runner.Check(ErrorFrom(badLookup) == ShaderManifestError::SectionOutOfBounds,
+                 "a name lookup whose buckets reach past the bucket table is SectionOutOfBounds");
+
     return runner.Report();
 }
@@ -0,0 +1,286 @@
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "emit/ShaderPackEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "MappedShaderManifest.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderPack.hpp"
+#include "TestHarness.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Shader packs: every module of a pack is found by name and reads the same as its own manifest, a pack
+// whose header or table of contents is damaged fails to open, and a damaged module fails only when a
+// program asks for it.
+//
+// This test needs no Slang, no compiler, and no asset. The mapped pack goes to the temp directory.
+
+using namespace lodestone;
+
+namespace
+{
+
+/** One compute entry point, one variant, one source that names the module. */
+CookedModule MakeModule(std::string name)
+{
+    CookedModule module;
+    module.Name = std::move(name);
+    module.SpaceSize = 1u;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.Sources.push_back("fn MainCS() { let module = \"" + module.Name + "\"; }\n");
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+
+    LibraryVariant variant;
+    variant.Suffix = "_Default";
+    variant.Description = "default";
+    variant.SourceIndices.push_back(0u);
+    variant.VisibilityIndices.push_back(0u);
+    variant.RasterIndices.push_back(0u);
+    variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+    module.Variants.emplace_back(std::move(variant));
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& bytes)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(bytes.data()), bytes.size() };
+}
+
+template<typename T>
+ShaderManifestError ErrorFrom(const ManifestResult<T>& result)
+{
+    return result.has_value() ? ShaderManifestError::Success : result.error();
+}
+
+ShaderPackHeader ReadHeader(const std::string& pack)
+{
+    ShaderPackHeader header{};
+    std::memcpy(&header, pack.data(), sizeof(ShaderPackHeader));
+    return header;
+}
+
+std::string WithHeader(std::string pack, const ShaderPackHeader& header)
+{
+    std::memcpy(pack.data(), &header, sizeof(ShaderPackHeader));
+    return pack;
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "ShaderPackTests" };
+
+    std::vector<CookedModule> modules;
+    std::vector<std::string> manifests;
+    for (const char* name : { "Blur", "Bloom", "Tonemap", "Particles", "Shadows" })
+    {
+        modules.push_back(MakeModule(name));
+        manifests.push_back(EmitShaderManifest(modules.back()));
+    }
+
+    std::vector<ShaderPackEntry> entries;
+    for (size_t i = 0u; i < modules.size(); ++i)
+    {
+        entries.push_back(ShaderPackEntry{ .ModuleName = modules[i].Name, .Manifest = manifests[i] });
+    }
+
+    const std::string pack = EmitShaderPack(entries);
+
+    runner.BeginSection("every module is found by name");
+    const ManifestResult<ShaderPackView> opened = ShaderPackView::Open(AsBytes(pack));
+    runner.Check(opened.has_value(), "the pack opens");
+    if (!opened)
+    {
+        return runner.Report();
+    }
+
+    const ShaderPackView& view = opened.value();
+    runner.Check(view.ModuleCount() == modules.size(), "the pack counts every module");
+    runner.Check(view.Slots().size() >= 2u * modules.size() && std::has_single_bit(view.Slots().size()),
+                 "the table has a power-of-two slot count at least twice the module count");
+    runner.Check(VerifyShaderPackRoundTrip(entries, pack).has_value(), "the cooker's own check passes");
+
+    for (size_t i = 0u; i < modules.size(); ++i)
+    {
+        const ManifestResult<ShaderManifestView> found = view.Find(modules[i].Name);
+        runner.Check(found.has_value() && found.value().ModuleName() == modules[i].Name &&
+                         found.value().Source(0u) == modules[i].Sources[0],
+                     "a found module reads its own name and source");
+    }
+
+    runner.Check(ErrorFrom(view.Find("Missing")) == ShaderManifestError::ModuleNotFound,
+                 "a name the pack does not hold is ModuleNotFound");
+    runner.Check(ErrorFrom(view.Find("")) == ShaderManifestError::ModuleNotFound,
+                 "an empty name is ModuleNotFound");
+
+    runner.BeginSection("each module sits in the pack as it would alone");
+    bool inPlace = true;
+    for (const ShaderPackSlot& slot : view.Slots())
+    {
+        if (slot.Size == 0u)
+        {
+            continue;
+        }
+
+        const std::string_view bytes = std::string_view{ pack }.substr(slot.Offset, slot.Size);
+        bool known = false;
+        for (const std::string& manifest : manifests)
+        {
+            known = known || bytes == manifest;
+        }
+
+        inPlace = inPlace && known && (slot.Offset % 8u) == 0u;
+    }
+
+    runner.Check(inPlace, "every slot holds one manifest byte for byte, on an 8-byte boundary");
+
+    runner.BeginSection("a damaged header or table of contents fails to open");
+    ShaderPackHeader header = ReadHeader(pack);
+    header.Magic = 0u;
+    runner.Check(ErrorFrom(ShaderPackView::Open(AsBytes(WithHeader(pack, header)))) ==
+                     ShaderManifestError::BadMagic,
+                 "a wrong magic is BadMagic");
+
+    header = ReadHeader(pack);
+    header.Version += 1u;
+    runner.Check(ErrorFrom(ShaderPackView::Open(AsBytes(WithHeader(pack, header)))) ==
+                     ShaderManifestError::VersionMismatch,
+                 "another version is VersionMismatch");
+
+    runner.Check(ErrorFrom(ShaderPackView::Open(AsBytes(pack.substr(0u, pack.size() - 8u)))) ==
+                     ShaderManifestError::SizeMismatch,
+                 "a truncated pack is SizeMismatch");
+
+    header = ReadHeader(pack);
+    header.SlotCount += 1u;
+    runner.Check(ErrorFrom(ShaderPackView::Open(AsBytes(WithHeader(pack, header)))) ==
+                     ShaderManifestError::SectionOutOfBounds,
+                 "a slot count that is not a power of two is SectionOutOfBounds");
+
+    header = ReadHeader(pack);
+    header.SlotTableOffset = header.FileSize;
+    runner.Check(ErrorFrom(ShaderPackView::Open(AsBytes(WithHeader(pack, header)))) ==
+                     ShaderManifestError::SectionOutOfBounds,
+                 "a table of contents past the end is SectionOutOfBounds");
+
+    runner.BeginSection("a damaged module fails only when it is found");
+    std::string damaged = pack;
+    const std::string_view damagedName = modules[2].Name;
+    for (const ShaderPackSlot& slot : view.Slots())
+    {
+        if (slot.Size != 0u && slot.NameHash == HashShaderPackName(damagedName))
+        {
+            damaged[slot.Offset] = '\0';
+        }
+    }
+
+    const ManifestResult<ShaderPackView> damagedView = ShaderPackView::Open(AsBytes(damaged));
+    runner.Check(damagedView.has_value(), "a pack with one damaged module still opens");
+    if (damagedView.has_value())
+    {
+        runner.Check(ErrorFrom(damagedView.value().Find(damagedName)) == ShaderManifestError::BadMagic,
+                     "finding the damaged module reports its own error");
+        runner.Check(damagedView.value().Find(modules[0].Name).has_value(),
+                     "every other module still opens");
+    }
+
+    runner.BeginSection("a pack of shared modules carries the library source file");
+    std::vector<ModuleArtifacts> artifacts;
+    for (size_t i = 0u; i < modules.size(); ++i)
+    {
+        ModuleArtifacts module;
+        module.Name = modules[i].Name;
+        module.Manifest = manifests[i];
+        module.ManifestFileName = MakeManifestFileName(modules[i].Name);
+        artifacts.push_back(std::move(module));
+    }
+
+    const CookResult<LibraryTables> library = FoldLibraryTables(artifacts, true);
+    if (!library)
+    {
+        runner.Check(false, "the library tables fold");
+        return runner.Report();
+    }
+
+    const std::string librarySources = EmitLibrarySourceManifest("ShaderLibrary", library.value().Sources);
+    std::vector<std::string> sharedManifests;
+    for (size_t i = 0u; i < modules.size(); ++i)
+    {
+        const CookResult<std::string> shared =
+            ShareManifestSources(manifests[i], library.value().SourceRemaps[i]);
+        sharedManifests.push_back(shared.has_value() ? shared.value() : std::string{});
+    }
+
+    std::vector<ShaderPackEntry> sharedEntries;
+    for (size_t i = 0u; i < modules.size(); ++i)
+    {
+        sharedEntries.push_back(
+            ShaderPackEntry{ .ModuleName = modules[i].Name, .Manifest = sharedManifests[i] });
+    }
+
+    const std::string sharedPack = EmitShaderPack(sharedEntries, librarySources);
+    runner.Check(VerifyShaderPackRoundTrip(sharedEntries, sharedPack).has_value(),
+                 "the cooker's own check passes on a shared pack");
+    const ManifestResult<ShaderPackView> sharedView = ShaderPackView::Open(AsBytes(sharedPack));
+    if (sharedView.has_value())
+    {
+        runner.Check(sharedView.value().HasSharedSources(), "the pack says it holds the library sources");
+        const ManifestResult<ShaderManifestView> found = sharedView.value().Find(modules[3].Name);
+        runner.Check(found.has_value() && found.value().SharesLibrarySources() &&
+                         found.value().Source(found.value().SlotTable()[0].SourceIndex) ==
+                             modules[3].Sources[0],
+                     "a shared module reads its text from the packed library source file");
+    }
+    else
+    {
+        runner.Check(false, "the shared pack opens");
+    }
+
+    runner.BeginSection("a pack maps from disk");
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "lodestone_shader_pack_test";
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+    std::filesystem::create_directories(directory, ignored);
+    const std::filesystem::path packPath = directory / MakeShaderPackFileName("ShaderLibrary");
+    {
+        std::ofstream file{ packPath, std::ios::binary | std::ios::trunc };
+        file.write(sharedPack.data(), static_cast<std::streamsize>(sharedPack.size()));
+    }
+
+    ManifestResult<MappedShaderPack> mapped = MappedShaderPack::Open(packPath);
+    runner.Check(mapped.has_value(), "the pack maps and opens");
+    if (mapped.has_value())
+    {
+        MappedShaderPack moved = std::move(mapped.value());
+        const ManifestResult<ShaderManifestView> found = moved.View().Find(modules[1].Name);
+        runner.Check(found.has_value() &&
+                         found.value().Source(found.value().SlotTable()[0].SourceIndex) ==
+                             modules[1].Sources[0],
+                     "a module of the mapped pack reads after the pack moved");
+    }
+
+    runner.Check(ErrorFrom(MappedShaderPack::Open(directory / "missing.ldpack")) ==
+                     ShaderManifestError::FileOpenFailed,
+                 "a missing pack is FileOpenFailed");
+
+    std::filesystem::remove_all(directory, ignored);
+    return runner.Report();
+}
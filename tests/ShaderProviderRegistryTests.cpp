@@ -0,0 +1,228 @@
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "MappedShaderManifest.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderProviderRegistry.hpp"
+#include "TestHarness.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// The provider registry: a hot reload swaps in a new manifest while render threads read sources out of
+// the old one. A pinned provider and its bytes outlive the swap, are freed once the last pin on them
+// goes, and a reader never sees text from a manifest that was freed under it.
+//
+// This test needs no Slang, no compiler, and no asset. It writes one file to the temp directory.
+
+using namespace lodestone;
+
+namespace
+{
+
+constexpr uint32_t k_VariantCount = 4u;
+constexpr uint32_t k_ReaderThreadCount = 4u;
+constexpr uint64_t k_ReloadCount = 200u;
+
+/** Every source names its generation and variant, so a reader can tell which manifest it read. */
+std::string ExpectedSource(uint64_t generation, uint32_t variant_index)
+{
+    return std::format("fn MainCS() {{ let generation{} = {}u; }}\n", generation, variant_index);
+}
+
+CookedModule MakeModule(uint64_t generation)
+{
+    CookedModule module;
+    module.Name = "Reloaded";
+    module.SpaceSize = k_VariantCount;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+
+    for (uint32_t i = 0u; i < k_VariantCount; ++i)
+    {
+        LibraryVariant variant;
+        variant.Index = i;
+        variant.Suffix = "_" + std::to_string(i);
+        variant.Description = "variant " + std::to_string(i);
+        variant.SourceIndices.push_back(i);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Sources.push_back(ExpectedSource(generation, i));
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+/** Publishes the manifest of one generation from memory. `watch` sees its bytes go when they are freed. */
+uint64_t PublishGeneration(ShaderProviderRegistry& registry,
+                           uint64_t generation,
+                           std::weak_ptr<const std::string>* watch = nullptr)
+{
+    auto bytes = std::make_shared<const std::string>(EmitShaderManifest(MakeModule(generation)));
+    const ManifestResult<ShaderManifestView> view = ShaderManifestView::Open(AsBytes(*bytes));
+    if (!view)
+    {
+        return 0u;
+    }
+
+    if (watch != nullptr)
+    {
+        *watch = bytes;
+    }
+
+    return registry.Publish(std::make_unique<ManifestShaderSourceProvider>(view.value(), generation),
+                            std::move(bytes));
+}
+
+/** Each render thread pins, reads every variant, and checks the text against the generation it pinned,
+ * until the last reload lands. Returns how many reads came back wrong. */
+uint32_t ReadWhileReloading(ShaderProviderRegistry& registry)
+{
+    std::atomic<uint32_t> mismatches{ 0u };
+    std::atomic<bool> reloading{ true };
+    {
+        std::vector<std::jthread> threads;
+        for (uint32_t t = 0u; t < k_ReaderThreadCount; ++t)
+        {
+            threads.emplace_back(
+                [&registry, &mismatches, &reloading]
+                {
+                    ShaderProviderRegistry::Reader reader = registry.AttachReader();
+                    while (reloading.load(std::memory_order_acquire))
+                    {
+                        const ShaderProviderRegistry::PinnedProvider pinned = reader.Pin();
+                        const uint64_t generation = pinned->Generation();
+                        for (uint32_t i = 0u; i < k_VariantCount; ++i)
+                        {
+                            if (pinned->Source(1u, i) != ExpectedSource(generation, i))
+                            {
+                                mismatches.fetch_add(1u, std::memory_order_relaxed);
+                            }
+                        }
+                    }
+                });
+        }
+
+        for (uint64_t generation = 2u; generation <= k_ReloadCount; ++generation)
+        {
+            PublishGeneration(registry, generation);
+        }
+
+        reloading.store(false, std::memory_order_release);
+    }
+
+    return mismatches.load();
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "ShaderProviderRegistryTests" };
+
+    runner.BeginSection("an empty registry pins nothing");
+    {
+        ShaderProviderRegistry registry;
+        ShaderProviderRegistry::Reader reader = registry.AttachReader();
+        const ShaderProviderRegistry::PinnedProvider pinned = reader.Pin();
+        runner.Check(!pinned && registry.Generation() == 0u,
+                     "a pin before the first publish holds no provider");
+    }
+
+    runner.BeginSection("a pin keeps the provider it took through a reload");
+    {
+        ShaderProviderRegistry registry;
+        std::weak_ptr<const std::string> firstBytes;
+        runner.Check(PublishGeneration(registry, 1u, &firstBytes) == 1u && registry.Generation() == 1u,
+                     "a publish returns the provider's generation");
+
+        ShaderProviderRegistry::Reader renderThread = registry.AttachReader();
+        ShaderProviderRegistry::Reader otherThread = registry.AttachReader();
+        {
+            const ShaderProviderRegistry::PinnedProvider pinned = renderThread.Pin();
+            const std::string_view source = pinned->Source(1u, 2u);
+            PublishGeneration(registry, 2u);
+
+            runner.Check(registry.Generation() == 2u && pinned->Generation() == 1u,
+                         "the registry moves on, and the pin keeps the provider it took");
+            runner.Check(!firstBytes.expired() && source == ExpectedSource(1u, 2u),
+                         "a source read before the reload still reads from the old bytes");
+            runner.Check(registry.Reclaim() == 1u, "the old provider waits while it is pinned");
+
+            const ShaderProviderRegistry::PinnedProvider fresh = otherThread.Pin();
+            const ShaderProviderRegistry::PinnedProvider nested = renderThread.Pin();
+            runner.Check(fresh->Generation() == 2u && nested->Generation() == 2u,
+                         "a pin taken after the reload sees the new provider, nested or not");
+        }
+
+        runner.Check(registry.Reclaim() == 0u && firstBytes.expired(),
+                     "the old provider and its bytes go once the last pin on them does");
+    }
+
+    runner.BeginSection("render threads read while the manifest is swapped");
+    {
+        ShaderProviderRegistry registry;
+        PublishGeneration(registry, 1u);
+        runner.Check(ReadWhileReloading(registry) == 0u,
+                     "every read matches the generation of the provider it pinned");
+        runner.Check(registry.Generation() == k_ReloadCount && registry.Reclaim() == 0u,
+                     "after the readers stop, the last reload is current and nothing is left retired");
+
+        ShaderProviderRegistry::Reader reader = registry.AttachReader();
+        runner.Check(reader.Pin()->Source(1u, 0u) == ExpectedSource(k_ReloadCount, 0u),
+                     "a reader that attaches later reuses a slot and reads the last reload");
+    }
+
+    runner.BeginSection("a mapped manifest is published one generation on");
+    {
+        const std::filesystem::path directory =
+            std::filesystem::temp_directory_path() / "lodestone_provider_registry_test";
+        std::error_code ignored;
+        std::filesystem::create_directories(directory, ignored);
+        const std::filesystem::path path = directory / "Reloaded.manifest";
+        {
+            const std::string manifest = EmitShaderManifest(MakeModule(8u));
+            std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+            file.write(manifest.data(), static_cast<std::streamsize>(manifest.size()));
+        }
+
+        ShaderProviderRegistry registry;
+        PublishGeneration(registry, 7u);
+        ManifestResult<MappedShaderManifest> mapped = MappedShaderManifest::Open(path);
+        runner.Check(mapped.has_value(), "the manifest maps");
+        if (mapped)
+        {
+            runner.Check(registry.Publish(std::move(mapped.value())) == 8u,
+                         "the mapped manifest is generation 8");
+            ShaderProviderRegistry::Reader reader = registry.AttachReader();
+            runner.Check(reader.Pin()->Source(1u, 3u) == ExpectedSource(8u, 3u),
+                         "its sources read through the mapping the registry keeps");
+        }
+
+        std::filesystem::remove_all(directory, ignored);
+    }
+
+    return runner.Report();
+}
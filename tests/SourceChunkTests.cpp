@@ -0,0 +1,244 @@
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "model/SourceChunker.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Chunked sources: the chunker cuts where the content says to, an edit moves only the cuts near it,
+// and a manifest that stores its sources as chunks reads back the same text by every path a loader has.
+//
+// This test needs no Slang, no compiler, and no asset. The sources are generated WGSL-shaped text, long
+// enough to cut into a few dozen chunks.
+
+using namespace lodestone;
+
+namespace
+{
+
+/** One function per block, each line different, so the hash sees varied bytes. `edited_line`, when in
+ * range, gets a different constant: the one-define difference between two variants. */
+std::string MakeSource(uint32_t edited_line)
+{
+    std::string source = "@group(0) @binding(0) var<storage, read_write> output : array<vec4<f32>>;\n";
+    for (uint32_t line = 0u; line < 240u; ++line)
+    {
+        if ((line % 20u) == 0u)
+        {
+            source += std::format("}}\n\nfn Block{}(index : u32) -> vec4<f32>\n{{\n", line / 20u);
+        }
+
+        const uint32_t scale = line == edited_line ? 97u : line % 11u;
+        source += std::format("    let v{} = output[index + {}u] * {}.0 + vec4<f32>(f32({}u));\n",
+                              line,
+                              (line * 7u) % 13u,
+                              scale,
+                              line);
+    }
+
+    source += "}\n";
+    return source;
+}
+
+bool JoinsBackTo(std::span<const std::string_view> chunks, std::string_view source)
+{
+    std::string joined;
+    for (const std::string_view chunk : chunks)
+    {
+        joined.append(chunk);
+    }
+
+    return joined == source;
+}
+
+bool ChunkSizesAreInBounds(std::span<const std::string_view> chunks)
+{
+    for (size_t i = 0u; i < chunks.size(); ++i)
+    {
+        const bool last = i + 1u == chunks.size();
+        if (chunks[i].size() > k_SourceChunkMaxSize || (!last && chunks[i].size() < k_SourceChunkMinSize))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** How many chunks of `edited` are also chunks of `original`. */
+size_t CountSharedChunks(std::string_view original, std::string_view edited)
+{
+    const std::vector<std::string_view> originalChunks = SplitSourceIntoChunks(original);
+    const std::unordered_set<std::string_view> known{ originalChunks.begin(), originalChunks.end() };
+
+    size_t shared = 0u;
+    for (const std::string_view chunk : SplitSourceIntoChunks(edited))
+    {
+        shared += known.contains(chunk) ? 1u : 0u;
+    }
+
+    return shared;
+}
+
+/** Two variants of one entry point, whose sources differ in one line. */
+CookedModule MakeModule(const std::string& first, const std::string& second)
+{
+    CookedModule module;
+    module.Name = "Chunked";
+    module.SpaceSize = 2u;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.Sources.push_back(first);
+    module.Sources.push_back(second);
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+
+    for (uint32_t i = 0u; i < 2u; ++i)
+    {
+        LibraryVariant variant;
+        variant.Index = i;
+        variant.Suffix = i == 0u ? "_A" : "_B";
+        variant.Description = i == 0u ? "first" : "second";
+        variant.SourceIndices.push_back(i);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+std::string JoinChunks(const ManifestSourceChunks& chunks)
+{
+    std::string joined;
+    for (const std::string_view chunk : chunks)
+    {
+        joined.append(chunk);
+    }
+
+    return joined;
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "SourceChunkTests" };
+
+    const std::string original = MakeSource(0xFFFFFFFFu);
+    const std::string edited = MakeSource(120u);
+
+    runner.BeginSection("the chunker cuts a source into pieces that join back to it");
+    const std::vector<std::string_view> chunks = SplitSourceIntoChunks(original);
+    runner.Check(chunks.size() > 4u, "a source of several kilobytes becomes several chunks");
+    runner.Check(JoinsBackTo(chunks, original), "the chunks, in order, are the source");
+    runner.Check(ChunkSizesAreInBounds(chunks), "every chunk but the last is between the bounds");
+    runner.Check(SplitSourceIntoChunks({}).empty(), "an empty source has no chunks");
+    runner.Check(SplitSourceIntoChunks("fn Tiny() {}\n").size() == 1u, "a short source is one chunk");
+
+    bool endsOnLines = true;
+    for (size_t i = 0u; i + 1u < chunks.size(); ++i)
+    {
+        endsOnLines = endsOnLines && chunks[i].ends_with('\n');
+    }
+    runner.Check(endsOnLines, "a cut in text of short lines falls at the end of a line");
+
+    const std::string longLine(3u * k_SourceChunkMaxSize, 'x');
+    const std::vector<std::string_view> longChunks = SplitSourceIntoChunks(longLine);
+    runner.Check(JoinsBackTo(longChunks, longLine) && ChunkSizesAreInBounds(longChunks),
+                 "a line longer than the largest chunk is cut inside the line");
+
+    runner.BeginSection("an edit moves only the cuts near it");
+    const size_t editedChunkCount = SplitSourceIntoChunks(edited).size();
+    const size_t shared = CountSharedChunks(original, edited);
+    runner.Check(editedChunkCount - shared <= 2u,
+                 "a variant that changes one line shares every chunk but the one or two around it");
+    runner.Check(CountSharedChunks(original, "// a new first line\n" + original) + 2u >= chunks.size(),
+                 "a line added at the top does not move the cuts below it");
+
+    runner.BeginSection("a manifest with chunked sources reads back the same text");
+    const CookedModule module = MakeModule(original, edited);
+    const std::string whole = EmitShaderManifest(module);
+    const std::string chunked = EmitShaderManifest(module, { .Layout = ManifestSourceLayout::Chunked });
+    runner.Check(chunked.size() + (original.size() / 2u) < whole.size(),
+                 "two near-identical sources cost little more than one");
+    runner.Check(VerifyManifestRoundTrip(module, chunked).has_value(),
+                 "the round-trip check reads every slot back through the provider");
+
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(AsBytes(chunked));
+    runner.Check(opened.has_value() && opened.value().HasChunkedSources(),
+                 "the manifest opens and says its sources are chunks");
+    if (!opened)
+    {
+        return runner.Report();
+    }
+
+    const ShaderManifestView& view = opened.value();
+    const ManifestSourceChunks editedChunks = view.SourceChunks(1u);
+    runner.Check(view.SourceCount() == 2u, "the source count counts sources, not chunks");
+    runner.Check(editedChunks.Count() > 1u && JoinChunks(editedChunks) == edited &&
+                     editedChunks.TotalSize() == edited.size(),
+                 "a source reads in place as its chunks, in order");
+    runner.Check(view.Source(1u).empty(), "a source of several chunks has no single view");
+
+    std::string buffer(edited.size(), '\0');
+    runner.Check(view.AssembleSource(1u, buffer) == edited, "a buffer of the total size receives the source");
+    std::string shortBuffer(edited.size() - 1u, '\0');
+    runner.Check(view.AssembleSource(1u, shortBuffer).empty(), "a buffer one byte short receives nothing");
+    runner.Check(view.SourceChunks(2u).Count() == 0u && view.AssembleSource(2u, buffer).empty(),
+                 "a source past the table has no chunks and assembles to nothing");
+
+    const ManifestShaderSourceProvider provider{ view, 0u };
+    runner.Check(provider.Source(1u, 0u) == original && provider.Source(1u, 1u) == edited,
+                 "the provider serves each variant's whole text");
+
+    runner.BeginSection("a manifest of whole sources reads the same way");
+    const ManifestResult<ShaderManifestView> wholeView = ShaderManifestView::Open(AsBytes(whole));
+    runner.Check(wholeView.has_value() && !wholeView.value().HasChunkedSources() &&
+                     wholeView.value().SourceChunks(1u).Count() == 1u &&
+                     wholeView.value().SourceChunks(1u)[0u] == wholeView.value().Source(1u),
+                 "a whole source is one chunk, the same view `Source` returns");
+
+    runner.BeginSection("the identity path keeps every chunk");
+    CookedModule undeduped = MakeModule(original, edited);
+    undeduped.SourceTable.DedupeEnabled = false;
+    const std::string identity = EmitShaderManifest(undeduped, { .Layout = ManifestSourceLayout::Chunked });
+    runner.Check(identity.size() > chunked.size() && VerifyManifestRoundTrip(undeduped, identity).has_value(),
+                 "with dedupe off, no chunk collapses and the text still reads back");
+
+    runner.BeginSection("the library pass reads chunked manifests");
+    ModuleArtifacts artifacts;
+    artifacts.Name = module.Name;
+    artifacts.Manifest = chunked;
+    artifacts.ManifestFileName = MakeManifestFileName(module.Name);
+    const std::vector<ModuleArtifacts> modules{ artifacts };
+    const CookResult<LibraryTables> folded = FoldLibraryTables(modules, true);
+    runner.Check(folded.has_value() && folded.value().Sources.size() == 2u &&
+                     folded.value().Sources[0] == original && folded.value().Sources[1] == edited,
+                 "the fold joins each chunked source into whole text");
+    runner.Check(!ShareManifestSources(chunked, folded.has_value() ? folded.value().SourceRemaps[0]
+                                                                    : std::vector<uint32_t>{})
+                      .has_value(),
+                 "a manifest with chunked sources does not rewrite onto the library source file");
+
+    return runner.Report();
+}
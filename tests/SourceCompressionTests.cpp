@@ -0,0 +1,347 @@
+#include "emit/LibraryTables.hpp"
+#include "emit/ModuleArtifacts.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "emit/SourceBlockEncoder.hpp"
+#include "model/CookedLibrary.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "SourceBlockCodec.hpp"
+#include "TestHarness.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Compressed sources: the block codec reads back what it wrote and refuses what it did not, and a
+// manifest that compresses its text reads back the same sources by every path a loader has.
+//
+// This test needs no Slang, no compiler, and no asset. The sources are generated WGSL-shaped text.
+
+using namespace lodestone;
+
+namespace
+{
+
+/** `line_count` lines of one function body, with enough repeats to compress and enough variety that
+ * the matcher must work for it. `salt` changes every constant, so two sources differ throughout. */
+std::string MakeSource(uint32_t line_count, uint32_t salt)
+{
+    std::string source = "@group(0) @binding(0) var<storage, read_write> output : array<vec4<f32>>;\n";
+    source += "fn MainCS(index : u32) -> vec4<f32>\n{\n";
+    for (uint32_t line = 0u; line < line_count; ++line)
+    {
+        source += std::format("    let v{} = output[index + {}u] * {}.0;\n", line, (line * 7u) % 13u, salt);
+    }
+
+    source += "}\n";
+    return source;
+}
+
+/** Variants of one small shader: the same declarations and helper, then a body of their own. This is
+ * what a dictionary is for, because each source is too short to find much of itself to match. */
+std::vector<std::string> MakeVariantSources(uint32_t count)
+{
+    std::vector<std::string> sources;
+    for (uint32_t variant = 0u; variant < count; ++variant)
+    {
+        std::string source = "struct Light\n{\n    position : vec3<f32>,\n    radius : f32,\n"
+                             "    color : vec3<f32>,\n    intensity : f32,\n};\n\n"
+                             "struct FrameConstants\n{\n    viewProjection : mat4x4<f32>,\n"
+                             "    cameraPosition : vec3<f32>,\n    lightCount : u32,\n};\n\n"
+                             "@group(0) @binding(0) var<uniform> frame : FrameConstants;\n"
+                             "@group(0) @binding(1) var<storage, read> lights : array<Light>;\n"
+                             "@group(0) @binding(2) var<storage, read_write> radiance : array<vec4<f32>>;\n\n"
+                             "fn Attenuate(light : Light, position : vec3<f32>) -> f32\n{\n"
+                             "    let distance = length(light.position - position);\n"
+                             "    return clamp(1.0 - distance / light.radius, 0.0, 1.0) * light.intensity;\n"
+                             "}\n\n"
+                             "@compute @workgroup_size(64, 1, 1)\n"
+                             "fn MainCS(@builtin(global_invocation_id) id : vec3<u32>)\n{\n";
+        source += std::format("    let tile = id.x * {}u + {}u;\n", variant + 2u, variant * 5u);
+        source += std::format("    var sum = vec3<f32>({}.0);\n", variant);
+        source += std::format(
+            "    for (var i = {}u; i < frame.lightCount; i += {}u)\n    {{\n", variant % 3u, 1u + variant);
+        source += std::format("        sum += lights[i].color * Attenuate(lights[i], vec3<f32>(f32(tile)))"
+                              " * {}.0;\n",
+                              variant * 3u);
+        source += "    }\n    radiance[tile] = vec4<f32>(sum, 1.0);\n}\n";
+        sources.push_back(std::move(source));
+    }
+
+    return sources;
+}
+
+/** Bytes that no LZ77 matcher shrinks: every four-byte window is new. */
+std::string MakeNoise(size_t size)
+{
+    std::string noise(size, '\0');
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (char& byte : noise)
+    {
+        state ^= state << 13u;
+        state ^= state >> 7u;
+        state ^= state << 17u;
+        byte = static_cast<char>(state & 0xFFu);
+    }
+
+    return noise;
+}
+
+bool RoundTrips(std::string_view input)
+{
+    const std::string block = EncodeSourceBlock(input);
+    std::string decoded(input.size(), '\0');
+    return DecodeSourceBlock(block, decoded) && decoded == input;
+}
+
+bool Decodes(std::string_view block, size_t size)
+{
+    std::string decoded(size, '\0');
+    return DecodeSourceBlock(block, decoded);
+}
+
+/** One variant for each source. */
+CookedModule MakeModule(std::vector<std::string> sources)
+{
+    CookedModule module;
+    module.Name = "Compressed";
+    module.SpaceSize = static_cast<uint32_t>(sources.size());
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+
+    for (uint32_t i = 0u; i < sources.size(); ++i)
+    {
+        LibraryVariant variant;
+        variant.Index = i;
+        variant.Suffix = std::format("_{}", i);
+        variant.Description = std::format("variant {}", i);
+        variant.SourceIndices.push_back(i);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    module.Sources = std::move(sources);
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+constexpr ManifestSourceOptions k_Compressed{ .Compression = ManifestSourceCompression::Blocks };
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "SourceCompressionTests" };
+
+    runner.BeginSection("a block decodes to the text it was encoded from");
+    const std::string source = MakeSource(200u, 3u);
+    runner.Check(RoundTrips({}), "an empty input round-trips");
+    runner.Check(RoundTrips("fn"), "an input shorter than a match round-trips");
+    runner.Check(RoundTrips(source), "a WGSL-shaped source round-trips");
+    runner.Check(EncodeSourceBlock(source).size() * 3u < source.size(),
+                 "a source full of repeats shrinks to less than a third");
+    runner.Check(RoundTrips(std::string(5000u, 'a')),
+                 "a run, which a match copies from its own output, round-trips");
+    runner.Check(RoundTrips(std::string(40u, 'x') + std::string(300u, 'y') + std::string(40u, 'x')),
+                 "literal and match lengths past a nibble round-trip");
+
+    const std::string noise = MakeNoise(k_SourceBlockSize);
+    runner.Check(RoundTrips(noise), "a full block of bytes that do not repeat round-trips");
+    runner.Check(EncodeSourceBlock(noise).size() > noise.size(), "bytes that do not repeat do not shrink");
+
+    runner.BeginSection("the decoder refuses a block it cannot trust");
+    const std::string block = EncodeSourceBlock(source);
+    runner.Check(!Decodes(block, source.size() - 1u) && !Decodes(block, source.size() + 1u),
+                 "a block decodes only into its own size");
+    runner.Check(!Decodes(block.substr(0u, block.size() / 2u), source.size()), "a truncated block fails");
+    runner.Check(!Decodes({}, 0u), "a block with no final sequence fails");
+    runner.Check(Decodes(std::string_view{ "\0", 1u }, 0u), "one empty final sequence decodes to nothing");
+
+    // One literal, then a match: token 0x10, literal 'a', offset, no more.
+    runner.Check(!Decodes(std::string_view{ "\x10" "a" "\x00\x00" "\x00", 5u }, 5u),
+                 "a zero offset fails");
+    runner.Check(!Decodes(std::string_view{ "\x10" "a" "\x02\x00" "\x00", 5u }, 5u),
+                 "an offset from before the output fails");
+    runner.Check(Decodes(std::string_view{ "\x10" "a" "\x01\x00" "\x00", 5u }, 5u),
+                 "the same block with an offset of one decodes to a run");
+    runner.Check(!Decodes(std::string_view{ "\xF0" "\xFF\xFF\xFF\xFF", 5u }, 64u),
+                 "a literal count that runs past the output fails");
+
+    runner.BeginSection("a manifest with compressed sources reads back the same text");
+    const CookedModule module = MakeModule({ source, MakeSource(180u, 5u) });
+    const std::string whole = EmitShaderManifest(module);
+    const std::string compressed = EmitShaderManifest(module, k_Compressed);
+    runner.Check(compressed.size() * 2u < whole.size(), "the manifest shrinks to less than half");
+    runner.Check(VerifyManifestRoundTrip(module, compressed).has_value(),
+                 "the round-trip check reads every slot back through the provider");
+
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(AsBytes(compressed));
+    runner.Check(opened.has_value() && opened.value().HasCompressedSources(),
+                 "the manifest opens and says its sources are compressed");
+    if (!opened)
+    {
+        return runner.Report();
+    }
+
+    const ShaderManifestView& view = opened.value();
+    runner.Check(view.SourceCount() == 2u && view.SourceSize(1u) == module.Sources[1].size(),
+                 "the view knows each source's size without decoding it");
+    runner.Check(view.Source(1u).empty() && view.SourceChunks(1u).Count() == 0u,
+                 "a compressed source has no view in place");
+
+    std::string buffer(module.Sources[1].size(), '\0');
+    runner.Check(view.AssembleSource(1u, buffer) == module.Sources[1],
+                 "a buffer of the size receives the source");
+    std::string shortBuffer(module.Sources[1].size() - 1u, '\0');
+    runner.Check(view.AssembleSource(1u, shortBuffer).empty(), "a buffer one byte short receives nothing");
+
+    const ManifestShaderSourceProvider provider{ view, 0u };
+    runner.Check(provider.Source(1u, 0u) == module.Sources[0] && provider.Source(1u, 1u) == module.Sources[1],
+                 "the provider serves each variant's whole text");
+
+    runner.BeginSection("a source longer than one block takes several");
+    const CookedModule large = MakeModule({ MakeSource(4000u, 7u), noise + source });
+    runner.Check(large.Sources[0].size() > 2u * k_SourceBlockSize, "the first source spans three blocks");
+    const std::string largeManifest = EmitShaderManifest(large, k_Compressed);
+    runner.Check(VerifyManifestRoundTrip(large, largeManifest).has_value(),
+                 "both sources read back, including the one whose first block is stored raw");
+
+    runner.BeginSection("chunks compress one by one");
+    const CookedModule near = MakeModule({ source, MakeSource(200u, 3u) + "// one more line\n" });
+    const std::string chunked = EmitShaderManifest(near, { .Layout = ManifestSourceLayout::Chunked });
+    const std::string both = EmitShaderManifest(
+        near, { .Layout = ManifestSourceLayout::Chunked, .Compression = ManifestSourceCompression::Blocks });
+    runner.Check(both.size() < chunked.size() && VerifyManifestRoundTrip(near, both).has_value(),
+                 "a chunked manifest compresses further and reads back the same text");
+
+    runner.BeginSection("the library pass reads and writes compressed sources");
+    ModuleArtifacts artifacts;
+    artifacts.Name = module.Name;
+    artifacts.Manifest = compressed;
+    artifacts.ManifestFileName = MakeManifestFileName(module.Name);
+    const std::vector<ModuleArtifacts> modules{ artifacts };
+    const CookResult<LibraryTables> folded = FoldLibraryTables(modules, true);
+    runner.Check(folded.has_value() && folded.value().Sources.size() == 2u &&
+                     folded.value().Sources[0] == module.Sources[0] &&
+                     folded.value().Sources[1] == module.Sources[1],
+                 "the fold decodes each source into whole text");
+    if (!folded)
+    {
+        return runner.Report();
+    }
+
+    const std::string librarySources =
+        EmitLibrarySourceManifest("ShaderLibrary", folded.value().Sources, ManifestSourceCompression::Blocks);
+    const CookResult<std::string> shared = ShareManifestSources(compressed, folded.value().SourceRemaps[0]);
+    runner.Check(shared.has_value() &&
+                     VerifySharedSourceRoundTrip(compressed, shared.value(), librarySources).has_value(),
+                 "a compressed manifest shares onto a compressed library source file and reads back");
+
+    const ManifestResult<ShaderManifestView> sources = ShaderManifestView::Open(AsBytes(librarySources));
+    runner.Check(sources.has_value() && sources.value().HasCompressedSources(),
+                 "the library source file says its sources are compressed");
+    if (shared.has_value() && sources.has_value())
+    {
+        const ManifestResult<ShaderManifestView> sharedView =
+            ShaderManifestView::Open(AsBytes(shared.value()), sources.value());
+        const bool decodes = sharedView.has_value() && sharedView.value().HasCompressedSources() &&
+                             ManifestShaderSourceProvider{ sharedView.value(), 0u }.Source(1u, 1u) ==
+                                 module.Sources[1];
+        runner.Check(decodes, "a shared manifest decodes its text from the library source file");
+    }
+
+    runner.BeginSection("the trainer keeps the lines that recur across sources");
+    const std::vector<std::string> variantSources = MakeVariantSources(24u);
+    const std::vector<std::string_view> samples{ variantSources.begin(), variantSources.end() };
+    const std::string dictionary = TrainSourceDictionary(samples, k_SourceDictionaryMaxSize);
+    runner.Check(dictionary.find("struct FrameConstants\n") != std::string::npos &&
+                     dictionary.find("light.intensity;\n") != std::string::npos,
+                 "the declarations and the helper every variant holds are in the dictionary");
+    runner.Check(dictionary.find("let tile") == std::string::npos,
+                 "a line that only one variant holds is not");
+    runner.Check(TrainSourceDictionary(samples, 64u).size() <= 64u,
+                 "the dictionary stays within the size it is given");
+    runner.Check(TrainSourceDictionary(std::span{ samples }.first(1u), k_SourceDictionaryMaxSize).empty(),
+                 "one source has nothing to share, so it trains no dictionary");
+    runner.Check(TrainSourceDictionary(samples, k_SourceDictionaryMaxSize) == dictionary,
+                 "the same sources train the same dictionary");
+
+    runner.BeginSection("a block encoded against a dictionary decodes only with it");
+    const std::string& small = variantSources[5];
+    const std::string against = EncodeSourceBlock(small, dictionary);
+    std::string decoded(small.size(), '\0');
+    runner.Check(DecodeSourceBlock(against, decoded, dictionary) && decoded == small,
+                 "a small source round-trips through the dictionary");
+    runner.Check(against.size() * 2u < EncodeSourceBlock(small).size(),
+                 "it encodes to less than half of what it does alone");
+    runner.Check(!DecodeSourceBlock(against, decoded), "without the dictionary, a match into it is refused");
+
+    // No literals, then a match of 8 from 4 back: the first four bytes come from the dictionary and the
+    // last four from what the match itself just wrote.
+    std::string run(8u, '\0');
+    runner.Check(DecodeSourceBlock(std::string_view{ "\x04" "\x04\x00" "\x00", 4u }, run, "abcd") &&
+                     run == "abcdabcd",
+                 "a match that starts in the dictionary runs on into the output");
+
+    runner.BeginSection("a manifest compresses its sources against one dictionary");
+    const CookedModule variants = MakeModule(variantSources);
+    const std::string plainBlocks = EmitShaderManifest(variants, k_Compressed);
+    const std::string withDictionary =
+        EmitShaderManifest(variants, { .Compression = ManifestSourceCompression::Dictionary });
+    runner.Check(withDictionary.size() * 2u < plainBlocks.size(),
+                 "small sources that share their declarations take less than half, dictionary included");
+    runner.Check(VerifyManifestRoundTrip(variants, withDictionary).has_value(),
+                 "the round-trip check reads every slot back through the provider");
+
+    const ManifestResult<ShaderManifestView> dictionaryView =
+        ShaderManifestView::Open(AsBytes(withDictionary));
+    runner.Check(dictionaryView.has_value() && dictionaryView.value().HasCompressedSources() &&
+                     dictionaryView.value().SourceDictionary() == dictionary,
+                 "the manifest holds the dictionary the sources trained");
+
+    std::string pastTheEnd = withDictionary;
+    const uint32_t fileSize = static_cast<uint32_t>(pastTheEnd.size());
+    std::memcpy(pastTheEnd.data() + offsetof(ShaderManifestHeader, SourceDictionarySize), &fileSize, 4u);
+    const ManifestResult<ShaderManifestView> damaged = ShaderManifestView::Open(AsBytes(pastTheEnd));
+    runner.Check(!damaged.has_value() && damaged.error() == ShaderManifestError::SectionOutOfBounds,
+                 "a dictionary that reaches past the file is SectionOutOfBounds");
+
+    runner.BeginSection("a library source file carries its own dictionary");
+    ModuleArtifacts variantArtifacts;
+    variantArtifacts.Name = variants.Name;
+    variantArtifacts.Manifest = withDictionary;
+    variantArtifacts.ManifestFileName = MakeManifestFileName(variants.Name);
+    const std::vector<ModuleArtifacts> variantModules{ variantArtifacts };
+    const CookResult<LibraryTables> variantTables = FoldLibraryTables(variantModules, true);
+    runner.Check(variantTables.has_value() && variantTables.value().Sources.size() == variantSources.size(),
+                 "the fold decodes every source through the dictionary");
+    if (variantTables.has_value())
+    {
+        const std::string libraryWithDictionary = EmitLibrarySourceManifest(
+            "ShaderLibrary", variantTables.value().Sources, ManifestSourceCompression::Dictionary);
+        const CookResult<std::string> sharedVariants =
+            ShareManifestSources(withDictionary, variantTables.value().SourceRemaps[0]);
+        const bool readsBack =
+            sharedVariants.has_value() && sharedVariants.value().size() < withDictionary.size() &&
+            VerifySharedSourceRoundTrip(withDictionary, sharedVariants.value(), libraryWithDictionary)
+                .has_value();
+        runner.Check(readsBack, "a shared manifest leaves its dictionary behind and uses the library's");
+    }
+
+    return runner.Report();
+}
@@ -0,0 +1,160 @@
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The sparse variant index: a space whose dependent axes leave most dense indices empty stores a rank
+// bitvector instead of one table entry for each index. Every index must find the variant the dense
+// table would have found, and every hole must find nothing.
+//
+// This test needs no Slang, no compiler, and no asset.
+
+using namespace lodestone;
+
+namespace
+{
+
+/** One entry point and one variant at each of `live_indices`, in the order given. */
+CookedModule MakeModule(uint32_t space_size, const std::vector<uint32_t>& live_indices)
+{
+    CookedModule module;
+    module.Name = "Sparse";
+    module.SpaceSize = space_size;
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+    module.Sources.push_back("// sparse");
+
+    for (const uint32_t index : live_indices)
+    {
+        LibraryVariant variant;
+        variant.Index = index;
+        variant.Suffix = "_" + std::to_string(index);
+        variant.Description = "variant " + std::to_string(index);
+        variant.SourceIndices.push_back(0u);
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+ShaderManifestHeader ReadHeader(const std::string& manifest)
+{
+    ShaderManifestHeader header{};
+    std::memcpy(&header, manifest.data(), sizeof(header));
+    return header;
+}
+
+/** Every index of the space, and a word past it, finds exactly the variant that holds it. */
+bool EveryIndexAgrees(const ShaderManifestView& view, uint32_t space_size, const std::vector<uint32_t>& live)
+{
+    for (uint32_t index = 0u; index < space_size + 64u; ++index)
+    {
+        const ManifestVariant* found = view.FindVariant(index);
+        const bool isLive = std::ranges::find(live, index) != live.end();
+        if (isLive != (found != nullptr) || (found != nullptr && found->Index != index))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "SparseVariantIndexTests" };
+
+    runner.BeginSection("a space that is mostly holes stores a bitvector");
+    {
+        // One live index in twenty, as a deep tree of dependent axes leaves them, with a run across a
+        // word boundary and the very last index of the space.
+        constexpr uint32_t k_SpaceSize = 4000u;
+        std::vector<uint32_t> live{ 62u, 63u, 64u, 65u, k_SpaceSize - 1u };
+        for (uint32_t index = 100u; index < k_SpaceSize - 1u; index += 20u)
+        {
+            live.push_back(index);
+        }
+        std::ranges::sort(live);
+
+        const CookedModule module = MakeModule(k_SpaceSize, live);
+        const std::string manifest = EmitShaderManifest(module);
+        runner.Check(VerifyManifestRoundTrip(module, manifest).has_value(), "the cooker's round trip passes");
+
+        const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(AsBytes(manifest));
+        runner.Check(opened.has_value() && opened.value().HasSparseVariantIndex(),
+                     "the manifest opens with a sparse variant index");
+        if (opened.has_value())
+        {
+            runner.Check(EveryIndexAgrees(opened.value(), k_SpaceSize, live),
+                         "every live index finds its variant, and every hole and index past the end none");
+            runner.Check(opened.value().FindSlot(1u, 65u) != nullptr &&
+                             opened.value().FindSlot(1u, 66u) == nullptr,
+                         "FindSlot goes through the same index");
+        }
+
+        const ShaderManifestHeader header = ReadHeader(manifest);
+        runner.Check(header.VariantIndexCount == 0u && header.VariantRankCount == (k_SpaceSize + 63u) / 64u,
+                     "the index is one 16-byte record for each 64 indices, and no dense table");
+    }
+
+    runner.BeginSection("the dense table stays where it is smaller or the only choice");
+    {
+        const std::vector<uint32_t> tiny{ 0u, 2u, 3u };
+        const std::string tinyManifest = EmitShaderManifest(MakeModule(4u, tiny));
+        const ManifestResult<ShaderManifestView> tinyView = ShaderManifestView::Open(AsBytes(tinyManifest));
+        runner.Check(tinyView.has_value() && !tinyView.value().HasSparseVariantIndex() &&
+                         EveryIndexAgrees(tinyView.value(), 4u, tiny),
+                     "a space of four indices keeps its dense table, which is no larger");
+
+        // Counting ranks needs the variant table in index order, so a module out of order stays dense.
+        const std::vector<uint32_t> shuffled{ 300u, 7u, 150u };
+        const CookedModule module = MakeModule(1000u, shuffled);
+        const std::string manifest = EmitShaderManifest(module);
+        const ManifestResult<ShaderManifestView> view = ShaderManifestView::Open(AsBytes(manifest));
+        runner.Check(view.has_value() && !view.value().HasSparseVariantIndex() &&
+                         EveryIndexAgrees(view.value(), 1000u, shuffled),
+                     "variants out of index order keep the dense table, and still resolve");
+    }
+
+    runner.BeginSection("a damaged bitvector cannot read past the variant table");
+    {
+        std::string manifest = EmitShaderManifest(MakeModule(640u, { 5u, 600u }));
+        const ShaderManifestHeader header = ReadHeader(manifest);
+        ManifestVariantRank lastRank{};
+        const size_t lastRankOffset =
+            header.VariantRankTableOffset + ((header.VariantRankCount - 1u) * sizeof(ManifestVariantRank));
+        std::memcpy(&lastRank, manifest.data() + lastRankOffset, sizeof(lastRank));
+        lastRank.RankBefore = 1000u;
+        std::memcpy(manifest.data() + lastRankOffset, &lastRank, sizeof(lastRank));
+
+        const ManifestResult<ShaderManifestView> view = ShaderManifestView::Open(AsBytes(manifest));
+        runner.Check(view.has_value() && view.value().FindVariant(600u) == nullptr &&
+                         view.value().FindVariant(5u) != nullptr,
+                     "a rank past the variant table finds nothing");
+    }
+
+    return runner.Report();
+}
@@ -69,9 +69,13 @@ const PermutationSpace k_EmptySpace{ "", {} };
 
 /** Two variants with different text and one shared layout. The cooked dump must therefore report two
  * sources and one layout, which is the collapse the interner performed. */
-InternedModule BuildTinyInternedModule()
+InternedModule BuildTinyInternedModule(bool record_provenance = true)
 {
     InternedModule module;
+    if (!record_provenance)
+    {
+        DisableProvenance(module);
+    }
     module.Name = "TinyModule";
     module.SpaceSize = 2u;
     module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
@@ -429,12 +433,19 @@ void CheckInternedDump(lodestone::tests::TestRunner& runner)
     runner.Check(Contains(dump, R"("mappedFrom")"), "each unique entry lists the artifacts that reached it");
     runner.Check(Contains(dump, R"("variantIndex": 1)"),
                  "provenance names the variant, so a surprising collapse is traceable");
+    runner.Check(Contains(dump, R"("entryPoint": "MainCS")") &&
+                     Contains(dump, R"("variant": "USE_FOO=true")"),
+                 "the records hold indices, and the dump reads the names back from the module");
 
     runner.Check(!Contains(dump, "// variant zero"),
                  "no target text reaches the dump, for the same reason the cooked dump holds none");
 
     const std::string second = DumpInternedModule(module);
     runner.Check(dump == second, "two dumps of one module agree byte for byte");
+
+    const std::string unrecorded = DumpInternedModule(BuildTinyInternedModule(false));
+    runner.Check(Contains(unrecorded, R"("recorded": false)") && !Contains(unrecorded, R"("mappedFrom")"),
+                 "under --no-provenance the dump says nothing was recorded, rather than list empty tables");
 }
 
 /** A dump that cannot tell two modules apart is worth nothing as a regression harness, so prove it
@@ -0,0 +1,235 @@
+#include "ChainPermutationSpace.hpp"
+#include "CookerErrors.hpp"
+#include "emit/ShaderManifestEmitter.hpp"
+#include "model/CookedLibrary.hpp"
+#include "permute/PermutationSpace.hpp"
+#include "permute/PermutationValue.hpp"
+#include "ShaderLibraryTypes.hpp"
+#include "ShaderManifest.hpp"
+#include "TestHarness.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Variant queries: a program that holds only a manifest names the axes it cares about and gets the
+// same dense index the generated `VariantIndex` computes. Axes it leaves out take their first value,
+// and an axis whose parent does not turn it on is ignored, exactly as `Canonicalize` does.
+//
+// The space has the shape of the OceanFft space, like PermutationIndexTests. A second manifest holds
+// the chain space of GeneratedCanonicalizeTests, where each parent's first value turns its child on.
+// This test needs no Slang, no compiler, and no asset.
+
+using namespace lodestone;
+
+namespace
+{
+
+const PermutationSpace k_QuerySpace{
+    "QuerySpace",
+    { PermutationAxis{ "QUERY_SIZE",
+                       { PermutationValue{ 128u },
+                         PermutationValue{ 256u },
+                         PermutationValue{ 512u },
+                         PermutationValue{ 1024u } },
+                       PermutationAxis::k_NoParent,
+                       PermutationValue{} },
+      PermutationAxis{ "QUERY_USE_WAVE_OPS",
+                       { PermutationValue{ false }, PermutationValue{ true } },
+                       PermutationAxis::k_NoParent,
+                       PermutationValue{} },
+      PermutationAxis{ "QUERY_WAVE_SIZE",
+                       { PermutationValue{ 16u }, PermutationValue{ 32u }, PermutationValue{ 64u } },
+                       1,
+                       PermutationValue{ true } } } };
+
+/** One compute entry point, and one source for each enumerated variant. */
+CookedModule MakeModule(const VariantSet& variants)
+{
+    CookedModule module;
+    module.Name = variants.Space == &k_QuerySpace ? "Query" : "Chain";
+    module.Space = variants.Space;
+    module.SpaceSize = static_cast<uint32_t>(variants.SpaceSize);
+    module.EntryPoints.push_back(LibraryEntryPoint{ .Name = "MainCS", .Stage = ShaderStageKind::Compute });
+    module.ResourceLists.emplace_back();
+    module.FootprintLists.emplace_back();
+    module.VisibilityLists.emplace_back();
+    module.RasterStates.emplace_back();
+
+    for (const VariantDescriptor& descriptor : variants.Variants)
+    {
+        LibraryVariant variant;
+        variant.Index = static_cast<uint32_t>(descriptor.Index);
+        variant.Suffix = MakeAssignmentSuffix(descriptor.Canonical);
+        variant.Description = DescribeAssignment(descriptor.Canonical);
+        variant.Canonical = descriptor.Canonical;
+        variant.SourceIndices.push_back(static_cast<uint32_t>(module.Sources.size()));
+        variant.VisibilityIndices.push_back(0u);
+        variant.RasterIndices.push_back(0u);
+        variant.Workgroups.emplace_back(WorkgroupSize{ .X = 64u, .Y = 1u, .Z = 1u });
+        module.Sources.push_back("// " + variant.Description);
+        module.Variants.emplace_back(std::move(variant));
+    }
+
+    return module;
+}
+
+std::span<const std::byte> AsBytes(const std::string& manifest)
+{
+    return std::span<const std::byte>{ reinterpret_cast<const std::byte*>(manifest.data()), manifest.size() };
+}
+
+PermutationBinding Bind(size_t axis_index, PermutationValue value)
+{
+    return PermutationBinding{ .Axis = &k_QuerySpace.Axes()[axis_index], .Value = value };
+}
+
+uint32_t ExpectedIndex(const PermutationAssignment& assignment)
+{
+    return static_cast<uint32_t>(
+        k_QuerySpace.ComputeVariantIndex(k_QuerySpace.CanonicalizeAssignment(assignment)));
+}
+
+ShaderManifestError ErrorFrom(const ManifestResult<uint32_t>& resolved)
+{
+    return resolved.has_value() ? ShaderManifestError::Success : resolved.error();
+}
+
+} // namespace
+
+int main()
+{
+    tests::TestRunner runner{ "VariantQueryTests" };
+
+    const CookResult<VariantSet> variants = k_QuerySpace.EnumerateVariants();
+    runner.Check(variants.has_value(), "the space enumerates");
+    if (!variants)
+    {
+        return runner.Report();
+    }
+
+    const CookedModule module = MakeModule(variants.value());
+    const std::string manifest = EmitShaderManifest(module);
+    runner.Check(VerifyManifestRoundTrip(module, manifest).has_value(),
+                 "the cooker's round trip, which resolves every variant by name, passes");
+
+    const ManifestResult<ShaderManifestView> opened = ShaderManifestView::Open(AsBytes(manifest));
+    runner.Check(opened.has_value(), "the manifest opens");
+    if (!opened)
+    {
+        return runner.Report();
+    }
+
+    const ShaderManifestView& view = opened.value();
+    runner.BeginSection("the axis table carries what canonicalization needs");
+    runner.Check(view.Axes().size() == 3u && view.Axes()[2].ParentAxis == 1u &&
+                     view.Axes()[2].RequiredParentValue == 1u &&
+                     view.Axes()[0].ParentAxis == k_ShaderManifestNoIndex,
+                 "the dependent axis names its parent and the parent's enabling value");
+    runner.Check(view.Axes()[1].NameHash == HashManifestName("QUERY_USE_WAVE_OPS"),
+                 "each axis carries the hash of its name");
+
+    runner.BeginSection("a full assignment resolves to the index the cooker gave it");
+    bool everyVariantResolves = true;
+    for (const VariantDescriptor& descriptor : variants.value().Variants)
+    {
+        std::vector<ManifestAxisValue> byIndex;
+        for (size_t i = 0u; i < descriptor.Canonical.size(); ++i)
+        {
+            const int64_t value = PermutationValueToInt64(descriptor.Canonical[i].Value);
+            byIndex.push_back(ManifestAxisValue::Indexed(static_cast<uint32_t>(i), value));
+        }
+
+        const ManifestResult<uint32_t> resolved = view.ResolveVariant(byIndex);
+        everyVariantResolves = everyVariantResolves && resolved.has_value() &&
+                               resolved.value() == static_cast<uint32_t>(descriptor.Index) &&
+                               view.FindSlot(1u, byIndex) == view.FindSlot(1u, resolved.value());
+    }
+
+    runner.Check(everyVariantResolves, "every variant resolves by axis index, and finds its own slot");
+
+    runner.BeginSection("a partial assignment canonicalizes as the generated code does");
+    runner.Check(view.ResolveVariant({}).value_or(~0u) == ExpectedIndex({}),
+                 "an empty assignment is every axis at its first value");
+
+    const std::array<ManifestAxisValue, 1u> sizeOnly{ ManifestAxisValue::Named("QUERY_SIZE", 512) };
+    runner.Check(view.ResolveVariant(sizeOnly).value_or(~0u) ==
+                     ExpectedIndex({ Bind(0u, PermutationValue{ 512u }) }),
+                 "naming one axis leaves the others at their first value");
+
+    const std::array<ManifestAxisValue, 1u> orphanWaveSize{ ManifestAxisValue::Named("QUERY_WAVE_SIZE", 64) };
+    runner.Check(view.ResolveVariant(orphanWaveSize).value_or(~0u) == ExpectedIndex({}),
+                 "a dependent axis whose parent is off is ignored");
+
+    const std::array<ManifestAxisValue, 2u> waveSize{ ManifestAxisValue::Named("QUERY_WAVE_SIZE", 64),
+                                                      ManifestAxisValue::Named("QUERY_USE_WAVE_OPS", 1) };
+    const uint32_t waveSizeIndex =
+        ExpectedIndex({ Bind(1u, PermutationValue{ true }), Bind(2u, PermutationValue{ 64u }) });
+    runner.Check(view.ResolveVariant(waveSize).value_or(~0u) == waveSizeIndex,
+                 "a dependent axis counts once its parent turns it on, in any order");
+    runner.Check(view.FindSlot(1u, waveSize) != nullptr && view.FindVariant(waveSizeIndex) != nullptr,
+                 "the resolved variant was cooked, and its slot is found");
+
+    const std::array<ManifestAxisValue, 2u> repeated{ ManifestAxisValue::Indexed(0u, 128),
+                                                      ManifestAxisValue::Indexed(0u, 1024) };
+    runner.Check(view.ResolveVariant(repeated).value_or(~0u) ==
+                     ExpectedIndex({ Bind(0u, PermutationValue{ 1024u }) }),
+                 "when an axis appears twice, the later value wins");
+
+    runner.BeginSection("a query the manifest cannot answer fails by name");
+    const std::array<ManifestAxisValue, 1u> unknownName{ ManifestAxisValue::Named("QUERY_MISSING", 0) };
+    runner.Check(ErrorFrom(view.ResolveVariant(unknownName)) == ShaderManifestError::AxisNotFound,
+                 "an axis name the manifest does not have is AxisNotFound");
+    const std::array<ManifestAxisValue, 1u> unknownIndex{ ManifestAxisValue::Indexed(3u, 0) };
+    runner.Check(ErrorFrom(view.ResolveVariant(unknownIndex)) == ShaderManifestError::AxisNotFound,
+                 "an axis index past the table is AxisNotFound");
+    const std::array<ManifestAxisValue, 1u> unknownValue{ ManifestAxisValue::Named("QUERY_WAVE_SIZE", 8) };
+    runner.Check(ErrorFrom(view.ResolveVariant(unknownValue)) == ShaderManifestError::AxisValueNotFound,
+                 "a value the axis does not take is AxisValueNotFound, even while the axis is off");
+    runner.Check(view.FindSlot(1u, unknownValue) == nullptr, "a failed query finds no slot");
+
+    runner.BeginSection("a parent switched off does not turn its child on with its first value");
+    const CookResult<VariantSet> chainVariants = tests::ChainPermutationSpace().EnumerateVariants();
+    const std::string chainManifest =
+        chainVariants ? EmitShaderManifest(MakeModule(chainVariants.value())) : std::string{};
+    const ManifestResult<ShaderManifestView> chainOpened = ShaderManifestView::Open(AsBytes(chainManifest));
+    runner.Check(chainOpened.has_value(), "the chain manifest opens");
+    if (!chainOpened)
+    {
+        return runner.Report();
+    }
+
+    // CHAIN_ENABLED off resets CHAIN_MODE to 0, which is the value that turns CHAIN_TAPS on.
+    const ShaderManifestView& chain = chainOpened.value();
+    const std::array<ManifestAxisValue, 3u> chainOff{ ManifestAxisValue::Named("CHAIN_ENABLED", 0),
+                                                      ManifestAxisValue::Named("CHAIN_TAPS", 8),
+                                                      ManifestAxisValue::Named("CHAIN_WIDE", 1) };
+    runner.Check(chain.ResolveVariant(chainOff).value_or(~0u) == chain.ResolveVariant({}).value_or(0u),
+                 "with the chain off, every link after it takes its first value");
+    runner.Check(chain.FindSlot(1u, chainOff) != nullptr, "and the query finds the slot the cooker built");
+
+    bool everyChainQueryCooked = true;
+    for (const int64_t enabled : { 0, 1 })
+    {
+        for (const int64_t mode : { 0, 1, 2 })
+        {
+            for (const int64_t taps : { 4, 8 })
+            {
+                const std::array<ManifestAxisValue, 3u> query{ ManifestAxisValue::Indexed(0u, enabled),
+                                                               ManifestAxisValue::Indexed(1u, mode),
+                                                               ManifestAxisValue::Indexed(2u, taps) };
+                const ManifestResult<uint32_t> resolved = chain.ResolveVariant(query);
+                everyChainQueryCooked = everyChainQueryCooked && resolved.has_value() &&
+                                        chain.FindVariant(resolved.value()) != nullptr;
+            }
+        }
+    }
+
+    runner.Check(everyChainQueryCooked, "no assignment of the chain names a hole");
+
+    return runner.Report();
+}
@@ -1,12 +1,17 @@
 #include "ArgumentParser.hpp"
+#include "CookTrace.hpp"
 #include "driver/CookerDriver.hpp"
 #include "CookerErrors.hpp"
 #include "driver/CookerOptions.hpp"
+#include "driver/WarmCompilerCache.hpp"
 #include "emit/OutputSink.hpp"
 
 #include <atomic>
+#include <charconv>
 #include <chrono>
 #include <csignal>
+#include <cstdint>
+#include <format>
 #include <iostream>
 #include <print>
 #include <span>
@@ -28,12 +33,15 @@ void HandleSIGINT(int signum)
     std::println(stderr, "\n[Received Ctrl-C. Preparing to exit gracefully...]");
 }
 
-bool RunCookingPipelineWithArgs(const lodestone::CookerOptions& options)
+/** `warm_compilers` is null for a one-shot cook, which has nothing to keep warm for. */
+bool RunCookingPipelineWithArgs(const lodestone::CookerOptions& options,
+                                lodestone::WarmCompilerCache* warm_compilers)
 {
     using namespace lodestone;
 
     FileOutputSink sink{ options.OutputPath };
-    const CookResult<CookStatistics> statistics = RunCook(options, sink);
+    const CookResult<CookStatistics> statistics =
+        warm_compilers != nullptr ? RunCook(options, sink, *warm_compilers) : RunCook(options, sink);
 
     if (!statistics)
     {
@@ -50,12 +58,13 @@ bool RunCookingPipelineWithArgs(const lodestone::CookerOptions& options)
                  statistics.value().TotalWgslBytes / 1024u,
                  statistics.value().ElapsedMilliseconds,
                  sink.Describe());
+    std::println(stdout, "[shader_cooker] phases: {}", DescribePhaseTimes(statistics.value().PhaseTimes));
     return true;
 }
 
 /** Parses one command line and cooks it once. Both modes go through here, so an interactive cook and
  * a scripted cook cannot take different paths. */
-int CookOnce(std::span<const std::string_view> arguments)
+int CookOnce(std::span<const std::string_view> arguments, lodestone::WarmCompilerCache* warm_compilers)
 {
     using namespace lodestone;
 
@@ -66,7 +75,88 @@ int CookOnce(std::span<const std::string_view> arguments)
         return k_ExitFailure;
     }
 
-    return RunCookingPipelineWithArgs(options.value()) ? k_ExitSuccess : k_ExitFailure;
+    return RunCookingPipelineWithArgs(options.value(), warm_compilers) ? k_ExitSuccess : k_ExitFailure;
+}
+
+/** `variant <index> <options>`: compiles one variant of the one module the options name, and writes the
+ * WGSL of each entry point beside the output path. A module the session already loaded answers
+ * without starting Slang, which is what an engine waiting on one edited shader needs. */
+int CookOneVariant(std::span<const std::string_view> arguments, lodestone::WarmCompilerCache& warm_compilers)
+{
+    using namespace lodestone;
+
+    uint32_t variantIndex = 0u;
+    const std::string_view indexText = arguments.empty() ? std::string_view{} : arguments.front();
+    const std::from_chars_result parsed =
+        std::from_chars(indexText.data(), indexText.data() + indexText.size(), variantIndex);
+    if (indexText.empty() || parsed.ec != std::errc{} || parsed.ptr != indexText.data() + indexText.size())
+    {
+        std::println(std::cout, "Usage: variant <index> [options] <one module>");
+        return k_ExitFailure;
+    }
+
+    const CookResult<CookerOptions> options = ParseCommandLine(arguments.subspan(1u));
+    if (!options)
+    {
+        std::println(std::cout, "Error parsing arguments: {}", ToString(options.error()));
+        return k_ExitFailure;
+    }
+
+    if (options.value().ModulePaths.size() != 1u)
+    {
+        std::println(std::cout, "A variant request names exactly one module.");
+        return k_ExitFailure;
+    }
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    const std::filesystem::path& modulePath = options.value().ModulePaths.front();
+    const CookResult<RawVariant> variant =
+        CompileLiveVariant(options.value(), modulePath, variantIndex, warm_compilers);
+    if (!variant)
+    {
+        std::println(
+            stdout, "[shader_cooker] variant {} failed: {}", variantIndex, ToString(variant.error()));
+        return k_ExitFailure;
+    }
+
+    FileOutputSink sink{ options.value().OutputPath };
+    const std::string moduleStem = modulePath.stem().string();
+    for (const RawEntryPoint& entryPoint : variant.value().EntryPoints)
+    {
+        const std::string artifactName =
+            std::format("{}_{}{}.wgsl", moduleStem, entryPoint.Name, entryPoint.VariantSuffix);
+        const CookResult<void> written = sink.WriteArtifact(artifactName, entryPoint.TargetText);
+        if (!written)
+        {
+            std::println(
+                stdout, "[shader_cooker] could not write {}: {}", artifactName, ToString(written.error()));
+            return k_ExitFailure;
+        }
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::println(stdout,
+                 "[shader_cooker] variant {} [{}]: {} entrypoints in {:.1f}ms -> {}",
+                 variantIndex,
+                 variant.value().VariantDescription,
+                 variant.value().EntryPoints.size(),
+                 elapsed.count(),
+                 sink.Describe());
+    return k_ExitSuccess;
+}
+
+void PrintWarmStatistics(const lodestone::WarmCompilerCache& warm_compilers)
+{
+    const lodestone::WarmCompilerStatistics statistics = warm_compilers.GetStatistics();
+    std::println(stdout,
+                 "[shader_cooker] this session: {} modules warm, {} loaded, {} workers warm, {} loaded, {} "
+                 "global sessions reused, {} created",
+                 statistics.ModulesWarm,
+                 statistics.ModulesLoaded,
+                 statistics.WorkersWarm,
+                 statistics.WorkersLoaded,
+                 statistics.GlobalSessionsReused,
+                 statistics.GlobalSessionsCreated);
 }
 
 /** No arguments means the interactive session. Arguments mean one cook and a real exit code, which is
@@ -86,7 +176,7 @@ int RunNonInteractive(int argc, char** argv)
         return k_ExitSuccess;
     }
 
-    return CookOnce(arguments);
+    return CookOnce(arguments, nullptr);
 }
 
 void BusySleep()
@@ -109,6 +199,12 @@ int main(int argc, char** argv)
     std::println(
         std::cout,
         "Shader Cooker Live Tool initialized. Type arguments and press Enter to cook, or '--quit' to exit.");
+    std::println(std::cout,
+                 "'variant <index> [options]' cooks one variant, and 'reload' forgets every loaded module.");
+
+    // Lives as long as the session. Every cook after the first takes its Slang sessions from here, so
+    // only a module whose files changed loads again, and no cook starts a global session it can reuse.
+    WarmCompilerCache warmCompilers;
 
     while (!k_WantsExit)
     {
@@ -153,9 +249,24 @@ int main(int argc, char** argv)
             continue;
         }
 
+        if (stringArgs[0] == "reload")
+        {
+            warmCompilers.Invalidate();
+            std::println(std::cout, "Every module loads again on its next cook.");
+            continue;
+        }
+
+        if (stringArgs[0] == "variant")
+        {
+            CookOneVariant(std::span<const std::string_view>{ stringArgs }.subspan(1u), warmCompilers);
+            PrintWarmStatistics(warmCompilers);
+            continue;
+        }
+
         std::println(std::cout, "Parsing arguments: {}", line);
 
-        CookOnce(stringArgs);
+        CookOnce(stringArgs, &warmCompilers);
+        PrintWarmStatistics(warmCompilers);
 
         std::println(std::cout,
                      "Cooking complete. Type arguments and press Enter to cook again, or '--quit' to exit.");
@@ -1,4 +1,5 @@
 #include "JsonWriter.hpp"
+#include "MappedShaderManifest.hpp"
 #include "ResourceFlags.hpp"
 #include "ShaderLibraryTypes.hpp"
 #include "ShaderManifest.hpp"
@@ -13,7 +14,7 @@
 #include <span>
 #include <string>
 #include <string_view>
-#include <vector>
+#include <utility>
 
 namespace
 {
@@ -23,9 +24,6 @@ enum class DumpError : uint8_t
     Invalid = 0,
     Success = 1,
     UsageError = 2,
-    FileOpenFailed = 3,
-    FileReadFailed = 4,
-    ManifestOpenFailed = 5,
     JsonUnbalanced = 6,
 };
 
@@ -37,6 +35,8 @@ std::string_view ToString(DumpError error) noexcept
 struct Options
 {
     std::filesystem::path ManifestPath;
+    /** The library source file, for a manifest cooked with `--share-sources`. */
+    std::filesystem::path SourcesPath;
     std::filesystem::path OutputPath;
     bool Pretty{ true };
     bool WithSources{ false };
@@ -64,6 +64,14 @@ std::expected<Options, DumpError> ParseOptions(std::span<char*> args) noexcept
             }
             options.OutputPath = args[++i];
         }
+        else if (arg == "--sources")
+        {
+            if (i + 1u >= args.size())
+            {
+                return std::unexpected(DumpError::UsageError);
+            }
+            options.SourcesPath = args[++i];
+        }
         else if (options.ManifestPath.empty())
         {
             options.ManifestPath = arg;
@@ -82,30 +90,6 @@ std::expected<Options, DumpError> ParseOptions(std::span<char*> args) noexcept
     return options;
 }
 
-std::expected<std::vector<std::byte>, DumpError> ReadFileBytes(const std::filesystem::path& path) noexcept
-{
-    std::ifstream file{ path, std::ios::binary | std::ios::ate };
-    if (!file)
-    {
-        return std::unexpected(DumpError::FileOpenFailed);
-    }
-
-    const std::streamsize size = file.tellg();
-    if (size < 0)
-    {
-        return std::unexpected(DumpError::FileReadFailed);
-    }
-
-    file.seekg(0);
-    std::vector<std::byte> bytes(static_cast<size_t>(size));
-    if (!bytes.empty() && !file.read(reinterpret_cast<char*>(bytes.data()), size))
-    {
-        return std::unexpected(DumpError::FileReadFailed);
-    }
-
-    return bytes;
-}
-
 void WriteEntryPoints(lodestone::JsonWriter& writer, const lodestone::ShaderManifestView& view) noexcept
 {
     writer.Key("entryPoints");
@@ -130,6 +114,11 @@ void WriteAxes(lodestone::JsonWriter& writer, const lodestone::ShaderManifestVie
         const lodestone::ManifestAxis& axis = view.Axes()[axisIndex];
         writer.BeginObject();
         writer.KeyString("name", view.String(axis.NameString));
+        if (axis.ParentAxis != lodestone::k_ShaderManifestNoIndex)
+        {
+            writer.KeyUInt("parent", axis.ParentAxis);
+            writer.KeyUInt("required_parent_value", axis.RequiredParentValue);
+        }
         writer.Key("values");
         writer.BeginArray();
         for (const int64_t value : view.AxisValues(static_cast<uint32_t>(axisIndex)))
@@ -310,7 +299,10 @@ void WriteSlot(lodestone::JsonWriter& writer,
 
     if (with_sources)
     {
-        writer.KeyString("source", view.Source(slot.SourceIndex));
+        // A chunked or compressed manifest has no view of most sources, so assemble them the way a
+        // loader would.
+        std::string source(view.SourceSize(slot.SourceIndex), '\0');
+        writer.KeyString("source", view.AssembleSource(slot.SourceIndex, source));
     }
 
     writer.EndObject();
@@ -373,7 +365,7 @@ int PrintUsage() noexcept
 {
     std::println(stderr,
                  "usage: manifest_dump <manifest.ls_shader_bin> [--compact] [--with-sources] "
-                 "[-o <output.json>]");
+                 "[--sources <library.sources.ldshaders>] [-o <output.json>]");
     return 1;
 }
 
@@ -388,25 +380,35 @@ int main(int argc, char** argv)
     }
     const Options& options = optionsResult.value();
 
-    const auto bytesResult = ReadFileBytes(options.ManifestPath);
-    if (!bytesResult.has_value())
+    // Mapped before the manifest opens, and kept alive beside it: a shared manifest reads its text here.
+    lodestone::MappedShaderManifest sources;
+    if (!options.SourcesPath.empty())
     {
-        std::println(
-            stderr, "Failed to read '{}': {}", options.ManifestPath.string(), ToString(bytesResult.error()));
-        return 1;
+        auto sourcesResult = lodestone::MappedShaderManifest::Open(options.SourcesPath);
+        if (!sourcesResult.has_value())
+        {
+            std::println(stderr,
+                         "Failed to open library sources '{}': {}",
+                         options.SourcesPath.string(),
+                         lodestone::ToString(sourcesResult.error()));
+            return 1;
+        }
+
+        sources = std::move(sourcesResult.value());
     }
 
-    const auto viewResult = lodestone::ShaderManifestView::Open(bytesResult.value());
-    if (!viewResult.has_value())
+    const auto manifestResult = lodestone::MappedShaderManifest::Open(options.ManifestPath, sources);
+    if (!manifestResult.has_value())
     {
         std::println(stderr,
                      "Failed to open manifest '{}': {}",
                      options.ManifestPath.string(),
-                     lodestone::ToString(viewResult.error()));
+                     lodestone::ToString(manifestResult.error()));
         return 1;
     }
 
-    const auto jsonResult = BuildManifestJson(viewResult.value(), options.Pretty, options.WithSources);
+    const auto jsonResult =
+        BuildManifestJson(manifestResult.value().View(), options.Pretty, options.WithSources);
     if (!jsonResult.has_value())
     {
         std::println(stderr, "Failed to build JSON: {}", ToString(jsonResult.error()));
@@ -0,0 +1,280 @@
+#include "SyntheticModule.hpp"
+#include "permute/PermutationAxis.hpp"
+#include "permute/PermutationValue.hpp"
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lodestone
+{
+
+namespace
+{
+
+    /** Elements in one layout buffer for each unit of its axis value. */
+    constexpr uint32_t k_LayoutElementsPerUnit{ 256u };
+
+    /** Axis values run from 1, so a layout buffer is never sized zero. */
+    uint32_t GetAxisValue(uint32_t value_index) noexcept
+    {
+        return value_index + 1u;
+    }
+
+    /** Code axes and layout axes are each dealt out to the entry points in turn, so every entry point
+     * reads about the same number of them. */
+    uint32_t GetRoleOrdinal(const SyntheticModuleShape& shape, uint32_t axis_index) noexcept
+    {
+        const SyntheticAxisRole role = GetAxisRole(shape, axis_index);
+        uint32_t ordinal = 0u;
+        for (uint32_t i = 0u; i < axis_index; ++i)
+        {
+            if (GetAxisRole(shape, i) == role)
+            {
+                ++ordinal;
+            }
+        }
+
+        return ordinal;
+    }
+
+    bool IsReadByEntryPoint(const SyntheticModuleShape& shape,
+                            uint32_t axis_index,
+                            uint32_t entry_point) noexcept
+    {
+        return GetAxisRole(shape, axis_index) != SyntheticAxisRole::Inert &&
+               GetRoleOrdinal(shape, axis_index) % shape.EntryPointCount == entry_point;
+    }
+
+    std::string MakeValueList(const SyntheticModuleShape& shape)
+    {
+        std::string list;
+        for (uint32_t i = 0u; i < shape.ValuesPerAxis; ++i)
+        {
+            list += std::format("{}PermutationValue{{ {}u }}", i == 0u ? "" : ", ", GetAxisValue(i));
+        }
+
+        return list;
+    }
+
+} // namespace
+
+std::string_view ToString(SyntheticAxisRole role) noexcept
+{
+    switch (role)
+    {
+    case SyntheticAxisRole::Code:
+        return "code";
+    case SyntheticAxisRole::Layout:
+        return "layout";
+    case SyntheticAxisRole::Inert:
+        return "inert";
+    default:
+        return "invalid";
+    }
+}
+
+std::string ValidateSyntheticShape(const SyntheticModuleShape& shape)
+{
+    if (shape.ModuleName.empty())
+    {
+        return "the module needs a name";
+    }
+    if (shape.AxisCount == 0u)
+    {
+        return "the space needs at least one axis";
+    }
+    if (shape.ValuesPerAxis < 2u || shape.ValuesPerAxis > PermutationAxis::k_MaxValues)
+    {
+        return std::format("an axis holds from 2 to {} values", PermutationAxis::k_MaxValues);
+    }
+    if (shape.DependencyDepth >= shape.AxisCount)
+    {
+        return "the dependency depth must be less than the axis count";
+    }
+    if (shape.EntryPointCount == 0u)
+    {
+        return "the module needs at least one entry point";
+    }
+    if (uint64_t{ shape.InertAxisCount } + shape.LayoutAxisCount > shape.AxisCount)
+    {
+        return "there are more inert and layout axes than axes";
+    }
+    if (CountSyntheticVariants(shape) > k_MaxSyntheticVariants)
+    {
+        return std::format("the space has more than {} variants", k_MaxSyntheticVariants);
+    }
+
+    return {};
+}
+
+/** A chain of n axes has n * (V - 1) + 1 active combinations. Each axis of the chain adds the values of
+ * its parent that do not enable it. */
+uint64_t CountSyntheticVariants(const SyntheticModuleShape& shape) noexcept
+{
+    const uint64_t chainLength = uint64_t{ shape.DependencyDepth } + 1u;
+    uint64_t count = chainLength * (shape.ValuesPerAxis - 1u) + 1u;
+    for (uint64_t i = chainLength; i < shape.AxisCount && count <= k_MaxSyntheticVariants; ++i)
+    {
+        count *= shape.ValuesPerAxis;
+    }
+
+    return count;
+}
+
+SyntheticAxisRole GetAxisRole(const SyntheticModuleShape& shape, uint32_t axis_index) noexcept
+{
+    if (axis_index >= shape.AxisCount)
+    {
+        return SyntheticAxisRole::Invalid;
+    }
+    if (axis_index >= shape.AxisCount - shape.InertAxisCount)
+    {
+        return SyntheticAxisRole::Inert;
+    }
+    if (axis_index >= shape.AxisCount - shape.InertAxisCount - shape.LayoutAxisCount)
+    {
+        return SyntheticAxisRole::Layout;
+    }
+
+    return SyntheticAxisRole::Code;
+}
+
+std::string MakeSyntheticAxisName(uint32_t axis_index)
+{
+    return std::format("SYN_AXIS_{}", axis_index);
+}
+
+PermutationSpace MakeSyntheticSpace(const SyntheticModuleShape& shape)
+{
+    std::vector<PermutationValue> values;
+    for (uint32_t i = 0u; i < shape.ValuesPerAxis; ++i)
+    {
+        values.emplace_back(GetAxisValue(i));
+    }
+
+    std::vector<PermutationAxis> axes;
+    axes.reserve(shape.AxisCount);
+    for (uint32_t i = 0u; i < shape.AxisCount; ++i)
+    {
+        const bool isDependent = i > 0u && i <= shape.DependencyDepth;
+        axes.emplace_back(MakeSyntheticAxisName(i),
+                          values,
+                          isDependent ? static_cast<int32_t>(i - 1u) : PermutationAxis::k_NoParent,
+                          isDependent ? values.back() : PermutationValue{});
+    }
+
+    return PermutationSpace{ shape.ModuleName, axes };
+}
+
+std::string GenerateSyntheticSlang(const SyntheticModuleShape& shape)
+{
+    std::string text = std::format("module {};\n", shape.ModuleName);
+    if (shape.LayoutAxisCount > 0u)
+    {
+        text += "import LodestoneAttributes;\n";
+    }
+
+    text += std::format("\n// Written by lodestone_module_generator. Run the generator again rather than "
+                        "edit it.\n// {} axes of {} values, dependency depth {}, {} entry points, "
+                        "{} layout axes, {} inert axes: {} variants.\n\n",
+                        shape.AxisCount,
+                        shape.ValuesPerAxis,
+                        shape.DependencyDepth,
+                        shape.EntryPointCount,
+                        shape.LayoutAxisCount,
+                        shape.InertAxisCount,
+                        CountSyntheticVariants(shape));
+
+    for (uint32_t i = 0u; i < shape.AxisCount; ++i)
+    {
+        text += std::format("// {} axis\nextern static const uint {} = {}u;\n",
+                            ToString(GetAxisRole(shape, i)),
+                            MakeSyntheticAxisName(i),
+                            GetAxisValue(0u));
+    }
+
+    text += "\nStructuredBuffer<float4> Input;\nRWStructuredBuffer<float4> Output;\n";
+    for (uint32_t i = 0u; i < shape.AxisCount; ++i)
+    {
+        if (GetAxisRole(shape, i) == SyntheticAxisRole::Layout)
+        {
+            text += std::format("\n[vx_element_count(\"{} * {}\")]\n"
+                                "StructuredBuffer<float4> LayoutInput{};\n",
+                                MakeSyntheticAxisName(i),
+                                k_LayoutElementsPerUnit,
+                                i);
+        }
+    }
+
+    for (uint32_t e = 0u; e < shape.EntryPointCount; ++e)
+    {
+        text += std::format("\n[shader(\"compute\")]\n[numthreads(64, 1, 1)]\n"
+                            "void Synthetic{}CS(uint3 threadId: SV_DispatchThreadID)\n{{\n"
+                            "    float4 value = Input[threadId.x];\n",
+                            e);
+        for (uint32_t i = 0u; i < shape.AxisCount; ++i)
+        {
+            if (!IsReadByEntryPoint(shape, i, e))
+            {
+                continue;
+            }
+
+            const std::string axisName = MakeSyntheticAxisName(i);
+            if (GetAxisRole(shape, i) == SyntheticAxisRole::Code)
+            {
+                text += std::format("    value = value * float({}) + float4(0.25f);\n", axisName);
+            }
+            else
+            {
+                // A link-time constant folds this branch, so the binding's use can follow the axis.
+                text += std::format("    if ({} > {}u)\n    {{\n"
+                                    "        value += LayoutInput{}[threadId.x];\n    }}\n",
+                                    axisName,
+                                    GetAxisValue(0u),
+                                    i);
+            }
+        }
+        text += "    Output[threadId.x] = value;\n}\n";
+    }
+
+    return text;
+}
+
+std::string GenerateRegistrySnippet(const SyntheticModuleShape& shape)
+{
+    const std::string valueList = MakeValueList(shape);
+    std::string text = std::format("    // Written by lodestone_module_generator for {}.\n"
+                                   "    const PermutationSpace k_{}Space{{\n        \"{}\",\n        {{ ",
+                                   shape.ModuleName,
+                                   shape.ModuleName,
+                                   shape.ModuleName);
+
+    for (uint32_t i = 0u; i < shape.AxisCount; ++i)
+    {
+        const bool isDependent = i > 0u && i <= shape.DependencyDepth;
+        const std::string parent =
+            isDependent ? std::format("{}", i - 1u) : std::string{ "PermutationAxis::k_NoParent" };
+        const std::string requiredValue =
+            isDependent ? std::format("PermutationValue{{ {}u }}", GetAxisValue(shape.ValuesPerAxis - 1u))
+                        : std::string{ "PermutationValue{}" };
+        text += std::format("{}PermutationAxis{{ \"{}\",\n                           {{ {} }},\n"
+                            "                           {},\n                           {} }}",
+                            i == 0u ? "" : ",\n          ",
+                            MakeSyntheticAxisName(i),
+                            valueList,
+                            parent,
+                            requiredValue);
+    }
+
+    text += std::format(" }} }};\n\n    // Add to k_ModuleSpaces, and raise its size by one:\n"
+                        "    // ModuleSpaceEntry{{ .ModuleName = \"{}\", .Space = &k_{}Space, "
+                        ".Policy = &k_EmptyPolicy }}\n",
+                        shape.ModuleName,
+                        shape.ModuleName);
+    return text;
+}
+
+} // namespace lodestone
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef LODESTONE_SYNTHETIC_MODULE_HPP
+#define LODESTONE_SYNTHETIC_MODULE_HPP
+#include "permute/PermutationSpace.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/** Writes a Slang module of any size, with the permutation space that drives it.
+ *
+ * The test assets stop at about a hundred variants. This module reaches the 10k to 100k range, so a
+ * cook can be timed against the variant count on a machine without a GPU. Each axis has one of three
+ * roles, and each role touches the output in a different way:
+ *
+ *  - A code axis feeds arithmetic in one entry point. It changes that entry point's text, and no other.
+ *  - A layout axis sizes one buffer through `[vx_element_count]`, and a static branch on it decides
+ *    whether one entry point reads that buffer. It changes the footprints of every variant.
+ *  - An inert axis is declared and driven, and nothing reads it. Every value gives the same output, so
+ *    the interner folds it away.
+ *
+ * The first `DependencyDepth + 1` axes form a chain. Each axis of the chain is active only when the
+ * axis before it holds its last value, the way IFFT_WAVE_SIZE depends on IFFT_USE_WAVE_OPS. */
+namespace lodestone
+{
+
+enum class SyntheticAxisRole : uint8_t
+{
+    Invalid = 0,
+    Code,
+    Layout,
+    Inert,
+};
+
+std::string_view ToString(SyntheticAxisRole role) noexcept;
+
+struct SyntheticModuleShape
+{
+    /** Also the file stem, because the cooker names a module after its file. */
+    std::string ModuleName{ "SyntheticModule" };
+    uint32_t AxisCount{ 4u };
+    /** At least 2, and at most `PermutationAxis::k_MaxValues`. */
+    uint32_t ValuesPerAxis{ 4u };
+    /** How many axes depend on the axis before them. At most `AxisCount - 1`. */
+    uint32_t DependencyDepth{ 0u };
+    uint32_t EntryPointCount{ 2u };
+    /** The last `InertAxisCount` axes are inert, and the `LayoutAxisCount` axes before them change
+     * layout. Every other axis is a code axis. */
+    uint32_t InertAxisCount{ 0u };
+    uint32_t LayoutAxisCount{ 0u };
+};
+
+/** The largest space the generator writes. `PermutationSpace` counts variants in an int32_t. */
+inline constexpr uint64_t k_MaxSyntheticVariants{ uint64_t{ 1u } << 24u };
+
+/** An empty string when the shape is valid, and otherwise the reason it is not. */
+std::string ValidateSyntheticShape(const SyntheticModuleShape& shape);
+
+/** The variants the cook produces, which is fewer than the index range when the shape has a chain. */
+[[nodiscard]] uint64_t CountSyntheticVariants(const SyntheticModuleShape& shape) noexcept;
+[[nodiscard]] SyntheticAxisRole GetAxisRole(const SyntheticModuleShape& shape, uint32_t axis_index) noexcept;
+std::string MakeSyntheticAxisName(uint32_t axis_index);
+
+/** The shape must be valid. */
+PermutationSpace MakeSyntheticSpace(const SyntheticModuleShape& shape);
+std::string GenerateSyntheticSlang(const SyntheticModuleShape& shape);
+/** The same space as C++ source, in the form `PermutationRegistry.cpp` declares its spaces. Pasted into
+ * that file, it makes the module cook from the plain cooker too. */
+std::string GenerateRegistrySnippet(const SyntheticModuleShape& shape);
+
+} // namespace lodestone
+
+#endif // !LODESTONE_SYNTHETIC_MODULE_HPP
@@ -0,0 +1,372 @@
+#include "SyntheticModule.hpp"
+
+#include "CookTrace.hpp"
+#include "CookerErrors.hpp"
+#include "JsonWriter.hpp"
+#include "driver/CookerDriver.hpp"
+#include "driver/CookerOptions.hpp"
+#include "emit/OutputSink.hpp"
+#include "permute/PermutationRegistry.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Writes one synthetic module, and with --cook, cooks it in this process and reports the cost. One run
+// is one point of a scaling curve. A script sweeps the shape and collects the --json reports:
+//
+//     lodestone_module_generator --axes=8 --values=4 --out=build/synthetic --cook --json=8x4.json
+//
+// Everything after `--` goes to the cooker unchanged, such as `-- --jobs=4 --no-variant-cache`.
+
+namespace
+{
+
+enum class GeneratorError : uint8_t
+{
+    Invalid = 0,
+    Success = 1,
+    UsageError = 2,
+    InvalidShape = 3,
+    WriteFailed = 4,
+    RegistrationFailed = 5,
+    CookFailed = 6,
+};
+
+constexpr std::string_view k_Usage =
+    R"(usage: lodestone_module_generator --out=<dir> [options] [-- <cooker args>]
+  --name=<name>          module name, and the stem of the .slang file (default SyntheticModule)
+  --axes=<n>             axis count (default 4)
+  --values=<n>           values on each axis, from 2 to 8 (default 4)
+  --depth=<n>            axes that depend on the axis before them (default 0)
+  --entry-points=<n>     compute entry points (default 2)
+  --layout-axes=<n>      axes that size a buffer and gate its use (default 0)
+  --inert-axes=<n>       axes that nothing reads (default 0)
+  --out=<dir>            where the .slang file and the registry snippet go
+  --cook                 register the space and cook the module in this process
+  --json=<file>          with --cook, write the shape and the cost of the cook to <file>)";
+
+struct Options
+{
+    lodestone::SyntheticModuleShape Shape;
+    std::filesystem::path OutputDirectory;
+    std::filesystem::path JsonPath;
+    bool Cook{ false };
+    std::vector<std::string_view> CookerArguments;
+};
+
+std::optional<uint32_t> ParseCount(std::string_view text) noexcept
+{
+    uint32_t value = 0u;
+    const std::from_chars_result parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (parsed.ec != std::errc{} || parsed.ptr != text.data() + text.size())
+    {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+/** Reads `--flag=<n>` into `out_value`. False when the argument is some other flag. */
+bool ReadCountFlag(std::string_view argument,
+                   std::string_view prefix,
+                   uint32_t& out_value,
+                   bool& out_malformed) noexcept
+{
+    if (!argument.starts_with(prefix))
+    {
+        return false;
+    }
+
+    const std::optional<uint32_t> value = ParseCount(argument.substr(prefix.size()));
+    out_malformed = !value.has_value();
+    out_value = value.value_or(out_value);
+    return true;
+}
+
+std::expected<Options, GeneratorError> ParseOptions(std::span<char*> args)
+{
+    Options options;
+    lodestone::SyntheticModuleShape& shape = options.Shape;
+    for (size_t i = 1u; i < args.size(); ++i)
+    {
+        const std::string_view arg{ args[i] };
+        bool malformed = false;
+        if (arg == "--")
+        {
+            for (size_t j = i + 1u; j < args.size(); ++j)
+            {
+                options.CookerArguments.emplace_back(args[j]);
+            }
+            break;
+        }
+
+        if (ReadCountFlag(arg, "--axes=", shape.AxisCount, malformed) ||
+            ReadCountFlag(arg, "--values=", shape.ValuesPerAxis, malformed) ||
+            ReadCountFlag(arg, "--depth=", shape.DependencyDepth, malformed) ||
+            ReadCountFlag(arg, "--entry-points=", shape.EntryPointCount, malformed) ||
+            ReadCountFlag(arg, "--layout-axes=", shape.LayoutAxisCount, malformed) ||
+            ReadCountFlag(arg, "--inert-axes=", shape.InertAxisCount, malformed))
+        {
+            if (malformed)
+            {
+                std::println(stderr, "[module_generator] '{}' needs a whole number", arg);
+                return std::unexpected(GeneratorError::UsageError);
+            }
+        }
+        else if (arg.starts_with("--name="))
+        {
+            shape.ModuleName = arg.substr(7u);
+        }
+        else if (arg.starts_with("--out="))
+        {
+            options.OutputDirectory = arg.substr(6u);
+        }
+        else if (arg.starts_with("--json="))
+        {
+            options.JsonPath = arg.substr(7u);
+        }
+        else if (arg == "--cook")
+        {
+            options.Cook = true;
+        }
+        else
+        {
+            std::println(stderr, "[module_generator] unknown argument '{}'", arg);
+            return std::unexpected(GeneratorError::UsageError);
+        }
+    }
+
+    if (options.OutputDirectory.empty())
+    {
+        return std::unexpected(GeneratorError::UsageError);
+    }
+
+    return options;
+}
+
+bool WriteTextFile(const std::filesystem::path& path, std::string_view text)
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    file << text;
+    if (!file)
+    {
+        std::println(stderr, "[module_generator] could not write '{}'", path.string());
+        return false;
+    }
+
+    return true;
+}
+
+/** The most memory the process has held at once. Zero where the platform cannot say. */
+uint64_t QueryPeakResidentBytes() noexcept
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == 0)
+    {
+        return 0u;
+    }
+    return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0u;
+    }
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    // Linux reports kilobytes.
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024u;
+#endif
+#endif
+}
+
+struct CookMeasurement
+{
+    uint64_t VariantCount{ 0u };
+    double WallMilliseconds{ 0.0 };
+    uint64_t PeakResidentBytes{ 0u };
+    lodestone::CookStatistics Statistics;
+};
+
+std::expected<CookMeasurement, GeneratorError> CookGeneratedModule(const Options& options,
+                                                                   const std::filesystem::path& module_path)
+{
+    using namespace lodestone;
+
+    PermutationSpace space = MakeSyntheticSpace(options.Shape);
+    CookMeasurement measurement;
+    measurement.VariantCount = CountSyntheticVariants(options.Shape);
+    if (!RegisterPermutationSpace(options.Shape.ModuleName, std::move(space), 0u))
+    {
+        std::println(stderr,
+                     "[module_generator] a permutation space named '{}' already exists. Pick another --name.",
+                     options.Shape.ModuleName);
+        return std::unexpected(GeneratorError::RegistrationFailed);
+    }
+
+    // The cooker's own flags come first. A cook without -o writes beside the module.
+    const std::string defaultOutput = (options.OutputDirectory / "ShaderLibrary.hpp").string();
+    const std::string modulePath = module_path.string();
+    std::vector<std::string_view> arguments = options.CookerArguments;
+    bool hasOutput = false;
+    for (const std::string_view argument : arguments)
+    {
+        hasOutput = hasOutput || argument == "-o" || argument == "--output";
+    }
+    if (!hasOutput)
+    {
+        arguments.emplace_back("-o");
+        arguments.emplace_back(defaultOutput);
+    }
+    arguments.emplace_back(modulePath);
+
+    const CookResult<CookerOptions> cookerOptions = ParseCommandLine(arguments);
+    if (!cookerOptions)
+    {
+        std::println(stderr,
+                     "[module_generator] the cooker arguments are wrong: {}",
+                     ToString(cookerOptions.error()));
+        return std::unexpected(GeneratorError::UsageError);
+    }
+
+    FileOutputSink sink{ cookerOptions->OutputPath };
+    const auto start = std::chrono::steady_clock::now();
+    const CookResult<CookStatistics> statistics = RunCook(cookerOptions.value(), sink);
+    measurement.WallMilliseconds =
+        std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count();
+    measurement.PeakResidentBytes = QueryPeakResidentBytes();
+
+    if (!statistics)
+    {
+        std::println(stderr, "[module_generator] cook failed: {}", ToString(statistics.error()));
+        return std::unexpected(GeneratorError::CookFailed);
+    }
+
+    measurement.Statistics = statistics.value();
+    return measurement;
+}
+
+bool WriteMeasurementJson(const Options& options, const CookMeasurement& measurement)
+{
+    using namespace lodestone;
+
+    const SyntheticModuleShape& shape = options.Shape;
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.KeyString("module", shape.ModuleName);
+    writer.KeyUInt("axes", shape.AxisCount);
+    writer.KeyUInt("values_per_axis", shape.ValuesPerAxis);
+    writer.KeyUInt("dependency_depth", shape.DependencyDepth);
+    writer.KeyUInt("entry_points", shape.EntryPointCount);
+    writer.KeyUInt("layout_axes", shape.LayoutAxisCount);
+    writer.KeyUInt("inert_axes", shape.InertAxisCount);
+    writer.KeyUInt("variants", measurement.VariantCount);
+    writer.KeyUInt("variants_compiled", measurement.Statistics.VariantsCompiled);
+    writer.KeyUInt("wgsl_bytes", measurement.Statistics.TotalWgslBytes);
+    writer.KeyDouble("wall_ms", measurement.WallMilliseconds);
+    writer.KeyUInt("peak_resident_bytes", measurement.PeakResidentBytes);
+    writer.Key("phase_ms");
+    writer.BeginObject();
+    for (size_t i = 1u; i < k_CookPhaseCount; ++i)
+    {
+        const auto phase = static_cast<CookPhase>(i);
+        writer.KeyDouble(ToString(phase), measurement.Statistics.PhaseTimes.Get(phase));
+    }
+    writer.EndObject();
+    writer.EndObject();
+
+    const JsonResult<std::string> document = writer.Finish();
+    return document.has_value() && WriteTextFile(options.JsonPath, document.value() + "\n");
+}
+
+int Run(const Options& options)
+{
+    using namespace lodestone;
+
+    const std::string problem = ValidateSyntheticShape(options.Shape);
+    if (!problem.empty())
+    {
+        std::println(stderr, "[module_generator] {}", problem);
+        return static_cast<int>(GeneratorError::InvalidShape);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.OutputDirectory, error);
+    const std::filesystem::path modulePath = options.OutputDirectory / (options.Shape.ModuleName + ".slang");
+    const std::filesystem::path snippetPath =
+        options.OutputDirectory / (options.Shape.ModuleName + "Registry.inl");
+    if (!WriteTextFile(modulePath, GenerateSyntheticSlang(options.Shape)) ||
+        !WriteTextFile(snippetPath, GenerateRegistrySnippet(options.Shape)))
+    {
+        return static_cast<int>(GeneratorError::WriteFailed);
+    }
+
+    std::println("[module_generator] wrote {} variants to {}, and the registration to {}",
+                 CountSyntheticVariants(options.Shape),
+                 modulePath.string(),
+                 snippetPath.string());
+    if (!options.Cook)
+    {
+        return 0;
+    }
+
+    const std::expected<CookMeasurement, GeneratorError> measurement =
+        CookGeneratedModule(options, modulePath);
+    if (!measurement)
+    {
+        return static_cast<int>(measurement.error());
+    }
+
+    std::println("[module_generator] {} variants in {:.1f}ms, peak memory {} MiB",
+                 measurement->VariantCount,
+                 measurement->WallMilliseconds,
+                 measurement->PeakResidentBytes / (1024u * 1024u));
+    std::println("[module_generator] phases: {}", DescribePhaseTimes(measurement->Statistics.PhaseTimes));
+
+    if (!options.JsonPath.empty() && !WriteMeasurementJson(options, measurement.value()))
+    {
+        return static_cast<int>(GeneratorError::WriteFailed);
+    }
+
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::expected<Options, GeneratorError> options =
+        ParseOptions(std::span<char*>{ argv, static_cast<size_t>(argc) });
+    if (!options)
+    {
+        std::println(stderr, "{}", k_Usage);
+        return static_cast<int>(options.error());
+    }
+
+    return Run(options.value());
+}